@@ -0,0 +1,108 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 2018-2021 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+#include "core.h"
+
+
+// allocations bigger than this part of the block size get their own blocks,
+// so they won't waste the rest of the current block
+enum { BigAllocDiv = 4 };
+
+// block data follows the header; header size is a multiple of the alignment
+struct alignas(VMemArena::Alignment) VMemArena::Block {
+  Block *next;
+  size_t size; // with header
+};
+
+
+//==========================================================================
+//
+//  VMemArena::VMemArena
+//
+//==========================================================================
+VMemArena::VMemArena (size_t ablockSize) noexcept
+  : blocks(nullptr)
+  , curr(nullptr)
+  , end(nullptr)
+  , blockSize(max2((size_t)4096, ablockSize))
+{
+  memset((void *)&stats, 0, sizeof(stats));
+}
+
+
+//==========================================================================
+//
+//  VMemArena::AllocSlow
+//
+//  `size` is already aligned
+//
+//==========================================================================
+void *VMemArena::AllocSlow (size_t size) noexcept {
+  if (size > blockSize/BigAllocDiv) {
+    // dedicated block; insert it after the current one, so we can continue using the current block
+    Block *blk = (Block *)Z_Malloc(sizeof(Block)+size);
+    blk->size = sizeof(Block)+size;
+    if (blocks) {
+      blk->next = blocks->next;
+      blocks->next = blk;
+    } else {
+      // no current block yet, so make this one "full"
+      blk->next = nullptr;
+      blocks = blk;
+    }
+    ++stats.blockCount;
+    stats.blockBytes += blk->size;
+    ++stats.allocCount;
+    stats.allocBytes += size;
+    void *res = (vuint8 *)blk+sizeof(Block);
+    memset(res, 0, size);
+    return res;
+  }
+  // start new block; the tail of the current one is lost
+  Block *blk = (Block *)Z_Malloc(sizeof(Block)+blockSize);
+  blk->size = sizeof(Block)+blockSize;
+  blk->next = blocks;
+  blocks = blk;
+  ++stats.blockCount;
+  stats.blockBytes += blk->size;
+  curr = (vuint8 *)blk+sizeof(Block);
+  end = curr+blockSize;
+  return Alloc(size);
+}
+
+
+//==========================================================================
+//
+//  VMemArena::Clear
+//
+//==========================================================================
+void VMemArena::Clear () noexcept {
+  while (blocks) {
+    Block *blk = blocks;
+    blocks = blk->next;
+    Z_Free(blk);
+  }
+  curr = end = nullptr;
+  memset((void *)&stats, 0, sizeof(stats));
+}
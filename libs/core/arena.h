@@ -0,0 +1,94 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 2018-2021 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  simple bump arena for data with the same lifetime
+//**
+//**  memory is taken from big zone blocks, and there is no way to free
+//**  a single allocation: everything is released at once with `Clear()`.
+//**  returned memory is zeroed, and no constructors or destructors are
+//**  called, so this is only for POD types.
+//**
+//**  arena is not thread-safe.
+//**
+//**************************************************************************
+
+// arena statistics
+struct VMemArenaStats {
+  vuint64 allocCount; // number of allocations since the last `Clear()`
+  vuint64 allocBytes; // bytes given to callers (sizes are rounded up to the alignment)
+  vuint64 blockBytes; // bytes taken from zone (including headers and unused block tails)
+  int blockCount; // including dedicated blocks for big allocations
+};
+
+
+//==========================================================================
+//
+//  VMemArena
+//
+//==========================================================================
+class VMemArena {
+public:
+  enum {
+    DefaultBlockSize = 256*1024,
+    Alignment = 16,
+  };
+
+private:
+  struct Block;
+
+  Block *blocks; // the first one is the current block
+  vuint8 *curr; // free space in the current block
+  vuint8 *end;
+  size_t blockSize;
+  VMemArenaStats stats;
+
+private:
+  void *AllocSlow (size_t size) noexcept;
+
+public:
+  VV_DISABLE_COPY(VMemArena)
+
+  explicit VMemArena (size_t ablockSize=DefaultBlockSize) noexcept;
+  inline ~VMemArena () noexcept { Clear(); }
+
+  // returns zeroed memory, aligned to `Alignment`
+  inline void *Alloc (size_t size) noexcept {
+    size = (size ? (size+(Alignment-1))&~(size_t)(Alignment-1) : Alignment);
+    if (size > (size_t)(end-curr)) return AllocSlow(size);
+    void *res = curr;
+    curr += size;
+    ++stats.allocCount;
+    stats.allocBytes += size;
+    memset(res, 0, size);
+    return res;
+  }
+
+  template<typename T> inline T *Alloc (size_t count=1) noexcept { return (T *)Alloc(count*sizeof(T)); }
+
+  // releases all blocks
+  void Clear () noexcept;
+
+  inline const VMemArenaStats &GetStats () const noexcept { return stats; }
+};
@@ -172,6 +172,14 @@ public:
   inline void Condense () noexcept { Resize(ArrNum); }
   inline void condense () noexcept { Resize(ArrNum); }
 
+  // exchange contents with another array; no elements are copied
+  inline void swap (TArray<T> &other) noexcept {
+    if (&other == this) return;
+    int tmpNum = ArrNum; ArrNum = other.ArrNum; other.ArrNum = tmpNum;
+    int tmpSize = ArrSize; ArrSize = other.ArrSize; other.ArrSize = tmpSize;
+    T *tmpData = ArrData; ArrData = other.ArrData; other.ArrData = tmpData;
+  }
+
   // this won't copy capacity (there is no reason to do it)
   TArray<T> &operator = (const TArray<T> &other) noexcept {
     if (&other == this) return *this; // oops
@@ -177,6 +177,8 @@
 #include "minipng.h"
 
 #include "syslow.h"
+#include "tracezone.h" // scoped timing zones
+#include "arena.h" // bump allocator for data with the same lifetime
 
 #include "timsort.h"
 
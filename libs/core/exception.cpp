@@ -124,6 +124,9 @@ void Sys_Error (const char *error, ...) noexcept {
   vsnprintf(buf, sizeof(buf), error, argptr);
   va_end(argptr);
 
+  // write queued messages, and log everything else synchronously
+  VLog::StopAsync();
+
   if (SysErrorCB) SysErrorCB(buf);
 
 #if defined(WIN32)
@@ -43,6 +43,7 @@ bool GLogSkipLogTypeName = true;
 #else
 bool GLogSkipLogTypeName = false;
 #endif
+bool (*GLogDevModeCB) () noexcept = nullptr;
 
 VLog::Listener *VLog::Listeners = nullptr;
 
@@ -106,6 +107,620 @@ static inline void InitLogLock () noexcept {
 }
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+// asynchronous log
+//
+// this is multiple producers, single consumer ring buffer. producers
+// reserve space by moving `asyncHead` with CAS, copy the message, and
+// then "commit" the record by writing its size. the log thread claims
+// records by moving `asyncDrainPos` with CAS, stops at the first
+// uncommitted one, zeroes consumed space, and moves `asyncTail`, so
+// uncommitted headers always read as zero.
+//
+// records are 8-byte aligned; a record never wraps around: if there is
+// no room at the end of the buffer, the producer reserves the tail part
+// too, and fills it with a padding record.
+//
+// when the log thread cannot write messages (`StopAsync()` is called
+// from a listener, or we are crashing), the current thread claims the
+// rest of the records, and calls listeners itself. such records are not
+// released, because we are going down anyway.
+//
+struct LogAsyncRecord {
+  vuint32 size; // with header and padding; 0 means "not committed yet"
+  vint32 type; // EName, or -1 for padding
+  vuint32 msecs; // captured by the producer
+  vuint16 flags;
+  vuint16 nameLen; // type name length
+  // type name follows, 0-terminated, then the text, 0-terminated
+};
+static_assert(sizeof(LogAsyncRecord) == 16, "invalid `LogAsyncRecord` size");
+
+enum {
+  LogAsyncDefaultBufferSize = 1024*1024,
+  LogAsyncPadType = -1,
+  LogAsyncMaxNameLen = 63,
+  // header, type name, EOL, and trailing zero
+  LogAsyncMaxOverhead = (int)sizeof(LogAsyncRecord)+LogAsyncMaxNameLen+1+2,
+};
+
+enum {
+  LogAsyncDevMode = 1u<<0,
+  // written by a listener on the log thread, so listeners that are
+  // called by the producer haven't seen it yet
+  LogAsyncNeedSync = 1u<<1,
+};
+
+static vuint8 *asyncBuf = nullptr;
+static vuint32 asyncBufSize = 0; // power of two
+static vuint64 asyncHead = 0; // reserved by producers
+static vuint64 asyncDrainPos = 0; // claimed by the log thread
+static vuint64 asyncTail = 0; // consumed by the log thread
+static int asyncActive = 0;
+static int asyncWriters = 0; // producers inside `asyncWrite()`
+static int asyncQuit = 0;
+static int asyncSleeping = 0;
+static vuint64 asyncQueued = 0;
+static vuint64 asyncDropped = 0;
+static vuint64 asyncReportedDropped = 0; // log thread only
+static vuint64 asyncSyncFallbacks = 0;
+static vuint32 asyncPeakUsed = 0;
+static bool asyncInited = false;
+static bool asyncAtExitSet = false;
+static bool asyncThreadStarted = false;
+static const char *asyncWarningName = "Warning"; // captured by `StartAsync()`
+static mythread asyncThread;
+static mythread_mutex asyncWakeLock;
+// thread-safe listeners are called with this lock held, not with `logLock`,
+// so game thread doesn't wait for the log thread
+// lock order: `logLock`, then `asyncListenersLock`
+static mythread_mutex asyncListenersLock;
+static mythread_cond asyncWakeCond;
+static thread_local bool asyncInLogThread = false;
+// locks the current thread holds while calling listeners for queued records
+// listeners can write messages, and such messages should not wait for these
+static thread_local bool asyncHoldsLogLock = false;
+static thread_local bool asyncHoldsListenersLock = false;
+
+
+//==========================================================================
+//
+//  AsyncListenersLocker
+//
+//  locks async listeners lock, if async log was ever started
+//
+//==========================================================================
+struct AsyncListenersLocker {
+  bool locked;
+  inline AsyncListenersLocker () noexcept : locked(asyncInited) { if (locked) mythread_mutex_lock(&asyncListenersLock); }
+  inline ~AsyncListenersLocker () noexcept { if (locked) mythread_mutex_unlock(&asyncListenersLock); }
+  VV_DISABLE_COPY(AsyncListenersLocker)
+};
+
+
+//==========================================================================
+//
+//  asyncWakeLogThread
+//
+//==========================================================================
+static inline void asyncWakeLogThread () noexcept {
+  if (__atomic_load_n(&asyncSleeping, __ATOMIC_SEQ_CST)) {
+    mythread_mutex_lock(&asyncWakeLock);
+    mythread_cond_signal(&asyncWakeCond);
+    mythread_mutex_unlock(&asyncWakeLock);
+  }
+}
+
+
+//==========================================================================
+//
+//  asyncTryLockFor
+//
+//  for crash handlers; returns `false` on timeout
+//
+//==========================================================================
+static bool asyncTryLockFor (mythread_mutex *mtx, double timeout) noexcept {
+  const double stt = Sys_Time();
+  for (;;) {
+    if (mythread_mutex_trylock(mtx) == 0) return true;
+    if (Sys_Time()-stt >= timeout) return false;
+    Sys_Yield();
+  }
+}
+
+
+//==========================================================================
+//
+//  asyncUpdatePeak
+//
+//==========================================================================
+static inline void asyncUpdatePeak (vuint32 used) noexcept {
+  vuint32 peak = __atomic_load_n(&asyncPeakUsed, __ATOMIC_RELAXED);
+  while (used > peak) {
+    if (__atomic_compare_exchange_n(&asyncPeakUsed, &peak, used, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+  }
+}
+
+
+//==========================================================================
+//
+//  asyncEnqueue
+//
+//  returns `false` if the buffer is full
+//
+//==========================================================================
+static bool asyncEnqueue (const VLogMessage &msg, int len, bool addEOL, unsigned flags) noexcept {
+  size_t nlen = strlen(msg.typeName);
+  if (nlen > LogAsyncMaxNameLen) nlen = LogAsyncMaxNameLen;
+  const vuint32 total = (vuint32)((sizeof(LogAsyncRecord)+nlen+1u+(unsigned)len+(addEOL ? 1u : 0u)+1u+7u)&~7u);
+  const vuint32 mask = asyncBufSize-1;
+  vuint64 head = __atomic_load_n(&asyncHead, __ATOMIC_RELAXED);
+  vuint32 pad;
+  for (;;) {
+    const vuint32 pos = (vuint32)head&mask;
+    pad = (asyncBufSize-pos < total ? asyncBufSize-pos : 0);
+    const vuint64 tail = __atomic_load_n(&asyncTail, __ATOMIC_ACQUIRE);
+    if (head+pad+total-tail > asyncBufSize) return false;
+    if (__atomic_compare_exchange_n(&asyncHead, &head, head+pad+total, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+      asyncUpdatePeak((vuint32)(head+pad+total-tail));
+      break;
+    }
+    // `head` is updated by failed CAS
+  }
+  if (pad) {
+    LogAsyncRecord *prec = (LogAsyncRecord *)(asyncBuf+((vuint32)head&mask));
+    prec->type = LogAsyncPadType;
+    __atomic_store_n(&prec->size, pad, __ATOMIC_RELEASE);
+  }
+  LogAsyncRecord *rec = (LogAsyncRecord *)(asyncBuf+((vuint32)(head+pad)&mask));
+  rec->type = (vint32)msg.type;
+  rec->msecs = msg.msecs;
+  rec->flags = (vuint16)(flags|(msg.devMode ? LogAsyncDevMode : 0u));
+  rec->nameLen = (vuint16)nlen;
+  char *name = (char *)(rec+1);
+  memcpy(name, msg.typeName, nlen);
+  name[nlen] = 0;
+  char *text = name+nlen+1;
+  memcpy(text, msg.text, (size_t)len);
+  if (addEOL) text[len++] = '\n';
+  text[len] = 0;
+  __atomic_store_n(&rec->size, total, __ATOMIC_RELEASE);
+  __atomic_add_fetch(&asyncQueued, 1, __ATOMIC_RELAXED);
+  return true;
+}
+
+
+//==========================================================================
+//
+//  asyncClaim
+//
+//  claims the next committed record; returns `nullptr` if there is none
+//
+//==========================================================================
+static LogAsyncRecord *asyncClaim (vuint64 &pos) noexcept {
+  const vuint32 mask = asyncBufSize-1;
+  pos = __atomic_load_n(&asyncDrainPos, __ATOMIC_ACQUIRE);
+  for (;;) {
+    LogAsyncRecord *rec = (LogAsyncRecord *)(asyncBuf+((vuint32)pos&mask));
+    const vuint32 size = __atomic_load_n(&rec->size, __ATOMIC_ACQUIRE);
+    if (!size) return nullptr; // empty, or not committed yet
+    if (__atomic_compare_exchange_n(&asyncDrainPos, &pos, pos+size, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) return rec;
+    // `pos` is updated by failed CAS
+  }
+}
+
+
+//==========================================================================
+//
+//  asyncDeliver
+//
+//  calls listeners, and takes only the locks the current thread doesn't
+//  hold yet. `logLock` is never waited for with `asyncListenersLock` held,
+//  so sync listeners may miss such message (this can happen only when
+//  the log thread writes the rest of the queue by itself).
+//
+//==========================================================================
+static void asyncDeliver (const VLogMessage &msg, bool syncListeners) noexcept {
+  bool lockedLog = false;
+  if (syncListeners && !asyncHoldsLogLock) {
+    if (asyncHoldsListenersLock) {
+      lockedLog = (mythread_mutex_trylock(&VLog::logLock) == 0);
+    } else {
+      mythread_mutex_lock(&VLog::logLock);
+      lockedLog = true;
+    }
+    asyncHoldsLogLock = lockedLog;
+  }
+  if (syncListeners && asyncHoldsLogLock) VLog::callSyncListeners(msg);
+  bool lockedListeners = false;
+  if (!asyncHoldsListenersLock) {
+    mythread_mutex_lock(&asyncListenersLock);
+    asyncHoldsListenersLock = lockedListeners = true;
+  }
+  VLog::callListenersAsync(msg);
+  if (lockedListeners) {
+    asyncHoldsListenersLock = false;
+    mythread_mutex_unlock(&asyncListenersLock);
+  }
+  if (lockedLog) {
+    asyncHoldsLogLock = false;
+    mythread_mutex_unlock(&VLog::logLock);
+  }
+}
+
+
+//==========================================================================
+//
+//  asyncDeliverRecord
+//
+//==========================================================================
+static void asyncDeliverRecord (const LogAsyncRecord *rec) noexcept {
+  VLogMessage msg;
+  msg.typeName = (const char *)(rec+1);
+  msg.text = msg.typeName+rec->nameLen+1;
+  msg.type = (EName)rec->type;
+  msg.msecs = rec->msecs;
+  msg.devMode = !!(rec->flags&LogAsyncDevMode);
+  asyncDeliver(msg, !!(rec->flags&LogAsyncNeedSync));
+}
+
+
+//==========================================================================
+//
+//  asyncDrain
+//
+//  called from the log thread
+//  returns `true` if something was processed
+//
+//==========================================================================
+static bool asyncDrain () noexcept {
+  bool res = false;
+  bool locked = false;
+  vuint64 pos;
+  while (LogAsyncRecord *rec = asyncClaim(pos)) {
+    const vuint32 size = rec->size;
+    if (rec->type != LogAsyncPadType) {
+      // `logLock` should be taken first
+      const bool needSync = !!(rec->flags&LogAsyncNeedSync);
+      if (needSync && locked) {
+        asyncHoldsListenersLock = locked = false;
+        mythread_mutex_unlock(&asyncListenersLock);
+      } else if (!needSync && !locked) {
+        mythread_mutex_lock(&asyncListenersLock);
+        asyncHoldsListenersLock = locked = true;
+      }
+      asyncDeliverRecord(rec);
+    }
+    memset((void *)rec, 0, size);
+    __atomic_store_n(&asyncTail, pos+size, __ATOMIC_RELEASE);
+    res = true;
+  }
+  // report dropped messages
+  const vuint64 dropped = __atomic_load_n(&asyncDropped, __ATOMIC_RELAXED);
+  if (dropped != asyncReportedDropped) {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "log queue overflow: %u message%s dropped\n", (unsigned)(dropped-asyncReportedDropped), (dropped-asyncReportedDropped == 1 ? "" : "s"));
+    asyncReportedDropped = dropped;
+    VLogMessage msg;
+    msg.text = buf;
+    msg.type = NAME_Warning;
+    msg.typeName = asyncWarningName;
+    asyncDeliver(msg, false);
+  }
+  if (locked) {
+    asyncHoldsListenersLock = false;
+    mythread_mutex_unlock(&asyncListenersLock);
+  }
+  return res;
+}
+
+
+//==========================================================================
+//
+//  asyncDeliverDirect
+//
+//  claims the rest of the queue, and calls listeners from the current
+//  thread; records are not released
+//
+//==========================================================================
+static void asyncDeliverDirect () noexcept {
+  vuint64 pos;
+  while (LogAsyncRecord *rec = asyncClaim(pos)) {
+    if (rec->type != LogAsyncPadType) asyncDeliverRecord(rec);
+  }
+}
+
+
+//==========================================================================
+//
+//  asyncHasData
+//
+//==========================================================================
+static inline bool asyncHasData () noexcept {
+  return (__atomic_load_n(&asyncHead, __ATOMIC_SEQ_CST) != __atomic_load_n(&asyncDrainPos, __ATOMIC_SEQ_CST));
+}
+
+
+//==========================================================================
+//
+//  asyncSyncFallback
+//
+//  message is too long for the queue, and will be written synchronously
+//
+//==========================================================================
+static void asyncSyncFallback () noexcept {
+  __atomic_add_fetch(&asyncSyncFallbacks, 1, __ATOMIC_RELAXED);
+  // keep the order
+  VLog::FlushAsync();
+}
+
+
+//==========================================================================
+//
+//  asyncLogThreadProc
+//
+//==========================================================================
+static MYTHREAD_RET_TYPE asyncLogThreadProc (void *) {
+  asyncInLogThread = true;
+  for (;;) {
+    const bool quit = __atomic_load_n(&asyncQuit, __ATOMIC_ACQUIRE);
+    if (asyncDrain()) continue;
+    if (quit && !asyncHasData()) break;
+    mythread_mutex_lock(&asyncWakeLock);
+    __atomic_store_n(&asyncSleeping, 1, __ATOMIC_SEQ_CST);
+    if (!asyncHasData() && !__atomic_load_n(&asyncQuit, __ATOMIC_ACQUIRE)) {
+      // timeout is just in case of lost wakeup
+      mythread_condtime ctime;
+      mythread_condtime_set(&ctime, &asyncWakeCond, 100);
+      (void)mythread_cond_timedwait(&asyncWakeCond, &asyncWakeLock, &ctime);
+    }
+    __atomic_store_n(&asyncSleeping, 0, __ATOMIC_SEQ_CST);
+    mythread_mutex_unlock(&asyncWakeLock);
+  }
+  Z_ThreadDone();
+  return MYTHREAD_RET_VALUE;
+}
+
+
+//==========================================================================
+//
+//  asyncAtExit
+//
+//==========================================================================
+static void asyncAtExit () {
+  VLog::StopAsync();
+}
+
+
+//==========================================================================
+//
+//  VLogMessage::VLogMessage
+//
+//==========================================================================
+VLogMessage::VLogMessage (const char *atext, EName atype) noexcept
+  : text(atext ? atext : "")
+  , type(atype)
+  , typeName(VName::SafeString(atype))
+  , msecs(atype == NAME_DevNet ? (vuint32)(Sys_Time()*1000) : 0u)
+  , devMode(GLogDevModeCB ? GLogDevModeCB() : false)
+{
+}
+
+
+//==========================================================================
+//
+//  VLog::callListenersAsync
+//
+//  called with async listeners lock held
+//
+//==========================================================================
+void VLog::callListenersAsync (const VLogMessage &msg) noexcept {
+  for (Listener *ls = Listeners; ls; ls = ls->next) {
+    if (!ls->ls->IsThreadSafe()) continue;
+    try {
+      ls->ls->SerialiseMessage(msg);
+    } catch (...) {
+    }
+  }
+}
+
+
+//==========================================================================
+//
+//  VLog::asyncWrite
+//
+//  returns `false` if the message should be written synchronously
+//
+//==========================================================================
+bool VLog::asyncWrite (EName Type, const char *s, int len, bool addEOL) noexcept {
+  // some listener on the log thread writes a message; it is queued, or
+  // written right away, but never waits for the locks the log thread holds
+  if (asyncInLogThread) {
+    VLogMessage msg(s, Type);
+    if (IsAsyncActive() && (vuint32)len+LogAsyncMaxOverhead <= asyncBufSize/4) {
+      if (!asyncEnqueue(msg, len, addEOL, LogAsyncNeedSync)) __atomic_add_fetch(&asyncDropped, 1, __ATOMIC_RELAXED);
+    } else {
+      asyncDeliver(msg, true);
+      if (addEOL) {
+        msg.text = "\n";
+        asyncDeliver(msg, true);
+      }
+    }
+    return true;
+  }
+  __atomic_add_fetch(&asyncWriters, 1, __ATOMIC_SEQ_CST);
+  if (!__atomic_load_n(&asyncActive, __ATOMIC_SEQ_CST)) {
+    __atomic_sub_fetch(&asyncWriters, 1, __ATOMIC_SEQ_CST);
+    return false;
+  }
+  // too long? write it synchronously, but keep the order
+  if ((vuint32)len+LogAsyncMaxOverhead > asyncBufSize/4) {
+    __atomic_sub_fetch(&asyncWriters, 1, __ATOMIC_SEQ_CST);
+    asyncSyncFallback();
+    return false;
+  }
+  VLogMessage msg(s, Type);
+  // listeners that cannot be called from the log thread are called right here
+  {
+    MyThreadLocker lock(&logLock);
+    if (!Listeners) {
+      __atomic_sub_fetch(&asyncWriters, 1, __ATOMIC_SEQ_CST);
+      return true;
+    }
+    callSyncListeners(msg);
+    if (addEOL) {
+      VLogMessage eolmsg = msg;
+      eolmsg.text = "\n";
+      callSyncListeners(eolmsg);
+    }
+  }
+  if (!asyncEnqueue(msg, len, addEOL, 0)) __atomic_add_fetch(&asyncDropped, 1, __ATOMIC_RELAXED);
+  __atomic_sub_fetch(&asyncWriters, 1, __ATOMIC_SEQ_CST);
+  asyncWakeLogThread();
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VLog::StartAsync
+//
+//==========================================================================
+bool VLog::StartAsync (int bufferSize) noexcept {
+  if (IsAsyncActive()) return true;
+  InitLogLock();
+  if (!asyncInited) {
+    asyncInited = true;
+    mythread_mutex_init(&asyncWakeLock);
+    mythread_mutex_init(&asyncListenersLock);
+    mythread_cond_init(&asyncWakeCond);
+  }
+  if (bufferSize <= 0) bufferSize = LogAsyncDefaultBufferSize;
+  vuint32 bsz = 65536;
+  while (bsz < (vuint32)bufferSize && bsz < 0x40000000u) bsz <<= 1;
+  if (asyncBufSize != bsz) {
+    Z_Free(asyncBuf);
+    asyncBuf = (vuint8 *)Z_Calloc(bsz);
+    asyncBufSize = bsz;
+  } else {
+    memset(asyncBuf, 0, bsz);
+  }
+  asyncHead = asyncDrainPos = asyncTail = 0;
+  asyncQuit = 0;
+  asyncSleeping = 0;
+  asyncWarningName = VName::SafeString(NAME_Warning);
+  if (mythread_create(&asyncThread, &asyncLogThreadProc, nullptr)) {
+    fprintf(stderr, "WARNING: cannot create log thread, logging synchronously\n");
+    return false;
+  }
+  asyncThreadStarted = true;
+  if (!asyncAtExitSet) {
+    asyncAtExitSet = true;
+    atexit(&asyncAtExit);
+  }
+  __atomic_store_n(&asyncActive, 1, __ATOMIC_SEQ_CST);
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VLog::StopAsync
+//
+//==========================================================================
+void VLog::StopAsync () noexcept {
+  const bool wasActive = !!__atomic_exchange_n(&asyncActive, 0, __ATOMIC_SEQ_CST);
+  // called from some listener? the log thread cannot wait for itself, so
+  // write the rest right here; new messages will be written the same way
+  if (asyncInLogThread) {
+    if (wasActive) asyncDeliverDirect();
+    return;
+  }
+  if (!__atomic_exchange_n(&asyncThreadStarted, false, __ATOMIC_SEQ_CST)) return;
+  // wait for producers that are already inside `asyncWrite()`
+  while (__atomic_load_n(&asyncWriters, __ATOMIC_SEQ_CST) != 0) Sys_Yield();
+  // log thread writes everything before exiting
+  mythread_mutex_lock(&asyncWakeLock);
+  __atomic_store_n(&asyncQuit, 1, __ATOMIC_SEQ_CST);
+  mythread_cond_signal(&asyncWakeCond);
+  mythread_mutex_unlock(&asyncWakeLock);
+  mythread_join(asyncThread);
+}
+
+
+//==========================================================================
+//
+//  VLog::FlushAsync
+//
+//==========================================================================
+void VLog::FlushAsync () noexcept {
+  if (asyncInLogThread || !IsAsyncActive()) return;
+  const vuint64 head = __atomic_load_n(&asyncHead, __ATOMIC_SEQ_CST);
+  while (__atomic_load_n(&asyncTail, __ATOMIC_ACQUIRE) < head && IsAsyncActive()) {
+    asyncWakeLogThread();
+    Sys_Yield();
+  }
+}
+
+
+//==========================================================================
+//
+//  VLog::EmergencyFlush
+//
+//==========================================================================
+void VLog::EmergencyFlush () noexcept {
+  if (!__atomic_exchange_n(&asyncActive, 0, __ATOMIC_SEQ_CST)) return;
+  if (!asyncInLogThread) {
+    // give the log thread a chance to write everything
+    const double stt = Sys_Time();
+    while (asyncHasData() && Sys_Time()-stt < 0.5) {
+      asyncWakeLogThread();
+      Sys_Yield();
+    }
+    if (!asyncHasData()) return;
+  }
+  // the log thread is stuck, or we are the log thread, or we crashed with
+  // some lock held; try to take the locks, but don't wait for them forever
+  const bool oldHoldsLog = asyncHoldsLogLock;
+  const bool oldHoldsListeners = asyncHoldsListenersLock;
+  const bool lockedLog = (!oldHoldsLog && asyncTryLockFor(&logLock, 0.2));
+  const bool lockedListeners = (!oldHoldsListeners && asyncTryLockFor(&asyncListenersLock, 0.2));
+  asyncHoldsLogLock = asyncHoldsListenersLock = true;
+  asyncDeliverDirect();
+  asyncHoldsLogLock = oldHoldsLog;
+  asyncHoldsListenersLock = oldHoldsListeners;
+  if (lockedListeners) mythread_mutex_unlock(&asyncListenersLock);
+  if (lockedLog) mythread_mutex_unlock(&logLock);
+}
+
+
+//==========================================================================
+//
+//  VLog::IsAsyncActive
+//
+//==========================================================================
+bool VLog::IsAsyncActive () noexcept {
+  return !!__atomic_load_n(&asyncActive, __ATOMIC_ACQUIRE);
+}
+
+
+//==========================================================================
+//
+//  VLog::GetAsyncStats
+//
+//==========================================================================
+void VLog::GetAsyncStats (VLogAsyncStats *stats) noexcept {
+  if (!stats) return;
+  stats->active = IsAsyncActive();
+  stats->bufferSize = (int)asyncBufSize;
+  stats->used = (int)(__atomic_load_n(&asyncHead, __ATOMIC_ACQUIRE)-__atomic_load_n(&asyncTail, __ATOMIC_ACQUIRE));
+  stats->peakUsed = (int)__atomic_load_n(&asyncPeakUsed, __ATOMIC_RELAXED);
+  stats->queued = __atomic_load_n(&asyncQueued, __ATOMIC_RELAXED);
+  stats->dropped = __atomic_load_n(&asyncDropped, __ATOMIC_RELAXED);
+  stats->syncFallbacks = __atomic_load_n(&asyncSyncFallbacks, __ATOMIC_RELAXED);
+}
+
+
 //==========================================================================
 //
 //  VLog::VLog
@@ -132,6 +747,7 @@ void VLog::AddListener (VLogListener *lst) noexcept {
   if (!lst) return;
   InitLogLock();
   MyThreadLocker lock(&logLock);
+  AsyncListenersLocker alock;
   //if (inWrite) { fprintf(stderr, "FATAL: cannot add log listeners from log listener!\n"); abort(); }
   Listener *ls = (Listener *)Z_Malloc(sizeof(Listener));
   if (!ls) { fprintf(stderr, "FATAL: out of memory for log listener list!\n"); abort(); }
@@ -156,6 +772,7 @@ void VLog::RemoveListener (VLogListener *lst) noexcept {
   if (!lst || !Listeners) return;
   InitLogLock();
   MyThreadLocker lock(&logLock);
+  AsyncListenersLocker alock;
   //if (inWrite) { fprintf(stderr, "FATAL: cannot remove log listeners from log listener!\n"); abort(); }
   Listener *lastCurr = nullptr, *lastPrev = nullptr;
   Listener *curr = Listeners, *prev = nullptr;
@@ -173,6 +790,25 @@ void VLog::RemoveListener (VLogListener *lst) noexcept {
 }
 
 
+//==========================================================================
+//
+//  VLog::callSyncListeners
+//
+//  calls listeners that cannot be called from the log thread
+//  log lock should be held
+//
+//==========================================================================
+void VLog::callSyncListeners (const VLogMessage &msg) noexcept {
+  for (Listener *ls = Listeners; ls; ls = ls->next) {
+    if (ls->ls->IsThreadSafe()) continue;
+    try {
+      ls->ls->SerialiseMessage(msg);
+    } catch (...) {
+    }
+  }
+}
+
+
 //==========================================================================
 //
 //  VLog::doWriteStr
@@ -182,14 +818,20 @@ void VLog::doWriteStr (EName Type, const char *s, bool addEOL) noexcept {
   static const char *eolstr = "\n";
   if (!s || !s[0]) return;
 
+  if (asyncWrite(Type, s, (int)strlen(s), addEOL)) return;
+
   MyThreadLocker lock(&logLock);
+  AsyncListenersLocker alock;
   if (!Listeners) return;
 
+  VLogMessage msg(s, Type);
+  VLogMessage eolmsg = msg;
+  eolmsg.text = eolstr;
   inWrite = true;
   for (Listener *ls = Listeners; ls; ls = ls->next) {
     try {
-      ls->ls->Serialise(s, Type);
-      if (addEOL) ls->ls->Serialise(eolstr, Type);
+      ls->ls->SerialiseMessage(msg);
+      if (addEOL) ls->ls->SerialiseMessage(eolmsg);
     } catch (...) {
     }
   }
@@ -203,12 +845,37 @@ void VLog::doWriteStr (EName Type, const char *s, bool addEOL) noexcept {
 //
 //==========================================================================
 void VLog::doWrite (EName Type, const char *fmt, va_list ap, bool addEOL) noexcept {
-  MyThreadLocker lock(&logLock);
-  if (!Listeners) return;
-
   if (!addEOL && (!fmt || !fmt[0])) return;
   if (!fmt) fmt = "";
 
+  // in async mode, format into the local buffer; long messages are written synchronously
+  if (IsAsyncActive() || asyncInLogThread) {
+    char sbuf[AsyncFormatBufferSize];
+    va_list apcopy;
+    va_copy(apcopy, ap);
+    const int size = vsnprintf(sbuf, sizeof(sbuf), fmt, apcopy);
+    va_end(apcopy);
+    if (size < 0) return; // oops
+    if (size < (int)sizeof(sbuf)) {
+      if (asyncWrite(Type, sbuf, size, addEOL)) return;
+    } else if (asyncInLogThread) {
+      // the log thread cannot use the shared buffer, it needs the log lock
+      char *tbuf = (char *)Z_Malloc((size_t)size+1);
+      va_copy(apcopy, ap);
+      vsnprintf(tbuf, (size_t)size+1, fmt, apcopy);
+      va_end(apcopy);
+      (void)asyncWrite(Type, tbuf, size, addEOL); // always succeeds in the log thread
+      Z_Free(tbuf);
+      return;
+    } else {
+      asyncSyncFallback();
+    }
+  }
+
+  MyThreadLocker lock(&logLock);
+  AsyncListenersLocker alock;
+  if (!Listeners) return;
+
   // initial allocation
   if (!logbufsize) abort(); // the thing that should not be
 
@@ -259,10 +926,11 @@ void VLog::doWrite (EName Type, const char *fmt, va_list ap, bool addEOL) noexce
   if (addEOL) { logbuf[size] = '\n'; logbuf[size+1] = 0; }
 
   //doWriteStr(Type, logbuf, false);
+  VLogMessage msg(logbuf, Type);
   inWrite = true;
   for (Listener *ls = Listeners; ls; ls = ls->next) {
     try {
-      ls->ls->Serialise(logbuf, Type);
+      ls->ls->SerialiseMessage(msg);
     } catch (...) {
     }
   }
@@ -461,8 +1129,10 @@ public:
     if (fo && s && s[0]) fwrite(s, strlen(s), 1, fo);
   }
 
-  void printEvent (EName event) noexcept {
-    if (event == NAME_None) event = NAME_Log;
+  void printEvent (const VLogMessage &msg) noexcept {
+    EName event = msg.type;
+    const char *evname = msg.typeName;
+    if (event == NAME_None) { event = NAME_Log; evname = "Log"; }
     lastEvent = event;
     FILE *fo = outfile();
     if (fo) {
@@ -477,22 +1147,30 @@ public:
           resetColor = false;
         }
         #endif
-        xprintStr(*VName(event), fo);
+        xprintStr(evname, fo);
         xprintStr(":", fo);
         #if !defined(_WIN32)
         if (resetColor) xprintStr("\x1b[0m", fo);
         #endif
         if (event == NAME_DevNet) {
-          unsigned msecs = unsigned(Sys_Time()*1000);
           char buf[64];
-          snprintf(buf, sizeof(buf), "%u:", msecs);
+          snprintf(buf, sizeof(buf), "%u:", (unsigned)msg.msecs);
           xprintStr(buf, fo);
         }
       }
     }
   }
 
+  // only stdio is used here
+  virtual bool IsThreadSafe () const noexcept override { return true; }
+
   virtual void Serialise (const char *Text, EName Event) noexcept override {
+    SerialiseMessage(VLogMessage(Text, Event));
+  }
+
+  virtual void SerialiseMessage (const VLogMessage &msg) noexcept override {
+    const char *Text = msg.text;
+    EName Event = msg.type;
     //if (Text[0]) { FILE *fo = fopen("z.txt", "a"); fwrite(Text, strlen(Text), 1, fo); fputc('|', fo); fclose(fo); }
     if (Event == NAME_None) Event = NAME_Log;
     if (!GLogTTYLog) { lastEvent = NAME_None; return; }
@@ -510,7 +1188,7 @@ public:
         if (lastWasNL || Event != lastEvent) {
           // force new event
           if (!lastWasNL) xprintStr("\n", outfile());
-          printEvent(Event);
+          printEvent(msg);
           if (!GLogSkipLogTypeName) xprintStr(" ", outfile());
         }
         lastWasNL = false;
@@ -24,6 +24,27 @@
 //**
 //**************************************************************************
 
+//==========================================================================
+//
+//  VLogMessage
+//
+//  everything listeners may need is captured by the thread that wrote
+//  the message, so the log thread never touches the engine state
+//
+//==========================================================================
+struct VLogMessage {
+  const char *text;
+  EName type;
+  const char *typeName; // `VName::SafeString(type)`
+  vuint32 msecs; // `Sys_Time()` in milliseconds
+  bool devMode; // result of `GLogDevModeCB()`
+
+  inline VLogMessage () noexcept : text(""), type(NAME_None), typeName(""), msecs(0), devMode(false) {}
+  // captures the current state
+  VLogMessage (const char *atext, EName atype) noexcept;
+};
+
+
 //==========================================================================
 //
 //  VLogListener
@@ -32,6 +53,23 @@
 class VLogListener : VInterface {
 public:
   virtual void Serialise (const char *Text, EName Event) noexcept = 0;
+  // this is what the logger calls; override it to use the captured state
+  virtual void SerialiseMessage (const VLogMessage &msg) noexcept { Serialise(msg.text, msg.type); }
+  // return `true` if this listener can be called from the log thread
+  // (it is still never called from several threads at once)
+  virtual bool IsThreadSafe () const noexcept { return false; }
+};
+
+
+// asynchronous log statistics
+struct VLogAsyncStats {
+  bool active;
+  int bufferSize; // in bytes
+  int used; // bytes in queue now
+  int peakUsed; // maximum bytes in queue
+  vuint64 queued; // messages queued
+  vuint64 dropped; // messages dropped because the queue was full
+  vuint64 syncFallbacks; // messages written synchronously because they were too long
 };
 
 
@@ -43,6 +81,7 @@ public:
 class VLog {
 private:
   enum { INITIAL_BUFFER_SIZE = 32768 };
+  enum { AsyncFormatBufferSize = 1024 }; // longer messages are written synchronously
 
   struct Listener {
     VLogListener *ls;
@@ -59,12 +98,37 @@ public:
   void doWriteStr (EName Type, const char *s, bool addEOL) noexcept;
   void doWrite (EName Type, const char *fmt, va_list ap, bool addEOL) noexcept;
 
+private:
+  static bool asyncWrite (EName Type, const char *s, int len, bool addEOL) noexcept;
+
+public: // for the log thread
+  // calls listeners that cannot be called from the log thread; log lock should be held
+  static void callSyncListeners (const VLogMessage &msg) noexcept;
+  // calls thread-safe listeners; async listeners lock should be held
+  static void callListenersAsync (const VLogMessage &msg) noexcept;
+
 public:
   VLog () noexcept;
 
   static void AddListener (VLogListener *Listener) noexcept;
   static void RemoveListener (VLogListener *Listener) noexcept;
 
+  // asynchronous mode: messages are formatted by the caller, and put into
+  // the ring buffer; thread-safe listeners are called from the log thread
+  // if the buffer is full, messages are dropped (and counted)
+  // `bufferSize` is rounded up to power of two; 0 means "default"
+  static bool StartAsync (int bufferSize=0) noexcept;
+  // writes all queued messages, and stops the log thread
+  // this is called from `Sys_Error()`
+  static void StopAsync () noexcept;
+  // waits until all queued messages are written
+  static void FlushAsync () noexcept;
+  // for crash handlers: writes queued messages, and never waits for long
+  // if the log thread cannot do it, messages are written from the current thread
+  static void EmergencyFlush () noexcept;
+  static bool IsAsyncActive () noexcept;
+  static void GetAsyncStats (VLogAsyncStats *stats) noexcept;
+
   void Write (EName Type, const char *fmt, ...) noexcept __attribute__((format(printf, 3, 4)));
   void WriteLine (EName Type, const char *fmt, ...) noexcept __attribute__((format(printf, 3, 4)));
 
@@ -101,3 +165,4 @@ extern bool GLogTTYLog; // true
 extern bool GLogSkipLogTypeName; // false
 extern bool GLogErrorToStderr; // false
 extern bool GLogWarningToStderr; // false
+extern bool (*GLogDevModeCB) () noexcept; // nullptr; see `VLogMessage::devMode`
@@ -44,3 +44,7 @@
 #include "map_impl.h"
 #undef TMAP_DO_DTOR
 #undef TMap_Class_Name
+
+
+// open addressing map with control bytes, same API as `TMap`
+#include "map_swiss.h"
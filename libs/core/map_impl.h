@@ -346,7 +346,9 @@ public:
       // copy entries
       if (other.mBucketsUsed > 0) {
         // has some entries
-        mEBSize = nextPOTU32(vuint32(mBucketsUsed));
+        mEBSize = nextPOTU32(vuint32(other.mBucketsUsed));
+        if (mEBSize < InitSize) mEBSize = InitSize;
+        if ((vuint32)other.mBucketsUsed >= mEBSize*LoadFactorPrc/100) mEBSize *= 2;
         mBuckets = (TEntry **)Z_Malloc(mEBSize*sizeof(TEntry *));
         memset(&mBuckets[0], 0, mEBSize*sizeof(TEntry *));
         mEntries = (TEntry *)Z_Malloc(mEBSize*sizeof(TEntry));
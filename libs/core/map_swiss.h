@@ -0,0 +1,454 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 2018-2021 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  Open addressing hash map with control bytes ("swiss table").
+//**
+//**  each slot has a control byte: either "empty", "deleted", or 7 bits
+//**  of the key hash. lookups check the whole group of control bytes at
+//**  once (SSE2, or 8 bytes in a 64-bit word without SSE2), and compare
+//**  keys only for matching bytes. slots are stored inline, so there is
+//**  no separate entry array and no pointer chasing.
+//**
+//**  API is the same as `TMap` (including iterators and the VM index
+//**  interface), so use sites can switch between them. keys and values
+//**  are constructed and destroyed in place.
+//**
+//**  the differences: iteration order is slot order, and pointers to
+//**  values are invalidated by any insertion (as with `TMap`).
+//**
+//**************************************************************************
+#include <new>
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+// group of control bytes
+struct TSwissGroup {
+  enum {
+    CtrlEmpty = 0x80,
+    CtrlDeleted = 0xfe,
+    // full slots have high bit reset
+  };
+
+#if defined(__SSE2__)
+  enum { Width = 16 };
+  typedef vuint32 Mask;
+
+  __m128i ctrl;
+
+  inline TSwissGroup (const vuint8 *p) noexcept : ctrl(_mm_loadu_si128((const __m128i *)p)) {}
+
+  inline Mask match (vuint8 h2) const noexcept { return (Mask)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8((char)h2), ctrl)); }
+  inline Mask matchEmpty () const noexcept { return (Mask)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8((char)CtrlEmpty), ctrl)); }
+  inline Mask matchEmptyOrDeleted () const noexcept { return (Mask)_mm_movemask_epi8(ctrl); }
+
+  static inline unsigned lowestIndex (Mask m) noexcept { return (unsigned)__builtin_ctz(m); }
+#else
+  enum { Width = 8 };
+  typedef vuint64 Mask;
+
+  vuint64 ctrl;
+
+  inline TSwissGroup (const vuint8 *p) noexcept {
+    memcpy(&ctrl, p, sizeof(ctrl));
+    #if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    ctrl = __builtin_bswap64(ctrl);
+    #endif
+  }
+
+  static inline vuint64 lsbs () noexcept { return 0x0101010101010101ULL; }
+  static inline vuint64 msbs () noexcept { return 0x8080808080808080ULL; }
+
+  // may report false positives for bytes after the real match; this is ok, as keys are compared anyway
+  inline Mask match (vuint8 h2) const noexcept { const vuint64 x = ctrl^(lsbs()*h2); return ((x-lsbs())&~x&msbs()); }
+  // "deleted" has bit 1 set, "empty" has not
+  inline Mask matchEmpty () const noexcept { return (ctrl&~(ctrl<<6)&msbs()); }
+  inline Mask matchEmptyOrDeleted () const noexcept { return (ctrl&msbs()); }
+
+  static inline unsigned lowestIndex (Mask m) noexcept { return (unsigned)(__builtin_ctzll(m)>>3); }
+#endif
+};
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+template<class TK, class TV> class TSwissMap {
+private:
+  enum {
+    GW = TSwissGroup::Width,
+    InitSize = GW*2, // *MUST* be power of two, and multiple of group width
+  };
+
+  struct TSlot {
+    TK key;
+    TV value;
+  };
+
+private:
+  vuint8 *mCtrl; // mCapacity bytes
+  TSlot *mSlots;
+  vuint32 mCapacity; // 0, or power of two
+  int mUsed;
+  int mGrowthLeft; // number of empty slots we can fill before rehashing (deleted slots are not counted)
+
+private:
+  // `GetTypeHash()` for integers and pointers can be weak, and we need good high bits too
+  static inline vuint32 mixHash (vuint32 h) noexcept {
+    h ^= h>>16;
+    h *= 0x7feb352dU;
+    h ^= h>>15;
+    h *= 0x846ca68bU;
+    h ^= h>>16;
+    return h;
+  }
+
+  static inline vuint8 hashH2 (vuint32 h) noexcept { return (vuint8)(h&0x7fU); }
+  static inline vuint32 hashH1 (vuint32 h) noexcept { return (h>>7); }
+
+  static inline bool isFull (vuint8 c) noexcept { return ((c&0x80U) == 0); }
+
+  // 7/8 load factor
+  static inline int capacityToGrowth (vuint32 cap) noexcept { return (int)(cap-cap/8); }
+
+  inline vuint32 groupMask () const noexcept { return mCapacity/GW-1; }
+
+  // returns slot index, or -1
+  int findIndex (const TK &akey) const noexcept {
+    if (mUsed == 0) return -1;
+    const vuint32 hash = mixHash(GetTypeHash(akey));
+    const vuint8 h2 = hashH2(hash);
+    const vuint32 gmask = groupMask();
+    vuint32 g = hashH1(hash)&gmask;
+    for (vuint32 step = 0; step <= gmask; ++step) {
+      const vuint32 base = g*GW;
+      TSwissGroup grp(mCtrl+base);
+      for (TSwissGroup::Mask m = grp.match(h2); m; m &= m-1) {
+        const vuint32 idx = base+TSwissGroup::lowestIndex(m);
+        if (mSlots[idx].key == akey) return (int)idx;
+      }
+      if (grp.matchEmpty()) return -1;
+      // triangular probing visits each group once
+      g = (g+step+1)&gmask;
+    }
+    return -1;
+  }
+
+  // there should be a free slot
+  vuint32 findInsertIndex (vuint32 hash) const noexcept {
+    const vuint32 gmask = groupMask();
+    vuint32 g = hashH1(hash)&gmask;
+    for (vuint32 step = 0; step <= gmask; ++step) {
+      const vuint32 base = g*GW;
+      TSwissGroup grp(mCtrl+base);
+      TSwissGroup::Mask m = grp.matchEmptyOrDeleted();
+      if (m) return base+TSwissGroup::lowestIndex(m);
+      g = (g+step+1)&gmask;
+    }
+    abort();
+  }
+
+  void destroySlots () noexcept {
+    if (!mUsed) return;
+    for (vuint32 f = 0; f < mCapacity; ++f) {
+      if (isFull(mCtrl[f])) {
+        mSlots[f].key.~TK();
+        mSlots[f].value.~TV();
+      }
+    }
+  }
+
+  void resizeTo (vuint32 newcap) noexcept {
+    vuint8 *octrl = mCtrl;
+    TSlot *oslots = mSlots;
+    const vuint32 ocap = mCapacity;
+    mCtrl = (vuint8 *)Z_Malloc(newcap);
+    memset(mCtrl, TSwissGroup::CtrlEmpty, newcap);
+    mSlots = (TSlot *)Z_Malloc(newcap*sizeof(TSlot));
+    mCapacity = newcap;
+    mGrowthLeft = capacityToGrowth(newcap)-mUsed;
+    // move alive entries; hashes are not stored, so recalculate them
+    for (vuint32 f = 0; f < ocap; ++f) {
+      if (!isFull(octrl[f])) continue;
+      TSlot *os = &oslots[f];
+      const vuint32 hash = mixHash(GetTypeHash(os->key));
+      const vuint32 idx = findInsertIndex(hash);
+      mCtrl[idx] = hashH2(hash);
+      new((void *)&mSlots[idx].key) TK(os->key);
+      new((void *)&mSlots[idx].value) TV(os->value);
+      os->key.~TK();
+      os->value.~TV();
+    }
+    Z_Free(octrl);
+    Z_Free((void *)oslots);
+  }
+
+  // called when there are no empty slots left
+  void grow () noexcept {
+    if (mCapacity == 0) {
+      resizeTo(InitSize);
+    } else if (mUsed <= capacityToGrowth(mCapacity)/2) {
+      // too many deleted slots; get rid of them
+      resizeTo(mCapacity);
+    } else {
+      resizeTo(mCapacity*2);
+    }
+  }
+
+  void eraseAt (vuint32 idx) noexcept {
+    mSlots[idx].key.~TK();
+    mSlots[idx].value.~TV();
+    --mUsed;
+    // if this group has an empty slot, no probe sequence goes past it,
+    // so the slot may become empty instead of deleted
+    if (TSwissGroup(mCtrl+(idx&~(vuint32)(GW-1))).matchEmpty()) {
+      mCtrl[idx] = TSwissGroup::CtrlEmpty;
+      ++mGrowthLeft;
+    } else {
+      mCtrl[idx] = TSwissGroup::CtrlDeleted;
+    }
+  }
+
+  inline int nextFull (int index) const noexcept {
+    while (index < (int)mCapacity && !isFull(mCtrl[index])) ++index;
+    return index;
+  }
+
+public:
+  class TIterator {
+  private:
+    TSwissMap *map;
+    vuint32 index;
+
+  public:
+    // ctor
+    inline TIterator (TSwissMap *amap) noexcept : map(amap), index(0) { vassert(amap); index = (vuint32)amap->nextFull(0); }
+
+    // special ctor that will create "end pointer"
+    inline TIterator (const TIterator &src, bool dummy) noexcept : map(src.map), index(src.map->mCapacity) {}
+
+    inline TIterator (const TIterator &src) noexcept : map(src.map), index(src.index) {}
+    inline TIterator &operator = (const TIterator &src) noexcept { if (&src != this) { map = src.map; index = src.index; } return *this; }
+
+    // convert to bool
+    inline operator bool () const noexcept { return (index < map->mCapacity); }
+
+    // next (prefix increment)
+    inline void operator ++ () noexcept { if (index < map->mCapacity) index = (vuint32)map->nextFull((int)index+1); }
+
+    // `foreach` interface
+    inline TIterator begin () noexcept { return TIterator(*this); }
+    inline TIterator end () noexcept { return TIterator(*this, true); }
+    inline bool operator != (const TIterator &b) const noexcept { return (map != b.map || index != b.index); } /* used to compare with end */
+    inline TIterator operator * () const noexcept { return TIterator(*this); } /* required for iterator */
+
+    // key/value getters
+    inline const TK &GetKey () const noexcept { return map->mSlots[index].key; }
+    inline const TV &GetValue () const noexcept { return map->mSlots[index].value; }
+    inline TV &GetValue () noexcept { return map->mSlots[index].value; }
+    inline const TK &getKey () const noexcept { return map->mSlots[index].key; }
+    inline const TV &getValue () const noexcept { return map->mSlots[index].value; }
+    inline TV &getValue () noexcept { return map->mSlots[index].value; }
+
+    // deletion never moves other entries, so this is safe
+    inline void removeCurrent () noexcept {
+      if (index < map->mCapacity) {
+        if (isFull(map->mCtrl[index])) map->eraseAt(index);
+        operator++();
+      }
+    }
+    inline void RemoveCurrent () noexcept { removeCurrent(); }
+
+    inline void resetToFirst () noexcept { index = (vuint32)map->nextFull(0); }
+  };
+
+  friend class TIterator;
+
+public:
+  // this is for VavoomC VM
+  inline bool isValidIIdx (vint32 index) const noexcept {
+    return (index >= 0 && index < (int)mCapacity);
+  }
+
+  // this is for VavoomC VM
+  inline vint32 getFirstIIdx () const noexcept {
+    const int index = nextFull(0);
+    return (vint32)(index < (int)mCapacity ? index : -1);
+  }
+
+  // <0: done
+  inline vint32 getNextIIdx (vint32 index) const noexcept {
+    if (!isValidIIdx(index)) return -1;
+    index = nextFull(index+1);
+    return (index < (int)mCapacity ? index : -1);
+  }
+
+  inline vint32 removeCurrAndGetNextIIdx (vint32 index) noexcept {
+    if (!isValidIIdx(index)) return -1;
+    if (isFull(mCtrl[index])) eraseAt((vuint32)index);
+    return getNextIIdx(index);
+  }
+
+  inline const TK *getKeyIIdx (vint32 index) const noexcept {
+    return (isValidIIdx(index) && isFull(mCtrl[index]) ? &mSlots[index].key : nullptr);
+  }
+
+  inline TV *getValueIIdx (vint32 index) const noexcept {
+    return (isValidIIdx(index) && isFull(mCtrl[index]) ? &mSlots[index].value : nullptr);
+  }
+
+public:
+  inline TSwissMap () noexcept : mCtrl(nullptr), mSlots(nullptr), mCapacity(0), mUsed(0), mGrowthLeft(0) {}
+
+  inline TSwissMap (const TSwissMap &other) noexcept : mCtrl(nullptr), mSlots(nullptr), mCapacity(0), mUsed(0), mGrowthLeft(0) {
+    operator=(other);
+  }
+
+  inline ~TSwissMap () noexcept { clear(); }
+
+  TSwissMap &operator = (const TSwissMap &other) noexcept {
+    if (&other != this) {
+      clear();
+      if (other.mUsed > 0) {
+        vuint32 newcap = InitSize;
+        while (capacityToGrowth(newcap) < other.mUsed) newcap *= 2;
+        resizeTo(newcap);
+        for (vuint32 f = 0; f < other.mCapacity; ++f) {
+          if (isFull(other.mCtrl[f])) put(other.mSlots[f].key, other.mSlots[f].value);
+        }
+      }
+    }
+    return *this;
+  }
+
+  void clear () noexcept {
+    destroySlots();
+    Z_Free(mCtrl);
+    Z_Free((void *)mSlots);
+    mCtrl = nullptr;
+    mSlots = nullptr;
+    mCapacity = 0;
+    mUsed = 0;
+    mGrowthLeft = 0;
+  }
+
+  // won't shrink slots
+  void reset () noexcept {
+    destroySlots();
+    if (mCapacity) memset(mCtrl, TSwissGroup::CtrlEmpty, mCapacity);
+    mUsed = 0;
+    mGrowthLeft = capacityToGrowth(mCapacity);
+  }
+
+  // removes deleted slots
+  void rehash () noexcept {
+    if (mCapacity) resizeTo(mCapacity);
+  }
+
+  // call this after alot of deletions
+  // if `doRealloc` is `false`, only remove deleted slots
+  void compact (bool doRealloc=true) noexcept {
+    if (!mCapacity) return;
+    if (!doRealloc) { rehash(); return; }
+    if (mUsed == 0) { clear(); return; }
+    vuint32 newcap = InitSize;
+    while (capacityToGrowth(newcap) < mUsed*2) newcap *= 2;
+    if (newcap < mCapacity) resizeTo(newcap);
+  }
+
+  inline bool has (const TK &akey) const noexcept { return (findIndex(akey) >= 0); }
+
+  inline const TV *get (const TK &akey) const noexcept {
+    const int idx = findIndex(akey);
+    return (idx >= 0 ? &mSlots[idx].value : nullptr);
+  }
+
+  inline TV *get (const TK &akey) noexcept {
+    const int idx = findIndex(akey);
+    return (idx >= 0 ? &mSlots[idx].value : nullptr);
+  }
+
+  //WARNING! returned pointer will be invalidated by any map insertion
+  inline TV *Find (const TK &Key) noexcept { return get(Key); }
+  inline TV *find (const TK &Key) noexcept { return get(Key); }
+  inline const TV *Find (const TK &Key) const noexcept { return get(Key); }
+  inline const TV *find (const TK &Key) const noexcept { return get(Key); }
+
+  inline const TV FindPtr (const TK &Key) const noexcept {
+    auto res = get(Key);
+    if (res) return *res;
+    return nullptr;
+  }
+  inline const TV findptr (const TK &Key) const noexcept { return FindPtr(Key); }
+
+  bool del (const TK &akey) noexcept {
+    const int idx = findIndex(akey);
+    if (idx < 0) return false;
+    eraseAt((vuint32)idx);
+    return true;
+  }
+
+  inline bool Remove (const TK &Key) noexcept { return del(Key); }
+  inline bool remove (const TK &Key) noexcept { return del(Key); }
+
+  // returns `true` if old value was replaced
+  bool put (const TK &akey, const TV &aval) noexcept {
+    const int oldidx = findIndex(akey);
+    if (oldidx >= 0) {
+      mSlots[oldidx].value = aval;
+      return true;
+    }
+    const vuint32 hash = mixHash(GetTypeHash(akey));
+    vuint32 idx = (mCapacity ? findInsertIndex(hash) : 0);
+    // reusing deleted slot doesn't need any growth
+    if (mCapacity == 0 || (mCtrl[idx] == TSwissGroup::CtrlEmpty && mGrowthLeft == 0)) {
+      grow();
+      idx = findInsertIndex(hash);
+    }
+    if (mCtrl[idx] == TSwissGroup::CtrlEmpty) --mGrowthLeft;
+    mCtrl[idx] = hashH2(hash);
+    new((void *)&mSlots[idx].key) TK(akey);
+    new((void *)&mSlots[idx].value) TV(aval);
+    ++mUsed;
+    return false;
+  }
+
+  inline void Set (const TK &Key, const TV &Value) noexcept { put(Key, Value); }
+  inline void set (const TK &Key, const TV &Value) noexcept { put(Key, Value); }
+
+  inline int count () const noexcept { return mUsed; }
+  inline int length () const noexcept { return mUsed; }
+  inline int capacity () const noexcept { return (int)mCapacity; }
+
+#ifdef CORE_MAP_TEST
+  int countItems () const noexcept {
+    int res = 0;
+    for (vuint32 f = 0; f < mCapacity; ++f) if (isFull(mCtrl[f])) ++res;
+    return res;
+  }
+#endif
+
+  TIterator first () noexcept { return TIterator(this); }
+};
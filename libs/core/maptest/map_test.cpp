@@ -22,10 +22,19 @@
 //**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //**
 //**************************************************************************
-#define EXCESSIVE_CHECKS
-#define EXCESSIVE_CHECKS_ITERATOR
-#define EXCESSIVE_COMPACT
-
+//**
+//**  hash map tests and benchmarks
+//**
+//**  usage: map_test [-paranoid] [-notest] [-nobench] [-n items] [-seed n]
+//**
+//**  tests are done for both `TMap` and `TSwissMap`; with `-paranoid`
+//**  the whole map is checked after each operation (this is SLOW).
+//**
+//**  benchmarks compare `TMap` and `TSwissMap` with integer and pointer
+//**  keys: insertion, lookup hits/misses, iteration, deletion, and
+//**  insert/delete churn. memory is measured with zone allocator stats.
+//**
+//**************************************************************************
 #define CORE_MAP_TEST
 
 typedef unsigned int vuint32;
@@ -51,6 +60,12 @@ static vuint32 GetTypeHash (int a) noexcept {
   return res;
 }
 
+// the same as in "hash/hashfunc.h"
+static vuint32 GetTypeHash (const void *a) noexcept {
+  const unsigned long long v = (unsigned long long)(size_t)a;
+  return GetTypeHash((int)(vuint32)v)^GetTypeHash((int)(vuint32)(v>>32));
+}
+
 
 static void fatal (const char *msg) {
   fprintf(stderr, "FATAL: %s\n", msg);
@@ -74,50 +89,77 @@ void Sys_Error (const char *error, ...) {
 #include "../zone.h"
 #include "../map.h"
 
-//int zone_malloc_call_count;
-//int zone_realloc_call_count;
-//int zone_free_call_count;
 
+static bool optParanoid = false;
+
+
+//==========================================================================
+//
+//  getTime
+//
+//  in seconds
+//
+//==========================================================================
+static double getTime () {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec+(double)ts.tv_nsec/1000000000.0;
+}
+
+
+// simple xorshift, so benchmark runs are reproducible
+static vuint32 prngState = 0x29a;
+
+static inline vuint32 prng () {
+  vuint32 x = prngState;
+  x ^= x<<13;
+  x ^= x>>17;
+  x ^= x<<5;
+  prngState = x;
+  return x;
+}
 
 
+// ////////////////////////////////////////////////////////////////////////// //
 // tests for hash table
 enum { MaxItems = 16384 };
 
+static int its[MaxItems];
 
-int its[MaxItems];
-TMap<int, int> hash;
 
-
-void checkHash (bool dump=false) {
+//==========================================================================
+//
+//  checkHash
+//
+//==========================================================================
+template<class TM> static void checkHash (TM &hash) {
   int count = 0;
-  if (dump) printf("====== CHECK ======\n");
   for (int i = 0; i < MaxItems; ++i) {
-    if (dump) {
-      auto flag = hash.get(i);
-      printf(" check #%d; v=%d; flag=%d\n", i, (flag ? *flag : 0), (flag ? 1 : 0));
-    }
     if (its[i] >= 0) {
       ++count;
-      if (!hash.has(i)) fatal("(0.0) fuuuuuuuuuuuu");
+      if (!hash.has(i)) fatal("(0.0) key lost");
       auto vp = hash.get(i);
-      if (!vp) fatal("(0.1) fuuuuuuuuuuuu");
-      if (*vp != its[i]) fatal("(0.2) fuuuuuuuuuuuu");
+      if (!vp) fatal("(0.1) key lost");
+      if (*vp != its[i]) fatal("(0.2) invalid value");
     } else {
-      if (hash.has(i)) fatal("(0.3) fuuuuuuuuuuuu");
+      if (hash.has(i)) fatal("(0.3) deleted key found");
     }
   }
-  if (count != hash.count()) fatal("(0.4) fuuuuuuuuuuuu");
-  if (dump) printf("------\n");
+  if (count != hash.count()) fatal("(0.4) invalid count");
 }
 
 
-void testIterator (bool verbose) {
+//==========================================================================
+//
+//  testIterator
+//
+//==========================================================================
+template<class TM> static void testIterator (TM &hash, bool verbose) {
   if (verbose) printf("  (iteration, normal)\n");
   static int marks[MaxItems];
   int count = 0;
   for (int i = 0; i < MaxItems; ++i) marks[i] = 0;
   for (auto it = hash.first(); it; ++it) {
-    //writeln('key=', k, '; value=', v);
     auto k = it.getKey();
     auto v = it.getValue();
     if (marks[k]) fatal("duplicate entry in iterator");
@@ -127,7 +169,7 @@ void testIterator (bool verbose) {
   }
   if (count != hash.length()) {
     printf("0: count=%d; hash.count=%d\n", count, hash.count());
-    //raise Exception.Create('lost entries in iterator');
+    fatal("lost entries in iterator");
   }
   if (verbose) printf("  (iteration, foreach)\n");
   // foreach iterator
@@ -141,7 +183,7 @@ void testIterator (bool verbose) {
   }
   if (count != 0) {
     printf("0: count=%d; hash.count=%d\n", count, hash.count());
-    //raise Exception.Create('lost entries in iterator');
+    fatal("lost entries in foreach iterator");
   }
   if (verbose) printf("  (iteration, counters)\n");
   count = 0;
@@ -152,76 +194,276 @@ void testIterator (bool verbose) {
   }
   if (hash.count() != hash.countItems()) {
     printf("OOPS: count=%d; countItems=%d\n", hash.count(), hash.countItems());
-    fatal("fuck");
+    fatal("invalid item count");
+  }
+}
+
+
+//==========================================================================
+//
+//  checkStep
+//
+//==========================================================================
+template<class TM> static void checkStep (TM &hash, int step) {
+  if (optParanoid || (step&1023) == 0) {
+    checkHash(hash);
+    testIterator(hash, false);
   }
 }
 
 
-int main () {
+//==========================================================================
+//
+//  runTests
+//
+//==========================================================================
+template<class TM> static void runTests (const char *name) {
+  TM hash;
   int xcount;
 
   for (int i = 0; i < MaxItems; ++i) its[i] = -1;
 
-  //Randomize();
-  srand(time(nullptr));
-
+  printf("=== testing %s ===\n", name);
   printf("testing: insertion\n");
   xcount = 0;
   for (int i = 0; i < MaxItems; ++i) {
-    int v = rand()%MaxItems;
-    //writeln('i=', i, '; v=', v, '; its[v]=', its[v]);
+    int v = (int)(prng()%MaxItems);
     if (its[v] >= 0) {
-      if (!hash.has(v)) fatal("(1.0) fuuuuuuuuuuuu");
+      if (!hash.has(v)) fatal("(1.0) key lost");
       auto vp = hash.get(v);
-      if (!vp) fatal("(1.1) fuuuuuuuuuuuu");
-      if (*vp != its[v]) fatal("(1.2) fuuuuuuuuuuuu");
+      if (!vp) fatal("(1.1) key lost");
+      if (*vp != its[v]) fatal("(1.2) invalid value");
     } else {
       its[v] = i;
-      if (hash.put(v, i)) fatal("(1.3) fuuuuuuuuuuuu");
+      if (hash.put(v, i)) fatal("(1.3) new key replaced something");
       ++xcount;
-      if (xcount != hash.count()) fatal("(1.4) fuuuuuuuuuuuu");
+      if (xcount != hash.count()) fatal("(1.4) invalid count");
     }
-    #ifdef EXCESSIVE_CHECKS
-    checkHash();
-    #endif
-    #ifdef EXCESSIVE_CHECKS_ITERATOR
-    testIterator(false);
-    #endif
+    checkStep(hash, i);
+  }
+  if (xcount != hash.count()) fatal("(1.5) invalid count");
+  checkHash(hash);
+  testIterator(hash, true);
+
+  printf("testing: copying\n");
+  {
+    TM copy;
+    copy = hash;
+    checkHash(copy);
+    testIterator(copy, false);
   }
-  if (xcount != hash.count()) fatal("(1.5) fuuuuuuuuuuuu");
-  checkHash();
-  testIterator(true);
+
+  printf("testing: removing with iterator\n");
+  for (auto it = hash.first(); it; ) {
+    const int k = it.getKey();
+    if (k%3 == 0) {
+      its[k] = -1;
+      --xcount;
+      it.removeCurrent();
+    } else {
+      ++it;
+    }
+  }
+  if (xcount != hash.count()) fatal("(3.0) invalid count");
+  checkHash(hash);
+  testIterator(hash, false);
 
   printf("testing: deletion\n");
   for (int i = 0; i < MaxItems*8; ++i) {
-    int v = rand()%MaxItems;
-    //writeln('trying to delete ', v, '; its[v]=', its[v]);
+    int v = (int)(prng()%MaxItems);
     bool del = hash.del(v);
-    //writeln('  del=', del);
     if (del) {
-      if (its[v] < 0) fatal("(2.0) fuuuuuuuuuuuu");
+      if (its[v] < 0) fatal("(2.0) deleted absent key");
       --xcount;
     } else {
-      if (its[v] >= 0) fatal("(2.1) fuuuuuuuuuuuu");
+      if (its[v] >= 0) fatal("(2.1) key not deleted");
     }
     its[v] = -1;
-    if (xcount != hash.count()) fatal("(2.2) fuuuuuuuuuuuu");
-    #ifdef EXCESSIVE_COMPACT
-    hash.compact();
-    if (xcount != hash.count()) fatal("(2.3) fuuuuuuuuuuuu");
-    #endif
-    #ifdef EXCESSIVE_CHECKS
-    checkHash();
-    #endif
-    #ifdef EXCESSIVE_CHECKS_ITERATOR
-    testIterator(false);
-    #endif
+    if (xcount != hash.count()) fatal("(2.2) invalid count");
+    if (optParanoid || (i&255) == 0) {
+      hash.compact();
+      if (xcount != hash.count()) fatal("(2.3) invalid count after compacting");
+    }
+    checkStep(hash, i);
     if (hash.count() == 0) break;
   }
 
   printf("testing: complete\n");
-  checkHash();
-  testIterator(true);
+  checkHash(hash);
+  testIterator(hash, true);
+}
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+// benchmarks
+struct BenchResult {
+  double insert, hit, miss, iterate, remove, churn; // in nanoseconds per operation
+  int64_t peakBytes;
+  int capacity;
+  vuint32 sink; // to prevent optimising things away
+};
+
+
+// keys are generated once, so both maps get the same work
+static int *benchIntKeys = nullptr;
+static int *benchIntMissKeys = nullptr;
+static void **benchPtrKeys = nullptr;
+static void **benchPtrMissKeys = nullptr;
+
+
+//==========================================================================
+//
+//  prepareKeys
+//
+//==========================================================================
+static void prepareKeys (int count) {
+  benchIntKeys = (int *)malloc(count*sizeof(int));
+  benchIntMissKeys = (int *)malloc(count*sizeof(int));
+  benchPtrKeys = (void **)malloc(count*sizeof(void *));
+  benchPtrMissKeys = (void **)malloc(count*sizeof(void *));
+  // unique keys: even numbers are present, odd are missing
+  for (int f = 0; f < count; ++f) {
+    benchIntKeys[f] = f*2;
+    benchIntMissKeys[f] = f*2+1;
+  }
+  // shuffle
+  for (int f = count-1; f > 0; --f) {
+    int n = (int)(prng()%(vuint32)(f+1));
+    int t = benchIntKeys[f]; benchIntKeys[f] = benchIntKeys[n]; benchIntKeys[n] = t;
+    n = (int)(prng()%(vuint32)(f+1));
+    t = benchIntMissKeys[f]; benchIntMissKeys[f] = benchIntMissKeys[n]; benchIntMissKeys[n] = t;
+  }
+  // pointers look like heap objects: 16-byte aligned, clustered
+  const size_t base = (size_t)0x7f0000100000ULL;
+  for (int f = 0; f < count; ++f) {
+    benchPtrKeys[f] = (void *)(base+(size_t)benchIntKeys[f]*0x110);
+    benchPtrMissKeys[f] = (void *)(base+(size_t)benchIntMissKeys[f]*0x110);
+  }
+}
+
+
+//==========================================================================
+//
+//  runBench
+//
+//==========================================================================
+template<class TM, class TK> static BenchResult runBench (const TK *keys, const TK *misskeys, int count) {
+  BenchResult res;
+  memset((void *)&res, 0, sizeof(res));
+  const double nsop = 1000000000.0/(double)count;
+
+  Z_ResetStats();
+  {
+    TM map;
+
+    double stt = getTime();
+    for (int f = 0; f < count; ++f) map.put(keys[f], f);
+    res.insert = (getTime()-stt)*nsop;
+
+    stt = getTime();
+    for (int f = 0; f < count; ++f) { const int *vp = map.find(keys[count-f-1]); res.sink += (vuint32)(vp ? *vp : 0); }
+    res.hit = (getTime()-stt)*nsop;
+
+    stt = getTime();
+    for (int f = 0; f < count; ++f) res.sink += (vuint32)map.has(misskeys[f]);
+    res.miss = (getTime()-stt)*nsop;
+
+    stt = getTime();
+    for (int n = 0; n < 4; ++n) {
+      for (auto &&it : map.first()) res.sink += (vuint32)it.getValue();
+    }
+    res.iterate = (getTime()-stt)*nsop/4.0;
+
+    res.capacity = map.capacity();
+    ZoneStats zs;
+    Z_GetStats(&zs);
+    res.peakBytes = zs.peakBytes;
+
+    // remove half of the keys
+    stt = getTime();
+    for (int f = 0; f < count; f += 2) res.sink += (vuint32)map.del(keys[f]);
+    res.remove = (getTime()-stt)*nsop*2.0;
+
+    // churn: the map stays at the same size, like thinker maps do
+    stt = getTime();
+    for (int f = 0; f < count; f += 2) {
+      map.put(keys[f], f);
+      res.sink += (vuint32)map.del(keys[f+1 < count ? f+1 : 0]);
+    }
+    res.churn = (getTime()-stt)*nsop*2.0;
+  }
+  return res;
+}
+
+
+//==========================================================================
+//
+//  printBench
+//
+//==========================================================================
+static void printBench (const char *name, const BenchResult &r, int count) {
+  printf("  %-22s %7.2f %7.2f %7.2f %7.2f %7.2f %7.2f  %9d KB (%5.1f bytes/item; capacity: %d)  [%08x]\n",
+    name, r.insert, r.hit, r.miss, r.iterate, r.remove, r.churn,
+    (int)(r.peakBytes/1024), (double)r.peakBytes/(double)count, r.capacity, r.sink);
+}
+
+
+//==========================================================================
+//
+//  runBenchmarks
+//
+//==========================================================================
+static void runBenchmarks (int count) {
+  prepareKeys(count);
+  Z_EnableStats(1);
+  printf("=== benchmarking with %d items (nanoseconds per operation) ===\n", count);
+  printf("  %-22s %7s %7s %7s %7s %7s %7s  %s\n", "map", "insert", "hit", "miss", "iter", "remove", "churn", "peak memory");
+  // run each benchmark twice, and report the second run, so allocator is warmed up
+  BenchResult r;
+  r = runBench<TMap<int, int>, int>(benchIntKeys, benchIntMissKeys, count);
+  r = runBench<TMap<int, int>, int>(benchIntKeys, benchIntMissKeys, count);
+  printBench("TMap<int>", r, count);
+  r = runBench<TSwissMap<int, int>, int>(benchIntKeys, benchIntMissKeys, count);
+  r = runBench<TSwissMap<int, int>, int>(benchIntKeys, benchIntMissKeys, count);
+  printBench("TSwissMap<int>", r, count);
+  r = runBench<TMap<void *, int>, void *>(benchPtrKeys, benchPtrMissKeys, count);
+  r = runBench<TMap<void *, int>, void *>(benchPtrKeys, benchPtrMissKeys, count);
+  printBench("TMap<ptr>", r, count);
+  r = runBench<TSwissMap<void *, int>, void *>(benchPtrKeys, benchPtrMissKeys, count);
+  r = runBench<TSwissMap<void *, int>, void *>(benchPtrKeys, benchPtrMissKeys, count);
+  printBench("TSwissMap<ptr>", r, count);
+  Z_EnableStats(0);
+}
+
+
+//==========================================================================
+//
+//  main
+//
+//==========================================================================
+int main (int argc, char **argv) {
+  bool doTests = true;
+  bool doBench = true;
+  int benchCount = 1000000;
+
+  for (int f = 1; f < argc; ++f) {
+    if (strcmp(argv[f], "-paranoid") == 0) { optParanoid = true; continue; }
+    if (strcmp(argv[f], "-notest") == 0) { doTests = false; continue; }
+    if (strcmp(argv[f], "-nobench") == 0) { doBench = false; continue; }
+    if (strcmp(argv[f], "-n") == 0 && f+1 < argc) { benchCount = atoi(argv[++f]); if (benchCount < 16) benchCount = 16; continue; }
+    if (strcmp(argv[f], "-seed") == 0 && f+1 < argc) { prngState = (vuint32)atoi(argv[++f]); if (!prngState) prngState = 1; continue; }
+    fprintf(stderr, "unknown option: '%s'\n", argv[f]);
+    return 1;
+  }
+
+  if (doTests) {
+    const vuint32 seed = prngState;
+    runTests<TMap<int, int> >("TMap");
+    prngState = seed;
+    runTests<TSwissMap<int, int> >("TSwissMap");
+  }
+
+  if (doBench) runBenchmarks(benchCount);
 
   return 0;
 }
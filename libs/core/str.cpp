@@ -551,6 +551,45 @@ VStr &VStr::makeImmutableRetSelf () noexcept {
 }
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+// key and value share the same immutable storage
+static TMap<VStr, VStr> vstrInternPool;
+static int vstrInternBytes = 0;
+static int vstrInternHits = 0;
+static mythread_mutex vstrInternLock;
+
+class VStr_Intern_Init_Class {
+public:
+  VStr_Intern_Init_Class (bool) {
+    mythread_mutex_init(&vstrInternLock);
+  }
+};
+
+__attribute__((used)) VStr_Intern_Init_Class vstr_intern_init_class_variable_(true);
+
+
+VStr VStr::intern (const char *s, int len) noexcept {
+  if (len < 0) len = (s ? (int)strlen(s) : 0);
+  if (len == 0) return VStr();
+  VStr key(s, len);
+  MyThreadLocker lock(&vstrInternLock);
+  VStr *res = vstrInternPool.get(key);
+  if (res) { ++vstrInternHits; return *res; }
+  key.makeImmutable();
+  vstrInternPool.put(key, key);
+  vstrInternBytes += len+1+(int)sizeof(Store);
+  return key;
+}
+
+
+void VStr::getInternStats (int *count, int *bytes, int *hits) noexcept {
+  MyThreadLocker lock(&vstrInternLock);
+  if (count) *count = vstrInternPool.length();
+  if (bytes) *bytes = vstrInternBytes;
+  if (hits) *hits = vstrInternHits;
+}
+
+
 void VStr::makeMutable () noexcept {
   if (!dataptr || atomicIsUnique() == 1) return; // nothing to do
   // allocate new string
@@ -567,9 +606,7 @@ void VStr::makeMutable () noexcept {
   // copy old data
   memcpy(dataptr, olddata, olen+1);
   //if (oldstore->rc > 0) --oldstore->rc; // decrement old refcounter
-  if (__atomic_load_n(&oldstore->rc, __ATOMIC_SEQ_CST) > 0) {
-    (void)__atomic_sub_fetch(&oldstore->rc, 1, __ATOMIC_SEQ_CST);
-  }
+  if (rcLoad(oldstore) > 0) (void)rcDec(oldstore);
 #ifdef VAVOOM_TEST_VSTR
   fprintf(stderr, "VStr: makeMutable: old=%p(%d); new=%p(%d)\n", oldstore+1, oldstore->rc, dataptr, newdata->rc);
 #endif
@@ -44,7 +44,7 @@ extern char *vavarg (const char *text, va_list ap) noexcept VVA_CHECKRESULT;
 //          make sure to `cloneUnique()` it, and pass to each thread its own VStr!
 class VStr {
 public:
-  struct __attribute__((packed)) Store {
+  struct Store {
     vint32 length;
     vint32 alloted;
     vint32 rc; // negative number means "immutable string"
@@ -52,6 +52,7 @@ public:
     vint32 dummy; // this is to get natural align on 8-byte boundary
   };
   static_assert(sizeof(Store) == 8*2, "invalid size for `VStr::Store` struct");
+  static_assert(alignof(Store) >= alignof(vint32), "invalid alignment for `VStr::Store` struct");
   static_assert(__builtin_offsetof(Store, rc)%8 == 0, "invalid rc alignent for `VStr::Store` struct");
 
   char *dataptr; // string, 0-terminated (0 is not in length); can be null
@@ -60,23 +61,31 @@ protected:
   VVA_CHECKRESULT inline Store *store () noexcept { return (dataptr ? (Store *)(dataptr-sizeof(Store)) : nullptr); }
   VVA_CHECKRESULT inline Store *store () const noexcept { return (dataptr ? (Store *)(dataptr-sizeof(Store)) : nullptr); }
 
+  // refcounter memory model is the one `std::shared_ptr` uses: increments are relaxed
+  // (you can only get a new reference from the existing one, so nothing to order),
+  // decrements are acq_rel (all uses of the data must happen before freeing it)
+  // strings are shared between threads (log, save writer, workers), so it is always atomic
+  static VVA_CHECKRESULT inline int rcLoad (const Store *st) noexcept { return __atomic_load_n(&st->rc, __ATOMIC_ACQUIRE); }
+  static inline void rcStore (Store *st, int newval) noexcept { __atomic_store_n(&st->rc, newval, __ATOMIC_RELEASE); }
+  static inline void rcInc (Store *st) noexcept { (void)__atomic_add_fetch(&st->rc, 1, __ATOMIC_RELAXED); }
+  static inline int rcDec (Store *st) noexcept { return __atomic_sub_fetch(&st->rc, 1, __ATOMIC_ACQ_REL); }
+
   // should be called only when storage is available
-  VVA_CHECKRESULT inline int atomicGetRC () const noexcept { return __atomic_load_n(&((const Store *)(dataptr-sizeof(Store)))->rc, __ATOMIC_SEQ_CST); }
+  VVA_CHECKRESULT inline int atomicGetRC () const noexcept { return rcLoad((Store *)(dataptr-sizeof(Store))); }
   // should be called only when storage is available
-  inline void atomicSetRC (int newval) noexcept { __atomic_store_n(&((Store *)(dataptr-sizeof(Store)))->rc, newval, __ATOMIC_SEQ_CST); }
+  inline void atomicSetRC (int newval) noexcept { rcStore((Store *)(dataptr-sizeof(Store)), newval); }
   // should be called only when storage is available
-  VVA_CHECKRESULT inline bool atomicIsImmutable () const noexcept { return (__atomic_load_n(&((const Store *)(dataptr-sizeof(Store)))->rc, __ATOMIC_SEQ_CST) < 0); }
+  VVA_CHECKRESULT inline bool atomicIsImmutable () const noexcept { return (rcLoad((Store *)(dataptr-sizeof(Store))) < 0); }
   // should be called only when storage is available
   // immutable strings aren't unique
-  VVA_CHECKRESULT inline bool atomicIsUnique () const noexcept { return (__atomic_load_n(&((const Store *)(dataptr-sizeof(Store)))->rc, __ATOMIC_SEQ_CST) == 1); }
+  VVA_CHECKRESULT inline bool atomicIsUnique () const noexcept { return (rcLoad((Store *)(dataptr-sizeof(Store))) == 1); }
   // should be called only when storage is available
-  // returns new value
   // WARNING: will happily modify immutable RC!
-  inline void atomicIncRC () const noexcept { (void)__atomic_add_fetch(&((Store *)(dataptr-sizeof(Store)))->rc, 1, __ATOMIC_SEQ_CST); }
+  inline void atomicIncRC () const noexcept { rcInc((Store *)(dataptr-sizeof(Store))); }
   // should be called only when storage is available
   // returns new value
   // WARNING: will happily modify immutable RC!
-  inline int atomicDecRC () const noexcept { return __atomic_sub_fetch(&((Store *)(dataptr-sizeof(Store)))->rc, 1, __ATOMIC_SEQ_CST); }
+  inline int atomicDecRC () const noexcept { return rcDec((Store *)(dataptr-sizeof(Store))); }
 
   VVA_CHECKRESULT inline char *getData () noexcept { return dataptr; }
   VVA_CHECKRESULT inline const char *getData () const noexcept { return dataptr; }
@@ -178,6 +187,12 @@ public:
   void makeImmutable () noexcept;
   VVA_CHECKRESULT VStr &makeImmutableRetSelf () noexcept;
 
+  // returns immutable string from the global intern pool; equal strings share the data
+  // interned strings are never freed, so use this only for things like VM literals
+  // the pool is locked, so this can be called from any thread
+  static VStr intern (const char *s, int len=-1) noexcept;
+  static void getInternStats (int *count, int *bytes, int *hits) noexcept;
+
   // clears the string
   inline void Clean () noexcept { decref(); }
   inline void Clear () noexcept { decref(); }
@@ -441,6 +441,22 @@ void Sys_FileDelete (VStr filename) {
 }
 
 
+//==========================================================================
+//
+//  Sys_FileRename
+//
+//  replaces existing destination file
+//
+//==========================================================================
+bool Sys_FileRename (VStr oldname, VStr newname) {
+  if (oldname.isEmpty() || newname.isEmpty()) return false;
+#ifdef ANDROID
+  if (isApkPath(oldname) || isApkPath(newname)) return false;
+#endif
+  return (rename(*oldname, *newname) == 0);
+}
+
+
 //==========================================================================
 //
 //  Sys_FileTime
@@ -913,6 +929,19 @@ void Sys_FileDelete (VStr filename) {
 }
 
 
+//==========================================================================
+//
+//  Sys_FileRename
+//
+//  replaces existing destination file
+//
+//==========================================================================
+bool Sys_FileRename (VStr oldname, VStr newname) {
+  if (oldname.isEmpty() || newname.isEmpty()) return false;
+  return (MoveFileEx(*oldname, *newname, MOVEFILE_REPLACE_EXISTING) != 0);
+}
+
+
 //==========================================================================
 //
 //  Sys_FileTime
@@ -43,6 +43,8 @@ int Sys_CurrFileTime (); // return current time in unix epoch
 bool Sys_CreateDirectory (VStr path);
 
 void Sys_FileDelete (VStr filename);
+// replaces existing `newname`; returns `false` on error
+bool Sys_FileRename (VStr oldname, VStr newname);
 
 // can return `nullptr` for invalid path
 void *Sys_OpenDir (VStr path, bool wantDirs=false); // nullptr: error
@@ -0,0 +1,324 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 2018-2021 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+#include "core.h"
+
+
+// each thread writes only to its own buffer, without locking. event is
+// "committed" by release store of `used`, so exporter can read committed
+// events at any time. the lock is taken only when a thread creates its
+// buffer, or resets it for a new trace (generation change), and by exporter.
+//
+// buffers are never freed, because thread-local pointers to them may
+// still be in use; event storage is reallocated only by the owner thread
+// (with the lock held), when the next trace wants different capacity.
+//
+enum {
+  TE_Zone,
+  TE_Counter,
+};
+
+struct TraceEvent {
+  const char *name;
+  vuint64 stime; // nanoseconds
+  union {
+    vuint64 dur; // zone duration, nanoseconds
+    double value; // counter value
+  };
+  vint32 type;
+};
+
+struct TraceThreadBuffer {
+  TraceThreadBuffer *next;
+  TraceEvent *events;
+  int capacity;
+  int used; // written only by the owner thread
+  vuint64 dropped;
+  vuint32 generation; // trace this buffer belongs to
+  int tid;
+  char name[64];
+};
+
+
+int VTrace::activeFlag = 0;
+
+static mythread_mutex traceLock;
+static bool traceLockInited = false;
+static TraceThreadBuffer *traceBuffers = nullptr;
+static int traceThreadCount = 0;
+static vuint32 traceGeneration = 0;
+static int traceCapacity = VTrace::DefaultCapacity;
+static vuint64 traceStartTime = 0;
+static vuint64 traceStopTime = 0;
+static thread_local TraceThreadBuffer *traceLocalBuffer = nullptr;
+static thread_local char traceLocalName[64] = {0};
+
+
+//==========================================================================
+//
+//  traceCopyName
+//
+//==========================================================================
+static void traceCopyName (char *dest, const char *name) noexcept {
+  size_t len = (name ? strlen(name) : 0);
+  if (len > 63) len = 63;
+  if (len) memcpy(dest, name, len);
+  dest[len] = 0;
+}
+
+
+//==========================================================================
+//
+//  traceGetLocalBuffer
+//
+//  returns buffer for the current trace
+//
+//==========================================================================
+static TraceThreadBuffer *traceGetLocalBuffer () noexcept {
+  TraceThreadBuffer *buf = traceLocalBuffer;
+  if (buf && buf->generation == __atomic_load_n(&traceGeneration, __ATOMIC_ACQUIRE)) return buf;
+  MyThreadLocker lock(&traceLock);
+  if (!buf) {
+    buf = (TraceThreadBuffer *)Z_Calloc(sizeof(TraceThreadBuffer));
+    buf->tid = ++traceThreadCount;
+    if (traceLocalName[0]) {
+      traceCopyName(buf->name, traceLocalName);
+    } else {
+      snprintf(buf->name, sizeof(buf->name), "thread #%d", buf->tid);
+    }
+    buf->next = traceBuffers;
+    traceBuffers = buf;
+    traceLocalBuffer = buf;
+  }
+  if (buf->capacity != traceCapacity) {
+    Z_Free(buf->events);
+    buf->events = (TraceEvent *)Z_Malloc(traceCapacity*(int)sizeof(TraceEvent));
+    buf->capacity = traceCapacity;
+  }
+  buf->used = 0;
+  buf->dropped = 0;
+  buf->generation = traceGeneration;
+  return buf;
+}
+
+
+//==========================================================================
+//
+//  traceAppendEvent
+//
+//  returns `nullptr` if the buffer is full
+//
+//==========================================================================
+static inline TraceEvent *traceAppendEvent (TraceThreadBuffer *buf) noexcept {
+  if (buf->used >= buf->capacity) {
+    __atomic_add_fetch(&buf->dropped, 1, __ATOMIC_RELAXED);
+    return nullptr;
+  }
+  return &buf->events[buf->used];
+}
+
+
+//==========================================================================
+//
+//  VTrace::Start
+//
+//==========================================================================
+void VTrace::Start (int capacity) noexcept {
+  //WARNING! THIS IS NOT THREAD-SAFE! (but it is called only from the main thread)
+  if (!traceLockInited) {
+    traceLockInited = true;
+    mythread_mutex_init(&traceLock);
+  }
+  MyThreadLocker lock(&traceLock);
+  if (capacity <= 0) capacity = DefaultCapacity;
+  traceCapacity = clampval(capacity, 1024, 0x1fffffff/(int)sizeof(TraceEvent));
+  traceStartTime = Sys_GetTimeNano();
+  traceStopTime = 0;
+  // all threads will reset their buffers on the next event
+  __atomic_store_n(&traceGeneration, traceGeneration+1, __ATOMIC_RELEASE);
+  __atomic_store_n(&activeFlag, 1, __ATOMIC_RELEASE);
+}
+
+
+//==========================================================================
+//
+//  VTrace::Stop
+//
+//==========================================================================
+void VTrace::Stop () noexcept {
+  if (!IsActive()) return;
+  __atomic_store_n(&activeFlag, 0, __ATOMIC_RELEASE);
+  MyThreadLocker lock(&traceLock);
+  traceStopTime = Sys_GetTimeNano();
+}
+
+
+//==========================================================================
+//
+//  VTrace::SetThreadName
+//
+//==========================================================================
+void VTrace::SetThreadName (const char *name) noexcept {
+  traceCopyName(traceLocalName, name);
+  TraceThreadBuffer *buf = traceLocalBuffer;
+  if (buf) {
+    // buffer exists, so the lock is initialised
+    MyThreadLocker lock(&traceLock);
+    traceCopyName(buf->name, name);
+  }
+}
+
+
+//==========================================================================
+//
+//  VTrace::RecordZone
+//
+//==========================================================================
+void VTrace::RecordZone (const char *name, vuint64 stime, vuint64 etime) noexcept {
+  if (!IsActive()) return;
+  TraceThreadBuffer *buf = traceGetLocalBuffer();
+  TraceEvent *ev = traceAppendEvent(buf);
+  if (!ev) return;
+  ev->name = name;
+  ev->stime = stime;
+  ev->dur = (etime > stime ? etime-stime : 0);
+  ev->type = TE_Zone;
+  __atomic_store_n(&buf->used, buf->used+1, __ATOMIC_RELEASE);
+}
+
+
+//==========================================================================
+//
+//  VTrace::RecordCounter
+//
+//==========================================================================
+void VTrace::RecordCounter (const char *name, double value) noexcept {
+  if (!IsActive()) return;
+  TraceThreadBuffer *buf = traceGetLocalBuffer();
+  TraceEvent *ev = traceAppendEvent(buf);
+  if (!ev) return;
+  ev->name = name;
+  ev->stime = Sys_GetTimeNano();
+  ev->value = value;
+  ev->type = TE_Counter;
+  __atomic_store_n(&buf->used, buf->used+1, __ATOMIC_RELEASE);
+}
+
+
+//==========================================================================
+//
+//  traceEscapeName
+//
+//  escapes string for JSON; result is truncated to fit
+//
+//==========================================================================
+static void traceEscapeName (char *dest, size_t destsize, const char *s) noexcept {
+  size_t pos = 0;
+  if (!s) s = "<null>";
+  while (*s && pos+7 < destsize) {
+    const vuint8 ch = (vuint8)(*s++);
+    if (ch == '"' || ch == '\\') {
+      dest[pos++] = '\\';
+      dest[pos++] = (char)ch;
+    } else if (ch < 32) {
+      pos += (size_t)snprintf(dest+pos, destsize-pos, "\\u%04x", (unsigned)ch);
+    } else {
+      dest[pos++] = (char)ch;
+    }
+  }
+  dest[pos] = 0;
+}
+
+
+//==========================================================================
+//
+//  VTrace::ExportChrome
+//
+//==========================================================================
+bool VTrace::ExportChrome (VStream *strm) {
+  if (!strm) return false;
+  char line[512];
+  char ename[160];
+  bool first = true;
+
+  auto put = [&strm, &first, &line] () {
+    if (!first) strm->Serialise(",\n", 2);
+    first = false;
+    strm->Serialise(line, (int)strlen(line));
+  };
+
+  strm->Serialise("{\"traceEvents\":[\n", 17);
+  if (traceLockInited) {
+    MyThreadLocker lock(&traceLock);
+    const vuint64 stt = traceStartTime;
+    for (TraceThreadBuffer *buf = traceBuffers; buf; buf = buf->next) {
+      if (buf->generation != traceGeneration) continue;
+      const int used = __atomic_load_n(&buf->used, __ATOMIC_ACQUIRE);
+      traceEscapeName(ename, sizeof(ename), buf->name);
+      snprintf(line, sizeof(line), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", buf->tid, ename);
+      put();
+      snprintf(line, sizeof(line), "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"sort_index\":%d}}", buf->tid, buf->tid);
+      put();
+      for (int f = 0; f < used; ++f) {
+        const TraceEvent &ev = buf->events[f];
+        // zone may be started before this trace
+        if (ev.stime < stt) continue;
+        traceEscapeName(ename, sizeof(ename), ev.name);
+        const double ts = (double)(ev.stime-stt)/1000.0; // in microseconds
+        if (ev.type == TE_Zone) {
+          snprintf(line, sizeof(line), "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", ename, buf->tid, ts, (double)ev.dur/1000.0);
+        } else {
+          snprintf(line, sizeof(line), "{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"value\":%.17g}}", ename, buf->tid, ts, (isfinite(ev.value) ? ev.value : 0.0));
+        }
+        put();
+        if (strm->IsError()) return false;
+      }
+    }
+  }
+  strm->Serialise("\n],\"displayTimeUnit\":\"ms\"}\n", 27);
+  return !strm->IsError();
+}
+
+
+//==========================================================================
+//
+//  VTrace::GetStats
+//
+//==========================================================================
+void VTrace::GetStats (VTraceStats *stats) noexcept {
+  if (!stats) return;
+  memset((void *)stats, 0, sizeof(VTraceStats));
+  stats->active = IsActive();
+  if (!traceLockInited) return;
+  MyThreadLocker lock(&traceLock);
+  stats->capacity = traceCapacity;
+  for (TraceThreadBuffer *buf = traceBuffers; buf; buf = buf->next) {
+    if (buf->generation != traceGeneration) continue;
+    ++stats->threads;
+    stats->events += (vuint64)__atomic_load_n(&buf->used, __ATOMIC_ACQUIRE);
+    stats->dropped += __atomic_load_n(&buf->dropped, __ATOMIC_RELAXED);
+  }
+  const vuint64 ett = (traceStopTime ? traceStopTime : Sys_GetTimeNano());
+  stats->duration = (traceStartTime && ett > traceStartTime ? (double)(ett-traceStartTime)/1000000000.0 : 0.0);
+}
@@ -0,0 +1,119 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 2018-2021 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  scoped timing zones and counters
+//**
+//**  zones and counters are recorded into per-thread buffers while the
+//**  trace is active, and can be exported as Chrome trace JSON (open it
+//**  with "chrome://tracing" or Perfetto UI).
+//**
+//**  when the trace is not active, a zone costs one relaxed load.
+//**
+//**  zone and counter names are not copied, so they should be string
+//**  literals (or other strings that live forever).
+//**
+//**************************************************************************
+
+// trace statistics
+struct VTraceStats {
+  bool active;
+  int threads; // threads that recorded something
+  int capacity; // maximum number of events per thread
+  vuint64 events; // recorded events
+  vuint64 dropped; // events dropped because thread buffer was full
+  double duration; // seconds since trace start (or trace length, if stopped)
+};
+
+
+//==========================================================================
+//
+//  VTrace
+//
+//==========================================================================
+class VTrace {
+public:
+  enum { DefaultCapacity = 262144 };
+
+private:
+  static int activeFlag;
+
+public:
+  static inline bool IsActive () noexcept { return __atomic_load_n(&activeFlag, __ATOMIC_RELAXED); }
+
+  // starts new trace, discarding old events; `capacity` is number of events per thread
+  static void Start (int capacity=0) noexcept;
+  // stops recording; recorded events are kept until next `Start()`
+  static void Stop () noexcept;
+
+  // sets name of the current thread (shown in the trace viewer)
+  static void SetThreadName (const char *name) noexcept;
+
+  // zone times are from `Sys_GetTimeNano()`
+  static void RecordZone (const char *name, vuint64 stime, vuint64 etime) noexcept;
+  static void RecordCounter (const char *name, double value) noexcept;
+
+  // writes recorded events as Chrome trace JSON
+  // it is better to do this when the trace is stopped, but it is safe anyway
+  // returns `false` on stream error
+  static bool ExportChrome (VStream *strm);
+
+  static void GetStats (VTraceStats *stats) noexcept;
+};
+
+
+//==========================================================================
+//
+//  VTraceZone
+//
+//==========================================================================
+class VTraceZone {
+private:
+  const char *name; // `nullptr` if the trace was not active on zone start
+  vuint64 stime;
+
+public:
+  VV_DISABLE_COPY(VTraceZone)
+
+  inline VTraceZone (const char *aname) noexcept : name(nullptr), stime(0) {
+    if (VTrace::IsActive()) {
+      name = aname;
+      stime = Sys_GetTimeNano();
+    }
+  }
+
+  inline ~VTraceZone () noexcept {
+    if (name) VTrace::RecordZone(name, stime, Sys_GetTimeNano());
+  }
+};
+
+
+#define VTRACE_ZONE_NAME_HELPER2(line_)  vtrace_zone_##line_
+#define VTRACE_ZONE_NAME_HELPER1(line_)  VTRACE_ZONE_NAME_HELPER2(line_)
+
+// times the rest of the current scope
+#define VTRACE_ZONE(name_)  VTraceZone VTRACE_ZONE_NAME_HELPER1(__LINE__)(name_)
+
+// records counter value; `value_` is not evaluated if the trace is not active
+#define VTRACE_COUNTER(name_,value_)  do { if (VTrace::IsActive()) VTrace::RecordCounter((name_), (double)(value_)); } while (0)
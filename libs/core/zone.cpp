@@ -29,6 +29,13 @@
 //**************************************************************************
 //#include "mimalloc/mimalloc.h"
 #include "core.h"
+#if !defined(VAVOOM_USE_MIMALLOC) && (defined(__GLIBC__) || defined(_WIN32))
+# include <malloc.h>
+#endif
+#if !defined(_WIN32)
+# include <dlfcn.h>
+# include <cxxabi.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -47,6 +54,67 @@ static volatile bool zShuttingDown = false;
 #endif
 
 
+static volatile int zStatsEnabled = 0;
+static ZoneStats zStats;
+
+
+// returns 0 if allocator cannot tell block size
+static inline size_t zBlockSize (void *ptr) noexcept {
+  if (!ptr) return 0;
+#if defined(VAVOOM_USE_MIMALLOC)
+  return ::mi_usable_size(ptr);
+#elif defined(__GLIBC__)
+  return ::malloc_usable_size(ptr);
+#elif defined(_WIN32)
+  return ::_msize(ptr);
+#else
+  return 0;
+#endif
+}
+
+
+static void zStatsAdd (void *oldptr, void *newptr, size_t oldsize, uint64_t *counter) noexcept {
+  const size_t newsize = zBlockSize(newptr);
+  __atomic_add_fetch(counter, 1, __ATOMIC_RELAXED);
+  if (newsize > oldsize || !oldptr) __atomic_add_fetch(&zStats.allocBytes, (uint64_t)newsize, __ATOMIC_RELAXED);
+  const int64_t live = __atomic_add_fetch(&zStats.liveBytes, (int64_t)newsize-(int64_t)oldsize, __ATOMIC_RELAXED);
+  int64_t peak = __atomic_load_n(&zStats.peakBytes, __ATOMIC_RELAXED);
+  while (live > peak && !__atomic_compare_exchange_n(&zStats.peakBytes, &peak, live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+
+static void zStatsFree (size_t oldsize) noexcept {
+  __atomic_add_fetch(&zStats.freeCount, 1, __ATOMIC_RELAXED);
+  __atomic_sub_fetch(&zStats.liveBytes, (int64_t)oldsize, __ATOMIC_RELAXED);
+}
+
+
+void Z_EnableStats (int enable) noexcept {
+  __atomic_store_n(&zStatsEnabled, (enable ? 1 : 0), __ATOMIC_SEQ_CST);
+}
+
+
+void Z_ResetStats () noexcept {
+  __atomic_store_n(&zStats.allocCount, 0, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&zStats.reallocCount, 0, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&zStats.freeCount, 0, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&zStats.allocBytes, 0, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&zStats.liveBytes, 0, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&zStats.peakBytes, 0, __ATOMIC_SEQ_CST);
+}
+
+
+void Z_GetStats (ZoneStats *stats) noexcept {
+  if (!stats) return;
+  stats->allocCount = __atomic_load_n(&zStats.allocCount, __ATOMIC_SEQ_CST);
+  stats->reallocCount = __atomic_load_n(&zStats.reallocCount, __ATOMIC_SEQ_CST);
+  stats->freeCount = __atomic_load_n(&zStats.freeCount, __ATOMIC_SEQ_CST);
+  stats->allocBytes = __atomic_load_n(&zStats.allocBytes, __ATOMIC_SEQ_CST);
+  stats->liveBytes = __atomic_load_n(&zStats.liveBytes, __ATOMIC_SEQ_CST);
+  stats->peakBytes = __atomic_load_n(&zStats.peakBytes, __ATOMIC_SEQ_CST);
+}
+
+
 static inline void ZManDeactivate () noexcept {
 #ifdef VAVOOM_USE_MIMALLOC
   __atomic_store_n(&zShuttingDown, true, __ATOMIC_SEQ_CST);
@@ -76,6 +144,364 @@ static inline bool isZManActive () noexcept {
 #endif
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+// sampling allocation profiler
+//
+// all profiler tables are allocated directly with `malloc_fn`, so profiler
+// never recurses into itself. sampled blocks are kept in a hash table keyed
+// by block address; to avoid locking on each free, a counting filter tells
+// if the block may be in the table.
+//
+enum {
+  ZProfMaxSites = 16384, // power of 2; site 0 collects everything that doesn't fit
+  ZProfLiveBuckets = 65536, // power of 2
+  ZProfFilterSize = 65536, // power of 2
+  ZProfLiveChunkSize = 4096,
+};
+
+struct ZProfSite {
+  const void *addr; // `nullptr` means "free slot"
+  void *vmframes[ZPROF_VM_FRAMES];
+  uint64_t allocs; // sampled
+  uint64_t bytes; // sampled
+  uint64_t markAllocs[2]; // `allocs` at the last tick/period mark
+  uint64_t markBytes[2];
+  int64_t liveCount;
+  int64_t liveBytes;
+};
+
+struct ZProfLive {
+  ZProfLive *next;
+  void *ptr;
+  size_t size;
+  uint32_t site;
+};
+
+struct ZProfLiveChunk {
+  ZProfLiveChunk *next;
+  ZProfLive nodes[ZProfLiveChunkSize];
+};
+
+static volatile int zProfActive = 0;
+static int zProfRate = 1;
+static mythread_mutex zProfLock;
+static ZProfSite *zProfSites = nullptr;
+static int zProfSiteCount = 0;
+static ZProfLive **zProfLiveBuckets = nullptr;
+static uint32_t *zProfFilter = nullptr;
+static ZProfLiveChunk *zProfLiveChunks = nullptr;
+static ZProfLive *zProfLiveFree = nullptr;
+static ZProfVMStackFn zProfVMStack = nullptr;
+static ZProfVMNameFn zProfVMName = nullptr;
+
+static thread_local int zProfCountdown = 0;
+static thread_local bool zProfInside = false; // to ignore allocations from VM hooks and such
+static thread_local bool zProfVMThread = false;
+
+
+class ZProf_Init_Class {
+public:
+  ZProf_Init_Class (bool) {
+    mythread_mutex_init(&zProfLock);
+  }
+};
+
+__attribute__((used)) ZProf_Init_Class zprof_init_class_variable_(true);
+
+
+static inline uint32_t zProfPtrHash (const void *ptr) noexcept {
+  uint64_t h = (uint64_t)(uintptr_t)ptr;
+  h = (h>>4)*0x9e3779b97f4a7c15ull;
+  return (uint32_t)(h>>32);
+}
+
+
+// should be called with locked mutex
+// returns site index; site 0 is used if the table is full
+static uint32_t zProfFindSite (const void *addr, void *const *frames) noexcept {
+  uint64_t h = (uint64_t)(uintptr_t)addr;
+  for (int f = 0; f < ZPROF_VM_FRAMES; ++f) h = (h^(uint64_t)(uintptr_t)frames[f])*0x9e3779b97f4a7c15ull;
+  uint32_t idx = (uint32_t)(h>>32)&(ZProfMaxSites-1);
+  // table is never more than 3/4 full, so there is always a free slot
+  for (;;) {
+    if (idx == 0) idx = 1;
+    ZProfSite *site = &zProfSites[idx];
+    if (!site->addr) {
+      if (zProfSiteCount >= ZProfMaxSites/4*3) return 0;
+      ++zProfSiteCount;
+      site->addr = addr;
+      memcpy(site->vmframes, frames, sizeof(site->vmframes));
+      return idx;
+    }
+    if (site->addr == addr && memcmp(site->vmframes, frames, sizeof(site->vmframes)) == 0) return idx;
+    idx = (idx+1)&(ZProfMaxSites-1);
+  }
+}
+
+
+// should be called with locked mutex
+static ZProfLive *zProfNewLiveNode () noexcept {
+  if (!zProfLiveFree) {
+    ZProfLiveChunk *chunk = (ZProfLiveChunk *)malloc_fn(sizeof(ZProfLiveChunk));
+    if (!chunk) return nullptr;
+    chunk->next = zProfLiveChunks;
+    zProfLiveChunks = chunk;
+    for (int f = ZProfLiveChunkSize-1; f >= 0; --f) {
+      chunk->nodes[f].next = zProfLiveFree;
+      zProfLiveFree = &chunk->nodes[f];
+    }
+  }
+  ZProfLive *node = zProfLiveFree;
+  zProfLiveFree = node->next;
+  return node;
+}
+
+
+// called after allocation or reallocation
+static void zProfAlloc (void *ptr, size_t size, const void *addr) noexcept {
+  if (zProfInside || !ptr) return;
+  if (--zProfCountdown > 0) return;
+  zProfCountdown = __atomic_load_n(&zProfRate, __ATOMIC_RELAXED);
+  zProfInside = true;
+  void *frames[ZPROF_VM_FRAMES];
+  memset((void *)frames, 0, sizeof(frames));
+  if (zProfVMThread && zProfVMStack) zProfVMStack(frames, ZPROF_VM_FRAMES);
+  {
+    MyThreadLocker lock(&zProfLock);
+    const uint32_t sidx = zProfFindSite(addr, frames);
+    ZProfSite *site = &zProfSites[sidx];
+    ++site->allocs;
+    site->bytes += size;
+    ZProfLive *node = zProfNewLiveNode();
+    if (node) {
+      const uint32_t h = zProfPtrHash(ptr);
+      node->ptr = ptr;
+      node->size = size;
+      node->site = sidx;
+      node->next = zProfLiveBuckets[h&(ZProfLiveBuckets-1)];
+      zProfLiveBuckets[h&(ZProfLiveBuckets-1)] = node;
+      __atomic_add_fetch(&zProfFilter[(h>>16)&(ZProfFilterSize-1)], 1, __ATOMIC_RELAXED);
+      ++site->liveCount;
+      site->liveBytes += (int64_t)size;
+    }
+  }
+  zProfInside = false;
+}
+
+
+// called before the block is freed or reallocated
+static void zProfFree (void *ptr) noexcept {
+  if (!ptr) return;
+  const uint32_t h = zProfPtrHash(ptr);
+  if (!__atomic_load_n(&zProfFilter[(h>>16)&(ZProfFilterSize-1)], __ATOMIC_RELAXED)) return;
+  MyThreadLocker lock(&zProfLock);
+  ZProfLive **pp = &zProfLiveBuckets[h&(ZProfLiveBuckets-1)];
+  while (*pp) {
+    ZProfLive *node = *pp;
+    if (node->ptr == ptr) {
+      *pp = node->next;
+      ZProfSite *site = &zProfSites[node->site];
+      --site->liveCount;
+      site->liveBytes -= (int64_t)node->size;
+      __atomic_sub_fetch(&zProfFilter[(h>>16)&(ZProfFilterSize-1)], 1, __ATOMIC_RELAXED);
+      node->next = zProfLiveFree;
+      zProfLiveFree = node;
+      return;
+    }
+    pp = &node->next;
+  }
+}
+
+
+void Z_ProfSetVMHooks (ZProfVMStackFn stackfn, ZProfVMNameFn namefn) noexcept {
+  zProfVMStack = stackfn;
+  zProfVMName = namefn;
+  zProfVMThread = true;
+}
+
+
+void Z_ProfStart (int rate) noexcept {
+  {
+    MyThreadLocker lock(&zProfLock);
+    if (!zProfSites) {
+      zProfSites = (ZProfSite *)malloc_fn(ZProfMaxSites*sizeof(ZProfSite));
+      zProfLiveBuckets = (ZProfLive **)malloc_fn(ZProfLiveBuckets*sizeof(ZProfLive *));
+      zProfFilter = (uint32_t *)malloc_fn(ZProfFilterSize*sizeof(uint32_t));
+      if (!zProfSites || !zProfLiveBuckets || !zProfFilter) Sys_Error("out of memory for allocation profiler!");
+    }
+    memset((void *)zProfSites, 0, ZProfMaxSites*sizeof(ZProfSite));
+    memset((void *)zProfLiveBuckets, 0, ZProfLiveBuckets*sizeof(ZProfLive *));
+    memset((void *)zProfFilter, 0, ZProfFilterSize*sizeof(uint32_t));
+    zProfSiteCount = 0;
+    // free all live nodes
+    zProfLiveFree = nullptr;
+    while (zProfLiveChunks) {
+      ZProfLiveChunk *chunk = zProfLiveChunks;
+      zProfLiveChunks = chunk->next;
+      free_fn(chunk);
+    }
+    __atomic_store_n(&zProfRate, (rate > 0 ? rate : 1), __ATOMIC_RELAXED);
+  }
+  __atomic_store_n(&zProfActive, 1, __ATOMIC_RELEASE);
+}
+
+
+void Z_ProfStop () noexcept {
+  __atomic_store_n(&zProfActive, 0, __ATOMIC_RELEASE);
+}
+
+
+int Z_ProfIsActive () noexcept {
+  return __atomic_load_n(&zProfActive, __ATOMIC_RELAXED);
+}
+
+
+int Z_ProfGetRate () noexcept {
+  return __atomic_load_n(&zProfRate, __ATOMIC_RELAXED);
+}
+
+
+void Z_ProfMark (int what) noexcept {
+  if (what != ZPROF_TICK && what != ZPROF_PERIOD) return;
+  if (!zProfSites) return;
+  const int midx = (what == ZPROF_TICK ? 0 : 1);
+  MyThreadLocker lock(&zProfLock);
+  for (int f = 0; f < ZProfMaxSites; ++f) {
+    ZProfSite *site = &zProfSites[f];
+    if (!site->allocs) continue;
+    site->markAllocs[midx] = site->allocs;
+    site->markBytes[midx] = site->bytes;
+  }
+}
+
+
+// site name for the report: module+offset (symbol)
+static void zProfSiteName (const void *addr, char *dest, size_t destsize) noexcept {
+  if (!addr) {
+    snprintf(dest, destsize, "<other sites>");
+    return;
+  }
+#if !defined(_WIN32)
+  Dl_info info;
+  // return address points after the call, so look for the call instruction
+  if (dladdr((const void *)((uintptr_t)addr-1), &info) && info.dli_fname) {
+    const char *mod = strrchr(info.dli_fname, '/');
+    mod = (mod ? mod+1 : info.dli_fname);
+    const unsigned ofs = (unsigned)((uintptr_t)addr-(uintptr_t)info.dli_fbase);
+    if (info.dli_sname) {
+      int status = -1;
+      char *dmname = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+      snprintf(dest, destsize, "%s+0x%x (%s)", mod, ofs, (status == 0 && dmname ? dmname : info.dli_sname));
+      ::free(dmname); // allocated with libc `malloc()`
+    } else {
+      snprintf(dest, destsize, "%s+0x%x", mod, ofs);
+    }
+    return;
+  }
+#endif
+  snprintf(dest, destsize, "%p", addr);
+}
+
+
+struct ZProfReport {
+  const void *addr;
+  void *vmframes[ZPROF_VM_FRAMES];
+  uint64_t allocs;
+  uint64_t bytes;
+  int64_t liveCount;
+  int64_t liveBytes;
+};
+
+
+static int zProfReportCmp (const void *aa, const void *bb, void *udata) {
+  const ZProfReport *a = (const ZProfReport *)aa;
+  const ZProfReport *b = (const ZProfReport *)bb;
+  if (udata) {
+    // by live bytes
+    if (a->liveBytes != b->liveBytes) return (a->liveBytes > b->liveBytes ? -1 : 1);
+  } else {
+    if (a->bytes != b->bytes) return (a->bytes > b->bytes ? -1 : 1);
+    if (a->allocs != b->allocs) return (a->allocs > b->allocs ? -1 : 1);
+  }
+  return 0;
+}
+
+
+void Z_ProfDump (int what, int topCount, const char *title) noexcept {
+  if (topCount <= 0 || !zProfSites) return;
+  if (what < ZPROF_TOTAL || what > ZPROF_PERIOD) return;
+  // collect sites under the lock, and log them without it, because logger allocates
+  ZProfReport *list = (ZProfReport *)malloc_fn(ZProfMaxSites*sizeof(ZProfReport));
+  if (!list) return;
+  int count = 0;
+  uint64_t totalAllocs = 0, totalBytes = 0;
+  int64_t totalLive = 0;
+  {
+    MyThreadLocker lock(&zProfLock);
+    for (int f = 0; f < ZProfMaxSites; ++f) {
+      const ZProfSite *site = &zProfSites[f];
+      if (!site->allocs) continue;
+      ZProfReport *rep = &list[count];
+      rep->allocs = site->allocs;
+      rep->bytes = site->bytes;
+      if (what == ZPROF_TICK || what == ZPROF_PERIOD) {
+        const int midx = (what == ZPROF_TICK ? 0 : 1);
+        rep->allocs -= site->markAllocs[midx];
+        rep->bytes -= site->markBytes[midx];
+      }
+      rep->liveCount = site->liveCount;
+      rep->liveBytes = site->liveBytes;
+      totalAllocs += rep->allocs;
+      totalBytes += rep->bytes;
+      totalLive += rep->liveBytes;
+      if (what == ZPROF_LIVE ? rep->liveCount <= 0 : rep->allocs == 0) continue;
+      rep->addr = site->addr;
+      memcpy(rep->vmframes, site->vmframes, sizeof(rep->vmframes));
+      ++count;
+    }
+  }
+
+  if (count == 0 && (what == ZPROF_TICK || what == ZPROF_PERIOD)) {
+    free_fn(list);
+    return;
+  }
+
+  timsort_r(list, (size_t)count, sizeof(ZProfReport), &zProfReportCmp, (what == ZPROF_LIVE ? (void *)list : nullptr));
+
+  static const char *whatNames[4] = { "total", "live", "tick", "period" };
+  const uint64_t rate = (uint64_t)Z_ProfGetRate();
+  GLog.Logf("allocation profile (%s, %s): ~%u allocations, ~%u KB; ~%u KB live in sampled blocks; 1/%u sampled",
+    (title && title[0] ? title : "zone"), whatNames[what], (unsigned)(totalAllocs*rate),
+    (unsigned)(totalBytes*rate/1024), (unsigned)(totalLive > 0 ? (uint64_t)totalLive*rate/1024 : 0), (unsigned)rate);
+
+  char sname[384];
+  char vmnames[256];
+  char fname[128];
+  for (int f = 0; f < count && f < topCount; ++f) {
+    const ZProfReport *rep = &list[f];
+    zProfSiteName(rep->addr, sname, sizeof(sname));
+    vmnames[0] = 0;
+    if (zProfVMName) {
+      for (int fidx = 0; fidx < ZPROF_VM_FRAMES && rep->vmframes[fidx]; ++fidx) {
+        zProfVMName(rep->vmframes[fidx], fname, sizeof(fname));
+        const size_t vlen = strlen(vmnames);
+        snprintf(vmnames+vlen, sizeof(vmnames)-vlen, "%s%s", (fidx ? " <- " : "  [vm: "), fname);
+      }
+      if (vmnames[0]) {
+        const size_t vlen = strlen(vmnames);
+        snprintf(vmnames+vlen, sizeof(vmnames)-vlen, "]");
+      }
+    }
+    GLog.Logf("  %8u KB %8u allocs  live: %8u KB %6u blocks  %s%s",
+      (unsigned)(rep->bytes*rate/1024), (unsigned)(rep->allocs*rate),
+      (unsigned)(rep->liveBytes > 0 ? (uint64_t)rep->liveBytes*rate/1024 : 0),
+      (unsigned)(rep->liveCount > 0 ? (uint64_t)rep->liveCount*rate : 0),
+      sname, vmnames);
+  }
+  free_fn(list);
+}
+
+
 const char *Z_GetAllocatorType () noexcept {
 #ifdef VAVOOM_USE_MIMALLOC
   return "mi-malloc";
@@ -93,6 +519,8 @@ void *Z_Malloc (size_t size) noexcept {
   void *res = malloc_fn(size > 0 ? size : size+1);
   if (!res) Sys_Error("out of memory for %u bytes!", (unsigned int)size);
   memset(res, 0, size+(size ? 0 : 1)); // just in case
+  if (__atomic_load_n(&zStatsEnabled, __ATOMIC_RELAXED)) zStatsAdd(nullptr, res, 0, &zStats.allocCount);
+  if (__atomic_load_n(&zProfActive, __ATOMIC_RELAXED)) zProfAlloc(res, size, __builtin_return_address(0));
   return res;
 }
 
@@ -104,19 +532,29 @@ __attribute__((alloc_size(2))) void *Z_Realloc (void *ptr, size_t size) noexcept
 #ifdef VAVOOM_USE_MIMALLOC
   if (size == 0 && !isZManActive()) return nullptr; // don't bother
 #endif
+  const bool stats = __atomic_load_n(&zStatsEnabled, __ATOMIC_RELAXED);
+  const size_t oldsize = (stats ? zBlockSize(ptr) : 0);
+  // old block should be forgotten before it is released, because other thread may get the same address
+  const bool prof = __atomic_load_n(&zProfActive, __ATOMIC_RELAXED);
+  if (prof) zProfFree(ptr);
   if (size) {
     void *res = realloc_fn(ptr, size);
     if (!res) Sys_Error("out of memory for %u bytes!", (unsigned int)size);
+    if (stats) zStatsAdd(ptr, res, oldsize, (ptr ? &zStats.reallocCount : &zStats.allocCount));
+    if (prof) zProfAlloc(res, size, __builtin_return_address(0));
     return res;
   } else {
-    if (ptr) free_fn(ptr);
+    if (ptr) {
+      free_fn(ptr);
+      if (stats) zStatsFree(oldsize);
+    }
     return nullptr;
   }
 }
 
 
-__attribute__((malloc)) __attribute__((alloc_size(1))) __attribute__((returns_nonnull))
-void *Z_Calloc (size_t size) noexcept {
+// `addr` is call site for allocation profiler
+static inline void *zCallocInternal (size_t size, const void *addr) noexcept {
 #if !defined(VAVOOM_USE_MIMALLOC)
   void *res = ::calloc(1, (size > 0 ? size : 1));
 #else
@@ -126,17 +564,29 @@ void *Z_Calloc (size_t size) noexcept {
 #if !defined(VAVOOM_USE_MIMALLOC)
   memset(res, 0, size+(size ? 0 : 1)); // just in case
 #endif
+  if (__atomic_load_n(&zStatsEnabled, __ATOMIC_RELAXED)) zStatsAdd(nullptr, res, 0, &zStats.allocCount);
+  if (__atomic_load_n(&zProfActive, __ATOMIC_RELAXED)) zProfAlloc(res, size, addr);
   return res;
 }
 
 
+__attribute__((malloc)) __attribute__((alloc_size(1))) __attribute__((returns_nonnull))
+void *Z_Calloc (size_t size) noexcept {
+  return zCallocInternal(size, __builtin_return_address(0));
+}
+
+
 void Z_Free (void *ptr) noexcept {
   if (!isZManActive()) return; // shitdoze hack
 #ifdef VAVOOM_CORE_COUNT_ALLOCS
   ++zone_free_call_count;
 #endif
   //fprintf(stderr, "Z_FREE! (%p)\n", ptr);
-  if (ptr) free_fn(ptr);
+  if (ptr) {
+    if (__atomic_load_n(&zStatsEnabled, __ATOMIC_RELAXED)) zStatsFree(zBlockSize(ptr));
+    if (__atomic_load_n(&zProfActive, __ATOMIC_RELAXED)) zProfFree(ptr);
+    free_fn(ptr);
+  }
 }
 
 
@@ -164,14 +614,15 @@ __attribute__((noreturn)) void Z_Exit (int exitcode) noexcept {
 #endif
 
 
+// call site is passed to allocator, so profiler will see the caller of `new`
 void *operator new (size_t size) noexcept(false) {
   //fprintf(stderr, "NEW: %u\n", (unsigned int)size);
-  return Z_Calloc(size);
+  return zCallocInternal(size, __builtin_return_address(0));
 }
 
 void *operator new[] (size_t size) noexcept(false) {
   //fprintf(stderr, "NEW[]: %u\n", (unsigned int)size);
-  return Z_Calloc(size);
+  return zCallocInternal(size, __builtin_return_address(0));
 }
 /*
 void *operator new (size_t size) noexcept {
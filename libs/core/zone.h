@@ -27,8 +27,8 @@
 //**  Memory Allocation.
 //**
 //**************************************************************************
-#ifdef __cplusplus
 #include <stdint.h>
+#ifdef __cplusplus
 void *operator new (size_t size) noexcept(false);
 void *operator new[] (size_t size) noexcept(false);
 void operator delete (void *p) noexcept;
@@ -77,6 +77,61 @@ void Z_Free (void *ptr) VV_ZONE_NOEXCEPT;
 void Z_ThreadDone () VV_ZONE_NOEXCEPT;
 
 
+// allocation statistics, for benchmarks
+// collecting is off by default (it costs several atomic ops per call)
+// statistics are process-wide, so allocations from other threads are counted too
+typedef struct ZoneStats {
+  uint64_t allocCount; // `Z_Malloc()`, `Z_Calloc()`, and `Z_Realloc()` with `nullptr`
+  uint64_t reallocCount;
+  uint64_t freeCount;
+  uint64_t allocBytes; // total bytes allocated (including reallocations)
+  int64_t liveBytes; // allocated minus freed since the last reset (can be negative; 0 if block sizes are unknown)
+  int64_t peakBytes; // peak value of `liveBytes`
+} ZoneStats;
+
+void Z_EnableStats (int enable) VV_ZONE_NOEXCEPT;
+void Z_ResetStats () VV_ZONE_NOEXCEPT;
+void Z_GetStats (ZoneStats *stats) VV_ZONE_NOEXCEPT;
+
+
+// sampling allocation profiler
+// when active, every Nth allocation records its call site (and VM call stack,
+// if the allocation is made by VM thread while VM code is running).
+// sampled blocks are tracked until freed, so live bytes per site are known.
+// all reported numbers are estimations (sampled values multiplied by the rate).
+// when the profiler is not active, it costs one relaxed load per call.
+enum {
+  ZPROF_TOTAL = 0, // everything since profiler start
+  ZPROF_LIVE = 1, // sampled blocks that are not freed yet
+  ZPROF_TICK = 2, // since the last `Z_ProfMark(ZPROF_TICK)`
+  ZPROF_PERIOD = 3, // since the last `Z_ProfMark(ZPROF_PERIOD)`
+};
+
+// maximum number of VM frames recorded for each site
+#define ZPROF_VM_FRAMES  (4)
+
+// puts VM frames (innermost first) into `frames`, returns number of frames (0 if VM is not running)
+// this must not allocate memory
+typedef int (*ZProfVMStackFn) (void **frames, int maxframes);
+// puts human-readable frame name into `dest`; called only from `Z_ProfDump()`
+typedef void (*ZProfVMNameFn) (void *frame, char *dest, size_t destsize);
+
+// VM stacks are collected only for the thread that called this
+void Z_ProfSetVMHooks (ZProfVMStackFn stackfn, ZProfVMNameFn namefn) VV_ZONE_NOEXCEPT;
+
+// starts new profile, discarding old data; `rate` is sampling rate (1: every allocation)
+void Z_ProfStart (int rate) VV_ZONE_NOEXCEPT;
+// stops sampling (and tracking of frees); collected data is kept until the next `Z_ProfStart()`
+void Z_ProfStop () VV_ZONE_NOEXCEPT;
+int Z_ProfIsActive () VV_ZONE_NOEXCEPT;
+int Z_ProfGetRate () VV_ZONE_NOEXCEPT;
+// `what` is `ZPROF_TICK` or `ZPROF_PERIOD`
+void Z_ProfMark (int what) VV_ZONE_NOEXCEPT;
+// logs `topCount` sites with the most allocated (or live) bytes
+// for `ZPROF_TICK` and `ZPROF_PERIOD`, nothing is logged if there were no sampled allocations
+void Z_ProfDump (int what, int topCount, const char *title) VV_ZONE_NOEXCEPT;
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -196,6 +196,79 @@ static int update_signal(MidiSong* song, int v)
 	return 0;
 }
 
+/* Mixing runs. Volumes are never bigger than MAX_AMP_VALUE, so 16x16-bit
+   multiplies give exactly the same products as the scalar code. */
+
+/* lp[0] += left * s; lp[1] += right * s; */
+static inline void mix_run_stereo(const MidiSong* song, sample_t*& sp, int32*& lp, int32 left, int32 right, int32 count)
+{
+#if TIMIDITY_SIMD
+	if (song->use_simd && count >= 8 && (uint32)left <= 32767 && (uint32)right <= 32767)
+	{
+		const __m128i vl = _mm_set1_epi16((int16)left);
+		const __m128i vr = _mm_set1_epi16((int16)right);
+
+		for (; count >= 8; count -= 8)
+		{
+			const __m128i s = _mm_loadu_si128((const __m128i*)sp);
+			const __m128i llo = _mm_mullo_epi16(s, vl), lhi = _mm_mulhi_epi16(s, vl);
+			const __m128i rlo = _mm_mullo_epi16(s, vr), rhi = _mm_mulhi_epi16(s, vr);
+			/* 32-bit products for samples 0..3 and 4..7 */
+			const __m128i l0 = _mm_unpacklo_epi16(llo, lhi), l1 = _mm_unpackhi_epi16(llo, lhi);
+			const __m128i r0 = _mm_unpacklo_epi16(rlo, rhi), r1 = _mm_unpackhi_epi16(rlo, rhi);
+			__m128i* d = (__m128i*)lp;
+			_mm_storeu_si128(d + 0, _mm_add_epi32(_mm_loadu_si128(d + 0), _mm_unpacklo_epi32(l0, r0)));
+			_mm_storeu_si128(d + 1, _mm_add_epi32(_mm_loadu_si128(d + 1), _mm_unpackhi_epi32(l0, r0)));
+			_mm_storeu_si128(d + 2, _mm_add_epi32(_mm_loadu_si128(d + 2), _mm_unpacklo_epi32(l1, r1)));
+			_mm_storeu_si128(d + 3, _mm_add_epi32(_mm_loadu_si128(d + 3), _mm_unpackhi_epi32(l1, r1)));
+			sp += 8;
+			lp += 16;
+		}
+	}
+#endif
+	while (count--)
+	{
+		sample_t s = *sp++;
+		lp[0] += left * s;
+		lp[1] += right * s;
+		lp += 2;
+	}
+}
+
+/* lp[0] += left * s; */
+static inline void mix_run_single(const MidiSong* song, sample_t*& sp, int32*& lp, int32 left, int32 count)
+{
+#if TIMIDITY_SIMD
+	/* the vector loop adds zeroes to lp[1]; the last sample is always mixed
+	   by the scalar loop, so it never touches anything past the buffer */
+	if (song->use_simd && count > 8 && (uint32)left <= 32767)
+	{
+		const __m128i vl = _mm_set1_epi16((int16)left);
+		const __m128i zero = _mm_setzero_si128();
+
+		for (; count > 8; count -= 8)
+		{
+			const __m128i s = _mm_loadu_si128((const __m128i*)sp);
+			const __m128i llo = _mm_mullo_epi16(s, vl), lhi = _mm_mulhi_epi16(s, vl);
+			const __m128i l0 = _mm_unpacklo_epi16(llo, lhi), l1 = _mm_unpackhi_epi16(llo, lhi);
+			__m128i* d = (__m128i*)lp;
+			_mm_storeu_si128(d + 0, _mm_add_epi32(_mm_loadu_si128(d + 0), _mm_unpacklo_epi32(l0, zero)));
+			_mm_storeu_si128(d + 1, _mm_add_epi32(_mm_loadu_si128(d + 1), _mm_unpackhi_epi32(l0, zero)));
+			_mm_storeu_si128(d + 2, _mm_add_epi32(_mm_loadu_si128(d + 2), _mm_unpacklo_epi32(l1, zero)));
+			_mm_storeu_si128(d + 3, _mm_add_epi32(_mm_loadu_si128(d + 3), _mm_unpackhi_epi32(l1, zero)));
+			sp += 8;
+			lp += 16;
+		}
+	}
+#endif
+	while (count--)
+	{
+		sample_t s = *sp++;
+		lp[0] += left * s;
+		lp += 2;
+	}
+}
+
 static void mix_mystery_signal(MidiSong* song, sample_t* sp, int32* lp, int v, int count)
 {
 	Voice *vp = song->voice + v;
@@ -203,7 +276,6 @@ static void mix_mystery_signal(MidiSong* song, sample_t* sp, int32* lp, int v, i
 		left = vp->left_mix,
 		right = vp->right_mix;
 	int cc;
-	sample_t s;
 
 	if (!(cc = vp->control_counter))
 	{
@@ -223,13 +295,7 @@ static void mix_mystery_signal(MidiSong* song, sample_t* sp, int32* lp, int v, i
 		{
 			count -= cc;
 
-			while (cc--)
-			{
-				s = *sp++;
-				lp[0] += left * s;
-				lp[1] += right * s;
-				lp += 2;
-			}
+			mix_run_stereo(song, sp, lp, left, right, cc);
 			cc = song->control_ratio;
 
 			if (update_signal(song, v))
@@ -243,13 +309,7 @@ static void mix_mystery_signal(MidiSong* song, sample_t* sp, int32* lp, int v, i
 		{
 			vp->control_counter = cc - count;
 
-			while (count--)
-			{
-				s = *sp++;
-				lp[0] += left * s;
-				lp[1] += right * s;
-				lp += 2;
-			}
+			mix_run_stereo(song, sp, lp, left, right, count);
 
 			return;
 		}
@@ -262,7 +322,6 @@ static void mix_centre_signal(MidiSong* song, sample_t* sp, int32* lp, int v, in
 	final_volume_t
 		left = vp->left_mix;
 	int cc;
-	sample_t s;
 
 	if (!(cc = vp->control_counter))
 	{
@@ -280,13 +339,7 @@ static void mix_centre_signal(MidiSong* song, sample_t* sp, int32* lp, int v, in
 		if (cc < count)
 		{
 			count -= cc;
-			while (cc--)
-			{
-				s = *sp++;
-				lp[0] += left * s;
-				lp[1] += left * s;
-				lp += 2;
-			}
+			mix_run_stereo(song, sp, lp, left, left, cc);
 			cc = song->control_ratio;
 			if (update_signal(song, v))
 			{
@@ -298,13 +351,7 @@ static void mix_centre_signal(MidiSong* song, sample_t* sp, int32* lp, int v, in
 		{
 			vp->control_counter = cc - count;
 
-			while (count--)
-			{
-				s = *sp++;
-				lp[0] += left * s;
-				lp[1] += left * s;
-				lp += 2;
-			}
+			mix_run_stereo(song, sp, lp, left, left, count);
 
 			return;
 		}
@@ -317,7 +364,6 @@ static void mix_single_signal(MidiSong* song, sample_t* sp, int32* lp, int v, in
 	final_volume_t
 		left = vp->left_mix;
 	int cc;
-	sample_t s;
 
 	if (!(cc = vp->control_counter))
 	{
@@ -335,12 +381,7 @@ static void mix_single_signal(MidiSong* song, sample_t* sp, int32* lp, int v, in
 		{
 			count -= cc;
 
-			while (cc--)
-			{
-				s = *sp++;
-				lp[0] += left * s;
-				lp += 2;
-			}
+			mix_run_single(song, sp, lp, left, cc);
 			cc = song->control_ratio;
 
 			if (update_signal(song, v))
@@ -353,12 +394,7 @@ static void mix_single_signal(MidiSong* song, sample_t* sp, int32* lp, int v, in
 		{
 			vp->control_counter = cc - count;
 
-			while (count--)
-			{
-				s = *sp++;
-				lp[0] += left * s;
-				lp += 2;
-			}
+			mix_run_single(song, sp, lp, left, count);
 
 			return;
 		}
@@ -370,43 +406,23 @@ static void mix_mystery(MidiSong* song, sample_t* sp, int32* lp, int v, int coun
 	final_volume_t
 		left = song->voice[v].left_mix,
 		right = song->voice[v].right_mix;
-	sample_t s;
 
-	while (count--)
-	{
-		s = *sp++;
-		lp[0] += left * s;
-		lp[1] += right * s;
-		lp += 2;
-	}
+	mix_run_stereo(song, sp, lp, left, right, count);
 }
 
 static void mix_centre(MidiSong* song, sample_t* sp, int32* lp, int v, int count)
 {
 	final_volume_t
 		left=song->voice[v].left_mix;
-	sample_t s;
 
-	while (count--)
-	{
-		s = *sp++;
-		lp[0] += left * s;
-		lp[1] += left * s;
-		lp += 2;
-	}
+	mix_run_stereo(song, sp, lp, left, left, count);
 }
 
 static void mix_single(MidiSong* song, sample_t* sp, int32* lp, int v, int count)
 {
 	final_volume_t left = song->voice[v].left_mix;
-	sample_t s;
 
-	while (count--)
-	{
-		s = *sp++;
-		lp[0] += left * s;
-		lp += 2;
-	}
+	mix_run_single(song, sp, lp, left, count);
 }
 
 /* Ramp a note out in c samples */
@@ -589,11 +589,25 @@ static void do_compute_data(MidiSong* song, int32 count)
 }
 
 
-static void s32tos16(void* dp, int32* lp, int32 c)
+static void s32tos16(const MidiSong* song, void* dp, int32* lp, int32 c)
 {
 	int16* sp = (int16*)(dp);
 	int32 l;
 
+#if TIMIDITY_SIMD
+	if (song->use_simd)
+	{
+		/* packssdw saturates exactly like the clamping below */
+		for (; c >= 8; c -= 8)
+		{
+			const __m128i a = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)lp), 32 - 16 - GUARD_BITS);
+			const __m128i b = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(lp + 4)), 32 - 16 - GUARD_BITS);
+			_mm_storeu_si128((__m128i*)sp, _mm_packs_epi32(a, b));
+			lp += 8;
+			sp += 8;
+		}
+	}
+#endif
 	while (c--)
 	{
 		l = (*lp++) >> (32 - 16 - GUARD_BITS);
@@ -747,7 +761,7 @@ int Timidity_PlaySome(MidiSong* song, void *stream, int samples)
 				comp_count = song->buffer_size;
 			}
 			do_compute_data(song, comp_count);
-			s32tos16((char*)stream + stream_start * sample_size, song->common_buffer,
+			s32tos16(song, (char*)stream + stream_start * sample_size, song->common_buffer,
 				2 * comp_count);
 			conv_count -= comp_count;
 			stream_start += comp_count;
@@ -819,6 +833,7 @@ MidiSong *Timidity_LoadSongMem(void* data, int size, DLS_Data* patches, Sf2Data*
 	song->resample_buffer = (sample_t*)safe_malloc(song->buffer_size * sizeof(sample_t));
 	song->common_buffer = (int32*)safe_malloc(song->buffer_size * 2 * sizeof(int32));
 	song->control_ratio = OUTPUT_RATE / CONTROLS_PER_SECOND;
+	song->use_simd = TIMIDITY_SIMD;
 
 	if (song->control_ratio < 1)
 	{
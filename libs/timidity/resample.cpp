@@ -21,6 +21,7 @@
 */
 
 #include <stdlib.h>
+#include <string.h>
 #include <inttypes.h>
 
 #include "timidity.h"
@@ -41,12 +42,60 @@ namespace LibTimidity
 
 #define PRECALC_LOOP_COUNT(start, end, incr) (((end) - (start) + (incr) - 1) / (incr))
 
+#if TIMIDITY_SIMD
+static inline int32 load_pair(const sample_t* src, int32 ofs)
+{
+	int32 res;
+	memcpy(&res, src + (ofs >> FRACTION_BITS), sizeof(res));
+	return res;
+}
+#endif
+
+/* Does `count` RESAMPLATIONs with fixed increment.
+   v1 + (((v2 - v1) * f) >> FRACTION_BITS) is the same as
+   (v1 * ((1 << FRACTION_BITS) - f) + v2 * f) >> FRACTION_BITS, and both
+   weights fit in 16 bits, so pmaddwd gives exactly the scalar result. */
+static inline void resample_run(const MidiSong* song, sample_t*& dest, const sample_t* src, int32& ofs, int32 incr, int32 count)
+{
+#if TIMIDITY_SIMD
+	if (song->use_simd && count >= 8)
+	{
+		const __m128i one = _mm_set1_epi32(1 << FRACTION_BITS);
+		const __m128i fmask = _mm_set1_epi32((int32)FRACTION_MASK);
+
+		for (; count >= 8; count -= 8)
+		{
+			const int32 o0 = ofs, o1 = o0 + incr, o2 = o1 + incr, o3 = o2 + incr;
+			const int32 o4 = o3 + incr, o5 = o4 + incr, o6 = o5 + incr, o7 = o6 + incr;
+			ofs = o7 + incr;
+			/* (v1, v2) pairs are gathered with 32-bit scalar loads */
+			const __m128i va = _mm_set_epi32(load_pair(src, o3), load_pair(src, o2), load_pair(src, o1), load_pair(src, o0));
+			const __m128i vb = _mm_set_epi32(load_pair(src, o7), load_pair(src, o6), load_pair(src, o5), load_pair(src, o4));
+			const __m128i fa = _mm_and_si128(_mm_set_epi32(o3, o2, o1, o0), fmask);
+			const __m128i fb = _mm_and_si128(_mm_set_epi32(o7, o6, o5, o4), fmask);
+			const __m128i wa = _mm_or_si128(_mm_sub_epi32(one, fa), _mm_slli_epi32(fa, 16));
+			const __m128i wb = _mm_or_si128(_mm_sub_epi32(one, fb), _mm_slli_epi32(fb, 16));
+			const __m128i ra = _mm_srai_epi32(_mm_madd_epi16(va, wa), FRACTION_BITS);
+			const __m128i rb = _mm_srai_epi32(_mm_madd_epi16(vb, wb), FRACTION_BITS);
+			_mm_storeu_si128((__m128i*)dest, _mm_packs_epi32(ra, rb));
+			dest += 8;
+		}
+	}
+#endif
+	INTERPVARS;
+
+	while (count--)
+	{
+		RESAMPLATION;
+		ofs += incr;
+	}
+}
+
 /*************** resampling with fixed increment *****************/
 
 static sample_t* rs_plain(MidiSong* song, int v, int32* countptr)
 {
 	/* Play sample until end, then free the voice. */
-	INTERPVARS;
 	Voice* vp = &song->voice[v];
 	sample_t* dest = song->resample_buffer;
 	sample_t* src = vp->sample->data;
@@ -79,12 +128,7 @@ static sample_t* rs_plain(MidiSong* song, int v, int32* countptr)
 		count -= i;
 	}
 
-	//while (i--)
-	for (int32 j = 0; j < i; j++)
-	{
-		RESAMPLATION;
-		ofs += incr;
-	}
+	resample_run(song, dest, src, ofs, incr, i);
 
 	if (ofs >= le)
 	{
@@ -100,7 +144,6 @@ static sample_t* rs_plain(MidiSong* song, int v, int32* countptr)
 static sample_t* rs_loop(MidiSong* song, Voice* vp, int32 count)
 {
 	/* Play sample until end-of-loop, skip back and continue. */
-	INTERPVARS;
 	int32
 		ofs = vp->sample_offset,
 		incr = vp->sample_increment,
@@ -134,12 +177,7 @@ static sample_t* rs_loop(MidiSong* song, Voice* vp, int32 count)
 			count -= i;
 		}
 
-		//while (i--)
-		for (int32 j = 0; j < i; j++)
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		resample_run(song, dest, src, ofs, incr, i);
 	}
 	vp->sample_offset = ofs; /* Update offset */
 
@@ -148,7 +186,6 @@ static sample_t* rs_loop(MidiSong* song, Voice* vp, int32 count)
 
 static sample_t* rs_bidir(MidiSong* song, Voice* vp, int32 count)
 {
-	INTERPVARS;
 	int32
 		ofs = vp->sample_offset,
 		incr = vp->sample_increment,
@@ -182,12 +219,7 @@ static sample_t* rs_bidir(MidiSong* song, Voice* vp, int32 count)
 			count -= i;
 		}
 
-		//while (i--)
-		for (int32 j = 0; j < i; j++)
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		resample_run(song, dest, src, ofs, incr, i);
 	}
 
 	/* Then do the bidirectional looping */
@@ -207,12 +239,7 @@ static sample_t* rs_bidir(MidiSong* song, Voice* vp, int32 count)
 			count -= i;
 		}
 
-		//while (i--)
-		for (int32 j = 0; j < i; j++)
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		resample_run(song, dest, src, ofs, incr, i);
 
 		if (ofs>=le)
 		{
@@ -389,7 +416,6 @@ static sample_t* rs_vib_plain(MidiSong* song, int v, int32* countptr)
 static sample_t* rs_vib_loop(MidiSong* song, Voice* vp, int32 count)
 {
 	/* Play sample until end-of-loop, skip back and continue. */
-	INTERPVARS;
 	int32
 		ofs=vp->sample_offset,
 		incr=vp->sample_increment,
@@ -432,12 +458,7 @@ static sample_t* rs_vib_loop(MidiSong* song, Voice* vp, int32 count)
 		}
 		count -= i;
 
-		//while (i--)
-		for (int32 j = 0; j < i; j++)
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		resample_run(song, dest, src, ofs, incr, i);
 
 		if (vibflag)
 		{
@@ -455,7 +476,6 @@ static sample_t* rs_vib_loop(MidiSong* song, Voice* vp, int32 count)
 
 static sample_t* rs_vib_bidir(MidiSong* song, Voice* vp, int32 count)
 {
-	INTERPVARS;
 	int32
 		ofs = vp->sample_offset,
 		incr = vp->sample_increment,
@@ -495,12 +515,7 @@ static sample_t* rs_vib_bidir(MidiSong* song, Voice* vp, int32 count)
 		}
 		count -= i;
 
-		//while (i--)
-		for (int32 j = 0; j < i; j++)
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		resample_run(song, dest, src, ofs, incr, i);
 
 		if (vibflag)
 		{
@@ -533,12 +548,7 @@ static sample_t* rs_vib_bidir(MidiSong* song, Voice* vp, int32 count)
 		}
 		count -= i;
 
-		//while (i--)
-		for (int32 j = 0; j < i; j++)
-		{
-			RESAMPLATION;
-			ofs += incr;
-		}
+		resample_run(song, dest, src, ofs, incr, i);
 
 		if (vibflag)
 		{
@@ -26,6 +26,15 @@
 #include <stdio.h>
 #include <stdint.h>
 
+/* SSE2 versions of the resampling and mixing loops; they produce exactly
+   the same output as the scalar ones. */
+#if defined(__SSE2__) && !defined(TIMIDITY_NO_SIMD)
+#define TIMIDITY_SIMD 1
+#include <emmintrin.h>
+#else
+#define TIMIDITY_SIMD 0
+#endif
+
 namespace LibTimidity
 {
 #if (defined(WIN32) || defined(_WIN32)) && !defined(__WIN32__)
@@ -446,6 +455,8 @@ struct MidiSong
 	int32				current_sample;
 	int32				event_count;
 	int32				at;
+	/* 0: use scalar resampling and mixing loops (for benchmarking) */
+	int					use_simd;
 };
 
 extern FILE *open_file(const char *name, int decompress, int noise_mode);
@@ -46,6 +46,7 @@ public:
 // ////////////////////////////////////////////////////////////////////////// //
 TArray<VName> VClass::GSpriteNames; // should be lowercase!
 TMapNC<VName, int> VClass::GSpriteNamesMap;
+int VClass::GClassTreeGen = 0;
 
 static TArray<mobjinfo_t> GMobjInfos;
 static TArray<mobjinfo_t> GScriptIds;
@@ -143,6 +144,10 @@ VClass::VClass (VName AName, VMemberBase *AOuter, const TLocation &ALoc)
   , KnownEnums()
   , InstanceCount(0)
   , InstanceCountWithSub(0)
+  , InstanceHead(nullptr)
+  , InstanceTail(nullptr)
+  , SelfAndSubClasses()
+  , SelfAndSubClassesGen(-1)
   , InstanceLimit(0)
   , InstanceLimitWithSub(0)
   , InstanceLimitCvar()
@@ -152,6 +157,7 @@ VClass::VClass (VName AName, VMemberBase *AOuter, const TLocation &ALoc)
 {
   LinkNext = GClasses;
   GClasses = this;
+  ++GClassTreeGen;
   ClassGameObjName = NAME_None;
   DecorateStateActionsBuilt = false;
 }
@@ -197,6 +203,10 @@ VClass::VClass (ENativeConstructor, size_t ASize, vuint32 AClassFlags, VClass *A
   , KnownEnums()
   , InstanceCount(0)
   , InstanceCountWithSub(0)
+  , InstanceHead(nullptr)
+  , InstanceTail(nullptr)
+  , SelfAndSubClasses()
+  , SelfAndSubClassesGen(-1)
   , InstanceLimit(0)
   , InstanceLimitWithSub(0)
   , InstanceLimitCvar()
@@ -206,6 +216,7 @@ VClass::VClass (ENativeConstructor, size_t ASize, vuint32 AClassFlags, VClass *A
 {
   LinkNext = GClasses;
   GClasses = this;
+  ++GClassTreeGen;
   ClassGameObjName = NAME_None;
   DecorateStateActionsBuilt = false;
 }
@@ -233,6 +244,8 @@ VClass::~VClass () {
 
   if (!GObjInitialised || GObjShuttingDown) return;
 
+  ++GClassTreeGen;
+
   // unlink from classes list
   if (GClasses == this) {
     GClasses = LinkNext;
@@ -364,6 +377,24 @@ bool VClass::AddKnownEnum (VName EnumName) {
 }
 
 
+//==========================================================================
+//
+//  VClass::GetSelfAndSubClasses
+//
+//==========================================================================
+const TArray<VClass *> &VClass::GetSelfAndSubClasses () {
+  if (SelfAndSubClassesGen != GClassTreeGen) {
+    SelfAndSubClassesGen = GClassTreeGen;
+    SelfAndSubClasses.reset();
+    SelfAndSubClasses.append(this);
+    for (VClass *Cls = GClasses; Cls; Cls = Cls->LinkNext) {
+      if (Cls != this && Cls->IsChildOf(this)) SelfAndSubClasses.append(Cls);
+    }
+  }
+  return SelfAndSubClasses;
+}
+
+
 //==========================================================================
 //
 //  VClass::FindClass
@@ -1229,6 +1260,9 @@ bool VClass::Define () {
   Defined = true;
   DefinedAsDependency = false;
 
+  // parent class (and parents of other classes) can be changed here
+  ++GClassTreeGen;
+
   VClass *PrevParent = ParentClass;
   if (ParentClassName != NAME_None) {
     ParentClass = StaticFindClass(ParentClassName);
@@ -2569,6 +2603,7 @@ VClass *VClass::CreateDerivedClass (VName AName, VMemberBase *AOuter, TArray<VDe
   }
   if (!NewClass) NewClass = new VClass(AName, AOuter, ALoc);
   NewClass->ParentClass = this;
+  ++GClassTreeGen;
 
   if (uvlist.length()) {
     TArray<bool> ignores;
@@ -393,6 +393,24 @@ public:
   int InstanceCount; // number of alive instances of this class
   int InstanceCountWithSub; // number of alive instances of this class and its subclasses (includes `InstanceCount`)
 
+  // live instance registry: all instances of exactly this class, in creation order
+  // objects are linked in `VObject::Register()`, and unlinked when they are deleted,
+  // so dead objects stay in the list until garbage collection (use `IsGoingToDie()`)
+  VObject *InstanceHead;
+  VObject *InstanceTail;
+
+private:
+  // this class and all its subclasses; built on demand
+  TArray<VClass *> SelfAndSubClasses;
+  int SelfAndSubClassesGen;
+  // incremented when classes are created, or class hierarchy is changed
+  static int GClassTreeGen;
+
+public:
+  // returns this class and all its subclasses (this class is the first one)
+  // use this with `InstanceHead` to walk all instances of the class and its subclasses
+  const TArray<VClass *> &GetSelfAndSubClasses ();
+
   // used by the main engine only
   int InstanceLimit;
   int InstanceLimitWithSub;
@@ -137,8 +137,15 @@ static inline void cstFixTopIPSP (const vuint8 *ip) {
 static void cstPush (VMethod *func) {
   if (cstUsed == cstSize) {
     //FIXME: handle OOM here
-    cstSize += 16384;
-    callStack = (CallStackItem *)Z_Realloc(callStack, sizeof(callStack[0])*cstSize);
+    // allocation profiler can walk the stack while we are allocating, so
+    // the old stack should stay valid until the new one is published
+    const vuint32 newSize = cstSize+16384;
+    CallStackItem *newStack = (CallStackItem *)Z_Malloc(sizeof(callStack[0])*newSize);
+    if (cstUsed) memcpy((void *)newStack, (void *)callStack, sizeof(callStack[0])*cstUsed);
+    CallStackItem *oldStack = callStack;
+    callStack = newStack;
+    cstSize = newSize;
+    Z_Free(oldStack);
   }
   callStack[cstUsed].func = func;
   callStack[cstUsed].ip = nullptr;
@@ -152,6 +159,31 @@ static inline void cstPop () {
 }
 
 
+//==========================================================================
+//
+//  cstProfGetStack
+//
+//  allocation profiler hook; it is registered from `PR_Init()`, so it is
+//  called only from the VM thread
+//
+//==========================================================================
+static int cstProfGetStack (void **frames, int maxframes) {
+  int count = 0;
+  for (vuint32 sp = cstUsed; sp > 0 && count < maxframes; --sp) frames[count++] = (void *)callStack[sp-1].func;
+  return count;
+}
+
+
+//==========================================================================
+//
+//  cstProfGetName
+//
+//==========================================================================
+static void cstProfGetName (void *frame, char *dest, size_t destsize) {
+  snprintf(dest, destsize, "%s", *((VMethod *)frame)->GetFullName());
+}
+
+
 // `ip` can be null
 static void cstDump (const vuint8 *ip, bool toStdErr=false) {
   if (VObject::DumpBacktraceToStdErr) toStdErr = true; // hard override
@@ -201,9 +233,12 @@ void VObject::PR_Init () {
   pr_stack[MAX_PROG_STACK-1].i = STACK_ID;
   VObject::pr_stackPtr = pr_stack+1;
 
+  // empty the stack first, so allocation profiler won't walk the old one
+  cstUsed = 0;
   cstSize = 16384;
   callStack = (CallStackItem *)Z_Realloc(callStack, sizeof(callStack[0])*cstSize);
-  cstUsed = 0;
+
+  Z_ProfSetVMHooks(&cstProfGetStack, &cstProfGetName);
 }
 
 
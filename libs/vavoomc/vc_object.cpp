@@ -125,6 +125,91 @@ void VScriptIterator::Finished () {
 }
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+// iterator free lists, bucketed by size; bigger iterators use the heap
+enum {
+  ScriptIterBucketShift = 5, // 32 bytes
+  ScriptIterBucketCount = 8, // up to 256 bytes
+};
+
+struct ScriptIterFreeBlock {
+  ScriptIterFreeBlock *next;
+};
+
+static ScriptIterFreeBlock *scriptIterFree[ScriptIterBucketCount] = {nullptr};
+static int scriptIterStatAllocs = 0;
+static int scriptIterStatHeapAllocs = 0;
+static int scriptIterStatLive = 0;
+static int scriptIterStatPooled = 0;
+
+
+//==========================================================================
+//
+//  VScriptIterator::operator new
+//
+//==========================================================================
+void *VScriptIterator::operator new (size_t size) {
+  ++scriptIterStatAllocs;
+  ++scriptIterStatLive;
+  const size_t bucket = (size+((1u<<ScriptIterBucketShift)-1))>>ScriptIterBucketShift;
+  if (bucket == 0 || bucket > ScriptIterBucketCount) {
+    ++scriptIterStatHeapAllocs;
+    return Z_Malloc(size);
+  }
+  ScriptIterFreeBlock *blk = scriptIterFree[bucket-1];
+  if (blk) {
+    scriptIterFree[bucket-1] = blk->next;
+    --scriptIterStatPooled;
+    return blk;
+  }
+  ++scriptIterStatHeapAllocs;
+  return Z_Malloc(bucket<<ScriptIterBucketShift);
+}
+
+
+//==========================================================================
+//
+//  VScriptIterator::operator delete
+//
+//==========================================================================
+void VScriptIterator::operator delete (void *ptr, size_t size) noexcept {
+  if (!ptr) return;
+  --scriptIterStatLive;
+  const size_t bucket = (size+((1u<<ScriptIterBucketShift)-1))>>ScriptIterBucketShift;
+  if (bucket == 0 || bucket > ScriptIterBucketCount) {
+    Z_Free(ptr);
+    return;
+  }
+  ScriptIterFreeBlock *blk = (ScriptIterFreeBlock *)ptr;
+  blk->next = scriptIterFree[bucket-1];
+  scriptIterFree[bucket-1] = blk;
+  ++scriptIterStatPooled;
+}
+
+
+//==========================================================================
+//
+//  VScriptIterator::GetAllocStats
+//
+//==========================================================================
+void VScriptIterator::GetAllocStats (int *allocs, int *heapAllocs, int *live, int *pooled) noexcept {
+  if (allocs) *allocs = scriptIterStatAllocs;
+  if (heapAllocs) *heapAllocs = scriptIterStatHeapAllocs;
+  if (live) *live = scriptIterStatLive;
+  if (pooled) *pooled = scriptIterStatPooled;
+}
+
+
+//==========================================================================
+//
+//  VScriptIterator::ResetAllocStats
+//
+//==========================================================================
+void VScriptIterator::ResetAllocStats () noexcept {
+  scriptIterStatAllocs = scriptIterStatHeapAllocs = 0;
+}
+
+
 //==========================================================================
 //
 //  VMethodProxy::VMethodProxy
@@ -331,6 +416,7 @@ VObject::~VObject () {
 
   ConditionalDestroy();
   GObjObjects[Index] = nullptr;
+  UnlinkClassInstance();
   //!if (UniqueId) GObjectsUIdMap.remove(UniqueId);
 
   if (!GInGarbageCollection) {
@@ -569,6 +655,23 @@ void VObject::Register () {
   vdgclogf("created object(%u) #%d: %p (%s)", UniqueId, Index, this, GetClass()->GetName());
   ++gcLastStats.alive;
   IncrementInstanceCounters();
+  // append to class instance list
+  ClassInstNext = nullptr;
+  ClassInstPrev = Class->InstanceTail;
+  if (ClassInstPrev) ClassInstPrev->ClassInstNext = this; else Class->InstanceHead = this;
+  Class->InstanceTail = this;
+}
+
+
+//==========================================================================
+//
+//  VObject::UnlinkClassInstance
+//
+//==========================================================================
+void VObject::UnlinkClassInstance () noexcept {
+  if (ClassInstPrev) ClassInstPrev->ClassInstNext = ClassInstNext; else if (Class->InstanceHead == this) Class->InstanceHead = ClassInstNext;
+  if (ClassInstNext) ClassInstNext->ClassInstPrev = ClassInstPrev; else if (Class->InstanceTail == this) Class->InstanceTail = ClassInstPrev;
+  ClassInstPrev = ClassInstNext = nullptr;
 }
 
 
@@ -651,6 +754,7 @@ void VObject::CollectGarbage (bool destroyDelayed) {
   if (!GNumDeleted && !destroyDelayed) return;
   vassert(GNumDeleted >= 0);
 
+  VTRACE_ZONE("CollectGarbage");
   GInGarbageCollection = true;
 
   vdgclogf("collecting garbage");
@@ -822,6 +926,8 @@ void VObject::CollectGarbage (bool destroyDelayed) {
   gcLastStats.poolSize = GObjObjects.length();
   gcLastStats.poolAllocated = GObjObjects.NumAllocated();
   gcLastStats.firstFree = gObjFirstFree;
+  VTRACE_COUNTER("gc alive", alive);
+  VTRACE_COUNTER("gc collected", bodycount);
 
   vdgclogf("garbage collection complete in %d msecs; %d objects deleted, %d objects live, %d of %d array slots used; firstfree=%d",
     (int)(gcLastStats.lastCollectDuration*1000), gcLastStats.lastCollected, gcLastStats.alive, gcLastStats.poolSize, gcLastStats.poolAllocated, gObjFirstFree);
@@ -1136,24 +1242,28 @@ public:
 //==========================================================================
 class VObjectsIterator : public VScriptIterator {
 private:
-  VClass *BaseClass;
+  TArray<VClass *> Classes; // a copy: the class list can be rebuilt while we're iterating
   VObject **Out;
-  int Index;
+  VObject *Current;
+  int ClassIndex;
 
 public:
-  VObjectsIterator (VClass *ABaseClass, VObject **AOut) : BaseClass(ABaseClass), Out(AOut), Index(0) {}
+  VObjectsIterator (VClass *ABaseClass, VObject **AOut) : Classes(ABaseClass->GetSelfAndSubClasses()), Out(AOut), Current(nullptr), ClassIndex(0) {}
 
+  // walks live instance lists; destroyed objects are still linked there until
+  // they are collected, so destroying the current object in the loop is ok
   virtual bool GetNext () override {
-    while (Index < VObject::GetObjectsCount()) {
-      VObject *Check = VObject::GetIndexObject(Index);
-      ++Index;
-      if (Check && !Check->IsGoingToDie() && Check->IsA(BaseClass)) {
-        *Out = Check;
+    for (;;) {
+      Current = (Current ? Current->GetNextClassInstance() : nullptr);
+      while (!Current) {
+        if (ClassIndex >= Classes.length()) { *Out = nullptr; return false; }
+        Current = Classes[ClassIndex++]->InstanceHead;
+      }
+      if (!Current->IsGoingToDie()) {
+        *Out = Current;
         return true;
       }
     }
-    *Out = nullptr;
-    return false;
   }
 };
 
@@ -452,7 +452,6 @@ class VObject : public VInterface {
   DECLARE_BASE_CLASS(VObject, VObject, CLASS_Abstract|CLASS_Native)
 
   // friends
-  friend class FObjectIterator;
   friend class VMethodProxy;
 
 public:
@@ -499,6 +498,9 @@ private:
   vuint32 UniqueId; // monotonically increasing
   vuint32 ObjectFlags; // private EObjectFlags used by object manager
   VClass *Class; // class the object belongs to
+  // links in the live instance list of `Class` (see `VClass::InstanceHead`)
+  VObject *ClassInstPrev;
+  VObject *ClassInstNext;
 
   // private systemwide variables
   //static bool GObjInitialised;
@@ -566,10 +568,17 @@ public:
 
   inline void SetDelayedDestroy () { SetFlags(VObjFlag_DelayedDestroy); }
 
+  // next instance of the same class (exactly this class, not subclasses)
+  // dead objects are in the list until they are collected
+  inline VObject *GetNextClassInstance () const noexcept { return ClassInstNext; }
+
   //static inline VObject *FindByUniqueId (vuint32 uid) noexcept { auto pp = GObjectsUIdMap.find(uid); return (pp ? *pp : nullptr); }
 
   // VObject interface
   virtual void Register ();
+private:
+  void UnlinkClassInstance () noexcept;
+public:
   virtual void Destroy ();
 
   virtual void SerialiseFields (VStream &); // this serialises object fields
@@ -864,36 +873,6 @@ public:
 };
 
 
-/*----------------------------------------------------------------------------
-  Object iterators.
-----------------------------------------------------------------------------*/
-
-// class for iterating through all objects
-class FObjectIterator {
-protected:
-  VClass *Class;
-  int Index;
-
-public:
-  FObjectIterator (VClass *InClass=VObject::StaticClass()) : Class(InClass), Index(-1) { ++*this; }
-
-  void operator ++ () { while (++Index < VObject::GObjObjects.Num() && (!VObject::GObjObjects[Index] || !VObject::GObjObjects[Index]->IsA(Class))) {} }
-  VObject *operator * () { return VObject::GObjObjects[Index]; }
-  VObject *operator -> () { return VObject::GObjObjects[Index]; }
-  operator bool () { return (Index < VObject::GObjObjects.Num()); }
-};
-
-
-// class for iterating through all objects which inherit from a specified base class
-template<class T> class TObjectIterator : public FObjectIterator {
-public:
-  TObjectIterator () : FObjectIterator(T::StaticClass()) {}
-
-  T *operator * () { return (T*)FObjectIterator::operator*(); }
-  T *operator -> () { return (T*)FObjectIterator::operator->(); }
-};
-
-
 // object creation template
 //template<class T> T *Spawn () { return (T*)VObject::StaticSpawnObject(T::StaticClass()); }
 template<class T> T *SpawnWithReplace () { return (T*)VObject::StaticSpawnObject(T::StaticClass(), false); } // don't skip replacement
@@ -991,6 +970,17 @@ public:
   virtual bool GetNext() = 0;
   // by default, the following does `delete this;`
   virtual void Finished ();
+
+  // iterators are created for each `foreach`, so they are allocated from
+  // free lists instead of the heap (VM is single-threaded, so no locking)
+  static void *operator new (size_t size);
+  static void operator delete (void *ptr, size_t size) noexcept;
+
+  // `allocs`: all allocations; `heapAllocs`: allocations that missed the free lists
+  // `live`: iterators in use; `pooled`: blocks in free lists
+  static void GetAllocStats (int *allocs, int *heapAllocs, int *live, int *pooled) noexcept;
+  // resets `allocs` and `heapAllocs`
+  static void ResetAllocStats () noexcept;
 };
 
 
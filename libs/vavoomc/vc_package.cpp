@@ -246,9 +246,8 @@ int VPackage::FindString (const char *str) {
   vassert(Ofs == StringCount);
   ++StringCount;
   TStringInfo &SI = StringInfo.Alloc();
-  // remember string
-  SI.str = VStr(str);
-  SI.str.makeImmutable();
+  // remember string; literals are interned, so equal strings from different packages share the data
+  SI.str = VStr::intern(str);
   SI.Offs = Ofs;
   SI.Next = StringLookup[hash];
   StringLookup[hash] = StringInfo.length()-1;
@@ -5030,6 +5030,7 @@ int VAcs::RunScript (float DeltaTime, bool immediate) {
               break;
           }
         }
+        XLevel->NoteGeometryChange(); // drop sight cache
         sp -= 2;
       }
       ACSVM_BREAK;
@@ -105,6 +105,9 @@ public:
 class FConsoleLog : public VLogListener {
 public:
   virtual void Serialise (const char *V, EName Event) noexcept override;
+  virtual void SerialiseMessage (const VLogMessage &msg) noexcept override;
+  // console lines and log file are protected with `conLogLock`
+  virtual bool IsThreadSafe () const noexcept override { return true; }
 };
 
 
@@ -829,13 +832,15 @@ static void DoPrint (const char *buf) noexcept {
 //  ConSerialise
 //
 //  tty output is done by standard logger
+//  this can be called from the log thread, so it should use only the
+//  state captured in `msg`
 //
 //==========================================================================
-static void ConSerialise (const char *str, EName Event, bool fromGLog) noexcept {
-  //devprintf("%s: %s\n", VName::SafeString(Event), *rc);
-  if (Event == NAME_Dev && !developer) return;
-  if (!fromGLog) { GLog.WriteLine(Event, "%s", str); return; }
-  if (!str) str = "";
+static void ConSerialise (const VLogMessage &msg) noexcept {
+  const char *str = msg.text;
+  const EName Event = msg.type;
+  //devprintf("%s: %s\n", msg.typeName, *rc);
+  if (Event == NAME_Dev && !msg.devMode) return;
   MyThreadLocker lock(&conLogLock);
   //fprintf(stderr, "<<<%s>>>", str);
   //HACK! if string starts with "Sys_Error:", print it, and close log file
@@ -866,13 +871,12 @@ static void ConSerialise (const char *str, EName Event, bool fromGLog) noexcept
       if (cpLogFileNeedName) {
         char buf[64];
         if (Event == NAME_DevNet) {
-          unsigned msecs = unsigned(Sys_Time()*1000);
-          snprintf(buf, sizeof(buf), "%u:", msecs);
-          fprintf(logfout, "%s:%s%s", VName::SafeString(Event), buf, (rstr == eol ? "" : " "));
+          snprintf(buf, sizeof(buf), "%u:", (unsigned)msg.msecs);
+          fprintf(logfout, "%s:%s%s", msg.typeName, buf, (rstr == eol ? "" : " "));
         } else {
           buf[0] = 0;
         }
-        fprintf(logfout, "%s:%s%s", VName::SafeString(Event), buf, (rstr == eol ? "" : " "));
+        fprintf(logfout, "%s:%s%s", msg.typeName, buf, (rstr == eol ? "" : " "));
         cpLogFileNeedName = false;
       }
       if (eol != rstr) fwrite(rstr, (ptrdiff_t)(eol-rstr), 1, logfout);
@@ -883,7 +887,7 @@ static void ConSerialise (const char *str, EName Event, bool fromGLog) noexcept
       cpLogFileNeedName = true;
       ++rstr;
     }
-    //fprintf(logfout, "%s: %s", VName::SafeString(Event), *rc);
+    //fprintf(logfout, "%s: %s", msg.typeName, *rc);
   }
 }
 
@@ -894,7 +898,8 @@ static void ConSerialise (const char *str, EName Event, bool fromGLog) noexcept
 //
 //==========================================================================
 void FConsoleDevice::Serialise (const char *V, EName Event) noexcept {
-  ConSerialise(V, Event, false);
+  if (Event == NAME_Dev && !developer) return;
+  GLog.WriteLine(Event, "%s", V);
 }
 
 
@@ -904,5 +909,15 @@ void FConsoleDevice::Serialise (const char *V, EName Event) noexcept {
 //
 //==========================================================================
 void FConsoleLog::Serialise (const char *Text, EName Event) noexcept {
-  ConSerialise(Text, Event, true);
+  ConSerialise(VLogMessage(Text, Event));
+}
+
+
+//==========================================================================
+//
+//  FConsoleLog::SerialiseMessage
+//
+//==========================================================================
+void FConsoleLog::SerialiseMessage (const VLogMessage &msg) noexcept {
+  ConSerialise(msg);
 }
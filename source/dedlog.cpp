@@ -32,6 +32,9 @@ static FILE *ddlogfout = nullptr;
 bool ttyRefreshInputLine = true;
 bool ttyExtraDisabled = false;
 bool dedEnableTTYLog = false;
+// TTY output and the input line are shared with the log thread
+// this is recursive, because the logger updates the prompt
+mythread_mutex dedTTYLock;
 
 void UpdateTTYPrompt ();
 
@@ -50,6 +53,7 @@ static FConsoleDevice Console;
 FOutputDevice *GCon = &Console;
 
 
+// this is called from the log thread, and protected with `dedTTYLock`
 class VDedLog : public VLogListener {
 public:
   EName lastEvent;
@@ -125,6 +129,7 @@ private:
 
 public:
   inline VDedLog () noexcept : lastEvent(NAME_Log), justNewlined(true), coLen(0) {
+    mythread_mutex_init_recursive(&dedTTYLock);
     // the first line should be cleared
     collectedLine[coLen++] = '\x1b';
     collectedLine[coLen++] = '[';
@@ -140,11 +145,19 @@ public:
   }
 
 public:
+  virtual bool IsThreadSafe () const noexcept override { return true; }
+
   virtual void Serialise (const char *Text, EName Event) noexcept override {
-    if (Event == NAME_Dev && !developer) return;
+    SerialiseMessage(VLogMessage(Text, Event));
+  }
+
+  virtual void SerialiseMessage (const VLogMessage &msg) noexcept override {
+    const EName Event = msg.type;
+    if (Event == NAME_Dev && !msg.devMode) return;
     //if (!ddlogfout) return;
+    MyThreadLocker lock(&dedTTYLock);
     lastEvent = Event;
-    VStr rc = VStr(Text).RemoveColors();
+    VStr rc = VStr(msg.text).RemoveColors();
     const char *rstr = *rc;
     if (!rstr || !rstr[0]) return;
     // use scroll region that is one less than the TTY height
@@ -168,12 +181,11 @@ public:
           resetColor = false;
         }
         #endif
-        putStr(VName::SafeString(lastEvent));
+        putStr(msg.typeName);
         putStr(":");
         if (lastEvent == NAME_DevNet) {
-          unsigned msecs = unsigned(Sys_Time()*1000);
           char buf[64];
-          snprintf(buf, sizeof(buf), "%u:", msecs);
+          snprintf(buf, sizeof(buf), "%u:", (unsigned)msg.msecs);
           putStr(buf);
         }
         #if !defined(_WIN32)
@@ -206,8 +218,8 @@ static VDedLog DedLog;
 //
 //==========================================================================
 void FConsoleDevice::Serialise (const char *V, EName Event) noexcept {
-  DedLog.Serialise(V, Event);
-  DedLog.Serialise("\n", Event);
+  // `DedLog` is called from the log thread
+  GLog.Log(Event, V);
 }
 
 
@@ -217,6 +229,7 @@ void FConsoleDevice::Serialise (const char *V, EName Event) noexcept {
 //
 //==========================================================================
 static void DD_SysErrorCallback (const char *msg) noexcept {
+  MyThreadLocker lock(&dedTTYLock);
   if (ddlogfout) {
     fprintf(ddlogfout, "%s\n", (msg ? msg : ""));
     fclose(ddlogfout);
@@ -231,6 +244,7 @@ static void DD_SysErrorCallback (const char *msg) noexcept {
 //
 //==========================================================================
 static void DD_ShutdownLog () {
+  MyThreadLocker lock(&dedTTYLock);
   if (ddlogfout) {
     fclose(ddlogfout);
     ddlogfout = nullptr;
@@ -61,12 +61,22 @@ int cli_ShowEndText = 0;
   VParsedArgs::RegisterFlagSet("-con-dump-all-vars", "!dump all console variables", &cli_DumpAllVars);
 
 const char *cli_LogFileName = nullptr;
+static int cli_LogSync = 0;
+static const char *cli_SimBench = nullptr;
+static const char *cli_ZoneProf = nullptr;
 
 /*static*/ bool cliRegister_con_args =
+  VParsedArgs::RegisterFlagSet("-log-sync", "write console and log output in the game thread", &cli_LogSync) &&
   VParsedArgs::RegisterStringOption("-logfile", "specify log file name", &cli_LogFileName) &&
   VParsedArgs::RegisterAlias("-log-file", "-logfile") &&
   VParsedArgs::RegisterAlias("--log-file", "-logfile");
 
+/*static*/ bool cliRegister_simbench_args =
+  VParsedArgs::RegisterStringOption("-simbench", "run simulation benchmark with the given `SimBench` arguments, and quit", &cli_SimBench);
+
+/*static*/ bool cliRegister_zoneprof_args =
+  VParsedArgs::RegisterStringOption("-zoneprof", "start allocation profiler with the given sampling rate (see `ZoneProf`)", &cli_ZoneProf);
+
 
 
 // state updates, number of tics/second
@@ -173,6 +183,18 @@ static VCvarI cl_framerate_net_timeout("cl_framerate_net_timeout", "28", "If we
 #include "dedlog.cpp"
 
 
+//==========================================================================
+//
+//  Host_LogDevMode
+//
+//  log listeners may run on the log thread, so `developer` is read here
+//
+//==========================================================================
+static bool Host_LogDevMode () noexcept {
+  return developer;
+}
+
+
 //==========================================================================
 //
 //  Host_CollectGarbage
@@ -227,7 +249,20 @@ void Host_Init () {
   #ifdef CLIENT
   C_Init(); // init console
   #endif
+  GLogDevModeCB = &Host_LogDevMode;
   DD_SetupLog();
+  // log listeners are set up, so we can move console and tty output to the log thread
+  if (cli_LogSync <= 0) VLog::StartAsync();
+  VTrace::SetThreadName("main");
+
+  if (cli_ZoneProf && cli_ZoneProf[0]) {
+    int rate = 0;
+    if (VStr::convertInt(cli_ZoneProf, &rate) && rate > 0) {
+      Z_ProfStart(rate);
+    } else {
+      GCon->Logf(NAME_Warning, "invalid allocation profiler sampling rate '%s'", cli_ZoneProf);
+    }
+  }
 
   {
     VStr cfgdir = FL_GetConfigDir();
@@ -400,6 +435,15 @@ void Host_Init () {
 #endif
   }
 
+  if (cli_SimBench && cli_SimBench[0]) {
+    // benchmark starts its own map
+    Host_CLIMapStartFound();
+    VCommand::cliPreCmds += va("SimBench -quit %s\n", cli_SimBench);
+#ifndef CLIENT
+    wasWarp = true;
+#endif
+  }
+
   GCmdBuf.Exec();
 
 #ifdef CLIENT
@@ -617,6 +661,35 @@ static void Host_UpdateLanguage () {
 
 static double lastNetFrameTime = 0;
 
+// `TraceFrames` command: number of frames left to trace, and the file to write
+static int traceFramesLeft = 0;
+static VStr traceFramesFile;
+
+
+//==========================================================================
+//
+//  Host_SaveTrace
+//
+//==========================================================================
+void Host_SaveTrace (VStr fname) {
+  if (fname.isEmpty()) fname = FL_GetConfigDir()+"/trace.json";
+  VStream *strm = FL_OpenSysFileWrite(fname);
+  if (!strm) {
+    GCon->Logf(NAME_Error, "cannot create trace file '%s'", *fname);
+    return;
+  }
+  bool ok = VTrace::ExportChrome(strm);
+  if (!strm->Close()) ok = false;
+  delete strm;
+  VTraceStats stats;
+  VTrace::GetStats(&stats);
+  if (!ok) {
+    GCon->Logf(NAME_Error, "error writing trace file '%s'", *fname);
+  } else {
+    GCon->Logf("trace saved to '%s' (%u events from %d threads, %u dropped)", *fname, (unsigned)stats.events, stats.threads, (unsigned)stats.dropped);
+  }
+}
+
 //==========================================================================
 //
 //  Host_Frame
@@ -660,6 +733,8 @@ void Host_Frame () {
 
     lastNetFrameTime = systime;
 
+    VTRACE_ZONE("Host_Frame");
+
     if (GSoundManager) GSoundManager->Process();
 
     Host_UpdateLanguage();
@@ -673,24 +748,34 @@ void Host_Frame () {
     Host_GetConsoleCommands();
 
     // process console commands
-    GCmdBuf.Exec();
+    {
+      VTRACE_ZONE("CmdBuf");
+      GCmdBuf.Exec();
+    }
     if (host_request_exit) Host_Quit();
 
     bool incFrame = false;
 
-    GNet->Poll();
+    {
+      VTRACE_ZONE("NetPoll");
+      GNet->Poll();
+    }
 
     // if we perfomed load/save, frame time will be near zero, so do nothing
     if (host_frametime >= max_fps_cap_double) {
       incFrame = true;
 
       #ifdef CLIENT
-      CL_SendMove(); // this also ticks network
+      {
+        VTRACE_ZONE("CL_SendMove");
+        CL_SendMove(); // this also ticks network
+      }
       #endif
 
       #ifdef SERVER
       if (GGameInfo->NetMode != NM_None && GGameInfo->NetMode != NM_Client) {
         // server operations
+        VTRACE_ZONE("ServerFrame");
         ServerFrame(host_frametics);
       }
       # ifndef CLIENT
@@ -705,10 +790,16 @@ void Host_Frame () {
 
       #ifdef CLIENT
       // fetch results from server
-      CL_ReadFromServer(host_frametime);
+      {
+        VTRACE_ZONE("CL_ReadFromServer");
+        CL_ReadFromServer(host_frametime);
+      }
 
       // update user interface
-      GRoot->TickWidgets(host_frametime);
+      {
+        VTRACE_ZONE("TickWidgets");
+        GRoot->TickWidgets(host_frametime);
+      }
       #endif
     }
 
@@ -717,7 +808,10 @@ void Host_Frame () {
     #ifdef CLIENT
     // update video
     if (show_time) time1 = Sys_Time();
-    SCR_Update();
+    {
+      VTRACE_ZONE("SCR_Update");
+      SCR_Update();
+    }
     if (show_time) time2 = Sys_Time();
 
     if (cls.signon) CL_DecayLights();
@@ -736,6 +830,10 @@ void Host_Frame () {
 
     if (incFrame) {
       ++host_framecount;
+      if (traceFramesLeft > 0 && --traceFramesLeft == 0) {
+        VTrace::Stop();
+        Host_SaveTrace(traceFramesFile);
+      }
     } else {
       if (developer) GCon->Log(NAME_Dev, "Frame delayed due to lengthy operation (this is perfectly ok)");
     }
@@ -841,6 +939,154 @@ COMMAND(Version) {
 }
 
 
+//==========================================================================
+//
+//  LogAsyncStats
+//
+//==========================================================================
+COMMAND(LogAsyncStats) {
+  VLogAsyncStats stats;
+  VLog::GetAsyncStats(&stats);
+  if (!stats.active) {
+    GCon->Log("log thread is not active");
+    return;
+  }
+  GCon->Logf("log queue: %d KB; used: %d bytes (peak: %d bytes)", stats.bufferSize/1024, stats.used, stats.peakUsed);
+  GCon->Logf("  %u messages queued, %u dropped, %u written synchronously", (unsigned)stats.queued, (unsigned)stats.dropped, (unsigned)stats.syncFallbacks);
+}
+
+
+//==========================================================================
+//
+//  TraceStart
+//
+//  TraceStart [maxevents] -- start recording timing zones
+//  `maxevents` is per-thread buffer size
+//
+//==========================================================================
+COMMAND(TraceStart) {
+  int capacity = 0;
+  if (Args.length() > 1) {
+    if (!Args[1].convertInt(&capacity) || capacity < 0) {
+      GCon->Log("usage: TraceStart [maxevents]");
+      return;
+    }
+  }
+  traceFramesLeft = 0;
+  VTrace::Start(capacity);
+  VTraceStats stats;
+  VTrace::GetStats(&stats);
+  GCon->Logf("trace started (%d events per thread)", stats.capacity);
+}
+
+
+//==========================================================================
+//
+//  TraceStop
+//
+//==========================================================================
+COMMAND(TraceStop) {
+  traceFramesLeft = 0;
+  VTrace::Stop();
+  VTraceStats stats;
+  VTrace::GetStats(&stats);
+  GCon->Logf("trace stopped: %u events in %.3f seconds", (unsigned)stats.events, stats.duration);
+}
+
+
+//==========================================================================
+//
+//  TraceSave
+//
+//  TraceSave [filename] -- write Chrome trace JSON
+//
+//==========================================================================
+COMMAND(TraceSave) {
+  Host_SaveTrace(Args.length() > 1 ? Args[1] : VStr::EmptyString);
+}
+
+
+//==========================================================================
+//
+//  TraceFrames
+//
+//  TraceFrames count [filename] -- trace `count` frames, then save the trace
+//
+//==========================================================================
+COMMAND(TraceFrames) {
+  int count = 0;
+  if (Args.length() < 2 || !Args[1].convertInt(&count) || count < 1) {
+    GCon->Log("usage: TraceFrames count [filename]");
+    return;
+  }
+  traceFramesFile = (Args.length() > 2 ? Args[2] : VStr::EmptyString);
+  VTrace::Start();
+  traceFramesLeft = count;
+  GCon->Logf("tracing %d frames", count);
+}
+
+
+//==========================================================================
+//
+//  TraceStats
+//
+//==========================================================================
+COMMAND(TraceStats) {
+  VTraceStats stats;
+  VTrace::GetStats(&stats);
+  GCon->Logf("trace is %s; %d threads, %u events (%u dropped), %.3f seconds; %d events per thread", (stats.active ? "active" : "stopped"), stats.threads, (unsigned)stats.events, (unsigned)stats.dropped, stats.duration, stats.capacity);
+}
+
+
+//==========================================================================
+//
+//  ZoneProf
+//
+//  sampling allocation profiler
+//
+//  usage:
+//    ZoneProf start [rate]    -- start profiling, sample each `rate` allocation (default is 64)
+//    ZoneProf stop            -- stop profiling (collected data is kept)
+//    ZoneProf mark            -- start new period
+//    ZoneProf total [top]     -- show top allocation sites since profiler start
+//    ZoneProf live [top]      -- show top allocation sites by live bytes
+//    ZoneProf period [top]    -- show top allocation sites since the last mark (or map loading)
+//
+//  see also `dbg_zone_prof_tick_top` and `dbg_zone_prof_mapload_top`
+//
+//==========================================================================
+COMMAND(ZoneProf) {
+  if (Args.length() < 2) {
+    GCon->Logf("allocation profiler is %s (sampling rate is %d)", (Z_ProfIsActive() ? "active" : "not active"), Z_ProfGetRate());
+    GCon->Log("usage: ZoneProf start [rate] | stop | mark | total [top] | live [top] | period [top]");
+    return;
+  }
+  VStr cmd = Args[1];
+  int arg = -1;
+  if (Args.length() > 2 && (!Args[2].convertInt(&arg) || arg < 1)) {
+    GCon->Logf(NAME_Error, "ZoneProf: invalid number '%s'", *Args[2]);
+    return;
+  }
+  if (cmd.strEquCI("start")) {
+    Z_ProfStart(arg > 0 ? arg : 64);
+    GCon->Logf("allocation profiler started (sampling rate is %d)", Z_ProfGetRate());
+  } else if (cmd.strEquCI("stop")) {
+    Z_ProfStop();
+    GCon->Log("allocation profiler stopped");
+  } else if (cmd.strEquCI("mark")) {
+    Z_ProfMark(ZPROF_PERIOD);
+  } else if (cmd.strEquCI("total")) {
+    Z_ProfDump(ZPROF_TOTAL, (arg > 0 ? arg : 20), "console");
+  } else if (cmd.strEquCI("live")) {
+    Z_ProfDump(ZPROF_LIVE, (arg > 0 ? arg : 20), "console");
+  } else if (cmd.strEquCI("period")) {
+    Z_ProfDump(ZPROF_PERIOD, (arg > 0 ? arg : 20), "console");
+  } else {
+    GCon->Logf(NAME_Error, "ZoneProf: unknown command '%s'", *cmd);
+  }
+}
+
+
 //==========================================================================
 //
 //  Host_GetConfigDir
@@ -990,6 +1236,8 @@ void Host_Shutdown () {
 
   if (shutting_down) {
     GLog.Log("Recursive shutdown");
+    // we crashed while shutting down, so the log thread may never be stopped
+    VLog::EmergencyFlush();
     return;
   }
   shutting_down = true;
@@ -1059,6 +1307,9 @@ void Host_Shutdown () {
   //SAFE_SHUTDOWN(Z_Shutdown, ())
   //GLog.Log("k8vavoom: shutdown complete");
 
+  // console will close the log file
+  VLog::StopAsync();
+
 #ifdef CLIENT
   if (developer) GLog.Log(NAME_Dev, "shutting down console");
   C_Shutdown(); // save log
@@ -45,6 +45,9 @@ void Host_ResetSkipFrames ();
 // this does GC rougly twice per second (unless forced)
 void Host_CollectGarbage (bool forced=false);
 
+// writes recorded timing zones as Chrome trace JSON (empty name: "trace.json" in config dir)
+void Host_SaveTrace (VStr fname);
+
 extern VCvarB developer;
 
 extern bool host_initialised;
@@ -322,6 +322,47 @@ void VLevel::ClearReferences () {
 }
 
 
+//==========================================================================
+//
+//  VLevel::GetMapArena
+//
+//==========================================================================
+VMemArena *VLevel::GetMapArena () {
+  if (!MapArena) MapArena = new VMemArena();
+  return MapArena;
+}
+
+
+//==========================================================================
+//
+//  VLevel::FreeMapArena
+//
+//  all data allocated from the arena should be dropped at this point
+//
+//==========================================================================
+void VLevel::FreeMapArena () {
+  delete MapArena;
+  MapArena = nullptr;
+}
+
+
+//==========================================================================
+//
+//  VLevel::DumpMapArenaStats
+//
+//==========================================================================
+void VLevel::DumpMapArenaStats () const {
+  if (!MapArena) {
+    GCon->Log("map arena: empty");
+    return;
+  }
+  const VMemArenaStats &st = MapArena->GetStats();
+  GCon->Logf("map arena: %u allocations, %u KB used; %d blocks, %u KB total (%u KB unused)",
+    (unsigned)st.allocCount, (unsigned)(st.allocBytes/1024), st.blockCount, (unsigned)(st.blockBytes/1024),
+    (unsigned)((st.blockBytes-st.allocBytes)/1024));
+}
+
+
 //==========================================================================
 //
 //  VLevel::ClearCachedData
@@ -355,8 +396,9 @@ void VLevel::ClearAllMapData () {
 
   if (Lines) {
     for (auto &&line : allLines()) {
-      delete[] line.v1lines;
-      delete[] line.v2lines;
+      // vertex line lists are in the map arena
+      line.v1lines = line.v2lines = nullptr;
+      line.v1linesCount = line.v2linesCount = 0;
       line.moreTags.clear();
     }
   }
@@ -395,6 +437,10 @@ void VLevel::ClearAllMapData () {
 
   delete[] BlockLinks;
   BlockLinks = nullptr;
+  BlockLinksIterating = 0;
+  BlockLinksHoles.clear();
+  BlockLinksHoleCounts.clear();
+  BlockLinksStamps.clear();
 
   delete[] RejectMatrix;
   RejectMatrix = nullptr;
@@ -408,6 +454,9 @@ void VLevel::ClearAllMapData () {
   Zones = nullptr;
   NumZones = 0;
 
+  // regions and line lists are gone, so we can release the arena
+  FreeMapArena();
+
   GTextureManager.ResetMapTextures();
 }
 
@@ -435,15 +484,13 @@ void VLevel::Destroy () {
   csTouchCount = 0;
   csTouched = nullptr;
 
+  ResetSoundPropGraph();
+  P_PathTraverseBatchLevelDestroyed(this);
+
   // destroy all thinkers (including scripts)
   DestroyAllThinkers();
 
-  while (HeadSecNode) {
-    msecnode_t *Node = HeadSecNode;
-    HeadSecNode = Node->SNext;
-    delete Node;
-    Node = nullptr;
-  }
+  FreeAllSecnodes();
 
   // free render data
   if (Renderer) {
@@ -519,6 +566,12 @@ void VLevel::Destroy () {
     StaticLightsMap = nullptr;
   }
 
+  if (SightCache) {
+    SightCache->clear();
+    delete SightCache;
+    SightCache = nullptr;
+  }
+
   ActiveSequences.Clear();
 
   for (int i = 0; i < Translations.Num(); ++i) {
@@ -1031,6 +1084,11 @@ IMPLEMENT_FUNCTION(VLevel, ChangeOneSectorInternal) {
   Self->ChangeOneSectorInternal(sec);
 }
 
+IMPLEMENT_FUNCTION(VLevel, NoteGeometryChange) {
+  P_GET_SELF;
+  Self->NoteGeometryChange();
+}
+
 IMPLEMENT_FUNCTION(VLevel, AddExtraFloor) {
   P_GET_PTR(sector_t, dst);
   P_GET_PTR(line_t, line);
@@ -1164,3 +1222,17 @@ void CL_LoadLevel (VName MapName) {
   Host_ResetSkipFrames();
 }
 #endif
+
+
+//==========================================================================
+//
+//  MapArenaStats
+//
+//==========================================================================
+COMMAND(MapArenaStats) {
+  if (!GLevel) {
+    GCon->Log("no level loaded");
+    return;
+  }
+  GLevel->DumpMapArenaStats();
+}
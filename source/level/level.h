@@ -245,6 +245,31 @@ struct VLightParams {
 };
 
 
+// per-tick sight check cache (see `VEntity::CanSeeEx()`)
+struct VSightCacheKey {
+  vuint32 LookerUId;
+  vuint32 TargetUId;
+  vuint32 Flags; // `CSE_xxx` flags, plus "better sight" mode
+
+  inline bool operator == (const VSightCacheKey &k) const noexcept { return (LookerUId == k.LookerUId && TargetUId == k.TargetUId && Flags == k.Flags); }
+};
+
+inline vuint32 GetTypeHash (const VSightCacheKey &k) noexcept { return hashU32(k.LookerUId^(k.TargetUId*0x9e3779b9u)^(k.Flags<<24)); }
+
+// cached result is valid only if nothing that can affect it was changed
+struct VSightCacheEntry {
+  TVec LookerOrigin;
+  float LookerHeight;
+  float LookerYaw;
+  TVec TargetOrigin;
+  float TargetRadius;
+  float TargetHeight;
+  vint32 TicTime;
+  vuint32 GeometryChangeCount;
+  bool Result;
+};
+
+
 class VLevel : public VGameObject {
   DECLARE_CLASS(VLevel, VGameObject, 0)
   NO_DEFAULT_CONSTRUCTOR(VLevel)
@@ -316,7 +341,16 @@ class VLevel : public VGameObject {
   vint32 BlockMapHeight; // size in mapblocks
   float BlockMapOrgX; // origin of block map
   float BlockMapOrgY;
-  VEntity **BlockLinks;   // for thing chains
+  // things in each blockmap cell, stored contiguously; the most recently linked thing is the last one
+  TArray<VEntity *> *BlockLinks;
+  // unlinked things leave `nullptr` holes instead of shifting the list (iterators skip them);
+  // a cell is compacted when half of it is holes (unless some iterator is active), and
+  // all cells with holes are compacted when the outermost iterator ends (see `BlockLinksIterEnd()`)
+  vint32 BlockLinksIterating;
+  TArray<vint32> BlockLinksHoles; // cells with holes
+  TArray<vint32> BlockLinksHoleCounts; // per cell
+  // per cell; incremented when things are linked to or unlinked from the cell (used to invalidate caches)
+  TArray<vuint32> BlockLinksStamps;
   polyblock_t **PolyBlockMap;
 
   // REJECT
@@ -347,6 +381,7 @@ class VLevel : public VGameObject {
 
   VThinker *ThinkerHead;
   VThinker *ThinkerTail;
+  vuint32 ThinkerOrderCounter; // last assigned `VThinker::ThinkerOrder`
 
   VLevelInfo *LevelInfo;
   VWorldInfo *WorldInfo;
@@ -426,6 +461,21 @@ class VLevel : public VGameObject {
 
   TArray<VMapMarkerInfo> MapMarkers;
 
+  // sight check cache; cleared on each world tick
+  TMapNC<VSightCacheKey, VSightCacheEntry> *SightCache;
+  // incremented on each sector/polyobject geometry change; invalidates cached sight checks
+  vuint32 GeometryChangeCount;
+
+  // `msecnode_t` slab allocator (see "level_secnode.cpp"); all slabs are freed with the level
+  struct SecNodeSlab;
+  SecNodeSlab *SecNodeSlabs;
+  vint32 SecNodeSlabCount;
+  vint32 SecNodesInUse;
+
+  // arena for small map-lifetime data (sector regions, linedef vertex lists,
+  // renderer sector surfaces); released in `ClearAllMapData()`
+  VMemArena *MapArena;
+
 protected:
   // temporary working set for decal spreader
   struct DecalLineInfo {
@@ -563,6 +613,10 @@ public:
   void ResetSZValidCount ();
   void IncrementSZValidCount ();
 
+  // call this when sector or polyobject geometry is changed
+  inline void NoteGeometryChange () noexcept { ++GeometryChangeCount; }
+  void ResetSightCache ();
+
   // this saves everything except thinkers, so i can load it for further experiments
   void DebugSaveLevel (VStream &strm);
 
@@ -670,6 +724,20 @@ public:
 
   msecnode_t *AddSecnode (sector_t *, VEntity *, msecnode_t *);
   msecnode_t *DelSecnode (msecnode_t *);
+  msecnode_t *AllocSecnode ();
+  void FreeAllSecnodes ();
+  void GetSecnodeStats (int *slabs, int *total, int *inuse, int *freelisted) const;
+  void DumpSecnodeStats () const; // slow!
+
+  // thing iterators bracket their walk with these, so compaction won't shift cell lists under them
+  inline void BlockLinksIterBegin () noexcept { ++BlockLinksIterating; }
+  void BlockLinksIterEnd ();
+  void CompactBlockLinks (int cellidx);
+
+  // creates arena on first call
+  VMemArena *GetMapArena ();
+  void FreeMapArena ();
+  void DumpMapArenaStats () const;
   void DelSectorList ();
 
   int FindSectorFromTag (sector_t *&sector, int tag, int start=-1);
@@ -941,7 +1009,13 @@ private:
 
   void PostProcessForDecals ();
 
-  void processSoundSector (int validcount, TArray<VEntity *> &elist, sector_t *sec, int soundblocks, VEntity *soundtarget, float maxdist, const TVec sndorigin);
+  // sound propagation graph; built on map load, but will be rebuilt if necessary
+  void BuildSoundPropGraph ();
+  void ResetSoundPropGraph ();
+  // called when sector planes were changed
+  void NoteSoundPropSectorChange (const sector_t *sector);
+  bool IsSoundLineOpen (line_t *line);
+  void processSoundSector (int validcount, sector_t *sec, int soundblocks, VEntity *soundtarget, float maxdistSq, const TVec sndorigin);
   void doRecursiveSound (TArray<VEntity *> &elist, sector_t *sec, VEntity *soundtarget, float maxdist, const TVec sndorigin);
 
   void eventAfterLevelLoaded () {
@@ -1010,6 +1084,7 @@ private:
   DECLARE_FUNCTION(BSPTraceLineEx)
   DECLARE_FUNCTION(ChangeSector)
   DECLARE_FUNCTION(ChangeOneSectorInternal)
+  DECLARE_FUNCTION(NoteGeometryChange)
   DECLARE_FUNCTION(AddExtraFloor)
   DECLARE_FUNCTION(SwapPlanes)
   DECLARE_FUNCTION(CastLightRay)
@@ -1152,3 +1227,7 @@ bool P_GetMidTexturePosition (const line_t *line, int sideno, float *ptextop, fl
 extern int dbgEntityTickTotal;
 extern int dbgEntityTickSimple;
 extern int dbgEntityTickNoTick;
+extern int dbgSightCacheHits;
+extern int dbgSightCacheMisses;
+extern int dbgSecNodeAllocs;
+extern int dbgSecNodeFrees;
@@ -80,7 +80,7 @@ void VLevel::AddExtraFloorSane (line_t *line, sector_t *dst) {
   // insert into region array
   // control must have negative height, so
   // region floor is ceiling, and region ceiling is floor
-  sec_region_t *reg = dst->AllocRegion();
+  sec_region_t *reg = dst->AllocRegion(GetMapArena());
   if (flipped) {
     // flipped
     reg->efloor.set(&src->floor, true);
@@ -141,7 +141,7 @@ void VLevel::AddExtraFloorShitty (line_t *line, sector_t *dst) {
   dst->SectorFlags |= sector_t::SF_HasExtrafloors;
 
   // insert into region array
-  sec_region_t *reg = dst->AllocRegion();
+  sec_region_t *reg = dst->AllocRegion(GetMapArena());
   if (isSolid) {
     // solid region: floor points down, ceiling points up
     if (flipped) {
@@ -187,7 +187,7 @@ void VLevel::AddExtraFloorShitty (line_t *line, sector_t *dst) {
   if (!isSolid) {
     // non-solid regions has visible floor and ceiling only when camera is inside
     // add the same region, but with flipped floor and ceiling (and mark it as visual only)
-    sec_region_t *reg2 = dst->AllocRegion();
+    sec_region_t *reg2 = dst->AllocRegion(GetMapArena());
     reg2->efloor = reg->efloor;
     reg2->efloor.Flip();
     reg2->eceiling = reg->eceiling;
@@ -158,6 +158,8 @@ void VLevel::GetSubsectorBBox (subsector_t *sub, float bbox[6]) {
 void VLevel::CalcSecMinMaxs (sector_t *sector) {
   if (!sector) return; // k8: just in case
 
+  NoteSoundPropSectorChange(sector);
+
   unsigned slopedFC = 0;
 
   if (sector->floor.normal.z == 1.0f || sector->linecount == 0) {
@@ -26,6 +26,117 @@
 #include "../gamedefs.h"
 
 
+// nodes are allocated in slabs, so moving actors don't hit the allocator on each relink
+enum { SecNodesPerSlab = 1024 };
+
+struct VLevel::SecNodeSlab {
+  SecNodeSlab *next;
+  msecnode_t nodes[SecNodesPerSlab];
+};
+
+
+//=============================================================================
+//
+//  VLevel::AllocSecnode
+//
+//  takes a node from the freelist, allocating a new slab if it is empty
+//
+//=============================================================================
+msecnode_t *VLevel::AllocSecnode () {
+  if (!HeadSecNode) {
+    SecNodeSlab *slab = (SecNodeSlab *)Z_Malloc(sizeof(SecNodeSlab));
+    slab->next = SecNodeSlabs;
+    SecNodeSlabs = slab;
+    ++SecNodeSlabCount;
+    // link in reverse, so consecutive allocations get consecutive addresses
+    for (int f = SecNodesPerSlab-1; f >= 0; --f) {
+      slab->nodes[f].SNext = HeadSecNode;
+      HeadSecNode = &slab->nodes[f];
+    }
+  }
+  msecnode_t *Node = HeadSecNode;
+  HeadSecNode = Node->SNext;
+  ++SecNodesInUse;
+  ++dbgSecNodeAllocs;
+  return Node;
+}
+
+
+//=============================================================================
+//
+//  VLevel::FreeAllSecnodes
+//
+//  frees all slabs; there should be no live nodes at this point
+//
+//=============================================================================
+void VLevel::FreeAllSecnodes () {
+  while (SecNodeSlabs) {
+    SecNodeSlab *slab = SecNodeSlabs;
+    SecNodeSlabs = slab->next;
+    Z_Free(slab);
+  }
+  SecNodeSlabCount = 0;
+  SecNodesInUse = 0;
+  HeadSecNode = nullptr;
+  SectorList = nullptr;
+}
+
+
+//=============================================================================
+//
+//  VLevel::GetSecnodeStats
+//
+//=============================================================================
+void VLevel::GetSecnodeStats (int *slabs, int *total, int *inuse, int *freelisted) const {
+  if (slabs) *slabs = SecNodeSlabCount;
+  if (total) *total = SecNodeSlabCount*SecNodesPerSlab;
+  if (inuse) *inuse = SecNodesInUse;
+  if (freelisted) *freelisted = SecNodeSlabCount*SecNodesPerSlab-SecNodesInUse;
+}
+
+
+//=============================================================================
+//
+//  VLevel::DumpSecnodeStats
+//
+//  walks the freelist to show how free nodes are scattered over slabs
+//
+//=============================================================================
+void VLevel::DumpSecnodeStats () const {
+  TArray<const SecNodeSlab *> slabs;
+  for (const SecNodeSlab *slab = SecNodeSlabs; slab; slab = slab->next) slabs.append(slab);
+  TArray<int> freeCount;
+  freeCount.setLength(slabs.length());
+  for (auto &&v : freeCount) v = 0;
+
+  int orphans = 0;
+  for (const msecnode_t *Node = HeadSecNode; Node; Node = Node->SNext) {
+    bool found = false;
+    for (int f = 0; f < slabs.length(); ++f) {
+      if (Node >= &slabs[f]->nodes[0] && Node < &slabs[f]->nodes[SecNodesPerSlab]) {
+        ++freeCount[f];
+        found = true;
+        break;
+      }
+    }
+    if (!found) ++orphans;
+  }
+
+  int emptySlabs = 0, fullSlabs = 0, partialFree = 0, totalFree = 0;
+  for (auto &&v : freeCount) {
+    totalFree += v;
+    if (v == SecNodesPerSlab) ++emptySlabs;
+    else if (v == 0) ++fullSlabs;
+    else partialFree += v;
+  }
+
+  GCon->Logf("secnodes: %d slabs (%d nodes each, %u bytes total); %d nodes in use, %d free", SecNodeSlabCount, (int)SecNodesPerSlab, (unsigned)(SecNodeSlabCount*sizeof(SecNodeSlab)), SecNodesInUse, totalFree);
+  GCon->Logf("secnodes: %d empty slabs, %d full slabs, %d partially used", emptySlabs, fullSlabs, slabs.length()-emptySlabs-fullSlabs);
+  GCon->Logf("secnodes: fragmentation: %d%% of free nodes are in partially used slabs", (totalFree ? partialFree*100/totalFree : 0));
+  if (orphans) GCon->Logf(NAME_Error, "secnodes: %d free nodes are not in any slab!", orphans);
+}
+
+
 //=============================================================================
 //
 //  VLevel::AddSecnode
@@ -55,12 +166,7 @@ msecnode_t *VLevel::AddSecnode (sector_t *Sec, VEntity *Thing, msecnode_t *NextN
   // couldn't find an existing node for this sector: add one at the head of the list
 
   // retrieve a node from the freelist
-  if (HeadSecNode) {
-    Node = HeadSecNode;
-    HeadSecNode = HeadSecNode->SNext;
-  } else {
-    Node = new msecnode_t;
-  }
+  Node = AllocSecnode();
 
   // killough 4/4/98, 4/7/98: mark new nodes unvisited
   Node->Visited = 0;
@@ -112,6 +218,8 @@ msecnode_t *VLevel::DelSecnode (msecnode_t *Node) {
     // return this node to the freelist
     Node->SNext = HeadSecNode;
     HeadSecNode = Node;
+    --SecNodesInUse;
+    ++dbgSecNodeFrees;
     return tn;
   }
   return nullptr;
@@ -133,3 +241,17 @@ void VLevel::DelSectorList () {
     SectorList = nullptr;
   }
 }
+
+
+//=============================================================================
+//
+//  SecNodeStats
+//
+//=============================================================================
+COMMAND(SecNodeStats) {
+  if (!GLevel) {
+    GCon->Log("no level loaded");
+    return;
+  }
+  GLevel->DumpSecnodeStats();
+}
@@ -32,6 +32,7 @@ static VCvarB gm_compat_everything_can_hear("gm_compat_everything_can_hear", fal
 static VCvarF gm_compat_max_hearing_distance("gm_compat_max_hearing_distance", "0", "Maximum hearing distance (0 means unlimited)?", CVAR_Archive);
 static VCvarB gm_compat_better_sound_distance("gm_compat_better_sound_distance", true, "Check line distance on sound propagation?", CVAR_Archive);
 static VCvarB dbg_disable_sound_alert("dbg_disable_sound_alert", false, "Disable sound alerting?", CVAR_PreInit);
+static VCvarB dbg_sound_alert_nocache("dbg_sound_alert_nocache", false, "Disable line opening cache and alert coalescing in sound propagation?", CVAR_PreInit);
 
 
 // ////////////////////////////////////////////////////////////////////////// //
@@ -39,6 +40,14 @@ static VCvarB dbg_disable_sound_alert("dbg_disable_sound_alert", false, "Disable
 // moved here 'cause levels like Vela Pax with ~10000 interconnected sectors
 // causes a huge slowdown on shooting
 // will be moved back to VM when i'll implement JIT compiler
+//
+// flooding walks a sector graph built on map load: only lines that can
+// ever pass the sound (two-sided, not self-referenced) are in it.
+// "is this door closed" check is expensive, so its result is cached per
+// line, and invalidated when any of line sectors is changed (this is
+// tracked in `CalcSecMinMaxs()`, which is called for any plane change).
+// also, several alerts from the same sector in the same tic (chaingun fire
+// from several monsters, for example) flood the level only once.
 
 //private transient array!Entity recSoundSectorEntities; // will be collected in native code
 
@@ -48,95 +57,248 @@ struct SoundSectorListItem {
 };
 
 
+struct SoundPropEdge {
+  line_t *line;
+  sector_t *other;
+};
+
+
+// graph is built for one level (server one)
+static VLevel *spLevel = nullptr;
+static TArray<int> spEdgeStart; // [NumSectors+1]; edges for sector `n` are [spEdgeStart[n]..spEdgeStart[n+1])
+static TArray<SoundPropEdge> spEdges;
+// sector change stamps, and line opening cache
+// line opening is valid if both sectors weren't changed after `spLineCheckedAt`
+static vuint32 spStampCounter = 1;
+static TArray<vuint32> spSectorStamp; // [NumSectors]
+static TArray<vuint32> spLineCheckedAt; // [NumLines]; 0 means "not checked"
+static TArray<vuint8> spLineOpen; // [NumLines]
+// entity collecting (sector can be flooded several times with different `sblock`)
+static vuint32 spCollectCounter = 0;
+static TArray<vuint32> spSectorCollected; // [NumSectors]
+
+// last flood, for coalescing
 static TArray<SoundSectorListItem> recSoundSectorList;
-static TMapNC<VEntity *, bool> recSoundSectorSeenEnts;
+static struct {
+  VLevel *level;
+  sector_t *sec;
+  VEntity *soundtarget;
+  float maxdistSq;
+  TVec sndorigin;
+  int tic;
+  vuint32 stamp;
+  bool betterDist;
+} spLastFlood = { nullptr, nullptr, nullptr, 0.0f, TVec(0.0f, 0.0f, 0.0f), 0, 0, false };
 
 
 //==========================================================================
 //
-//  VLevel::processSoundSector
+//  VLevel::ResetSoundPropGraph
 //
 //==========================================================================
-void VLevel::processSoundSector (int validcount, TArray<VEntity *> &elist, sector_t *sec, int soundblocks, VEntity *soundtarget, float maxdistSq, const TVec sndorigin) {
-  if (!sec) return;
+void VLevel::ResetSoundPropGraph () {
+  if (spLevel != this && spLastFlood.level != this) return;
+  spLevel = nullptr;
+  spLastFlood.level = nullptr;
+  spEdgeStart.clear();
+  spEdges.clear();
+  spSectorStamp.clear();
+  spLineCheckedAt.clear();
+  spLineOpen.clear();
+  spSectorCollected.clear();
+  recSoundSectorList.clear();
+}
 
-  // `validcount` and other things were already checked in caller
-  // also, caller already set `soundtraversed` and `SoundTarget`
-  // that is, you MUST NOT check `soundtraversed` here!
-  const bool distUnlim = (maxdistSq == 0.0f);
 
-  unsigned hmask = 0/*, exmask = VEntity::EFEX_NoInteraction*/;
-  if (!gm_compat_everything_can_hear) {
-    hmask = VEntity::EF_NoSector|VEntity::EF_NoBlockmap;
-    if (!gm_compat_corpses_can_hear) hmask |= VEntity::EF_Corpse;
-  }
+//==========================================================================
+//
+//  VLevel::BuildSoundPropGraph
+//
+//==========================================================================
+void VLevel::BuildSoundPropGraph () {
+  ResetSoundPropGraph();
+  if (NumSectors <= 0) return;
 
-  for (VEntity *Ent = sec->ThingList; Ent; Ent = Ent->SNext) {
-    //FIXME: skip some entities that cannot (possibly) react
-    //       this can break some code, but... meh
-    //       maybe don't omit corpses?
-    if ((Ent->EntityFlags&hmask)|(Ent->FlagsEx&VEntity::EFEX_NoInteraction)) continue;
-    if (Ent == soundtarget) continue; // skip target
-    // check max distance
-    if (!distUnlim && length2DSquared(sndorigin-Ent->Origin) > maxdistSq) continue;
-    if (!recSoundSectorSeenEnts.put(Ent, true)) {
-      // register for processing
-      elist.append(Ent);
+  spEdgeStart.setLength(NumSectors+1);
+  for (int sidx = 0; sidx < NumSectors; ++sidx) {
+    sector_t *sec = &Sectors[sidx];
+    spEdgeStart[sidx] = spEdges.length();
+    line_t **slinesptr = sec->lines;
+    for (int i = sec->linecount; i--; ++slinesptr) {
+      line_t *line = *slinesptr;
+      // ignore one-sided lines
+      if (line->sidenum[1] == -1) continue;
+      // ignore self-referenced sectors
+      if (line->frontsector == line->backsector) continue;
+      sector_t *other = (line->frontsector == sec ? line->backsector : line->frontsector);
+      if (!other) continue; // just in case
+      // `ML_TWOSIDED` and `ML_SOUNDBLOCK` can be changed by scripts, so they are checked on flooding
+      SoundPropEdge &e = spEdges.alloc();
+      e.line = line;
+      e.other = other;
     }
   }
+  spEdgeStart[NumSectors] = spEdges.length();
+
+  spSectorStamp.setLength(NumSectors);
+  for (auto &&st : spSectorStamp) st = spStampCounter;
+  spLineCheckedAt.setLength(NumLines);
+  for (auto &&ca : spLineCheckedAt) ca = 0;
+  spLineOpen.setLength(NumLines);
+  spSectorCollected.setLength(NumSectors);
+  for (auto &&sc : spSectorCollected) sc = 0;
+  spCollectCounter = 0;
+
+  spLevel = this;
+}
 
-  line_t **slinesptr = sec->lines;
-  for (int i = sec->linecount; i--; ++slinesptr) {
-    const line_t *line = *slinesptr;
 
-    // ignore one-sided lines
-    if (line->sidenum[1] == -1 || !(line->flags&ML_TWOSIDED)) continue;
+//==========================================================================
+//
+//  VLevel::NoteSoundPropSectorChange
+//
+//==========================================================================
+void VLevel::NoteSoundPropSectorChange (const sector_t *sector) {
+  if (spLevel != this || !sector) return;
+  const int sidx = (int)(ptrdiff_t)(sector-Sectors);
+  if (sidx < 0 || sidx >= spSectorStamp.length()) return; // just in case
+  if (++spStampCounter == 0) {
+    // wrapped; invalidate everything
+    for (auto &&ca : spLineCheckedAt) ca = 0;
+    for (auto &&st : spSectorStamp) st = 1;
+    spStampCounter = 2;
+  }
+  spSectorStamp[sidx] = spStampCounter;
+}
 
-    // ignore self-referenced sectors
-    if (line->frontsector == line->backsector) continue;
 
-    sector_t *other = (line->frontsector == sec ? line->backsector : line->frontsector);
-    if (!other) continue; // just in case
+//==========================================================================
+//
+//  IsSoundLineOpenInternal
+//
+//==========================================================================
+static bool IsSoundLineOpenInternal (line_t *line) {
+  // check for closed door
+  opening_t *op = SV_LineOpenings(line, *line->v1, 0xffffffff);
+  while (op && op->range <= 0.0f) op = op->next;
+  if (!op) {
+    op = SV_LineOpenings(line, *line->v2, 0xffffffff);
+    while (op && op->range <= 0.0f) op = op->next;
+    if (!op) return false; // closed door
+  }
+  return true;
+}
 
-    bool addIt = false;
-    int sblock = 0;
 
+//==========================================================================
+//
+//  VLevel::IsSoundLineOpen
+//
+//==========================================================================
+bool VLevel::IsSoundLineOpen (line_t *line) {
+  if (dbg_sound_alert_nocache.asBool()) return IsSoundLineOpenInternal(line);
+  const int lidx = (int)(ptrdiff_t)(line-Lines);
+  const vuint32 checked = spLineCheckedAt[lidx];
+  if (checked &&
+      spSectorStamp[(int)(ptrdiff_t)(line->frontsector-Sectors)] <= checked &&
+      spSectorStamp[(int)(ptrdiff_t)(line->backsector-Sectors)] <= checked)
+  {
+    return spLineOpen[lidx];
+  }
+  const bool res = IsSoundLineOpenInternal(line);
+  spLineCheckedAt[lidx] = spStampCounter;
+  spLineOpen[lidx] = (res ? 1 : 0);
+  return res;
+}
+
+
+//==========================================================================
+//
+//  VLevel::processSoundSector
+//
+//  floods to neighbour sectors
+//
+//==========================================================================
+void VLevel::processSoundSector (int validcount, sector_t *sec, int soundblocks, VEntity *soundtarget, float maxdistSq, const TVec sndorigin) {
+  if (!sec) return;
+
+  // `validcount` and other things were already checked in caller
+  // also, caller already set `soundtraversed` and `SoundTarget`
+  // that is, you MUST NOT check `soundtraversed` here!
+  const bool checkLineDist = (maxdistSq != 0.0f && gm_compat_better_sound_distance.asBool());
+
+  const int sidx = (int)(ptrdiff_t)(sec-Sectors);
+  const SoundPropEdge *edge = spEdges.ptr()+spEdgeStart[sidx];
+  for (int i = spEdgeStart[sidx+1]-spEdgeStart[sidx]; i--; ++edge) {
+    line_t *line = edge->line;
+    if (!(line->flags&ML_TWOSIDED)) continue;
+
+    int sblock;
     if (line->flags&ML_SOUNDBLOCK) {
-      if (soundblocks == 0) {
-        //RecursiveSound(other, 1, soundtarget, Splash, maxdist!optional, emmiter!optional);
-        addIt = true;
-        sblock = 1;
-      }
+      if (soundblocks != 0) continue;
+      sblock = 1;
     } else {
-      //RecursiveSound(other, soundblocks, soundtarget, Splash, maxdist!optional, emmiter!optional);
-      addIt = true;
       sblock = soundblocks;
     }
 
-    if (addIt) {
-      // don't add one sector several times
-      if (other->validcount == validcount && other->soundtraversed <= sblock+1) continue; // already flooded
-      // check for closed door
-      opening_t *op = SV_LineOpenings(line, *line->v1, 0xffffffff);
-      while (op && op->range <= 0.0f) op = op->next;
-      if (!op) {
-        op = SV_LineOpenings(line, *line->v2, 0xffffffff);
-        while (op && op->range <= 0.0f) op = op->next;
-        if (!op) continue; // closed door
-      }
-      //GCon->Logf(NAME_Debug, "  sound to sector: scount=%d; from sector=%d; sector=%d from line %d", sblock, (int)(ptrdiff_t)(sec-&Sectors[0]), (int)(ptrdiff_t)(other-&Sectors[0]), (int)(ptrdiff_t)(check-&Lines[0]));
-      // if both vertices are too far, don't travel this line
-      if (!distUnlim && gm_compat_better_sound_distance.asBool()) {
-        if (length2DSquared(sndorigin-(*line->v1)) > maxdistSq && length2DSquared(sndorigin-(*line->v2)) > maxdistSq) continue;
-      }
-      // set flags
-      other->validcount = validcount;
-      other->soundtraversed = sblock+1;
-      other->SoundTarget = soundtarget;
-      // add to processing list
-      SoundSectorListItem &sl = recSoundSectorList.alloc();
-      sl.sec = other;
-      sl.sblock = sblock;
+    sector_t *other = edge->other;
+    // don't add one sector several times
+    if (other->validcount == validcount && other->soundtraversed <= sblock+1) continue; // already flooded
+    if (!IsSoundLineOpen(line)) continue; // closed door
+    //GCon->Logf(NAME_Debug, "  sound to sector: scount=%d; from sector=%d; sector=%d from line %d", sblock, (int)(ptrdiff_t)(sec-&Sectors[0]), (int)(ptrdiff_t)(other-&Sectors[0]), (int)(ptrdiff_t)(check-&Lines[0]));
+    // if both vertices are too far, don't travel this line
+    if (checkLineDist) {
+      if (length2DSquared(sndorigin-(*line->v1)) > maxdistSq && length2DSquared(sndorigin-(*line->v2)) > maxdistSq) continue;
+    }
+    // set flags
+    other->validcount = validcount;
+    other->soundtraversed = sblock+1;
+    other->SoundTarget = soundtarget;
+    // add to processing list
+    SoundSectorListItem &sl = recSoundSectorList.alloc();
+    sl.sec = other;
+    sl.sblock = sblock;
+  }
+}
+
+
+//==========================================================================
+//
+//  CollectSoundEntities
+//
+//  collects entities from all flooded sectors
+//
+//==========================================================================
+static void CollectSoundEntities (VLevel *Level, TArray<VEntity *> &elist, VEntity *soundtarget, float maxdistSq, const TVec sndorigin) {
+  const bool distUnlim = (maxdistSq == 0.0f);
+
+  unsigned hmask = 0/*, exmask = VEntity::EFEX_NoInteraction*/;
+  if (!gm_compat_everything_can_hear) {
+    hmask = VEntity::EF_NoSector|VEntity::EF_NoBlockmap;
+    if (!gm_compat_corpses_can_hear) hmask |= VEntity::EF_Corpse;
+  }
+
+  if (++spCollectCounter == 0) {
+    for (auto &&sc : spSectorCollected) sc = 0;
+    spCollectCounter = 1;
+  }
+
+  for (auto &&sli : recSoundSectorList) {
+    // sector can be flooded again with lesser `sblock`, but it has the same entities
+    vuint32 &collected = spSectorCollected[(int)(ptrdiff_t)(sli.sec-Level->Sectors)];
+    if (collected == spCollectCounter) continue;
+    collected = spCollectCounter;
+    // entity is linked to only one sector, so there's no need to check for duplicates
+    for (VEntity *Ent = sli.sec->ThingList; Ent; Ent = Ent->SNext) {
+      //FIXME: skip some entities that cannot (possibly) react
+      //       this can break some code, but... meh
+      //       maybe don't omit corpses?
+      if ((Ent->EntityFlags&hmask)|(Ent->FlagsEx&VEntity::EFEX_NoInteraction)) continue;
+      if (Ent == soundtarget) continue; // skip target
+      // check max distance
+      if (!distUnlim && length2DSquared(sndorigin-Ent->Origin) > maxdistSq) continue;
+      // register for processing
+      elist.append(Ent);
     }
   }
 }
@@ -152,6 +314,7 @@ void VLevel::processSoundSector (int validcount, TArray<VEntity *> &elist, secto
 //==========================================================================
 void VLevel::doRecursiveSound (TArray<VEntity *> &elist, sector_t *sec, VEntity *soundtarget, float maxdist, const TVec sndorigin) {
   if (!sec) return;
+  if (spLevel != this) BuildSoundPropGraph();
   IncrementValidCount();
 
   // wake up all monsters in this sector
@@ -165,25 +328,54 @@ void VLevel::doRecursiveSound (TArray<VEntity *> &elist, sector_t *sec, VEntity
   }
   maxdist *= maxdist; // squared
 
+  // the same alert in the same tic, and nothing was changed? reuse flooded sectors
+  const bool betterDist = gm_compat_better_sound_distance.asBool();
+  if (!dbg_sound_alert_nocache.asBool() &&
+      spLastFlood.level == this && spLastFlood.sec == sec && spLastFlood.soundtarget == soundtarget &&
+      spLastFlood.tic == TicTime && spLastFlood.stamp == spStampCounter &&
+      spLastFlood.maxdistSq == maxdist && spLastFlood.betterDist == betterDist &&
+      (maxdist == 0.0f || spLastFlood.sndorigin == sndorigin))
+  {
+    // other alerts could overwrite sector fields, so restore them
+    // sectors flooded several times will get the last (i.e. the final) value
+    for (auto &&sli : recSoundSectorList) {
+      sli.sec->validcount = validcount;
+      sli.sec->soundtraversed = sli.sblock+1;
+      sli.sec->SoundTarget = soundtarget;
+    }
+    CollectSoundEntities(this, elist, soundtarget, maxdist, sndorigin);
+    return;
+  }
+
   sec->validcount = validcount;
   sec->soundtraversed = /*soundblocks*/0+1;
   sec->SoundTarget = soundtarget;
 
   recSoundSectorList.resetNoDtor();
-  recSoundSectorSeenEnts.reset();
-  processSoundSector(validcount, elist, sec, /*soundblocks*/0, soundtarget, maxdist, sndorigin);
+  SoundSectorListItem &first = recSoundSectorList.alloc();
+  first.sec = sec;
+  first.sblock = 0;
 
   // don't use `foreach` here!
   int rspos = 0;
   while (rspos < recSoundSectorList.length()) {
     const SoundSectorListItem *sli = recSoundSectorList.ptr()+rspos;
-    processSoundSector(validcount, elist, sli->sec, sli->sblock, soundtarget, maxdist, sndorigin);
+    processSoundSector(validcount, sli->sec, sli->sblock, soundtarget, maxdist, sndorigin);
     ++rspos;
   }
 
+  spLastFlood.level = this;
+  spLastFlood.sec = sec;
+  spLastFlood.soundtarget = soundtarget;
+  spLastFlood.maxdistSq = maxdist;
+  spLastFlood.sndorigin = sndorigin;
+  spLastFlood.tic = TicTime;
+  spLastFlood.stamp = spStampCounter;
+  spLastFlood.betterDist = betterDist;
+
+  CollectSoundEntities(this, elist, soundtarget, maxdist, sndorigin);
+
   //if (recSoundSectorList.length > 1) print("RECSOUND: len=%d", recSoundSectorList.length);
-  //recSoundSectorList.resetNoDtor();
-  //recSoundSectorSeenEnts.reset();
 }
 
 
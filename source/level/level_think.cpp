@@ -37,6 +37,7 @@ VCvarB dbg_vm_disable_thinkers("dbg_vm_disable_thinkers", false, "Disable VM thi
 VCvarB dbg_vm_enable_secthink("dbg_vm_enable_secthink", true, "Enable sector thinkers when VM thinkers are disabled (for debug)?", CVAR_PreInit);
 VCvarB dbg_vm_disable_specials("dbg_vm_disable_specials", false, "Disable updating specials (for debug)?", CVAR_PreInit);
 VCvarB dbg_vm_show_tick_stats("dbg_vm_show_tick_stats", false, "Show some debug tick statistics?", CVAR_PreInit);
+static VCvarI dbg_zone_prof_tick_top("dbg_zone_prof_tick_top", "0", "Show this number of top allocation sites after each world tick, if allocation profiler is active (see `ZoneProf`).", CVAR_PreInit);
 
 static VCvarB dbg_limiter_counters("dbg_limiter_counters", false, "Show limiter counters?", CVAR_PreInit);
 static VCvarB dbg_limiter_remove_messages("dbg_limiter_remove_messages", false, "Show limiter remove messages?", CVAR_PreInit);
@@ -51,6 +52,10 @@ static TArray<VEntity *> corpseQueue;
 int dbgEntityTickTotal = 0;
 int dbgEntityTickSimple = 0;
 int dbgEntityTickNoTick = 0;
+int dbgSightCacheHits = 0;
+int dbgSightCacheMisses = 0;
+int dbgSecNodeAllocs = 0;
+int dbgSecNodeFrees = 0;
 
 
 //==========================================================================
@@ -159,6 +164,13 @@ void VLevel::AddThinker (VThinker *Th) {
   Th->Next = nullptr;
   if (ThinkerTail) ThinkerTail->Next = Th; else ThinkerHead = Th;
   ThinkerTail = Th;
+  // thinkers are always appended, so the order follows the list
+  if (++ThinkerOrderCounter == 0) {
+    // wrapped (this is very unlikely); renumber the whole list
+    for (VThinker *t = ThinkerHead; t; t = t->Next) t->ThinkerOrder = ++ThinkerOrderCounter;
+  } else {
+    Th->ThinkerOrder = ThinkerOrderCounter;
+  }
   // notify thinker that is was just added to a level
   Th->AddedToLevel();
 }
@@ -205,6 +217,7 @@ void VLevel::DestroyAllThinkers () {
   }
   ThinkerHead = nullptr;
   ThinkerTail = nullptr;
+  ThinkerOrderCounter = 0;
 }
 
 
@@ -248,6 +261,7 @@ void VLevel::UpdateThinkersLevelInfo () {
 //==========================================================================
 void VLevel::RunScriptThinkers (float DeltaTime) {
   if (DeltaTime <= 0.0f) return;
+  VTRACE_ZONE("RunScriptThinkers");
   // run script thinkers
   // do not run newly spawned scripts on this frame, though
   //const int sclenOrig = scriptThinkers.length();
@@ -343,6 +357,7 @@ void VLevel::TickDecals (float DeltaTime) {
 //==========================================================================
 void VLevel::TickWorld (float DeltaTime) {
   if (DeltaTime <= 0.0f) return;
+  VTRACE_ZONE("TickWorld");
 
   CheckAndRecalcWorldBBoxes();
 
@@ -354,6 +369,10 @@ void VLevel::TickWorld (float DeltaTime) {
   eventBeforeWorldTick(DeltaTime);
 
   dbgEntityTickTotal = dbgEntityTickSimple = dbgEntityTickNoTick = 0;
+  dbgSightCacheHits = dbgSightCacheMisses = 0;
+  dbgSecNodeAllocs = dbgSecNodeFrees = 0;
+  VScriptIterator::ResetAllocStats();
+  ResetSightCache();
 
   if (dbg_world_think_vm_time) stimet = -Sys_Time();
 
@@ -476,6 +495,7 @@ void VLevel::TickWorld (float DeltaTime) {
   }
 
   worldThinkTimeVM = (dbg_world_think_vm_time ? Sys_Time()+stimet : -1);
+  VTRACE_COUNTER("entity ticks", dbgEntityTickTotal);
 
   RunScriptThinkers(DeltaTime);
 
@@ -560,6 +580,21 @@ void VLevel::TickWorld (float DeltaTime) {
 
   if (dbg_vm_show_tick_stats.asBool()) {
     GCon->Logf(NAME_Debug, "TICK: total=%d; simple=%d; notick=%d (full left: %d)", dbgEntityTickTotal, dbgEntityTickSimple, dbgEntityTickNoTick, dbgEntityTickTotal-(dbgEntityTickSimple+dbgEntityTickNoTick));
+    GCon->Logf(NAME_Debug, "TICK: sight cache hits=%d; misses=%d", dbgSightCacheHits, dbgSightCacheMisses);
+    int snslabs, sntotal, sninuse, snfree;
+    GetSecnodeStats(&snslabs, &sntotal, &sninuse, &snfree);
+    GCon->Logf(NAME_Debug, "TICK: secnodes allocs=%d; frees=%d; in use=%d of %d (%d slabs)", dbgSecNodeAllocs, dbgSecNodeFrees, sninuse, sntotal, snslabs);
+    int itallocs, itheap, itlive, itpooled;
+    VScriptIterator::GetAllocStats(&itallocs, &itheap, &itlive, &itpooled);
+    int icinuse, icpooled, icbytes;
+    VPathTraverse::GetInterceptPoolStats(&icinuse, &icpooled, &icbytes);
+    GCon->Logf(NAME_Debug, "TICK: iterators allocs=%d; heap allocs=%d; live=%d; pooled=%d; intercept buffers in use=%d; pooled=%d (%d bytes)", itallocs, itheap, itlive, itpooled, icinuse, icpooled, icbytes);
+  }
+
+  // allocations since the previous tick (this includes rendering and such)
+  if (Z_ProfIsActive() && dbg_zone_prof_tick_top.asInt() > 0) {
+    Z_ProfDump(ZPROF_TICK, dbg_zone_prof_tick_top.asInt(), va("tick %d", TicTime));
+    Z_ProfMark(ZPROF_TICK);
   }
 }
 
@@ -668,40 +703,6 @@ VThinker *VLevel::SpawnThinker (VClass *AClass, const TVec &AOrigin,
 //  Script iterators
 //
 //==========================================================================
-class VScriptThinkerLevelIterator : public VScriptIterator {
-private:
-  VLevel *Self;
-  VClass *Class;
-  VThinker **Out;
-  VThinker *Current;
-
-public:
-  VScriptThinkerLevelIterator (VLevel *ASelf, VClass *AClass, VThinker **AOut)
-    : Self(ASelf)
-    , Class(AClass)
-    , Out(AOut)
-    , Current(nullptr)
-  {}
-
-  virtual bool GetNext () override {
-    if (!Current) {
-      Current = Self->ThinkerHead;
-    } else {
-      Current = Current->Next;
-    }
-    *Out = nullptr;
-    while (Current) {
-      if (Current->IsA(Class) && !Current->IsGoingToDie()) {
-        *Out = Current;
-        break;
-      }
-      Current = Current->Next;
-    }
-    return !!*Out;
-  }
-};
-
-
 class VActivePlayersLevelIterator : public VScriptIterator {
 private:
   VLevel *Self;
@@ -729,7 +730,7 @@ IMPLEMENT_FUNCTION(VLevel, AllThinkers) {
   P_GET_PTR(VThinker *, Thinker);
   P_GET_PTR(VClass, Class);
   P_GET_SELF;
-  RET_PTR(new VScriptThinkerLevelIterator(Self, Class, Thinker));
+  RET_PTR(new VScriptThinkerClassIterator(Self, Class, Thinker));
 }
 
 
@@ -737,3 +738,69 @@ IMPLEMENT_FUNCTION(VLevel, AllActivePlayers) {
   P_GET_PTR(VBasePlayer *, Out);
   RET_PTR(new VActivePlayersLevelIterator(Out));
 }
+
+
+//==========================================================================
+//
+//  ThinkerIterBench
+//
+//  usage:
+//    ThinkerIterBench [class [iterations]]
+//
+//  compares `AllThinkers()` iteration via level thinker list and via
+//  class instance lists on the current server level
+//
+//==========================================================================
+COMMAND(ThinkerIterBench) {
+  if (!GLevel) {
+    GCon->Log("no level loaded");
+    return;
+  }
+
+  VStr clsname = (Args.length() > 1 ? Args[1] : VStr("Inventory"));
+  VClass *cls = VClass::FindClassNoCase(*clsname);
+  if (!cls || !cls->IsChildOf(VThinker::StaticClass())) {
+    GCon->Logf(NAME_Error, "'%s' is not a thinker class", *clsname);
+    return;
+  }
+  int iters = (Args.length() > 2 ? VStr::atoi(*Args[2]) : 1000);
+  if (iters < 1) iters = 1;
+
+  int totalThinkers = 0;
+  for (VThinker *th = GLevel->ThinkerHead; th; th = th->Next) ++totalThinkers;
+
+  int counts[2] = { 0, 0 };
+  double times[2] = { 0.0, 0.0 };
+  TArray<VThinker *> seqs[2]; // from the first iteration, to check the order
+  for (int mode = 0; mode < 2; ++mode) {
+    VThinker *th = nullptr;
+    int count = 0;
+    const double stt = -Sys_Time();
+    for (int f = 0; f < iters; ++f) {
+      VScriptThinkerClassIterator it(GLevel, cls, &th, mode);
+      count = 0;
+      if (f == 0) {
+        while (it.GetNext()) { ++count; seqs[mode].append(th); }
+      } else {
+        while (it.GetNext()) ++count;
+      }
+    }
+    times[mode] = (stt+Sys_Time())*1000000.0/iters;
+    counts[mode] = count;
+  }
+
+  GCon->Logf("class '%s': %d of %d thinkers; %d subclasses; auto mode uses %s", cls->GetName(), counts[0], totalThinkers,
+             cls->GetSelfAndSubClasses().length()-1, (VScriptThinkerClassIterator::UseClassInstances(cls) ? "instance lists" : "thinker list"));
+  GCon->Logf("  thinker list  : %.3f usecs per iteration", times[0]);
+  GCon->Logf("  instance lists: %.3f usecs per iteration", times[1]);
+  if (counts[0] != counts[1]) {
+    GCon->Logf(NAME_Error, "  MISMATCH: thinker list found %d, instance lists found %d", counts[0], counts[1]);
+  } else {
+    for (int f = 0; f < seqs[0].length(); ++f) {
+      if (seqs[0][f] != seqs[1][f]) {
+        GCon->Logf(NAME_Error, "  ORDER MISMATCH at #%d", f);
+        break;
+      }
+    }
+  }
+}
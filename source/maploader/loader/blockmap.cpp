@@ -90,10 +90,9 @@ void VLevel::LoadBlockMap (int Lump) {
   BlockMapHeight = BlockMapLump[3];
   BlockMap = BlockMapLump + 4;
 
-  // clear out mobj chains
+  // clear out mobj lists
   int Count = BlockMapWidth * BlockMapHeight;
-  BlockLinks = new VEntity*[Count];
-  memset(BlockLinks, 0, sizeof(VEntity *)*Count);
+  BlockLinks = new TArray<VEntity *>[Count];
   */
 }
 
@@ -36,7 +36,7 @@
 void VLevel::LoadLineDefs1 (int Lump, int NumBaseVerts, const VMapInfo &MInfo) {
   NumLines = W_LumpLength(Lump)/14;
   Lines = new line_t[NumLines];
-  if (Lines <= 0) Host_Error("Map '%s' has no lines!", *MapName);
+  if (NumLines <= 0) Host_Error("Map '%s' has no lines!", *MapName);
   memset((void *)Lines, 0, sizeof(line_t)*NumLines);
 
   VStream *lumpstream = W_CreateLumpReaderNum(Lump);
@@ -78,7 +78,7 @@ void VLevel::LoadLineDefs1 (int Lump, int NumBaseVerts, const VMapInfo &MInfo) {
 void VLevel::LoadLineDefs2 (int Lump, int NumBaseVerts, const VMapInfo &MInfo) {
   NumLines = W_LumpLength(Lump)/16;
   Lines = new line_t[NumLines];
-  if (Lines <= 0) Host_Error("Map '%s' has no lines!", *MapName);
+  if (NumLines <= 0) Host_Error("Map '%s' has no lines!", *MapName);
   memset((void *)Lines, 0, sizeof(line_t)*NumLines);
 
   VStream *lumpstream = W_CreateLumpReaderNum(Lump);
@@ -51,6 +51,8 @@ VCvarB loader_build_blockmap("loader_force_blockmap_rebuild", false, "Force bloc
 VCvarB nodes_allow_compressed("nodes_allow_compressed", false, "Allow loading v1+ compressed GL nodes?", CVAR_Archive);
 
 static VCvarB loader_force_nodes_rebuild("loader_force_nodes_rebuild", true, "Force node rebuilding?", CVAR_Archive);
+static VCvarB dbg_map_arena_stats("dbg_map_arena_stats", false, "Show map arena statistics after map loading (see `MapArenaStats`)?", CVAR_Archive);
+static VCvarI dbg_zone_prof_mapload_top("dbg_zone_prof_mapload_top", "16", "Show this number of top allocation sites after map loading, if allocation profiler is active (see `ZoneProf`).", CVAR_PreInit);
 
 
 extern VCvarI nodes_builder_type;
@@ -223,6 +225,8 @@ static bool hashLump (sha224_ctx *sha224ctx, MD5Context *md5ctx, int lumpnum) {
 //
 //==========================================================================
 void VLevel::LoadMap (VName AMapName) {
+  VTRACE_ZONE("LoadMap");
+  if (Z_ProfIsActive()) Z_ProfMark(ZPROF_PERIOD);
   AuxiliaryCloser auxCloser;
 
   bool killCache = loader_cache_ignore_one;
@@ -513,6 +517,7 @@ load_again:
   double DecalProcessingTime = 0;
   double FloodFixTime = 0;
   double SectorListTime = 0;
+  double SoundPropTime = 0;
   double MapHashingTime = 0;
 
   {
@@ -595,6 +600,7 @@ load_again:
     if (NeedNodesBuild || forceNodeRebuildFromFixer) {
       GCon->Logf("building GL nodes");
       //R_OSDMsgShowSecondary("BUILDING NODES");
+      VTRACE_ZONE("BuildNodes");
       BuildNodes();
       forceNewBlockmap = true;
       saveCachedData = true;
@@ -654,11 +660,15 @@ load_again:
     BlockMapHeight = BlockMapLump[3];
     BlockMap = BlockMapLump+4;
 
-    // clear out mobj chains
+    // clear out mobj lists
     int count = BlockMapWidth*BlockMapHeight;
     delete [] BlockLinks;
-    BlockLinks = new VEntity *[count];
-    memset(BlockLinks, 0, sizeof(VEntity *)*count);
+    BlockLinks = new TArray<VEntity *>[count];
+    BlockLinksHoles.clear();
+    BlockLinksHoleCounts.setLength(count);
+    if (count > 0) memset((void *)BlockLinksHoleCounts.ptr(), 0, count*sizeof(BlockLinksHoleCounts[0]));
+    BlockLinksStamps.setLength(count);
+    if (count > 0) memset((void *)BlockLinksStamps.ptr(), 0, count*sizeof(BlockLinksStamps[0]));
   }
   BlockMapTime += Sys_Time();
 
@@ -682,7 +692,10 @@ load_again:
 
   // ACS object code
   double AcsTime = -Sys_Time();
-  LoadACScripts(BehaviorLump, xmaplumpnum);
+  {
+    VTRACE_ZONE("LoadACScripts");
+    LoadACScripts(BehaviorLump, xmaplumpnum);
+  }
   AcsTime += Sys_Time();
 
   double GroupLinesTime = -Sys_Time();
@@ -706,10 +719,13 @@ load_again:
   // set up polyobjs, slopes, 3D floors and some other static stuff
   GCon->Log("spawning the world...");
   double SpawnWorldTime = -Sys_Time();
-  GGameInfo->eventSpawnWorld(this);
-  // hash it all again, 'cause spawner may change something
-  HashSectors();
-  HashLines();
+  {
+    VTRACE_ZONE("SpawnWorld");
+    GGameInfo->eventSpawnWorld(this);
+    // hash it all again, 'cause spawner may change something
+    HashSectors();
+    HashLines();
+  }
   SpawnWorldTime += Sys_Time();
   GCon->Log("world spawning complete");
 
@@ -787,6 +803,10 @@ load_again:
   BuildSectorLists();
   SectorListTime += Sys_Time();
 
+  SoundPropTime = -Sys_Time();
+  BuildSoundPropGraph();
+  SoundPropTime += Sys_Time();
+
   // calculate xxHash32 of various map parts
 
   // hash of linedefs, sidedefs, sectors (in this order)
@@ -843,9 +863,12 @@ load_again:
   AddLoadingTiming("Sector min/max", MinMaxTime);
   AddLoadingTiming("Floodbug fixing", FloodFixTime);
   AddLoadingTiming("Sector lists", SectorListTime);
+  AddLoadingTiming("Sound propagation", SoundPropTime);
   AddLoadingTiming("Map hashing", MapHashingTime);
 
   DumpLoadingTimings();
+  if (dbg_map_arena_stats) DumpMapArenaStats();
+  if (Z_ProfIsActive()) Z_ProfDump(ZPROF_PERIOD, dbg_zone_prof_mapload_top.asInt(), "map load");
 
   mapTextureWarns.clear();
 
@@ -119,7 +119,7 @@ void VLevel::BuildDecalsVVList () {
       }
 
       if (count > 0) {
-        line_t **list = new line_t *[count];
+        line_t **list = GetMapArena()->Alloc<line_t *>(count);
         memcpy(list, wklist.ptr(), count*sizeof(line_t *));
         if (vn == 0) {
           ld->v1linesCount = count;
@@ -1093,7 +1093,7 @@ void VLevel::LoadTextMap (int Lump, const VMapInfo &MInfo) {
   Sectors = new sector_t[NumSectors];
   for (int i = 0; i < NumSectors; ++i) {
     Sectors[i] = Parser.ParsedSectors[i];
-    Sectors[i].CreateBaseRegion();
+    Sectors[i].CreateBaseRegion(GetMapArena());
   }
   HashSectors();
 
@@ -1099,6 +1099,7 @@ void VNetConnection::KeepaliveTick () {
 //
 //==========================================================================
 void VNetConnection::Tick () {
+  VTRACE_ZONE("VNetConnection::Tick");
   Driver->UpdateNetTime();
 
   if (IsClosed()) {
@@ -1708,6 +1709,7 @@ void VNetConnection::CollectAndSortAliveThinkerChans (ThinkerSortInfo *snfo) {
 //
 //==========================================================================
 void VNetConnection::UpdateThinkers () {
+  VTRACE_ZONE("UpdateThinkers");
   PendingThinkers.resetNoDtor();
   PendingGoreEnts.resetNoDtor();
   AliveGoreChans.resetNoDtor();
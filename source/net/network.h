@@ -704,8 +704,8 @@ public:
   // when we detach a thinker, there's no need to send any updates for it anymore
   // we cannot have this flag in thinker itself, because new
   // clients should still get detached thinkers once
-  TMapNC<VThinker *, bool> DetachedThinkers;
-  TMapNC<VThinker *, bool> SimulatedThinkers;
+  TSwissMap<VThinker *, bool> DetachedThinkers;
+  TSwissMap<VThinker *, bool> SimulatedThinkers;
 
   // timings, etc.
   double LastReceiveTime; // last time a packet was received, for timeout checking
@@ -751,7 +751,8 @@ public:
   TArray<vuint32> QueuedAcks;
   TArray<vuint32> AcksToResend;
   TArray<VChannel *> OpenChannels;
-  TMapNC<VThinker *, VThinkerChannel *> ThinkerChannels;
+  // looked up for each thinker on each network update
+  TSwissMap<VThinker *, VThinkerChannel *> ThinkerChannels;
 
   VField *OriginField;
   VField *DataGameTimeField;
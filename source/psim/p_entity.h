@@ -235,9 +235,8 @@ class VEntity : public VThinker {
   //TODO: think should occupy all blockmap cells it touches
   //      i should fix the code which does "blockmap marching", so
   //      it won't return one thing several times
-  VEntity *BlockMapNext;
-  VEntity *BlockMapPrev;
   vuint32 BlockMapCell; // blockmap cell index+1, so it will be independent of coords (0 means none)
+  vint32 BlockMapSlot; // index in `BlockLinks[BlockMapCell-1]`
 
   // links in sector (if needed)
   VEntity *SNext;
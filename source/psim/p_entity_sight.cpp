@@ -35,6 +35,8 @@
 
 static VCvarB compat_better_sight("compat_better_sight", true, "Check more points in LOS calculations?", CVAR_Archive);
 static VCvarB dbg_disable_cansee("dbg_disable_cansee", false, "Disable CanSee processing (for debug)?", CVAR_PreInit);
+static VCvarB sv_sight_cache("sv_sight_cache", true, "Cache sight checks for the current tick?", CVAR_Archive);
+static VCvarB dbg_sight_cache_verify("dbg_sight_cache_verify", false, "Recheck cached sight results, and report mismatches (for debug)?", CVAR_PreInit);
 
 /*
   enum {
@@ -117,5 +119,60 @@ bool VEntity::CanSeeEx (VEntity *Other, unsigned flags) {
     dirF = dirR = TVec::ZeroVector;
   }
   //if (forShooting) dirR = TVec::ZeroVector; // just in case, lol
-  return XLevel->CastCanSee(Sector, Origin, Height, dirF, dirR, Other->Origin, Other->Radius, Other->Height, !(flags&CSE_CheckBaseRegion)/*skip base region*/, Other->Sector, /*alwaysBetter*/cbs, !!(flags&CSE_IgnoreBlockAll), !!(flags&CSE_IgnoreFakeFloors));
+
+  if (!sv_sight_cache.asBool()) {
+    return XLevel->CastCanSee(Sector, Origin, Height, dirF, dirR, Other->Origin, Other->Radius, Other->Height, !(flags&CSE_CheckBaseRegion)/*skip base region*/, Other->Sector, /*alwaysBetter*/cbs, !!(flags&CSE_IgnoreBlockAll), !!(flags&CSE_IgnoreFakeFloors));
+  }
+
+  // monsters tend to check the same targets several times per tick, so cache the result
+  VSightCacheKey key;
+  key.LookerUId = GetUniqueId();
+  key.TargetUId = Other->GetUniqueId();
+  key.Flags = (flags&(CSE_CheckBaseRegion|CSE_IgnoreBlockAll|CSE_IgnoreFakeFloors))|(cbs ? 0x80000000u : 0u);
+
+  if (!XLevel->SightCache) XLevel->SightCache = new TMapNC<VSightCacheKey, VSightCacheEntry>();
+  VSightCacheEntry *ce = XLevel->SightCache->get(key);
+  if (ce && ce->TicTime == XLevel->TicTime && ce->GeometryChangeCount == XLevel->GeometryChangeCount &&
+      ce->LookerOrigin == Origin && ce->LookerHeight == Height && (!cbs || ce->LookerYaw == Angles.yaw) &&
+      ce->TargetOrigin == Other->Origin && ce->TargetRadius == Other->Radius && ce->TargetHeight == Other->Height)
+  {
+    ++dbgSightCacheHits;
+    if (dbg_sight_cache_verify.asBool()) {
+      const bool res = XLevel->CastCanSee(Sector, Origin, Height, dirF, dirR, Other->Origin, Other->Radius, Other->Height, !(flags&CSE_CheckBaseRegion)/*skip base region*/, Other->Sector, /*alwaysBetter*/cbs, !!(flags&CSE_IgnoreBlockAll), !!(flags&CSE_IgnoreFakeFloors));
+      if (res != ce->Result) {
+        GCon->Logf(NAME_Debug, "SIGHT CACHE MISMATCH: %s:%u -> %s:%u (flags=0x%08x): cached=%d; real=%d", GetClass()->GetName(), GetUniqueId(), Other->GetClass()->GetName(), Other->GetUniqueId(), key.Flags, (int)ce->Result, (int)res);
+        ce->Result = res;
+      }
+    }
+    return ce->Result;
+  }
+
+  ++dbgSightCacheMisses;
+  const bool res = XLevel->CastCanSee(Sector, Origin, Height, dirF, dirR, Other->Origin, Other->Radius, Other->Height, !(flags&CSE_CheckBaseRegion)/*skip base region*/, Other->Sector, /*alwaysBetter*/cbs, !!(flags&CSE_IgnoreBlockAll), !!(flags&CSE_IgnoreFakeFloors));
+
+  VSightCacheEntry ne;
+  ne.LookerOrigin = Origin;
+  ne.LookerHeight = Height;
+  ne.LookerYaw = Angles.yaw;
+  ne.TargetOrigin = Other->Origin;
+  ne.TargetRadius = Other->Radius;
+  ne.TargetHeight = Other->Height;
+  ne.TicTime = XLevel->TicTime;
+  ne.GeometryChangeCount = XLevel->GeometryChangeCount;
+  ne.Result = res;
+  if (ce) *ce = ne; else XLevel->SightCache->put(key, ne);
+
+  return res;
+}
+
+
+//==========================================================================
+//
+//  VLevel::ResetSightCache
+//
+//  called on each world tick; keeps allocated memory
+//
+//==========================================================================
+void VLevel::ResetSightCache () {
+  if (SightCache) SightCache->reset();
 }
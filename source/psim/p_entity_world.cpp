@@ -150,8 +150,10 @@ void VEntity::CopyRegCeiling (sec_region_t *r, bool setz) {
 class VRoughBlockSearchIterator : public VScriptIterator {
 private:
   VEntity *Self;
+  VLevel *Level;
   int Distance;
-  VEntity *Ent;
+  const TArray<VEntity *> *List; // current cell
+  int Index; // in `List`, walking down
   VEntity **EntPtr;
 
   int StartX;
@@ -166,6 +168,7 @@ private:
 
 public:
   VRoughBlockSearchIterator (VEntity *, int, VEntity **);
+  virtual ~VRoughBlockSearchIterator () override;
   virtual bool GetNext () override;
 };
 
@@ -353,18 +356,20 @@ void VEntity::UnlinkFromWorld () {
 
   if (BlockMapCell /*&& !(EntityFlags&EF_NoBlockmap)*/) {
     // unlink from block map
-    if (BlockMapNext) BlockMapNext->BlockMapPrev = BlockMapPrev;
-    if (BlockMapPrev) {
-      BlockMapPrev->BlockMapNext = BlockMapNext;
-    } else {
-      // we are the first entity in blockmap cell
-      BlockMapCell -= 1; // real cell number
-      // do some sanity checks
-      vassert(XLevel->BlockLinks[BlockMapCell] == this);
-      // fix list head
-      XLevel->BlockLinks[BlockMapCell] = BlockMapNext;
-    }
+    // leave a hole, so other things are not moved (and their order is kept)
+    const int cellidx = BlockMapCell-1;
+    TArray<VEntity *> &list = XLevel->BlockLinks[cellidx];
+    const int idx = BlockMapSlot;
+    // do some sanity checks
+    vassert(idx >= 0 && idx < list.length() && list[idx] == this);
+    list[idx] = nullptr;
+    const int holes = ++XLevel->BlockLinksHoleCounts[cellidx];
+    if (holes == 1) XLevel->BlockLinksHoles.append((vint32)cellidx);
+    // compaction is linear, so doing it only when half of the list is holes keeps unlinking O(1) amortized
+    if (XLevel->BlockLinksIterating == 0 && holes*2 >= list.length()) XLevel->CompactBlockLinks(cellidx);
+    ++XLevel->BlockLinksStamps[cellidx];
     BlockMapCell = 0;
+    BlockMapSlot = -1;
   }
 
   SubSector = nullptr;
@@ -500,15 +505,12 @@ void VEntity::LinkToWorld (int properFloorCheck) {
         blocky >= 0 && blocky < XLevel->BlockMapHeight)
     {
       BlockMapCell = ((unsigned)blocky*(unsigned)XLevel->BlockMapWidth+(unsigned)blockx);
-      VEntity **link = &XLevel->BlockLinks[BlockMapCell];
-      BlockMapPrev = nullptr;
-      BlockMapNext = *link;
-      if (*link) (*link)->BlockMapPrev = this;
-      *link = this;
+      // iterators walk cell lists from the end, so new things are found first
+      TArray<VEntity *> &list = XLevel->BlockLinks[BlockMapCell];
+      BlockMapSlot = list.length();
+      list.append(this);
+      ++XLevel->BlockLinksStamps[BlockMapCell];
       BlockMapCell += 1;
-    } else {
-      // thing is off the map
-      BlockMapNext = BlockMapPrev = nullptr;
     }
   }
 
@@ -2631,12 +2633,15 @@ void VEntity::UpdateVelocity (float DeltaTime, bool allowSlopeFriction) {
 //==========================================================================
 VRoughBlockSearchIterator::VRoughBlockSearchIterator (VEntity *ASelf, int ADistance, VEntity **AEntPtr)
   : Self(ASelf)
+  , Level(ASelf->XLevel)
   , Distance(ADistance)
-  , Ent(nullptr)
+  , List(nullptr)
+  , Index(-1)
   , EntPtr(AEntPtr)
   , Count(1)
   , CurrentEdge(-1)
 {
+  Level->BlockLinksIterBegin();
   StartX = MapBlock(Self->Origin.x-Self->XLevel->BlockMapOrgX);
   StartY = MapBlock(Self->Origin.y-Self->XLevel->BlockMapOrgY);
 
@@ -2644,11 +2649,22 @@ VRoughBlockSearchIterator::VRoughBlockSearchIterator (VEntity *ASelf, int ADista
   if (StartX >= 0 && StartX < Self->XLevel->BlockMapWidth &&
       StartY >= 0 && StartY < Self->XLevel->BlockMapHeight)
   {
-    Ent = Self->XLevel->BlockLinks[StartY*Self->XLevel->BlockMapWidth+StartX];
+    List = &Self->XLevel->BlockLinks[StartY*Self->XLevel->BlockMapWidth+StartX];
+    Index = List->length()-1;
   }
 }
 
 
+//==========================================================================
+//
+//  VRoughBlockSearchIterator::~VRoughBlockSearchIterator
+//
+//==========================================================================
+VRoughBlockSearchIterator::~VRoughBlockSearchIterator () {
+  Level->BlockLinksIterEnd();
+}
+
+
 //==========================================================================
 //
 //  VRoughBlockSearchIterator::GetNext
@@ -2659,19 +2675,24 @@ bool VRoughBlockSearchIterator::GetNext () {
   int BlockY;
 
   for (;;) {
-    while (Ent && Ent->IsGoingToDie()) Ent = Ent->BlockMapNext;
-
-    if (Ent) {
-      *EntPtr = Ent;
-      Ent = Ent->BlockMapNext;
-      return true;
+    if (List) {
+      // lists cannot shrink while we're iterating, unlinked things are `nullptr`
+      while (Index >= 0) {
+        VEntity *Ent = (*List)[Index--];
+        if (Ent && !Ent->IsGoingToDie()) {
+          *EntPtr = Ent;
+          return true;
+        }
+      }
+      List = nullptr;
     }
 
     switch (CurrentEdge) {
       case 0:
         // trace the first block section (along the top)
         if (BlockIndex <= FirstStop) {
-          Ent = Self->XLevel->BlockLinks[BlockIndex];
+          List = &Self->XLevel->BlockLinks[BlockIndex];
+          Index = List->length()-1;
           ++BlockIndex;
         } else {
           CurrentEdge = 1;
@@ -2681,7 +2702,8 @@ bool VRoughBlockSearchIterator::GetNext () {
       case 1:
         // trace the second block section (right edge)
         if (BlockIndex <= SecondStop) {
-          Ent = Self->XLevel->BlockLinks[BlockIndex];
+          List = &Self->XLevel->BlockLinks[BlockIndex];
+          Index = List->length()-1;
           BlockIndex += Self->XLevel->BlockMapWidth;
         } else {
           CurrentEdge = 2;
@@ -2691,7 +2713,8 @@ bool VRoughBlockSearchIterator::GetNext () {
       case 2:
         // trace the third block section (bottom edge)
         if (BlockIndex >= ThirdStop) {
-          Ent = Self->XLevel->BlockLinks[BlockIndex];
+          List = &Self->XLevel->BlockLinks[BlockIndex];
+          Index = List->length()-1;
           --BlockIndex;
         } else {
           CurrentEdge = 3;
@@ -2701,7 +2724,8 @@ bool VRoughBlockSearchIterator::GetNext () {
       case 3:
         // trace the final block section (left edge)
         if (BlockIndex > FinalStop) {
-          Ent = Self->XLevel->BlockLinks[BlockIndex];
+          List = &Self->XLevel->BlockLinks[BlockIndex];
+          Index = List->length()-1;
           BlockIndex -= Self->XLevel->BlockMapWidth;
         } else {
           CurrentEdge = -1;
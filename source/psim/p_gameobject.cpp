@@ -242,10 +242,12 @@ int tagHashTag (const TagHash *th, int index) {
 //
 //  sector_t::CreateBaseRegion
 //
+//  regions are allocated from the level map arena
+//
 //==========================================================================
-void sector_t::CreateBaseRegion () {
+void sector_t::CreateBaseRegion (VMemArena *arena) {
   vassert(!eregions);
-  sec_region_t *reg = (sec_region_t *)Z_Calloc(sizeof(sec_region_t));
+  sec_region_t *reg = arena->Alloc<sec_region_t>();
   reg->efloor.set(&floor, false);
   reg->eceiling.set(&ceiling, false);
   reg->params = &params;
@@ -259,13 +261,11 @@ void sector_t::CreateBaseRegion () {
 //
 //  sector_t::DeleteAllRegions
 //
+//  region memory is owned by the map arena, so this only drops the list
+//
 //==========================================================================
 void sector_t::DeleteAllRegions () {
-  while (eregions) {
-    sec_region_t *r = eregions;
-    eregions = r->next;
-    Z_Free(r);
-  }
+  eregions = nullptr;
 }
 
 
@@ -274,8 +274,8 @@ void sector_t::DeleteAllRegions () {
 //  sector_t::AllocRegion
 //
 //==========================================================================
-sec_region_t *sector_t::AllocRegion () {
-  sec_region_t *reg = (sec_region_t *)Z_Calloc(sizeof(sec_region_t));
+sec_region_t *sector_t::AllocRegion (VMemArena *arena) {
+  sec_region_t *reg = arena->Alloc<sec_region_t>();
   sec_region_t *last = eregions;
   if (last) {
     while (last->next) last = last->next;
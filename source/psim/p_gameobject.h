@@ -830,11 +830,11 @@ struct sector_t {
   }
 
   // should be called for new sectors to setup base region
-  void CreateBaseRegion ();
+  void CreateBaseRegion (VMemArena *arena);
   void DeleteAllRegions ();
 
   // `next` is set, everything other is zeroed
-  sec_region_t *AllocRegion ();
+  sec_region_t *AllocRegion (VMemArena *arena);
 };
 
 
@@ -635,6 +635,7 @@ bool VLevel::MovePolyobj (int num, float x, float y, bool forced) {
   po = GetPolyobj(num);
   if (!po) Sys_Error("Invalid polyobj number: %d", num);
 
+  NoteGeometryChange();
   if (IsForServer()) UnLinkPolyobj(po);
 
   segList = po->segs;
@@ -705,6 +706,8 @@ bool VLevel::RotatePolyobj (int num, float angle) {
   polyobj_t *po = GetPolyobj(num);
   if (!po) Sys_Error("Invalid polyobj number: %d", num);
 
+  NoteGeometryChange();
+
   // calculate the angle
   float an = po->angle+angle;
   float msinAn, mcosAn;
@@ -791,9 +794,10 @@ bool VLevel::PolyCheckMobjBlocking (seg_t *seg, polyobj_t *po) {
   right = (right < 0 ? 0 : right);
   right = (right >= BlockMapWidth ? BlockMapWidth-1 : right);
 
-  for (j = bottom*BlockMapWidth; j <= top*BlockMapWidth; j += BlockMapWidth) {
+  for (j = bottom; j <= top; ++j) {
     for (i = left; i <= right; ++i) {
-      for (mobj = BlockLinks[j+i]; mobj; mobj = mobj->BlockMapNext) {
+      for (VBlockThingsIterator It(this, i, j); It; ++It) {
+        mobj = *It;
         if (mobj->IsGoingToDie()) continue;
         if (mobj->EntityFlags&VEntity::EF_ColideWithWorld) {
           if (mobj->EntityFlags&(VEntity::EF_Solid|VEntity::EF_Corpse)) {
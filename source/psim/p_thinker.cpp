@@ -38,6 +38,8 @@
 
 IMPLEMENT_CLASS(V, Thinker)
 
+static VCvarB vm_thinker_class_lists("vm_thinker_class_lists", true, "Use class instance lists for `AllThinkers()` iterators, if it is faster?", 0);
+
 
 //==========================================================================
 //
@@ -261,43 +263,115 @@ void VThinker::BroadcastCenterPrint (const char *s) {
 
 //==========================================================================
 //
-//  Script iterators
+//  VScriptThinkerClassIterator::VScriptThinkerClassIterator
 //
 //==========================================================================
-class VScriptThinkerIterator : public VScriptIterator {
-private:
-  VThinker *Self;
-  VClass *Class;
-  VThinker **Out;
-  VThinker *Current;
+VScriptThinkerClassIterator::VScriptThinkerClassIterator (VLevel *ALevel, VClass *AClass, VThinker **AOut, int AUseLists)
+  : Level(ALevel)
+  , Class(AClass)
+  , Out(AOut)
+  , Current(nullptr)
+  , Found()
+  , FoundIndex(0)
+  , FoundOrder(0)
+  , UseLists(AUseLists < 0 ? UseClassInstances(AClass) : AUseLists > 0)
+  , Collected(false)
+{
+}
 
-public:
-  VScriptThinkerIterator (VThinker *ASelf, VClass *AClass, VThinker **AOut)
-    : Self(ASelf)
-    , Class(AClass)
-    , Out(AOut)
-    , Current(nullptr)
-  {}
 
-  virtual bool GetNext () override {
-    if (!Current) {
-      Current = Self->XLevel->ThinkerHead;
-    } else {
-      Current = Current->Next;
+//==========================================================================
+//
+//  VScriptThinkerClassIterator::CollectFromLists
+//
+//==========================================================================
+void VScriptThinkerClassIterator::CollectFromLists () {
+  // don't keep the reference, class list can be rebuilt by the VM code
+  const TArray<VClass *> &classes = Class->GetSelfAndSubClasses();
+  for (auto &&cls : classes) {
+    // all objects there are of the exact class, so no need to check it
+    for (VObject *obj = cls->InstanceHead; obj; obj = obj->GetNextClassInstance()) {
+      VThinker *th = (VThinker *)obj;
+      if (th->XLevel == Level && !th->IsGoingToDie()) Found.append(th);
+    }
+  }
+  if (Found.length() > 1) {
+    timsort_r(Found.ptr(), Found.length(), sizeof(VThinker *), [](const void *a, const void *b, void *) -> int {
+      const vuint32 oa = (*(const VThinker **)a)->ThinkerOrder;
+      const vuint32 ob = (*(const VThinker **)b)->ThinkerOrder;
+      return (oa < ob ? -1 : oa > ob ? 1 : 0);
+    }, nullptr);
+  }
+  FoundOrder = Level->ThinkerOrderCounter;
+}
+
+
+//==========================================================================
+//
+//  VScriptThinkerClassIterator::UseClassInstances
+//
+//  instance counters include thinkers from all levels (and dead objects
+//  are still in instance lists), so use lists only if they are small
+//
+//==========================================================================
+bool VScriptThinkerClassIterator::UseClassInstances (VClass *AClass) noexcept {
+  if (!vm_thinker_class_lists.asBool()) return false;
+  if (!AClass || AClass == VThinker::StaticClass()) return false;
+  return (AClass->InstanceCountWithSub*2 <= VThinker::StaticClass()->InstanceCountWithSub);
+}
+
+
+//==========================================================================
+//
+//  VScriptThinkerClassIterator::GetNext
+//
+//==========================================================================
+bool VScriptThinkerClassIterator::GetNext () {
+  *Out = nullptr;
+  if (UseLists) {
+    if (!Collected) {
+      Collected = true;
+      CollectFromLists();
     }
-    *Out = nullptr;
-    while (Current) {
+    while (FoundIndex < Found.length()) {
+      VThinker *th = Found[FoundIndex++];
+      if (!th->IsGoingToDie()) {
+        *Out = th;
+        return true;
+      }
+    }
+    // thinkers spawned while iterating are at the end of the thinker list; continue from the last old one
+    UseLists = false;
+    Current = Level->ThinkerTail;
+    while (Current && Current->ThinkerOrder > FoundOrder) Current = Current->Prev;
+    if (!Current) {
+      // all thinkers are new (or there are no thinkers at all)
+      Current = Level->ThinkerHead;
+      if (!Current) return false;
       if (Current->IsA(Class) && !Current->IsGoingToDie()) {
         *Out = Current;
-        break;
+        return true;
       }
-      Current = Current->Next;
     }
-    return !!*Out;
   }
-};
+  // walk level thinker list
+  Current = (Current ? Current->Next : Level->ThinkerHead);
+  while (Current) {
+    if (Current->IsA(Class) && !Current->IsGoingToDie()) {
+      *Out = Current;
+      return true;
+    }
+    Current = Current->Next;
+  }
+  return false;
+}
 
 
+//==========================================================================
+//
+//  Script iterators
+//
+//==========================================================================
 class VActivePlayersIterator : public VScriptIterator {
 private:
   VThinker *Self;
@@ -466,7 +540,7 @@ IMPLEMENT_FUNCTION(VThinker, AllThinkers) {
   VClass *Class;
   VThinker **Thinker;
   vobjGetParamSelf(Class, Thinker);
-  RET_PTR(new VScriptThinkerIterator(Self, Class, Thinker));
+  RET_PTR(new VScriptThinkerClassIterator(Self->XLevel, Class, Thinker));
 }
 
 IMPLEMENT_FUNCTION(VThinker, AllActivePlayers) {
@@ -484,6 +558,50 @@ IMPLEMENT_FUNCTION(VThinker, PathTraverse) {
   RET_PTR(new VPathTraverse(Self, In, x1, y1, x2, y2, flags));
 }
 
+// native final int PathTraverseBatchBegin (float x1, float y1, int flags);
+IMPLEMENT_FUNCTION(VThinker, PathTraverseBatchBegin) {
+  float x1, y1;
+  int flags;
+  vobjGetParamSelf(x1, y1, flags);
+  RET_INT(P_PathTraverseBatchBegin(Self, x1, y1, flags));
+}
+
+// native final int PathTraverseBatchAdd (int batch, float x2, float y2);
+IMPLEMENT_FUNCTION(VThinker, PathTraverseBatchAdd) {
+  int handle;
+  float x2, y2;
+  vobjGetParamSelf(handle, x2, y2);
+  VPathTraverseBatch *batch = P_PathTraverseBatchGet(Self, handle);
+  if (!batch) {
+    VObject::VMDumpCallStack();
+    GCon->Logf(NAME_Error, "%s: invalid path traverse batch handle %d", Self->GetClass()->GetName(), handle);
+    RET_INT(-1);
+    return;
+  }
+  RET_INT(batch->AddRay(x2, y2));
+}
+
+// native final iterator PathTraverseBatch (out intercept_t *In, int batch, int ray);
+IMPLEMENT_FUNCTION(VThinker, PathTraverseBatch) {
+  intercept_t **In;
+  int handle, ray;
+  vobjGetParamSelf(In, handle, ray);
+  VPathTraverseBatch *batch = P_PathTraverseBatchGet(Self, handle);
+  if (batch && (ray < 0 || ray >= batch->GetRayCount())) batch = nullptr;
+  if (!batch) {
+    VObject::VMDumpCallStack();
+    GCon->Logf(NAME_Error, "%s: invalid path traverse batch handle %d (or ray %d)", Self->GetClass()->GetName(), handle, ray);
+  }
+  RET_PTR(P_PathTraverseBatchRay(Self, batch, ray, In));
+}
+
+// native final void PathTraverseBatchEnd (int batch);
+IMPLEMENT_FUNCTION(VThinker, PathTraverseBatchEnd) {
+  int handle;
+  vobjGetParamSelf(handle);
+  P_PathTraverseBatchEnd(Self, handle);
+}
+
 // native final iterator RadiusThings (out Entity Ent, TVec Org, float Radius);
 IMPLEMENT_FUNCTION(VThinker, RadiusThings) {
   VEntity **EntPtr;
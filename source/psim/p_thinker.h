@@ -65,6 +65,7 @@ class VThinker : public VGameObject {
 
   VThinker *Prev;
   VThinker *Next;
+  vuint32 ThinkerOrder; // increases along the level thinker list (see `VLevel::AddThinker()`)
 
   float SpawnTime; // `Spawn()` function sets this to game time
 
@@ -137,6 +138,10 @@ public:
   DECLARE_FUNCTION(AllThinkers)
   DECLARE_FUNCTION(AllActivePlayers)
   DECLARE_FUNCTION(PathTraverse)
+  DECLARE_FUNCTION(PathTraverseBatchBegin)
+  DECLARE_FUNCTION(PathTraverseBatchAdd)
+  DECLARE_FUNCTION(PathTraverseBatch)
+  DECLARE_FUNCTION(PathTraverseBatchEnd)
   DECLARE_FUNCTION(RadiusThings)
 
   void eventClientTick (float DeltaTime) {
@@ -177,3 +182,35 @@ public:
   inline T *operator -> () noexcept { return (T *)Th; }
   inline T *operator * () noexcept { return (T *)Th; }
 };
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+// VM iterator for level thinkers of the given class (with subclasses)
+// if the class has much less instances than there are thinkers, matching
+// thinkers are collected from class instance lists instead of walking the
+// whole level thinker list. they are sorted by `ThinkerOrder`, so the order
+// is the same as in the thinker list; thinkers spawned while iterating are
+// returned after them, as the thinker list walker would do.
+class VScriptThinkerClassIterator : public VScriptIterator {
+private:
+  VLevel *Level;
+  VClass *Class;
+  VThinker **Out;
+  VThinker *Current; // thinker list walker position
+  TArray<VThinker *> Found; // collected from instance lists on the first `GetNext()`
+  int FoundIndex;
+  vuint32 FoundOrder; // `Level->ThinkerOrderCounter` at collection time
+  bool UseLists;
+  bool Collected;
+
+  void CollectFromLists ();
+
+public:
+  // `AUseLists`: -1 to select automatically, 0 to walk thinker list, 1 to walk instance lists
+  VScriptThinkerClassIterator (VLevel *ALevel, VClass *AClass, VThinker **AOut, int AUseLists=-1);
+
+  virtual bool GetNext () override;
+
+  // should we walk class instance lists instead of thinker list?
+  static bool UseClassInstances (VClass *AClass) noexcept;
+};
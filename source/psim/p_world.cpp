@@ -36,6 +36,45 @@ static VCvarB dbg_use_buggy_thing_traverser("dbg_use_buggy_thing_traverser", fal
 static VCvarB dbg_use_vavoom_thing_coldet("dbg_use_vavoom_thing_coldet", false, "Use original Vavoom buggy thing coldet (for debug)?", 0);
 
 
+//==========================================================================
+//
+//  VLevel::BlockLinksIterEnd
+//
+//  compacts cells with holes when the outermost iterator is done
+//
+//==========================================================================
+void VLevel::BlockLinksIterEnd () {
+  vassert(BlockLinksIterating > 0);
+  if (--BlockLinksIterating != 0) return;
+  if (BlockLinksHoles.length() == 0) return;
+  // the same cell can be listed several times (if it was compacted in `VEntity::UnlinkFromWorld()`)
+  for (auto &&cellidx : BlockLinksHoles) if (BlockLinksHoleCounts[cellidx]) CompactBlockLinks(cellidx);
+  BlockLinksHoles.resetNoDtor();
+}
+
+
+//==========================================================================
+//
+//  VLevel::CompactBlockLinks
+//
+//  removes holes left by unlinked things, keeping the order of the others
+//
+//==========================================================================
+void VLevel::CompactBlockLinks (int cellidx) {
+  if (!BlockLinks || cellidx < 0 || cellidx >= BlockMapWidth*BlockMapHeight) return;
+  TArray<VEntity *> &list = BlockLinks[cellidx];
+  int dest = 0;
+  for (int f = 0; f < list.length(); ++f) {
+    VEntity *ent = list[f];
+    if (!ent) continue;
+    ent->BlockMapSlot = dest;
+    list[dest++] = ent;
+  }
+  if (dest != list.length()) list.setLength(dest, false);
+  BlockLinksHoleCounts[cellidx] = 0;
+}
+
+
 // ////////////////////////////////////////////////////////////////////////// //
 #define EQUAL_EPSILON (1.0f/65536.0f)
 
@@ -81,6 +120,146 @@ static float interceptVector (const divline_t &v2, const divline_t &v1) {
 }
 
 
+//==========================================================================
+//
+//  InsertIntercept
+//
+//  insert new intercept
+//  this is faster than sorting, as most intercepts are already sorted
+//
+//==========================================================================
+static intercept_t &InsertIntercept (TArray<intercept_t> &list, const float frac) {
+  int pos = list.length();
+  if (pos == 0 || list[pos-1].frac <= frac) {
+    // no need to bubble, just append it
+    intercept_t &xit = list.Alloc();
+    xit.frac = frac;
+    return xit;
+  }
+  // bubble
+  while (pos > 0 && list[pos-1].frac > frac) --pos;
+  // insert
+  intercept_t it;
+  it.frac = frac;
+  list.insert(pos, it);
+  return list[pos];
+}
+
+
+//==========================================================================
+//
+//  RemoveInterceptsFrom
+//
+//  removes all intercepts with `frac` >= the given one
+//
+//==========================================================================
+static void RemoveInterceptsFrom (TArray<intercept_t> &list, const float frac) {
+  int len = list.length();
+  while (len > 0 && list[len-1].frac >= frac) --len;
+  if (len != list.length()) list.setLength(len, false); // don't resize
+}
+
+
+//==========================================================================
+//
+//  TraceCrossesLine
+//
+//  returns `true` if the trace crosses the line, and intercept point
+//
+//==========================================================================
+static inline bool TraceCrossesLine (const line_t *ld, const TPlane &trace_plane, const TVec &trace_org, const TVec &trace_delta, float &frac) {
+  //const float dot1 = DotProduct(*ld->v1, trace_plane.normal)-trace_plane.dist;
+  //const float dot2 = DotProduct(*ld->v2, trace_plane.normal)-trace_plane.dist;
+  const float dot1 = trace_plane.PointDistance(*ld->v1);
+  const float dot2 = trace_plane.PointDistance(*ld->v2);
+
+  // do not use multiplication to check: zero speedup, lost accuracy
+  //if (dot1*dot2 >= 0) continue; // line isn't crossed
+  if (dot1 < 0.0f && dot2 < 0.0f) return false; // didn't reached back side
+  // if the trace is parallel to the line plane, ignore it
+  if (dot1 >= 0.0f && dot2 >= 0.0f) return false; // didn't reached front side
+
+  // hit the line
+
+  // find the fractional intercept point along the trace line
+  const float den = DotProduct(ld->normal, trace_delta);
+  if (den == 0) return false;
+
+  const float num = ld->dist-DotProduct(trace_org, ld->normal);
+  frac = num/den;
+  if (frac < 0 || frac > 1.0f) return false; // behind source or beyond end point
+  return true;
+}
+
+
+//==========================================================================
+//
+//  TraceHitsThing
+//
+//  checks the trace against thing bounding box
+//  returns `true` if the box is hit, and intercept point
+//
+//==========================================================================
+static bool TraceHitsThing (const VEntity *th, const divline_t &trace, const TVec &trace_org, float &frac) {
+  divline_t line;
+  // [RH] don't check a corner to corner crossection for hit
+  // instead, check against the actual bounding box
+
+  // there's probably a smarter way to determine which two sides
+  // of the thing face the trace than by trying all four sides...
+  int numfronts = 0;
+  for (int i = 0; i < 4; ++i) {
+    switch (i) {
+      case 0: // top edge
+        line.y = th->Origin.y+th->Radius;
+        if (trace_org.y < line.y) continue;
+        line.x = th->Origin.x+th->Radius;
+        line.dx = -th->Radius*2;
+        line.dy = 0;
+        break;
+      case 1: // right edge
+        line.x = th->Origin.x+th->Radius;
+        if (trace_org.x < line.x) continue;
+        line.y = th->Origin.y-th->Radius;
+        line.dx = 0;
+        line.dy = th->Radius*2;
+        break;
+      case 2: // bottom edge
+        line.y = th->Origin.y-th->Radius;
+        if (trace_org.y > line.y) continue;
+        line.x = th->Origin.x-th->Radius;
+        line.dx = th->Radius*2;
+        line.dy = 0;
+        break;
+      case 3: // left edge
+        line.x = th->Origin.x-th->Radius;
+        if (trace_org.x > line.x) continue;
+        line.y = th->Origin.y + th->Radius;
+        line.dx = 0;
+        line.dy = -th->Radius*2;
+        break;
+    }
+    ++numfronts;
+
+    // check if this side is facing the trace origin
+    // if it is, see if the trace crosses it
+    if (pointOnDLineSide(line.x, line.y, trace) != pointOnDLineSide(line.x+line.dx, line.y+line.dy, trace)) {
+      // it's a hit
+      frac = interceptVector(trace, line);
+      if (frac < 0 || frac > 1.0f) continue;
+      return true;
+    }
+  }
+  // if none of the sides was facing the trace, then the trace
+  // must have started inside the box, so add it as an intercept
+  if (numfronts == 0) {
+    frac = 0;
+    return true;
+  }
+  return false;
+}
+
+
 //==========================================================================
 //
 //  VBlockLinesIterator::VBlockLinesIterator
@@ -159,15 +338,18 @@ bool VBlockLinesIterator::GetNext () {
 //==========================================================================
 VRadiusThingsIterator::VRadiusThingsIterator (VThinker *ASelf, VEntity **AEntPtr, TVec Org, float Radius)
   : Self(ASelf)
+  , Level(ASelf->XLevel)
   , EntPtr(AEntPtr)
-  , Ent(nullptr)
+  , List(nullptr)
+  , Index(-1)
 {
+  Level->BlockLinksIterBegin();
   if (Radius < 0.0f) Radius = 0.0f;
   // cache some variables
-  const float bmOrgX = Self->XLevel->BlockMapOrgX;
-  const float bmOrgY = Self->XLevel->BlockMapOrgY;
-  const int bmWidth = Self->XLevel->BlockMapWidth;
-  const int bmHeight = Self->XLevel->BlockMapHeight;
+  const float bmOrgX = Level->BlockMapOrgX;
+  const float bmOrgY = Level->BlockMapOrgY;
+  const int bmWidth = Level->BlockMapWidth;
+  const int bmHeight = Level->BlockMapHeight;
   // calculate blockmap rectangle
   xl = MapBlock(Org.x-Radius-bmOrgX-MAXRADIUS);
   xh = MapBlock(Org.x+Radius-bmOrgX+MAXRADIUS);
@@ -177,7 +359,8 @@ VRadiusThingsIterator::VRadiusThingsIterator (VThinker *ASelf, VEntity **AEntPtr
     // nothing to do
     // set the vars so `GetNext()` will return `false`
     xl = xh = yl = yh = x = y = 0;
-    Ent = nullptr;
+    List = nullptr;
+    Index = -1;
   } else {
     // clip rect
     if (xl < 0) xl = 0;
@@ -189,11 +372,22 @@ VRadiusThingsIterator::VRadiusThingsIterator (VThinker *ASelf, VEntity **AEntPtr
     // prepare iteration
     x = xl;
     y = yl;
-    Ent = Self->XLevel->BlockLinks[y*bmWidth+x];
+    List = &Level->BlockLinks[y*bmWidth+x];
+    Index = List->length()-1;
   }
 }
 
 
+//==========================================================================
+//
+//  VRadiusThingsIterator::~VRadiusThingsIterator
+//
+//==========================================================================
+VRadiusThingsIterator::~VRadiusThingsIterator () {
+  Level->BlockLinksIterEnd();
+}
+
+
 //==========================================================================
 //
 //  VRadiusThingsIterator::GetNext
@@ -201,12 +395,15 @@ VRadiusThingsIterator::VRadiusThingsIterator (VThinker *ASelf, VEntity **AEntPtr
 //==========================================================================
 bool VRadiusThingsIterator::GetNext () {
   for (;;) {
-    while (Ent && Ent->IsGoingToDie()) Ent = Ent->BlockMapNext;
-
-    if (Ent) {
-      *EntPtr = Ent;
-      Ent = Ent->BlockMapNext;
-      return true;
+    if (List) {
+      // lists cannot shrink while we're iterating, unlinked things are `nullptr`
+      while (Index >= 0) {
+        VEntity *Ent = (*List)[Index--];
+        if (Ent && !Ent->IsGoingToDie()) {
+          *EntPtr = Ent;
+          return true;
+        }
+      }
     }
 
     ++y;
@@ -221,7 +418,8 @@ bool VRadiusThingsIterator::GetNext () {
     }
 
     // it cannot get out of bounds, no need to perform any checks here
-    Ent = Self->XLevel->BlockLinks[y*Self->XLevel->BlockMapWidth+x];
+    List = &Level->BlockLinks[y*Level->BlockMapWidth+x];
+    Index = List->length()-1;
   }
 }
 
@@ -231,6 +429,56 @@ bool VRadiusThingsIterator::GetNext () {
 static TMapNC<VEntity *, bool> vptSeenThings;
 
 
+// intercept buffers are reused across traversals; there can be several
+// active traversals (nested `foreach`), so this is a free list of buffers
+static TArray<TArray<intercept_t> *> vptFreeIntercepts;
+static int vptInterceptsInUse = 0;
+
+
+//==========================================================================
+//
+//  AllocInterceptBuffer
+//
+//==========================================================================
+static TArray<intercept_t> &AllocInterceptBuffer () {
+  ++vptInterceptsInUse;
+  if (vptFreeIntercepts.length()) {
+    TArray<intercept_t> *buf = vptFreeIntercepts.last();
+    vptFreeIntercepts.drop();
+    return *buf;
+  }
+  return *(new TArray<intercept_t>());
+}
+
+
+//==========================================================================
+//
+//  ReleaseInterceptBuffer
+//
+//==========================================================================
+static void ReleaseInterceptBuffer (TArray<intercept_t> &buf) {
+  --vptInterceptsInUse;
+  buf.resetNoDtor(); // keep the memory
+  vptFreeIntercepts.append(&buf);
+}
+
+
+//==========================================================================
+//
+//  VPathTraverse::GetInterceptPoolStats
+//
+//==========================================================================
+void VPathTraverse::GetInterceptPoolStats (int *inUse, int *pooled, int *bytes) noexcept {
+  if (inUse) *inUse = vptInterceptsInUse;
+  if (pooled) *pooled = vptFreeIntercepts.length();
+  if (bytes) {
+    int total = 0;
+    for (auto &&buf : vptFreeIntercepts) total += buf->capacity()*(int)sizeof(intercept_t);
+    *bytes = total;
+  }
+}
+
+
 //==========================================================================
 //
 //  VPathTraverse::VPathTraverse
@@ -238,7 +486,8 @@ static TMapNC<VEntity *, bool> vptSeenThings;
 //==========================================================================
 VPathTraverse::VPathTraverse (VThinker *Self, intercept_t **AInPtr, float InX1,
                               float InY1, float x2, float y2, int flags)
-  : seen3DSlopes(false)
+  : Intercepts(AllocInterceptBuffer())
+  , seen3DSlopes(false)
   , seenThing(false)
   , Count(0)
   , In(nullptr)
@@ -248,6 +497,16 @@ VPathTraverse::VPathTraverse (VThinker *Self, intercept_t **AInPtr, float InX1,
 }
 
 
+//==========================================================================
+//
+//  VPathTraverse::~VPathTraverse
+//
+//==========================================================================
+VPathTraverse::~VPathTraverse () {
+  ReleaseInterceptBuffer(Intercepts);
+}
+
+
 //==========================================================================
 //
 //  VPathTraverse::Init
@@ -321,20 +580,7 @@ void VPathTraverse::Init (VThinker *Self, float InX1, float InY1, float x2, floa
 //
 //==========================================================================
 intercept_t &VPathTraverse::NewIntercept (const float frac) {
-  int pos = Intercepts.length();
-  if (pos == 0 || Intercepts[pos-1].frac <= frac) {
-    // no need to bubble, just append it
-    intercept_t &xit = Intercepts.Alloc();
-    xit.frac = frac;
-    return xit;
-  }
-  // bubble
-  while (pos > 0 && Intercepts[pos-1].frac > frac) --pos;
-  // insert
-  intercept_t it;
-  it.frac = frac;
-  Intercepts.insert(pos, it);
-  return Intercepts[pos];
+  return InsertIntercept(Intercepts, frac);
 }
 
 
@@ -344,9 +590,7 @@ intercept_t &VPathTraverse::NewIntercept (const float frac) {
 //
 //==========================================================================
 void VPathTraverse::RemoveInterceptsAfter (const float frac) {
-  int len = Intercepts.length();
-  while (len > 0 && Intercepts[len-1].frac >= frac) --len;
-  if (len != Intercepts.length()) Intercepts.setLength(len, false); // don't resize
+  RemoveInterceptsFrom(Intercepts, frac);
 }
 
 
@@ -363,26 +607,8 @@ void VPathTraverse::RemoveInterceptsAfter (const float frac) {
 bool VPathTraverse::AddLineIntercepts (VThinker *Self, int mapx, int mapy, bool EarlyOut, bool wantThings) {
   line_t *ld;
   for (VBlockLinesIterator It(Self->XLevel, mapx, mapy, &ld); It.GetNext(); ) {
-    //const float dot1 = DotProduct(*ld->v1, trace_plane.normal)-trace_plane.dist;
-    //const float dot2 = DotProduct(*ld->v2, trace_plane.normal)-trace_plane.dist;
-    const float dot1 = trace_plane.PointDistance(*ld->v1);
-    const float dot2 = trace_plane.PointDistance(*ld->v2);
-
-    // do not use multiplication to check: zero speedup, lost accuracy
-    //if (dot1*dot2 >= 0) continue; // line isn't crossed
-    if (dot1 < 0.0f && dot2 < 0.0f) continue; // didn't reached back side
-    // if the trace is parallel to the line plane, ignore it
-    if (dot1 >= 0.0f && dot2 >= 0.0f) continue; // didn't reached front side
-
-    // hit the line
-
-    // find the fractional intercept point along the trace line
-    const float den = DotProduct(ld->normal, trace_delta);
-    if (den == 0) continue;
-
-    const float num = ld->dist-DotProduct(trace_org, ld->normal);
-    const float frac = num/den;
-    if (frac < 0 || frac > 1.0f) continue; // behind source or beyond end point
+    float frac;
+    if (!TraceCrossesLine(ld, trace_plane, trace_org, trace_delta, frac)) continue;
 
     // check if any of line sectors contains 3d floors with slopes
     if (wantThings && !seen3DSlopes) {
@@ -468,82 +694,23 @@ void VPathTraverse::AddThingIntercepts (VThinker *Self, int mapx, int mapy) {
     trace.y = trace_org.y;
     trace.dx = trace_delta.x;
     trace.dy = trace_delta.y;
-    divline_t line;
     /*static*/ const int deltas[3] = { 0, -1, 1 };
     for (int dy = 0; dy < 3; ++dy) {
       for (int dx = 0; dx < 3; ++dx) {
         for (VBlockThingsIterator It(Self->XLevel, mapx+deltas[dx], mapy+deltas[dy]); It; ++It) {
           if (It->Radius <= 0.0f || It->Height <= 0.0f) continue;
           if (vptSeenThings.has(*It)) continue;
-          // [RH] don't check a corner to corner crossection for hit
-          // instead, check against the actual bounding box
-
-          // there's probably a smarter way to determine which two sides
-          // of the thing face the trace than by trying all four sides...
-          int numfronts = 0;
-          for (int i = 0; i < 4; ++i) {
-            switch (i) {
-              case 0: // top edge
-                line.y = It->Origin.y+It->Radius;
-                if (trace_org.y < line.y) continue;
-                line.x = It->Origin.x+It->Radius;
-                line.dx = -It->Radius*2;
-                line.dy = 0;
-                break;
-              case 1: // right edge
-                line.x = It->Origin.x+It->Radius;
-                if (trace_org.x < line.x) continue;
-                line.y = It->Origin.y-It->Radius;
-                line.dx = 0;
-                line.dy = It->Radius*2;
-                break;
-              case 2: // bottom edge
-                line.y = It->Origin.y-It->Radius;
-                if (trace_org.y > line.y) continue;
-                line.x = It->Origin.x-It->Radius;
-                line.dx = It->Radius*2;
-                line.dy = 0;
-                break;
-              case 3: // left edge
-                line.x = It->Origin.x-It->Radius;
-                if (trace_org.x > line.x) continue;
-                line.y = It->Origin.y + It->Radius;
-                line.dx = 0;
-                line.dy = -It->Radius*2;
-                break;
-            }
-            ++numfronts;
-
-            // check if this side is facing the trace origin
-            // if it is, see if the trace crosses it
-            if (pointOnDLineSide(line.x, line.y, trace) != pointOnDLineSide(line.x+line.dx, line.y+line.dy, trace)) {
-              // it's a hit
-              float frac = interceptVector(trace, line);
-              if (frac < 0 || frac > 1.0f) continue;
-
-              vptSeenThings.put(*It, true);
-
-              intercept_t &In = NewIntercept(frac);
-              In.frac = frac;
-              In.Flags = 0;
-              In.line = nullptr;
-              In.thing = *It;
-              seenThing = true;
-              break;
-            }
-          }
-          // if none of the sides was facing the trace, then the trace
-          // must have started inside the box, so add it as an intercept
-          if (numfronts == 0) {
-            vptSeenThings.put(*It, true);
+          float frac;
+          if (!TraceHitsThing(*It, trace, trace_org, frac)) continue;
 
-            intercept_t &In = NewIntercept(0);
-            In.frac = 0;
-            In.Flags = 0;
-            In.line = nullptr;
-            In.thing = *It;
-            seenThing = true;
-          }
+          vptSeenThings.put(*It, true);
+
+          intercept_t &In = NewIntercept(frac);
+          In.frac = frac;
+          In.Flags = 0;
+          In.line = nullptr;
+          In.thing = *It;
+          seenThing = true;
         }
       }
     }
@@ -563,3 +730,907 @@ bool VPathTraverse::GetNext () {
   *InPtr = In++;
   return true;
 }
+
+
+//==========================================================================
+//
+//  VPathTraverseBatch::VPathTraverseBatch
+//
+//==========================================================================
+VPathTraverseBatch::VPathTraverseBatch ()
+  : Level(nullptr)
+  , OrgX(0.0f)
+  , OrgY(0.0f)
+  , Flags(0)
+  , LinesGeometry(0)
+  , TraceStamp(0)
+  , BusyCount(0)
+  , Owner(nullptr)
+  , StartTic(0)
+  , InUse(false)
+{
+}
+
+
+//==========================================================================
+//
+//  VPathTraverseBatch::~VPathTraverseBatch
+//
+//==========================================================================
+VPathTraverseBatch::~VPathTraverseBatch () {
+  for (auto &&buf : RayIntercepts) delete buf;
+  RayIntercepts.clear();
+}
+
+
+//==========================================================================
+//
+//  VPathTraverseBatch::Start
+//
+//==========================================================================
+void VPathTraverseBatch::Start (VLevel *ALevel, float x1, float y1, int AFlags) {
+  vassert(BusyCount == 0);
+  Level = ALevel;
+  OrgX = x1;
+  OrgY = y1;
+  Flags = AFlags;
+  Dests.reset();
+  Rays.reset();
+  RayCells.reset();
+  RayDeps.reset();
+  CellMap.reset();
+  Cells.reset();
+  LineEntries.reset();
+  LinesGeometry = (Level ? Level->GeometryChangeCount : 0);
+  Things.reset();
+  TraceStamp = 0;
+}
+
+
+//==========================================================================
+//
+//  VPathTraverseBatch::Reset
+//
+//==========================================================================
+void VPathTraverseBatch::Reset () {
+  vassert(BusyCount == 0);
+  Level = nullptr;
+  Owner = nullptr;
+  StartTic = 0;
+  InUse = false;
+  Dests.clear();
+  Rays.clear();
+  RayCells.clear();
+  RayDeps.clear();
+  CellMap.clear();
+  Cells.clear();
+  LineEntries.clear();
+  LinesGeometry = 0;
+  Things.clear();
+  TraceStamp = 0;
+  for (auto &&buf : RayIntercepts) buf->clear();
+}
+
+
+//==========================================================================
+//
+//  VPathTraverseBatch::AddRay
+//
+//==========================================================================
+int VPathTraverseBatch::AddRay (float x2, float y2) {
+  const int ray = Dests.length()/2;
+  Dests.append(x2);
+  Dests.append(y2);
+  RayInfo &ri = Rays.alloc();
+  ri.firstCell = -1;
+  ri.cellCount = 0;
+  ri.firstDep = ri.depCount = 0;
+  ri.geometry = 0;
+  ri.busy = 0;
+  ri.traced = false;
+  if (RayIntercepts.length() <= ray) RayIntercepts.append(new TArray<intercept_t>());
+  return ray;
+}
+
+
+//==========================================================================
+//
+//  VPathTraverseBatch::LockRay
+//
+//==========================================================================
+void VPathTraverseBatch::LockRay (int ray) noexcept {
+  ++Rays[ray].busy;
+  ++BusyCount;
+}
+
+
+//==========================================================================
+//
+//  VPathTraverseBatch::UnlockRay
+//
+//==========================================================================
+void VPathTraverseBatch::UnlockRay (int ray) noexcept {
+  vassert(Rays[ray].busy > 0);
+  --Rays[ray].busy;
+  --BusyCount;
+}
+
+
+//==========================================================================
+//
+//  VPathTraverseBatch::IsCellUpToDate
+//
+//  things are checked only if cell links were not changed, so all of
+//  them are still linked (and alive)
+//
+//==========================================================================
+bool VPathTraverseBatch::IsCellUpToDate (const CellInfo &ci) const noexcept {
+  if (ci.thingCount < 0 || ci.thingStamp != Level->BlockLinksStamps[ci.cellidx]) return false;
+  const ThingCand *tc = Things.ptr()+ci.firstThing;
+  for (int f = ci.thingCount; f--; ++tc) {
+    const VEntity *th = tc->th;
+    if (th->Origin.x != tc->x || th->Origin.y != tc->y || th->Radius != tc->radius) return false;
+    if ((th->Radius > 0.0f && th->Height > 0.0f) != tc->usable) return false;
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VPathTraverseBatch::IsUpToDate
+//
+//  checks if the world around the ray was changed since the last trace
+//
+//==========================================================================
+bool VPathTraverseBatch::IsUpToDate (int ray) const noexcept {
+  const RayInfo &ri = Rays[ray];
+  if (!ri.traced || ri.geometry != Level->GeometryChangeCount) return false;
+  const RayDep *dep = RayDeps.ptr()+ri.firstDep;
+  for (int f = ri.depCount; f--; ++dep) {
+    const CellInfo &ci = Cells[dep->ci];
+    // the cell could be collected again by another ray
+    if (ci.firstThing != dep->firstThing || !IsCellUpToDate(ci)) return false;
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VPathTraverseBatch::Prepare
+//
+//==========================================================================
+int VPathTraverseBatch::Prepare (int ray) {
+  // never change intercepts under the iterator
+  if (Rays[ray].busy == 0 && !IsUpToDate(ray)) {
+    // polyobjects could be moved; drop cached line lists
+    if (LinesGeometry != Level->GeometryChangeCount) {
+      LinesGeometry = Level->GeometryChangeCount;
+      LineEntries.reset();
+      for (auto &&ci : Cells) ci.lineCount = -1;
+    }
+    TraceRay(ray);
+  }
+  return RayIntercepts[ray]->length();
+}
+
+
+//==========================================================================
+//
+//  VPathTraverseBatch::WalkRay
+//
+//  collects blockmap cells for the ray (this must be the same walk as
+//  `VPathTraverse::Init()` does); blockmap is never changed, so this is
+//  done only once
+//
+//==========================================================================
+void VPathTraverseBatch::WalkRay (int ray) {
+  RayInfo &ri = Rays[ray];
+  ri.firstCell = RayCells.length();
+  VBlockMapWalker walker;
+  if (walker.start(Level, OrgX, OrgY, Dests[ray*2+0], Dests[ray*2+1])) {
+    int mapx, mapy;
+    while (walker.next(mapx, mapy)) RayCells.append(mapy*Level->BlockMapWidth+mapx);
+  }
+  ri.cellCount = RayCells.length()-ri.firstCell;
+}
+
+
+//==========================================================================
+//
+//  VPathTraverseBatch::GetCell
+//
+//  returns index in `Cells`; collects lines or things for the cell
+//  (in the order `VBlockLinesIterator` and `VBlockThingsIterator` use)
+//  thing snapshot is taken again if the cell was changed
+//
+//==========================================================================
+int VPathTraverseBatch::GetCell (int cellidx, bool withThings) {
+  int res;
+  auto cp = CellMap.get(cellidx);
+  if (cp) {
+    res = *cp;
+  } else {
+    res = Cells.length();
+    CellInfo &ci = Cells.alloc();
+    ci.cellidx = cellidx;
+    ci.firstLine = ci.firstThing = 0;
+    ci.lineCount = ci.thingCount = -1;
+    ci.thingStamp = 0;
+    ci.depStamp = 0;
+    CellMap.put(cellidx, res);
+  }
+
+  if (withThings) {
+    if (!IsCellUpToDate(Cells[res])) {
+      // old snapshot is left in `Things`, because other rays can refer to it
+      const TArray<VEntity *> &list = Level->BlockLinks[cellidx];
+      Cells[res].firstThing = Things.length();
+      for (int f = list.length()-1; f >= 0; --f) {
+        VEntity *th = list[f];
+        if (!th) continue; // unlinked while somebody is iterating
+        ThingCand &tc = Things.alloc();
+        tc.th = th;
+        tc.x = th->Origin.x;
+        tc.y = th->Origin.y;
+        tc.radius = th->Radius;
+        tc.usable = (th->Radius > 0.0f && th->Height > 0.0f);
+        tc.traceStamp = 0;
+      }
+      Cells[res].thingCount = Things.length()-Cells[res].firstThing;
+      Cells[res].thingStamp = Level->BlockLinksStamps[cellidx];
+    }
+  } else {
+    if (Cells[res].lineCount < 0) {
+      const int first = LineEntries.length();
+      // polyobjects first
+      for (polyblock_t *pl = Level->PolyBlockMap[cellidx]; pl; pl = pl->next) {
+        polyobj_t *po = pl->polyobj;
+        if (!po) continue;
+        LineEntry &pe = LineEntries.alloc();
+        pe.line = nullptr;
+        pe.po = po;
+        pe.count = po->numsegs;
+        for (int f = 0; f < po->numsegs; ++f) {
+          LineEntry &le = LineEntries.alloc();
+          le.line = po->segs[f]->linedef;
+          le.po = nullptr;
+          le.count = 0;
+        }
+      }
+      for (const vint32 *list = Level->BlockMapLump+Level->BlockMap[cellidx]+1; *list != -1; ++list) {
+#ifdef PARANOID
+        if (*list < 0 || *list >= Level->NumLines) Host_Error("Broken blockmap - line %d", *list);
+#endif
+        LineEntry &le = LineEntries.alloc();
+        le.line = &Level->Lines[*list];
+        le.po = nullptr;
+        le.count = 0;
+      }
+      Cells[res].firstLine = first;
+      Cells[res].lineCount = LineEntries.length()-first;
+    }
+  }
+
+  return res;
+}
+
+
+//==========================================================================
+//
+//  VPathTraverseBatch::TraceRay
+//
+//  this does exactly what `VPathTraverse` does, but with cached cell data
+//
+//==========================================================================
+void VPathTraverseBatch::TraceRay (int ray) {
+  TArray<intercept_t> &list = *RayIntercepts[ray];
+  list.resetNoDtor();
+
+  if (Rays[ray].firstCell < 0) WalkRay(ray);
+
+  const int stamp = ++TraceStamp;
+  RayInfo &ri = Rays[ray];
+  // reuse dependency space if this ray was the last one traced
+  if (ri.depCount && ri.firstDep+ri.depCount == RayDeps.length()) RayDeps.setLength(ri.firstDep, false);
+  ri.firstDep = RayDeps.length();
+  ri.depCount = 0;
+  ri.geometry = Level->GeometryChangeCount;
+  ri.traced = true;
+
+  const int cellStart = ri.firstCell;
+  const int cellEnd = cellStart+ri.cellCount;
+  if (cellStart == cellEnd) return; // nothing to do (walker failed, or the trace is outside of the map)
+
+  const bool wantThings = (Flags&PT_ADDTHINGS);
+  const bool wantLines = (Flags&PT_ADDLINES);
+  const bool earlyOut = (Flags&PT_EARLYOUT);
+  const int bmWidth = Level->BlockMapWidth;
+  const int bmHeight = Level->BlockMapHeight;
+  bool seen3DSlopes = false;
+  bool seenThing = false;
+
+  float x1 = OrgX, y1 = OrgY;
+  float x2 = Dests[ray*2+0], y2 = Dests[ray*2+1];
+
+  Level->IncrementValidCount();
+
+  // check if `Length()` and `SetPointDirXY()` are happy
+  if (x1 == x2 && y1 == y2) { x2 += 0.002f; y2 += 0.002f; }
+
+  const TVec trace_org = TVec(x1, y1, 0);
+  const TVec trace_dest = TVec(x2, y2, 0);
+  const TVec trace_delta = trace_dest-trace_org;
+  TPlane trace_plane;
+  trace_plane.SetPointDirXY(trace_org, trace_delta);
+
+  divline_t trace;
+  trace.x = trace_org.x;
+  trace.y = trace_org.y;
+  trace.dx = trace_delta.x;
+  trace.dy = trace_delta.y;
+
+  for (int cn = cellStart; cn < cellEnd; ++cn) {
+    const int cellidx = RayCells[cn];
+    const int mapx = cellidx%bmWidth;
+    const int mapy = cellidx/bmWidth;
+
+    if (wantThings) {
+      /*static*/ const int deltas[3] = { 0, -1, 1 };
+      for (int dy = 0; dy < 3; ++dy) {
+        const int cy = mapy+deltas[dy];
+        if (cy < 0 || cy >= bmHeight) continue;
+        for (int dx = 0; dx < 3; ++dx) {
+          const int cx = mapx+deltas[dx];
+          if (cx < 0 || cx >= bmWidth) continue;
+          const int ci = GetCell(cy*bmWidth+cx, true);
+          if (Cells[ci].depStamp != stamp) {
+            Cells[ci].depStamp = stamp;
+            RayDep &dep = RayDeps.alloc();
+            dep.ci = ci;
+            dep.firstThing = Cells[ci].firstThing;
+          }
+          const int tend = Cells[ci].firstThing+Cells[ci].thingCount;
+          for (int tn = Cells[ci].firstThing; tn < tend; ++tn) {
+            ThingCand &tc = Things[tn];
+            if (!tc.usable) continue;
+            // the thing was either added, or missed the trace; no need to check it again
+            if (tc.traceStamp == stamp) continue;
+            tc.traceStamp = stamp;
+            float frac;
+            if (!TraceHitsThing(tc.th, trace, trace_org, frac)) continue;
+
+            intercept_t &In = InsertIntercept(list, frac);
+            In.frac = frac;
+            In.Flags = 0;
+            In.line = nullptr;
+            In.thing = tc.th;
+            seenThing = true;
+          }
+        }
+      }
+    }
+
+    if (wantLines) {
+      const int ci = GetCell(cellidx, false);
+      const LineEntry *le = LineEntries.ptr()+Cells[ci].firstLine;
+      const LineEntry *leend = le+Cells[ci].lineCount;
+      bool stop = false;
+      for (; le < leend; ++le) {
+        if (le->po) {
+          // polyobject lines are checked only once per trace
+          if (le->po->validcount == validcount) le += le->count; else le->po->validcount = validcount;
+          continue;
+        }
+        line_t *ld = le->line;
+        if (ld->validcount == validcount) continue; // line has already been checked
+        ld->validcount = validcount;
+
+        float frac;
+        if (!TraceCrossesLine(ld, trace_plane, trace_org, trace_delta, frac)) continue;
+
+        // check if any of line sectors contains 3d floors with slopes
+        if (wantThings && !seen3DSlopes) {
+          if (ld->frontsector && ld->frontsector->Has3DSlopes()) seen3DSlopes = true;
+          else if (ld->backsector && ld->backsector->Has3DSlopes()) seen3DSlopes = true;
+        }
+
+        bool doExit = false;
+        // try to early out the check
+        if (earlyOut && frac < 1.0f && (!ld->backsector || !(ld->flags&ML_TWOSIDED))) {
+          // stop checking
+          RemoveInterceptsFrom(list, frac); // this will remove blocking line, but we need it, hence the flag
+          doExit = true;
+        }
+
+        intercept_t &In = InsertIntercept(list, frac);
+        In.frac = frac;
+        In.Flags = intercept_t::IF_IsALine;
+        In.line = ld;
+        In.thing = nullptr;
+
+        if (doExit) { stop = true; break; }
+      }
+      if (stop) break; // early out
+    }
+  }
+  ri.depCount = RayDeps.length()-ri.firstDep;
+
+  // add "extra thing check" flag
+  if (seen3DSlopes && seenThing) {
+    for (auto &&it : list) it.Flags |= intercept_t::IF_ExtraThingCheck;
+  }
+}
+
+
+//==========================================================================
+//
+//  VPathTraverseBatchIterator::VPathTraverseBatchIterator
+//
+//==========================================================================
+VPathTraverseBatchIterator::VPathTraverseBatchIterator (VPathTraverseBatch *ABatch, int ARay, intercept_t **AInPtr)
+  : Batch(ABatch)
+  , Ray(ARay)
+  , Index(0)
+  , InPtr(AInPtr)
+{
+  if (Batch) {
+    Batch->Prepare(Ray);
+    Batch->LockRay(Ray);
+  }
+}
+
+
+//==========================================================================
+//
+//  VPathTraverseBatchIterator::~VPathTraverseBatchIterator
+//
+//==========================================================================
+VPathTraverseBatchIterator::~VPathTraverseBatchIterator () {
+  if (Batch) Batch->UnlockRay(Ray);
+}
+
+
+//==========================================================================
+//
+//  VPathTraverseBatchIterator::GetNext
+//
+//==========================================================================
+bool VPathTraverseBatchIterator::GetNext () {
+  if (!Batch || Index >= Batch->GetInterceptCount(Ray)) return false; // everything was traversed
+  *InPtr = Batch->GetIntercepts(Ray)+Index;
+  ++Index;
+  return true;
+}
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+// batches for VM; handle is index+1
+static TArray<VPathTraverseBatch *> vptBatches;
+
+
+//==========================================================================
+//
+//  P_PathTraverseBatchBegin
+//
+//  batches which were not finished in the previous tics are reused
+//  (unless somebody is still iterating them)
+//
+//==========================================================================
+int P_PathTraverseBatchBegin (VThinker *Self, float x1, float y1, int flags) {
+  if (!Self || !Self->XLevel) return 0;
+  VLevel *level = Self->XLevel;
+  int slot = -1;
+  for (int f = 0; f < vptBatches.length(); ++f) {
+    const VPathTraverseBatch *b = vptBatches[f];
+    if (b->IsBusy()) continue;
+    if (!b->InUse || b->GetLevel() != level || b->StartTic != level->TicTime) { slot = f; break; }
+  }
+  if (slot < 0) slot = vptBatches.append(new VPathTraverseBatch());
+  VPathTraverseBatch *b = vptBatches[slot];
+  b->Start(level, x1, y1, flags);
+  b->InUse = true;
+  b->Owner = Self;
+  b->StartTic = level->TicTime;
+  return slot+1;
+}
+
+
+//==========================================================================
+//
+//  P_PathTraverseBatchGet
+//
+//  handles are valid only for the thinker which started the batch, and
+//  only in the same tic (batch can be reused in the next tic, and cached
+//  things can be collected by GC)
+//
+//==========================================================================
+VPathTraverseBatch *P_PathTraverseBatchGet (VThinker *Self, int handle) {
+  if (!Self || !Self->XLevel || handle < 1 || handle > vptBatches.length()) return nullptr;
+  VPathTraverseBatch *b = vptBatches[handle-1];
+  if (!b->InUse || b->Owner != Self || b->GetLevel() != Self->XLevel || b->StartTic != Self->XLevel->TicTime) return nullptr;
+  return b;
+}
+
+
+//==========================================================================
+//
+//  P_PathTraverseBatchEnd
+//
+//==========================================================================
+void P_PathTraverseBatchEnd (VThinker *Self, int handle) {
+  VPathTraverseBatch *b = P_PathTraverseBatchGet(Self, handle);
+  if (b) b->InUse = false;
+}
+
+
+//==========================================================================
+//
+//  P_PathTraverseBatchRay
+//
+//  batch does only gz thing check; debug thing checks are done with
+//  `VPathTraverse`, so the results are the same as for separate traces
+//
+//==========================================================================
+VScriptIterator *P_PathTraverseBatchRay (VThinker *Self, VPathTraverseBatch *batch, int ray, intercept_t **AInPtr) {
+  if (batch && (dbg_use_buggy_thing_traverser || dbg_use_vavoom_thing_coldet)) {
+    return new VPathTraverse(Self, AInPtr, batch->GetOrgX(), batch->GetOrgY(), batch->GetRayDestX(ray), batch->GetRayDestY(ray), batch->GetFlags());
+  }
+  return new VPathTraverseBatchIterator(batch, ray, AInPtr);
+}
+
+
+//==========================================================================
+//
+//  P_PathTraverseBatchLevelDestroyed
+//
+//  batches keep level, thing and line pointers
+//
+//==========================================================================
+void P_PathTraverseBatchLevelDestroyed (VLevel *level) {
+  for (auto &&b : vptBatches) if (b->GetLevel() == level) b->Reset();
+}
+
+
+//==========================================================================
+//
+//  P_FreePathTraverseBatches
+//
+//==========================================================================
+void P_FreePathTraverseBatches () {
+  for (auto &&b : vptBatches) delete b;
+  vptBatches.clear();
+}
+
+
+//==========================================================================
+//
+//  BlockThingsBench
+//
+//  compares old linked thing chains with per-cell thing lists on a
+//  synthetic slaughtermap: thousands of actors packed in a few dense
+//  clusters. fake actors are as big as real entities, and allocated in
+//  random order, so chain walking suffers from cache misses like in game.
+//  lists are tested with shifting unlink, and with holes (what the engine
+//  does); "relink all" is link/unlink churn for every thing.
+//
+//==========================================================================
+namespace {
+struct BenchThing {
+  float x, y, radius;
+  vuint32 cell; // index+1
+  int slot; // in cell list
+  BenchThing *next;
+  BenchThing *prev;
+  vuint8 payload[1024]; // simulate entity size
+};
+
+static inline vuint32 benchRandom (vuint32 &seed) noexcept {
+  seed ^= seed<<13;
+  seed ^= seed>>17;
+  seed ^= seed<<5;
+  return seed;
+}
+
+static inline float benchRandomFloat (vuint32 &seed) noexcept {
+  return (float)(benchRandom(seed)&0xffffffu)/(float)0x1000000u;
+}
+}
+
+
+COMMAND(BlockThingsBench) {
+  int count = 8000;
+  int rounds = 20;
+  if (Args.length() > 1) count = clampval(VStr::atoi(*Args[1]), 16, 200000);
+  if (Args.length() > 2) rounds = clampval(VStr::atoi(*Args[2]), 1, 1000);
+
+  const int bmW = 64, bmH = 64;
+  const float cellSize = (float)MAPBLOCKUNITS;
+  vuint32 seed = 0x29a;
+
+  // create clusters
+  enum { NumClusters = 6 };
+  float clx[NumClusters], cly[NumClusters], clr[NumClusters];
+  for (int f = 0; f < NumClusters; ++f) {
+    clr[f] = cellSize*(2.0f+benchRandomFloat(seed)*4.0f);
+    clx[f] = clr[f]+benchRandomFloat(seed)*(bmW*cellSize-clr[f]*2.0f);
+    cly[f] = clr[f]+benchRandomFloat(seed)*(bmH*cellSize-clr[f]*2.0f);
+  }
+
+  // allocate things in shuffled order, so chains are scattered over memory
+  TArray<BenchThing *> things;
+  things.setLength(count);
+  for (auto &&th : things) th = new BenchThing;
+  for (int f = count-1; f > 0; --f) {
+    const int n = (int)(benchRandom(seed)%(vuint32)(f+1));
+    BenchThing *tmp = things[f];
+    things[f] = things[n];
+    things[n] = tmp;
+  }
+  for (auto &&th : things) {
+    const int cl = (int)(benchRandom(seed)%NumClusters);
+    // 90% of actors are in clusters, the rest are spread over the map
+    if (benchRandom(seed)%10 != 0) {
+      const float a = benchRandomFloat(seed)*2.0f*(float)M_PI;
+      const float d = benchRandomFloat(seed)*clr[cl];
+      th->x = clx[cl]+cosf(a)*d;
+      th->y = cly[cl]+sinf(a)*d;
+    } else {
+      th->x = benchRandomFloat(seed)*bmW*cellSize;
+      th->y = benchRandomFloat(seed)*bmH*cellSize;
+    }
+    th->radius = 16.0f+benchRandomFloat(seed)*48.0f;
+    th->cell = 0;
+  }
+
+  enum { BenchChains, BenchShift, BenchHoles, NumBenchModes };
+  static const char *modeNames[NumBenchModes] = { "chains", "shift", "holes" };
+
+  BenchThing **chains = new BenchThing *[bmW*bmH];
+  memset((void *)chains, 0, bmW*bmH*sizeof(chains[0]));
+  TArray<BenchThing *> *lists = new TArray<BenchThing *>[bmW*bmH];
+  int *holes = new int[bmW*bmH];
+  memset((void *)holes, 0, bmW*bmH*sizeof(holes[0]));
+
+  auto cellOf = [&](const BenchThing *th) -> int {
+    const int cx = clampval((int)(th->x/cellSize), 0, bmW-1);
+    const int cy = clampval((int)(th->y/cellSize), 0, bmH-1);
+    return cy*bmW+cx;
+  };
+
+  auto chainLink = [&](BenchThing *th) {
+    const int c = cellOf(th);
+    th->prev = nullptr;
+    th->next = chains[c];
+    if (chains[c]) chains[c]->prev = th;
+    chains[c] = th;
+    th->cell = (vuint32)c+1;
+  };
+  auto chainUnlink = [&](BenchThing *th) {
+    if (th->next) th->next->prev = th->prev;
+    if (th->prev) th->prev->next = th->next; else chains[th->cell-1] = th->next;
+    th->cell = 0;
+  };
+  auto listLink = [&](BenchThing *th) {
+    const int c = cellOf(th);
+    th->slot = lists[c].length();
+    lists[c].append(th);
+    th->cell = (vuint32)c+1;
+  };
+  // shift the rest of the list, and fix slots of moved things
+  auto shiftUnlink = [&](BenchThing *th) {
+    TArray<BenchThing *> &list = lists[th->cell-1];
+    const int idx = th->slot;
+    list.removeAt(idx);
+    for (int f = idx; f < list.length(); ++f) list[f]->slot = f;
+    th->cell = 0;
+  };
+  // leave a hole, and compact the list when half of it is holes (like `VEntity::UnlinkFromWorld()` does)
+  auto holeUnlink = [&](BenchThing *th) {
+    const int c = (int)th->cell-1;
+    TArray<BenchThing *> &list = lists[c];
+    list[th->slot] = nullptr;
+    if (++holes[c]*2 >= list.length()) {
+      int dest = 0;
+      for (int f = 0; f < list.length(); ++f) {
+        BenchThing *o = list[f];
+        if (!o) continue;
+        o->slot = dest;
+        list[dest++] = o;
+      }
+      list.setLength(dest, false);
+      holes[c] = 0;
+    }
+    th->cell = 0;
+  };
+  auto benchLink = [&](BenchThing *th, int mode) {
+    if (mode == BenchChains) chainLink(th); else listLink(th);
+  };
+  auto benchUnlink = [&](BenchThing *th, int mode) {
+    if (mode == BenchChains) chainUnlink(th); else if (mode == BenchShift) shiftUnlink(th); else holeUnlink(th);
+  };
+
+  // query: count things touching each thing's box (like `CheckRelPosition()`)
+  auto chainQuery = [&]() -> int {
+    int hits = 0;
+    for (const BenchThing *th : things) {
+      const int cx = (int)(th->x/cellSize), cy = (int)(th->y/cellSize);
+      for (int by = max2(0, cy-1); by <= min2(bmH-1, cy+1); ++by) {
+        for (int bx = max2(0, cx-1); bx <= min2(bmW-1, cx+1); ++bx) {
+          for (const BenchThing *o = chains[by*bmW+bx]; o; o = o->next) {
+            const float bd = th->radius+o->radius;
+            if (fabsf(o->x-th->x) < bd && fabsf(o->y-th->y) < bd) ++hits;
+          }
+        }
+      }
+    }
+    return hits;
+  };
+  auto listQuery = [&]() -> int {
+    int hits = 0;
+    for (const BenchThing *th : things) {
+      const int cx = (int)(th->x/cellSize), cy = (int)(th->y/cellSize);
+      for (int by = max2(0, cy-1); by <= min2(bmH-1, cy+1); ++by) {
+        for (int bx = max2(0, cx-1); bx <= min2(bmW-1, cx+1); ++bx) {
+          const TArray<BenchThing *> &list = lists[by*bmW+bx];
+          for (int n = list.length()-1; n >= 0; --n) {
+            const BenchThing *o = list[n];
+            if (!o) continue;
+            const float bd = th->radius+o->radius;
+            if (fabsf(o->x-th->x) < bd && fabsf(o->y-th->y) < bd) ++hits;
+          }
+        }
+      }
+    }
+    return hits;
+  };
+  // move some things around, and relink them
+  auto moveThings = [&](vuint32 &mseed, int mode) {
+    for (BenchThing *th : things) {
+      if (benchRandom(mseed)%4 != 0) continue;
+      benchUnlink(th, mode);
+      th->x = clampval(th->x+(benchRandomFloat(mseed)-0.5f)*16.0f, 0.0f, bmW*cellSize-1.0f);
+      th->y = clampval(th->y+(benchRandomFloat(mseed)-0.5f)*16.0f, 0.0f, bmH*cellSize-1.0f);
+      benchLink(th, mode);
+    }
+  };
+  // link/unlink churn: relink every thing in place (like tiny moves which don't change the cell)
+  auto relinkThings = [&](int mode) {
+    for (BenchThing *th : things) {
+      benchUnlink(th, mode);
+      benchLink(th, mode);
+    }
+  };
+
+  // all structures replay the same moves from the same start positions
+  TArray<float> startPos;
+  startPos.setLength(count*2);
+  for (int f = 0; f < count; ++f) { startPos[f*2+0] = things[f]->x; startPos[f*2+1] = things[f]->y; }
+
+  double queryTime[NumBenchModes], moveTime[NumBenchModes], churnTime[NumBenchModes];
+  int hits[NumBenchModes];
+  int maxCell = 0;
+  for (int mode = 0; mode < NumBenchModes; ++mode) {
+    for (int f = 0; f < count; ++f) { things[f]->x = startPos[f*2+0]; things[f]->y = startPos[f*2+1]; }
+    for (int c = 0; c < bmW*bmH; ++c) { lists[c].reset(); holes[c] = 0; }
+    for (BenchThing *th : things) benchLink(th, mode);
+    if (mode == BenchShift) {
+      for (int c = 0; c < bmW*bmH; ++c) maxCell = max2(maxCell, lists[c].length());
+    }
+    queryTime[mode] = moveTime[mode] = churnTime[mode] = 0;
+    hits[mode] = 0;
+    vuint32 mseed = 0x29a;
+    for (int r = 0; r < rounds; ++r) {
+      const double stt = Sys_Time();
+      moveThings(mseed, mode);
+      const double qtt = Sys_Time();
+      hits[mode] += (mode == BenchChains ? chainQuery() : listQuery());
+      const double rtt = Sys_Time();
+      relinkThings(mode);
+      churnTime[mode] += Sys_Time()-rtt;
+      queryTime[mode] += rtt-qtt;
+      moveTime[mode] += qtt-stt;
+    }
+  }
+
+  GCon->Logf("BlockThingsBench: %d things, %d rounds, %d clusters; max things in cell: %d", count, rounds, (int)NumClusters, maxCell);
+  for (int mode = 0; mode < NumBenchModes; ++mode) {
+    GCon->Logf("  %-6s: query %.3f msec/round, move %.3f msec/round, relink all %.3f msec/round (%d hits)", modeNames[mode],
+      queryTime[mode]*1000.0/rounds, moveTime[mode]*1000.0/rounds, churnTime[mode]*1000.0/rounds, hits[mode]);
+    if (hits[mode] != hits[BenchChains]) GCon->Logf(NAME_Error, "  MISMATCH: chains found %d hits, %s found %d hits", hits[BenchChains], modeNames[mode], hits[mode]);
+  }
+
+  delete[] holes;
+  delete[] lists;
+  delete[] chains;
+  for (auto &&th : things) delete th;
+}
+
+
+//==========================================================================
+//
+//  PathTraverseBatchBench
+//
+//  usage:
+//    PathTraverseBatchBench [pellets [spread [iterations]]]
+//
+//  traces a cone of rays from the player (like shotgun pellets) with
+//  `VPathTraverse` and with `VPathTraverseBatch`, checks that both give
+//  the same intercepts, and shows timings
+//
+//==========================================================================
+COMMAND(PathTraverseBatchBench) {
+  VBasePlayer *plr = (GGameInfo ? GGameInfo->Players[0] : nullptr);
+  VEntity *mo = (plr ? plr->MO : nullptr);
+  if (!mo || !mo->XLevel) {
+    GCon->Log("no player");
+    return;
+  }
+
+  const int pellets = (Args.length() > 1 ? clampval(VStr::atoi(*Args[1]), 1, 256) : 20);
+  const float spread = (Args.length() > 2 ? clampval(VStr::atof(*Args[2]), 0.0f, 360.0f) : 11.2f);
+  const int iters = (Args.length() > 3 ? clampval(VStr::atoi(*Args[3]), 1, 100000) : 1000);
+  const float range = 2048.0f;
+  const int flags = PT_ADDLINES|PT_ADDTHINGS;
+
+  TArray<float> dests;
+  for (int f = 0; f < pellets; ++f) {
+    const float yaw = mo->Angles.yaw+(pellets > 1 ? spread*((float)f/(float)(pellets-1)-0.5f) : 0.0f);
+    float s, c;
+    msincos(yaw, &s, &c);
+    dests.append(mo->Origin.x+c*range);
+    dests.append(mo->Origin.y+s*range);
+  }
+
+  // check results
+  int mismatches = 0, total = 0;
+  {
+    VPathTraverseBatch batch;
+    batch.Start(mo->XLevel, mo->Origin.x, mo->Origin.y, flags);
+    for (int f = 0; f < pellets; ++f) batch.AddRay(dests[f*2+0], dests[f*2+1]);
+    for (int f = 0; f < pellets; ++f) {
+      const int bcount = batch.Prepare(f);
+      const intercept_t *bin = batch.GetIntercepts(f);
+      intercept_t *in = nullptr;
+      int n = 0;
+      bool ok = true;
+      for (VPathTraverse It(mo, &in, mo->Origin.x, mo->Origin.y, dests[f*2+0], dests[f*2+1], flags); It.GetNext(); ++n) {
+        if (n >= bcount) { ok = false; continue; }
+        const intercept_t &bi = bin[n];
+        if (in->frac != bi.frac || in->Flags != bi.Flags || in->line != bi.line || in->thing != bi.thing) ok = false;
+      }
+      if (n != bcount) ok = false;
+      total += n;
+      if (!ok) {
+        ++mismatches;
+        GCon->Logf(NAME_Error, "  MISMATCH in ray #%d: %d intercepts from path traverser, %d from batch", f, n, bcount);
+      }
+    }
+    GCon->Logf("PathTraverseBatchBench: %d rays, %g degrees, %d iterations; %d intercepts; %d cells, %d thing candidates", pellets, spread, iters, total, batch.GetCellCount(), batch.GetThingCandidateCount());
+  }
+  if (mismatches) return;
+
+  // serial
+  double serialTime = -Sys_Time();
+  for (int it = 0; it < iters; ++it) {
+    for (int f = 0; f < pellets; ++f) {
+      intercept_t *in = nullptr;
+      for (VPathTraverse It(mo, &in, mo->Origin.x, mo->Origin.y, dests[f*2+0], dests[f*2+1], flags); It.GetNext(); ) {}
+    }
+  }
+  serialTime += Sys_Time();
+
+  // batched
+  VPathTraverseBatch batch;
+  double batchTime = -Sys_Time();
+  for (int it = 0; it < iters; ++it) {
+    batch.Start(mo->XLevel, mo->Origin.x, mo->Origin.y, flags);
+    for (int f = 0; f < pellets; ++f) batch.AddRay(dests[f*2+0], dests[f*2+1]);
+    for (int f = 0; f < pellets; ++f) (void)batch.Prepare(f);
+  }
+  batchTime += Sys_Time();
+
+  GCon->Logf("  path traverser: %.3f usecs per attack", serialTime*1000000.0/iters);
+  GCon->Logf("  batch         : %.3f usecs per attack", batchTime*1000000.0/iters);
+}
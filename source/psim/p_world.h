@@ -60,24 +60,42 @@ public:
 //
 //  VBlockThingsIterator
 //
+//  walks cell list from the end, so the most recently linked thing comes
+//  first. things can be unlinked or relinked by callbacks; while any
+//  iterator is active, cell lists never shrink (unlinked things leave
+//  `nullptr` holes, which are skipped here).
+//
 //==========================================================================
 class VBlockThingsIterator {
 private:
-  VEntity *Ent;
+  VLevel *Level;
+  const TArray<VEntity *> *List;
+  int Index;
+
+  inline void SkipHoles () { while (Index >= 0 && !(*List)[Index]) --Index; }
 
 public:
-  VBlockThingsIterator (VLevel *Level, int x, int y) {
+  VBlockThingsIterator (VLevel *ALevel, int x, int y) : Level(ALevel) {
+    Level->BlockLinksIterBegin();
     if (x < 0 || x >= Level->BlockMapWidth || y < 0 || y >= Level->BlockMapHeight) {
-      Ent = nullptr;
+      List = nullptr;
+      Index = -1;
     } else {
-      Ent = Level->BlockLinks[y*Level->BlockMapWidth+x];
+      List = &Level->BlockLinks[y*Level->BlockMapWidth+x];
+      Index = List->length()-1;
+      SkipHoles();
     }
   }
 
-  inline operator bool () const { return !!Ent; }
-  inline void operator ++ () { Ent = Ent->BlockMapNext; }
-  inline VEntity *operator * () const { return Ent; }
-  inline VEntity *operator -> () const { return Ent; }
+  VBlockThingsIterator (const VBlockThingsIterator &) = delete;
+  VBlockThingsIterator &operator = (const VBlockThingsIterator &) = delete;
+
+  inline ~VBlockThingsIterator () { Level->BlockLinksIterEnd(); }
+
+  inline operator bool () const { return (Index >= 0); }
+  inline void operator ++ () { --Index; SkipHoles(); }
+  inline VEntity *operator * () const { return (*List)[Index]; }
+  inline VEntity *operator -> () const { return (*List)[Index]; }
 };
 
 
@@ -89,14 +107,17 @@ public:
 class VRadiusThingsIterator : public VScriptIterator {
 private:
   VThinker *Self;
+  VLevel *Level;
   VEntity **EntPtr;
-  VEntity *Ent;
+  const TArray<VEntity *> *List; // current cell
+  int Index; // in `List`, walking down
   int x, y;
   int xl, xh;
   int yl, yh;
 
 public:
   VRadiusThingsIterator (VThinker *ASelf, VEntity **AEntPtr, TVec Org, float Radius);
+  virtual ~VRadiusThingsIterator () override;
   virtual bool GetNext () override;
 };
 
@@ -111,7 +132,7 @@ public:
 //==========================================================================
 class VPathTraverse : public VScriptIterator {
 private:
-  TArray<intercept_t> Intercepts;
+  TArray<intercept_t> &Intercepts; // taken from the buffer pool, returned in dtor
 
   TPlane trace_plane;
   TVec trace_org;
@@ -128,8 +149,15 @@ private:
 
 public:
   VPathTraverse (VThinker *Self, intercept_t **AInPtr, float InX1, float InY1, float x2, float y2, int flags);
+  virtual ~VPathTraverse () override;
   virtual bool GetNext () override;
 
+  VPathTraverse (const VPathTraverse &) = delete;
+  VPathTraverse &operator = (const VPathTraverse &) = delete;
+
+  // `inUse`: buffers taken by active traversals; `pooled`: free buffers; `bytes`: memory allocated for all pooled buffers
+  static void GetInterceptPoolStats (int *inUse, int *pooled, int *bytes) noexcept;
+
 private:
   void Init (VThinker *Self, float InX1, float InY1, float x2, float y2, int flags);
   bool AddLineIntercepts (VThinker *Self, int mapx, int mapy, bool EarlyOut, bool wantThings);
@@ -137,3 +165,165 @@ private:
   intercept_t &NewIntercept (const float frac);
   void RemoveInterceptsAfter (const float frac); // >=
 };
+
+
+//==========================================================================
+//
+//  VPathTraverseBatch
+//
+//  traces several rays from the same point (multi-pellet hitscans).
+//  line lists of blockmap cells and thing candidates are collected once
+//  for all rays, and each ray gets exactly the same intercepts (in the
+//  same order) as `VPathTraverse` would give.
+//
+//  rays are traced lazily, one by one, when they are requested. attack
+//  code can change the world between pellets (kill, gib or move things,
+//  spawn puffs and blood), so each trace remembers which thing cells it
+//  used. before giving out a ray, only those cells (their link stamps and
+//  thing snapshots) and level geometry are checked, and only that ray is
+//  traced again if necessary. rays which are being iterated are never
+//  traced again.
+//
+//==========================================================================
+class VPathTraverseBatch {
+private:
+  // cached line list of a blockmap cell, in `VBlockLinesIterator` order
+  // polyobject entry (`po != nullptr`) is followed by `count` lines of that polyobject
+  struct LineEntry {
+    line_t *line;
+    polyobj_t *po;
+    int count;
+  };
+
+  struct CellInfo {
+    int cellidx;
+    int firstLine, lineCount; // in `LineEntries`; `lineCount < 0`: not collected yet
+    int firstThing, thingCount; // current snapshot in `Things`; `thingCount < 0`: not collected yet
+    vuint32 thingStamp; // `VLevel::BlockLinksStamps[cellidx]` when the snapshot was taken
+    int depStamp; // used to collect ray dependencies
+  };
+
+  // thing candidate; snapshot is used to check if the thing was changed
+  struct ThingCand {
+    VEntity *th;
+    float x, y, radius;
+    bool usable; // has positive radius and height
+    int traceStamp; // thing was already checked in this trace
+  };
+
+  // thing cell snapshot used by a ray trace
+  struct RayDep {
+    int ci; // in `Cells`
+    int firstThing; // snapshot id
+  };
+
+  struct RayInfo {
+    int firstCell, cellCount; // in `RayCells`; `firstCell < 0`: blockmap was not walked yet
+    int firstDep, depCount; // in `RayDeps`, for the last trace
+    vuint32 geometry; // `VLevel::GeometryChangeCount` at trace time
+    int busy; // number of active iterators
+    bool traced;
+  };
+
+  VLevel *Level;
+  float OrgX, OrgY;
+  int Flags;
+  TArray<float> Dests; // x, y pairs
+  TArray<RayInfo> Rays;
+
+  TArray<int> RayCells; // blockmap cells walked by the rays
+  TArray<RayDep> RayDeps;
+  TMapNC<int, int> CellMap; // cell index -> index in `Cells`
+  TArray<CellInfo> Cells;
+  TArray<LineEntry> LineEntries;
+  vuint32 LinesGeometry; // `VLevel::GeometryChangeCount` for cached line lists (polyobjects)
+  TArray<ThingCand> Things;
+  int TraceStamp;
+  int BusyCount; // active iterators
+
+  // separate buffer for each ray, so retracing one ray won't move intercepts of others
+  TArray<TArray<intercept_t> *> RayIntercepts;
+
+public:
+  // used by VM handles
+  VThinker *Owner; // only compared, never dereferenced
+  int StartTic;
+  bool InUse;
+
+public:
+  VPathTraverseBatch ();
+  ~VPathTraverseBatch ();
+
+  VPathTraverseBatch (const VPathTraverseBatch &) = delete;
+  VPathTraverseBatch &operator = (const VPathTraverseBatch &) = delete;
+
+  void Start (VLevel *ALevel, float x1, float y1, int AFlags);
+  // drops all cached level data (used when the level is destroyed)
+  void Reset ();
+  // returns ray index
+  int AddRay (float x2, float y2);
+
+  inline VLevel *GetLevel () const noexcept { return Level; }
+  inline float GetOrgX () const noexcept { return OrgX; }
+  inline float GetOrgY () const noexcept { return OrgY; }
+  inline int GetFlags () const noexcept { return Flags; }
+  inline int GetRayCount () const noexcept { return Dests.length()/2; }
+  inline float GetRayDestX (int ray) const noexcept { return Dests[ray*2+0]; }
+  inline float GetRayDestY (int ray) const noexcept { return Dests[ray*2+1]; }
+  inline bool IsBusy () const noexcept { return (BusyCount > 0); }
+
+  // traces the ray if necessary; returns number of intercepts for the ray
+  // busy rays are never traced again
+  int Prepare (int ray);
+  // valid after `Prepare()`, until the ray is traced again
+  inline intercept_t *GetIntercepts (int ray) noexcept { return RayIntercepts[ray]->ptr(); }
+  inline int GetInterceptCount (int ray) const noexcept { return RayIntercepts[ray]->length(); }
+
+  // iterators lock their rays, so nested `Prepare()` won't change their intercepts
+  void LockRay (int ray) noexcept;
+  void UnlockRay (int ray) noexcept;
+
+  // stats
+  inline int GetCellCount () const noexcept { return Cells.length(); }
+  inline int GetThingCandidateCount () const noexcept { return Things.length(); }
+
+private:
+  bool IsCellUpToDate (const CellInfo &ci) const noexcept;
+  bool IsUpToDate (int ray) const noexcept;
+  void WalkRay (int ray);
+  int GetCell (int cellidx, bool withThings);
+  void TraceRay (int ray);
+};
+
+
+//==========================================================================
+//
+//  VPathTraverseBatchIterator
+//
+//  VM iterator for one ray of the batch
+//
+//==========================================================================
+class VPathTraverseBatchIterator : public VScriptIterator {
+private:
+  VPathTraverseBatch *Batch;
+  int Ray;
+  int Index;
+  intercept_t **InPtr;
+
+public:
+  VPathTraverseBatchIterator (VPathTraverseBatch *ABatch, int ARay, intercept_t **AInPtr);
+  virtual ~VPathTraverseBatchIterator () override;
+  virtual bool GetNext () override;
+};
+
+
+// batch handles for VM (0 is invalid handle)
+int P_PathTraverseBatchBegin (VThinker *Self, float x1, float y1, int flags);
+// returns `nullptr` for batches started by other thinkers, or in other tics
+VPathTraverseBatch *P_PathTraverseBatchGet (VThinker *Self, int handle);
+void P_PathTraverseBatchEnd (VThinker *Self, int handle);
+// creates VM iterator for the batch ray (`batch` can be `nullptr`, this gives empty iterator)
+VScriptIterator *P_PathTraverseBatchRay (VThinker *Self, VPathTraverseBatch *batch, int ray, intercept_t **AInPtr);
+// called when the level is destroyed
+void P_PathTraverseBatchLevelDestroyed (VLevel *level);
+void P_FreePathTraverseBatches ();
@@ -327,6 +327,7 @@ bool VOpenGLDrawer::SetSpriteLump (VTexture *Tex, VTextureTranslation *Translati
       needUp = true;
     }
     Tex->lastUpdateFrame = updateFrame;
+    Tex->MarkUsed();
     if (Translation || CMap || ShadeColor) {
       // color translation, color map, or stenciled
       // find translation, and mark it as recently used
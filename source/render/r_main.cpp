@@ -763,26 +763,23 @@ VRenderLevelShared::~VRenderLevelShared () {
   delete[] bspVisRadius;
   bspVisRadius = nullptr;
 
+  // sector surfaces are in the level map arena, only their surfaces should be freed
   for (auto &&sub : Level->allSubsectors()) {
     for (subregion_t *r = sub.regions; r != nullptr; r = r->next) {
       if (r->realfloor != nullptr) {
         FreeSurfaces(r->realfloor->surfs);
-        delete r->realfloor;
         r->realfloor = nullptr;
       }
       if (r->realceil != nullptr) {
         FreeSurfaces(r->realceil->surfs);
-        delete r->realceil;
         r->realceil = nullptr;
       }
       if (r->fakefloor != nullptr) {
         FreeSurfaces(r->fakefloor->surfs);
-        delete r->fakefloor;
         r->fakefloor = nullptr;
       }
       if (r->fakeceil != nullptr) {
         FreeSurfaces(r->fakeceil->surfs);
-        delete r->fakeceil;
         r->fakeceil = nullptr;
       }
     }
@@ -1431,6 +1428,7 @@ void R_RenderPlayerView () {
 //==========================================================================
 void VRenderLevelShared::RenderPlayerView () {
   if (!Level->LevelInfo) return;
+  VTRACE_ZONE("RenderPlayerView");
 
   if (lastRenderQuality != r_fix_tjunctions.asBool()) {
     lastRenderQuality = r_fix_tjunctions.asBool();
@@ -1465,7 +1463,10 @@ void VRenderLevelShared::RenderPlayerView () {
   //TODO: we can separate BspVis building (and batching surfaces for rendering), and
   //      the actual rendering. this way we'll be able to do better dynlight checks
 
-  PushDlights();
+  {
+    VTRACE_ZONE("PushDlights");
+    PushDlights();
+  }
 
   // update camera textures that were visible in the last frame
   // rendering camera texture sets `NextUpdateTime`
@@ -1497,14 +1498,20 @@ void VRenderLevelShared::RenderPlayerView () {
   if (dbg_clip_dump_added_ranges) GCon->Logf("=== RENDER SCENE: (%f,%f,%f); (yaw=%f; pitch=%f)", Drawer->vieworg.x, Drawer->vieworg.y, Drawer->vieworg.x, Drawer->viewangles.yaw, Drawer->viewangles.pitch);
 
   //GCon->Log(NAME_Debug, "*** VRenderLevelShared::RenderPlayerView: ENTER ***");
-  RenderScene(&refdef, nullptr);
+  {
+    VTRACE_ZONE("RenderScene");
+    RenderScene(&refdef, nullptr);
+  }
   //GCon->Log(NAME_Debug, "*** VRenderLevelShared::RenderPlayerView: EXIT ***");
 
   if (dbg_clip_dump_added_ranges) ViewClip.Dump();
 
   // perform bloom effect
   //GCon->Logf(NAME_Debug, "BLOOM: (%d,%d); (%dx%d)", refdef.x, refdef.y, refdef.width, refdef.height);
-  Drawer->Posteffect_Bloom(refdef.x, refdef.y, refdef.width, refdef.height);
+  {
+    VTRACE_ZONE("Bloom");
+    Drawer->Posteffect_Bloom(refdef.x, refdef.y, refdef.width, refdef.height);
+  }
 
   // recalc in case recursive scene renderer moved it
   // we need it for psprite rendering
@@ -1988,13 +1995,24 @@ void VRenderLevelShared::PrecacheLevel () {
 
   if (maxpbar > 0) {
     GCon->Logf("precaching %d textures", maxpbar);
-    for (int f = 1; f < maxtex; ++f) {
-      if (texturepresent[f]) {
+    // decode textures in worker threads, so we will only upload pixels here
+    // this is done in batches, to avoid keeping too many decoded textures in RAM
+    TArray<VTexture *> batch;
+    double decodeTime = 0;
+    int f = 1;
+    while (f < maxtex) {
+      batch.reset();
+      for (; f < maxtex && batch.length() < 256; ++f) if (texturepresent[f]) batch.append(GTextureManager[f]);
+      decodeTime -= Sys_Time();
+      (void)GTextureManager.DecodeTextures(batch);
+      decodeTime += Sys_Time();
+      for (VTexture *tex : batch) {
         ++currpbar;
         R_PBarUpdate("Textures", currpbar, maxpbar);
-        Drawer->PrecacheTexture(GTextureManager[f]);
+        Drawer->PrecacheTexture(tex);
       }
     }
+    GCon->Logf("texture decoding took %.3f seconds", decodeTime);
   }
 
   R_PBarUpdate("Textures", maxpbar, maxpbar, true); // final update
@@ -198,9 +198,8 @@ sec_surface_t *VRenderLevelShared::CreateSecSurface (sec_surface_t *ssurf, subse
 
   surface_t *surf = nullptr;
   if (!ssurf) {
-    // new sector surface
-    ssurf = new sec_surface_t;
-    memset((void *)ssurf, 0, sizeof(sec_surface_t));
+    // new sector surface (zeroed, in the map arena)
+    ssurf = Level->GetMapArena()->Alloc<sec_surface_t>();
     surf = NewWSurf(vcount);
   } else {
     // change sector surface
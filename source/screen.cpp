@@ -641,6 +641,7 @@ void SCR_Update (bool fullUpdate) {
   CheckResolutionChange();
 
   if (Drawer) Drawer->IncUpdateFrame();
+  GTextureManager.ResidencyTick();
 
   // disable tty logs for network games
   if (GGameInfo->NetMode >= NM_DedicatedServer) C_DisableTTYLogs(); else C_EnableTTYLogs();
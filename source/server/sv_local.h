@@ -433,6 +433,12 @@ void Draw_TeleportIcon ();
 void SV_DropClient (VBasePlayer *Player, bool crash);
 void SV_SpawnServer (const char *mapname, bool spawn_thinkers, bool titlemap=false);
 void SV_SendServerInfoToClients ();
+// shuts down current game, and starts a new one (this is what `Map` command does)
+void SV_SpawnNewGame (const char *mapname);
+void SV_ConnectClient (VBasePlayer *player);
+void SV_ConnectBot (const char *name);
+// runs player ticks (and reborns), without world tick
+void SV_RunClients (bool skipFrame=false);
 
 // call after texture manager updated a flat
 void SV_UpdateSkyFlat ();
@@ -441,6 +447,17 @@ extern int LeavePosition;
 extern bool completed;
 
 
+//==========================================================================
+//
+//  sv_simbench
+//
+//==========================================================================
+extern bool sv_simbench_recording;
+
+// called for each player tick, when `sv_simbench_recording` is set
+void SV_SimBenchRecordInput (VBasePlayer *Player);
+
+
 //==========================================================================
 //
 //  ????
@@ -450,6 +450,7 @@ void P_InitThinkers () {
 //
 //==========================================================================
 void SV_Shutdown () {
+  SV_ShutdownSaveWriter();
   if (GGameInfo) {
     SV_ShutdownGame();
     GGameInfo->ConditionalDestroy();
@@ -463,6 +464,7 @@ void SV_Shutdown () {
   }
 
   P_FreeTerrainTypes();
+  P_FreePathTraverseBatches();
   ShutdownLockDefs();
   svs.serverinfo.Clean();
 
@@ -691,6 +693,7 @@ static void CheckForIntermissionSkip () {
 //
 //==========================================================================
 static void SV_RunPlayerTick (VBasePlayer *Player, bool skipFrame) {
+  if (sv_simbench_recording) SV_SimBenchRecordInput(Player);
   Player->ForwardMove = (skipFrame && dbg_skipframe_player_block_move ? 0 : Player->ClientForwardMove);
   Player->SideMove = (skipFrame && dbg_skipframe_player_block_move ? 0 : Player->ClientSideMove);
   //if (Player->ForwardMove) GCon->Logf("ffm: %f (%d)", Player->ClientForwardMove, (int)skipFrame);
@@ -735,7 +738,7 @@ static void SV_RunPlayerTick (VBasePlayer *Player, bool skipFrame) {
 //  SV_RunClients
 //
 //==========================================================================
-static void SV_RunClients (bool skipFrame=false) {
+void SV_RunClients (bool skipFrame) {
   int currMaxFrags = 0;
 
   // get commands
@@ -2056,6 +2059,21 @@ COMMAND_WITH_AC(Map) {
   }
   mapname = Args[1];
 
+  SV_SpawnNewGame(*mapname);
+
+#ifdef CLIENT
+  if (GGameInfo->NetMode != NM_DedicatedServer) CL_SetupLocalPlayer();
+#endif
+}
+
+//==========================================================================
+//
+//  SV_SpawnNewGame
+//
+//  shuts down current game, and starts a new one on the given map
+//
+//==========================================================================
+void SV_SpawnNewGame (const char *mapname) {
   SV_ShutdownGame();
 
   // default the player start spot group to 0
@@ -2066,13 +2084,10 @@ COMMAND_WITH_AC(Map) {
   else if ((int)Skill >= P_GetNumSkills()) Skill = P_GetNumSkills()-1;
 
   SV_ResetPlayers();
-  SV_SpawnServer(*mapname, true/*spawn thinkers*/);
-
-#ifdef CLIENT
-  if (GGameInfo->NetMode != NM_DedicatedServer) CL_SetupLocalPlayer();
-#endif
+  SV_SpawnServer(mapname, true/*spawn thinkers*/);
 }
 
+
 //==========================================================================
 //
 //  COMMAND_AC Map
@@ -2281,6 +2296,7 @@ void ServerFrame (int realtics) {
 
   SV_SendClientMessages(); // full
   SV_UpdateMaster();
+  SV_PollSaveWriter();
 }
 
 
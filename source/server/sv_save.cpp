@@ -50,6 +50,8 @@ enum { NUM_AUTOSAVES = 9 };
 // ////////////////////////////////////////////////////////////////////////// //
 static VCvarB r_dbg_save_on_level_exit("r_dbg_save_on_level_exit", false, "Save before exiting a level.\nNote that after loading this save you prolly won't be able to exit again.", CVAR_PreInit/*|CVAR_Archive*/);
 static VCvarI save_compression_level("save_compression_level", "6", "Save file compression level [0..9]", CVAR_Archive);
+static VCvarB save_async("save_async", true, "Compress and write savegames in the background thread?", CVAR_Archive);
+static VCvarB dbg_save_timing("dbg_save_timing", false, "Show how long the game was blocked by saving, and how long the background writing took.", CVAR_Archive);
 
 static VCvarB dbg_save_ignore_wadlist("dbg_save_ignore_wadlist", false, "Ignore list of loaded wads in savegame when hash mated?", CVAR_PreInit/*|CVAR_Archive*/);
 
@@ -84,10 +86,14 @@ static VStr saveFileBase;
 
 #define SAVE_DESCRIPTION_LENGTH    (24)
 //#define SAVE_VERSION_TEXT_NO_DATE  "Version 1.34.4"
-#define SAVE_VERSION_TEXT          "Version 1.34.12"
+// maps are stored sequentially after the map list; still can be loaded
+#define SAVE_VERSION_TEXT_SEQ      "Version 1.34.12"
+// map directory with offsets, map data follows checkpoint data
+#define SAVE_VERSION_TEXT          "Version 1.35.0"
 #define SAVE_VERSION_TEXT_LENGTH   (16)
 
 static_assert(strlen(SAVE_VERSION_TEXT) <= SAVE_VERSION_TEXT_LENGTH, "oops");
+static_assert(strlen(SAVE_VERSION_TEXT_SEQ) <= SAVE_VERSION_TEXT_LENGTH, "oops");
 
 #define SAVE_EXTDATA_ID_END      (0)
 #define SAVE_EXTDATA_ID_DATEVAL  (1)
@@ -110,9 +116,23 @@ public:
   TArray<vuint8> Data;
   VName Name;
   vint32 DecompressedSize;
+  // changed each time map data is replaced
+  // used to put back the data compressed by the save writer thread
+  vuint32 Generation;
+  // maps from the savegame are loaded on demand; `Data` is empty until then
+  VStr SourceFile;
+  vint32 SourceOffset; // <0: data is in memory
+  vint32 SourceSize;
+
+  VSavedMap () : Compressed(0), Data(), Name(NAME_None), DecompressedSize(0), Generation(0), SourceFile(), SourceOffset(-1), SourceSize(0) {}
+
+  inline bool IsLoaded () const noexcept { return (SourceOffset < 0); }
 };
 
 
+static vuint32 savedMapGeneration = 0;
+
+
 class VSavedCheckpoint {
 public:
   struct EntityInfo {
@@ -242,6 +262,10 @@ public:
   bool LoadSlot (int Slot);
   bool SaveToSlot (int Slot);
   VSavedMap *FindMap (VName Name);
+
+  bool HasUnloadedMaps () const;
+  // load data for all maps that are still in the savegame file
+  void LoadAllMaps ();
 };
 
 
@@ -564,11 +588,15 @@ static VStr GetSaveSlotBaseFileName (int slot) {
 //
 //  open savegame slot file if it exists
 //  sets `saveFileBase`
+//  `diskName` will be set to the full file name
 //
 //==========================================================================
-static VStream *SV_OpenSlotFileRead (int slot) {
+static VStream *SV_OpenSlotFileRead (int slot, VStr *diskName=nullptr) {
   saveFileBase.clear();
+  if (diskName) diskName->clear();
   if (isBadSlotIndex(slot)) return nullptr;
+  // the slot may be still in the writer queue
+  SV_WaitSaveWriter();
   // search save subdir
   auto svdir = SV_GetSavesDir()+"/"+GetSaveSlotCommonDirectoryPrefix();
   auto dir = Sys_OpenDir(svdir);
@@ -580,6 +608,7 @@ static VStream *SV_OpenSlotFileRead (int slot) {
       if (fname.startsWithNoCase(svpfx) && fname.endsWithNoCase(".vsg")) {
         Sys_CloseDir(dir);
         saveFileBase = svdir+"/"+fname;
+        if (diskName) *diskName = saveFileBase;
         return FL_OpenSysFileRead(saveFileBase);
       }
     }
@@ -597,6 +626,7 @@ static VStream *SV_OpenSlotFileRead (int slot) {
       if (fname.isEmpty()) break;
       if (fname.startsWithNoCase(svpfx) && fname.endsWithNoCase(".vsg")) {
         Sys_CloseDir(dir);
+        if (diskName) *diskName = svdir+"/"+fname;
         return FL_OpenSysFileRead(svdir+"/"+fname);
       }
     }
@@ -659,16 +689,15 @@ static bool removeSlotSaveFiles (int slot, VStr fignore) {
 
 //==========================================================================
 //
-//  SV_CreateSlotFileWrite
+//  SV_GetSlotFileNameWrite
 //
-//  create new savegame slot file
-//  also, removes any existing savegame file for the same slot
-//  sets `saveFileBase`
+//  build file name for the new savegame slot file
+//  the file itself is created by the save writer
+//  returns empty string for invalid slot
 //
 //==========================================================================
-static VStream *SV_CreateSlotFileWrite (int slot, VStr descr) {
-  saveFileBase.clear();
-  if (isBadSlotIndex(slot)) return nullptr;
+static VStr SV_GetSlotFileNameWrite (int slot, VStr descr) {
+  if (isBadSlotIndex(slot)) return VStr();
   if (slot == QUICKSAVE_SLOT) descr = VStr();
   //removeSlotSaveFiles(slot);
   auto svpfx = SV_GetSavesDir()+"/"+GetSaveSlotBaseFileName(slot);
@@ -691,13 +720,7 @@ static VStream *SV_CreateSlotFileWrite (int slot, VStr descr) {
   // finalize file name
   if (newdesc.length()) { svpfx += "_"; svpfx += newdesc; }
   svpfx += ".vsg";
-  saveFileBase = svpfx;
-  VStream *res = FL_OpenSysFileWrite(svpfx);
-  if (res) {
-    removeSlotSaveFiles(slot, svpfx);
-    UpdateSaveDirWadList();
-  }
-  return res;
+  return svpfx;
 }
 
 
@@ -709,6 +732,9 @@ static VStream *SV_CreateSlotFileWrite (int slot, VStr descr) {
 //==========================================================================
 static bool SV_DeleteSlotFile (int slot) {
   if (isBadSlotIndex(slot)) return false;
+  // the current game may need maps from this file
+  BaseSlot.LoadAllMaps();
+  SV_WaitSaveWriter();
   return removeSlotSaveFiles(slot, VStr::EmptyString);
 }
 #endif
@@ -795,6 +821,43 @@ void VSaveSlot::Clear () {
 }
 
 
+//==========================================================================
+//
+//  IsKnownSaveVersion
+//
+//==========================================================================
+static inline bool IsKnownSaveVersion (const char *VersionText) {
+  return
+    VStr::Cmp(VersionText, SAVE_VERSION_TEXT) == 0 ||
+    VStr::Cmp(VersionText, SAVE_VERSION_TEXT_SEQ) == 0;
+}
+
+
+//==========================================================================
+//
+//  SV_LoadSavedMapData
+//
+//  load compressed map data from the savegame file
+//  can be called from the writer thread, so no console output here
+//
+//==========================================================================
+static bool SV_LoadSavedMapData (VSavedMap *Map) {
+  if (Map->IsLoaded()) return true;
+  VStream *Strm = FL_OpenSysFileRead(Map->SourceFile);
+  if (!Strm) return false;
+  Map->Data.setLength(Map->SourceSize);
+  Strm->Seek(Map->SourceOffset);
+  if (Map->SourceSize) Strm->Serialise(Map->Data.ptr(), Map->SourceSize);
+  const bool err = Strm->IsError();
+  delete Strm;
+  if (err) { Map->Data.clear(); return false; }
+  Map->SourceFile.clear();
+  Map->SourceOffset = -1;
+  Map->SourceSize = 0;
+  return true;
+}
+
+
 //==========================================================================
 //
 //  SkipExtData
@@ -901,7 +964,8 @@ bool VSaveSlot::LoadSlot (int Slot) {
   Clear();
   saveFileBase.clear();
 
-  VStream *Strm = SV_OpenSlotFileRead(Slot);
+  VStr diskName;
+  VStream *Strm = SV_OpenSlotFileRead(Slot, &diskName);
   if (!Strm) {
     saveFileBase.clear();
     GCon->Log("Savegame file doesn't exist");
@@ -912,7 +976,7 @@ bool VSaveSlot::LoadSlot (int Slot) {
   char VersionText[SAVE_VERSION_TEXT_LENGTH+1];
   memset(VersionText, 0, sizeof(VersionText));
   Strm->Serialise(VersionText, SAVE_VERSION_TEXT_LENGTH);
-  if (VStr::Cmp(VersionText, SAVE_VERSION_TEXT) /*&& VStr::Cmp(VersionText, SAVE_VERSION_TEXT_NO_DATE)*/) {
+  if (!IsKnownSaveVersion(VersionText)) {
     saveFileBase.clear();
     // bad version
     Strm->Close();
@@ -925,16 +989,14 @@ bool VSaveSlot::LoadSlot (int Slot) {
   *Strm << Description;
 
   // skip extended data
-  if (VStr::Cmp(VersionText, SAVE_VERSION_TEXT) == 0) {
-    if (!SkipExtData(Strm) || Strm->IsError()) {
-      saveFileBase.clear();
-      // bad file
-      Strm->Close();
-      delete Strm;
-      Strm = nullptr;
-      GCon->Log("Savegame is corrupted");
-      return false;
-    }
+  if (!SkipExtData(Strm) || Strm->IsError()) {
+    saveFileBase.clear();
+    // bad file
+    Strm->Close();
+    delete Strm;
+    Strm = nullptr;
+    GCon->Log("Savegame is corrupted");
+    return false;
   }
 
   // check list of loaded modules
@@ -981,20 +1043,36 @@ bool VSaveSlot::LoadSlot (int Slot) {
   *Strm << TmpName;
   CurrentMap = *TmpName;
 
+  const bool seekable = (VStr::Cmp(VersionText, SAVE_VERSION_TEXT) == 0);
+  bool err = false;
+
   vint32 NumMaps;
   *Strm << STRM_INDEX(NumMaps);
-  for (int i = 0; i < NumMaps; ++i) {
+  if (NumMaps < 0 || NumMaps > 65536) err = true;
+  for (int i = 0; !err && i < NumMaps; ++i) {
     VSavedMap *Map = new VSavedMap();
     Maps.Append(Map);
+    Map->Generation = ++savedMapGeneration;
     vint32 DataLen;
     *Strm << TmpName << Map->Compressed << STRM_INDEX(Map->DecompressedSize) << STRM_INDEX(DataLen);
     Map->Name = *TmpName;
-    Map->Data.SetNum(DataLen);
-    Strm->Serialise(Map->Data.Ptr(), Map->Data.Num());
+    if (DataLen < 0 || Map->DecompressedSize < 0) { err = true; break; }
+    if (seekable) {
+      // map data will be loaded when it is needed
+      vint32 DataOfs;
+      *Strm << STRM_INDEX(DataOfs);
+      if (DataOfs < 0) { err = true; break; }
+      Map->SourceOffset = DataOfs; // relative for now
+      Map->SourceSize = DataLen;
+    } else {
+      Map->Data.SetNum(DataLen);
+      Strm->Serialise(Map->Data.Ptr(), Map->Data.Num());
+    }
+    if (Strm->IsError()) err = true;
   }
 
   //HACK: if `NumMaps` is 0, we're loading checkpoint
-  if (NumMaps == 0) {
+  if (!err && NumMaps == 0) {
     // load players inventory
     VSavedCheckpoint &cp = CheckPoint;
     cp.Serialise(Strm);
@@ -1003,7 +1081,18 @@ bool VSaveSlot::LoadSlot (int Slot) {
     cp.Clear();
   }
 
-  bool err = Strm->IsError();
+  err = (err || Strm->IsError());
+
+  if (!err && seekable) {
+    // map data starts right after the directory and checkpoint data
+    const int dataStart = Strm->Tell();
+    const int dataSize = Strm->TotalSize()-dataStart;
+    for (auto &&Map : Maps) {
+      if (Map->SourceOffset > dataSize || Map->SourceSize > dataSize-Map->SourceOffset) { err = true; break; }
+      Map->SourceOffset += dataStart;
+      Map->SourceFile = diskName;
+    }
+  }
 
   Strm->Close();
   delete Strm;
@@ -1019,21 +1108,421 @@ bool VSaveSlot::LoadSlot (int Slot) {
 }
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+// savegame writer
+//
+// the game thread builds complete savegame image in memory (only the
+// current map is left uncompressed), and the writer compresses it, writes
+// it to temporary file, and renames the file to the final name. this way
+// the game can continue while the save is written, and a crash in the
+// middle of writing will not destroy the previous save.
+// finished jobs are processed in the game thread: compressed map data is
+// put back into the base slot, and old slot files are removed.
+// all strings in the job should be unique copies (see `cloneUnique()`),
+// because the writer thread copies and clears them (name strings are
+// immutable, so `MapNames` are safe).
+struct VSaveWriteJob {
+  int Slot;
+  VStr FileName; // final file name
+  int CompressionLevel;
+  TArray<vuint8> Header; // everything before the map list
+  TArray<VSavedMap *> Maps; // owned copies
+  TArray<VStr> MapNames; // name table can be modified by the game thread, so we cannot use `VName` in the writer
+  TArray<vuint8> Trailer; // checkpoint data
+  TArray<vint32> MapOffsets; // file offsets of written map data
+  double QueueTime; // `Sys_Time()` when it was queued
+  double WriteTime; // compression and i/o, in seconds
+  bool Error;
+
+  VSaveWriteJob () : Slot(0), FileName(), CompressionLevel(0), Header(), Maps(), MapNames(), Trailer(), MapOffsets(), QueueTime(0), WriteTime(0), Error(false) {}
+  ~VSaveWriteJob () { for (auto &&Map : Maps) delete Map; Maps.clear(); }
+};
+
+
+static bool saveWriterInited = false;
+static bool saveWriterStarted = false;
+static bool saveWriterBusy = false;
+static bool saveWriterDoQuit = false;
+static mythread saveWriterThread;
+static mythread_mutex saveWriterLock;
+static mythread_cond saveWriterCond;
+static TArray<VSaveWriteJob *> saveWriterQueue;
+static TArray<VSaveWriteJob *> saveWriterDone;
+
+
+//==========================================================================
+//
+//  SV_CompressSavedMap
+//
+//  can be called from the writer thread
+//
+//==========================================================================
+static bool SV_CompressSavedMap (VSavedMap *Map, int level) {
+  if (Map->Compressed || level <= 0) return true;
+  TArray<vuint8> cdata;
+  VArrayStream *ArrStrm = new VArrayStream("<savemap>", cdata);
+  ArrStrm->BeginWrite();
+  VZLibStreamWriter *ZipStrm = new VZLibStreamWriter(ArrStrm, level);
+  ZipStrm->Serialise(Map->Data.Ptr(), Map->Data.Num());
+  bool err = !ZipStrm->Close();
+  err = (err || ArrStrm->IsError());
+  delete ZipStrm;
+  delete ArrStrm;
+  if (err) return false;
+  Map->Data.swap(cdata);
+  Map->Compressed = 1;
+  return true;
+}
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+struct SaveCompressContext {
+  VSavedMap **Maps;
+  int MapCount;
+  int Level;
+  atomic_int Next;
+  atomic_int Failed;
+};
+
+
+//==========================================================================
+//
+//  SV_CompressSavedMapsWorker
+//
+//==========================================================================
+static void SV_CompressSavedMapsWorker (SaveCompressContext *ctx) {
+  for (;;) {
+    const int idx = atomic_increment(&ctx->Next)-1;
+    if (idx >= ctx->MapCount) break;
+    if (!SV_CompressSavedMap(ctx->Maps[idx], ctx->Level)) atomic_store(&ctx->Failed, 1);
+  }
+}
+
+
+//==========================================================================
+//
+//  saveCompressThreadProc
+//
+//==========================================================================
+static MYTHREAD_RET_TYPE saveCompressThreadProc (void *actx) {
+  SV_CompressSavedMapsWorker((SaveCompressContext *)actx);
+  Z_ThreadDone();
+  return MYTHREAD_RET_VALUE;
+}
+
+
+//==========================================================================
+//
+//  SV_CompressSavedMaps
+//
+//  maps are compressed independently, so we can do it in parallel
+//  can be called from the writer thread
+//
+//==========================================================================
+static bool SV_CompressSavedMaps (TArray<VSavedMap *> &maps, int level) {
+  if (level <= 0) return true;
+  TArray<VSavedMap *> todo;
+  for (auto &&Map : maps) if (!Map->Compressed) todo.append(Map);
+  if (todo.length() == 0) return true;
+
+  SaveCompressContext ctx;
+  ctx.Maps = todo.ptr();
+  ctx.MapCount = todo.length();
+  ctx.Level = level;
+  ctx.Next = 0;
+  ctx.Failed = 0;
+
+  enum { MaxHelpers = 7 };
+  mythread helpers[MaxHelpers];
+  int helperCount = min2(min2(todo.length()-1, Sys_GetCPUCount()-1), (int)MaxHelpers);
+  int started = 0;
+  while (started < helperCount) {
+    if (mythread_create(&helpers[started], &saveCompressThreadProc, &ctx)) break;
+    ++started;
+  }
+  // this thread is working too
+  SV_CompressSavedMapsWorker(&ctx);
+  for (int f = 0; f < started; ++f) mythread_join(helpers[f]);
+
+  return (atomic_get(&ctx.Failed) == 0);
+}
+
+
+//==========================================================================
+//
+//  SV_DecompressSavedMap
+//
+//==========================================================================
+static bool SV_DecompressSavedMap (VSavedMap *Map, TArray<vuint8> &dest) {
+  if (!Map->Compressed) {
+    dest.setLength(Map->Data.length());
+    if (Map->Data.length()) memcpy(dest.ptr(), Map->Data.ptr(), Map->Data.length());
+    return true;
+  }
+  VArrayStream *ArrStrm = new VArrayStream("<savemap:mapdata>", Map->Data);
+  VZLibStreamReader *ZipStrm = new VZLibStreamReader(ArrStrm, VZLibStreamReader::UNKNOWN_SIZE, Map->DecompressedSize);
+  dest.SetNum(Map->DecompressedSize);
+  ZipStrm->Serialise(dest.Ptr(), dest.Num());
+  const bool err = ZipStrm->IsError();
+  delete ZipStrm;
+  delete ArrStrm;
+  return !err;
+}
+
+
+//==========================================================================
+//
+//  SV_ExecuteSaveJob
+//
+//  compress maps, write temporary file, and rename it
+//  called from the writer thread, so no console output here
+//
+//  file layout after the header is:
+//    map directory (name, compression flag, unpacked size, data size, data offset)
+//    checkpoint data
+//    map data
+//  offsets are relative to the start of map data
+//
+//==========================================================================
+static bool SV_ExecuteSaveJob (VSaveWriteJob *job) {
+  const double stt = Sys_Time();
+  job->Error = false;
+  job->MapOffsets.clear();
+
+  // maps that were never loaded from the old savegame
+  for (auto &&Map : job->Maps) {
+    if (!SV_LoadSavedMapData(Map)) { job->Error = true; break; }
+  }
+
+  if (!job->Error && !SV_CompressSavedMaps(job->Maps, job->CompressionLevel)) job->Error = true;
+
+  const VStr tmpname = job->FileName+".tmp";
+  VStream *Strm = (job->Error ? nullptr : FL_OpenSysFileWrite(tmpname));
+  if (Strm) {
+    Strm->Serialise(job->Header.ptr(), job->Header.length());
+    vint32 NumMaps = job->Maps.length();
+    *Strm << STRM_INDEX(NumMaps);
+    vint32 DataOfs = 0;
+    for (int f = 0; f < job->Maps.length(); ++f) {
+      VSavedMap *Map = job->Maps[f];
+      VStr TmpName = job->MapNames[f];
+      vint32 DataLen = Map->Data.Num();
+      *Strm << TmpName << Map->Compressed << STRM_INDEX(Map->DecompressedSize) << STRM_INDEX(DataLen) << STRM_INDEX(DataOfs);
+      DataOfs += DataLen;
+    }
+    if (job->Trailer.length()) Strm->Serialise(job->Trailer.ptr(), job->Trailer.length());
+    for (auto &&Map : job->Maps) {
+      job->MapOffsets.append(Strm->Tell());
+      Strm->Serialise(Map->Data.Ptr(), Map->Data.Num());
+    }
+    bool err = Strm->IsError();
+    Strm->Close();
+    err = (err || Strm->IsError());
+    delete Strm;
+    if (err || !Sys_FileRename(tmpname, job->FileName)) {
+      Sys_FileDelete(tmpname);
+      job->Error = true;
+    }
+  } else {
+    job->Error = true;
+  }
+
+  job->WriteTime = Sys_Time()-stt;
+  return !job->Error;
+}
+
+
+//==========================================================================
+//
+//  SV_FinishSaveJob
+//
+//  called in the game thread after the job is executed; deletes the job
+//
+//==========================================================================
+static void SV_FinishSaveJob (VSaveWriteJob *job) {
+  if (job->Error) {
+    GCon->Logf(NAME_Error, "error saving to slot %d, savegame is not written!", job->Slot);
+  } else {
+    // put compressed data back into the base slot, so we won't keep uncompressed maps
+    // maps that are still on disk now live in the new file (the old one may be removed)
+    for (int f = 0; f < job->Maps.length(); ++f) {
+      VSavedMap *Map = job->Maps[f];
+      VSavedMap *bmap = BaseSlot.FindMap(Map->Name);
+      if (!bmap || bmap->Generation != Map->Generation) continue;
+      if (!bmap->IsLoaded()) {
+        bmap->SourceFile = job->FileName;
+        bmap->SourceOffset = job->MapOffsets[f];
+        bmap->SourceSize = Map->Data.length();
+      } else if (!bmap->Compressed && Map->Compressed) {
+        bmap->Data.swap(Map->Data);
+        bmap->Compressed = Map->Compressed;
+      }
+    }
+    removeSlotSaveFiles(job->Slot, job->FileName);
+  }
+  if (dbg_save_timing) {
+    GCon->Logf(NAME_Debug, "SAVE: slot %d written in %d msecs (%d msecs after queueing)", job->Slot,
+      (int)(job->WriteTime*1000.0+0.5), (job->QueueTime > 0 ? (int)((Sys_Time()-job->QueueTime)*1000.0+0.5) : 0));
+  }
+  delete job;
+}
+
+
+//==========================================================================
+//
+//  saveWriterThreadProc
+//
+//==========================================================================
+static MYTHREAD_RET_TYPE saveWriterThreadProc (void *) {
+  mythread_mutex_lock(&saveWriterLock);
+  for (;;) {
+    while (!saveWriterDoQuit && saveWriterQueue.length() == 0) mythread_cond_wait(&saveWriterCond, &saveWriterLock);
+    // mutex is held again
+    // finish queued jobs even if we were asked to quit
+    if (saveWriterQueue.length() == 0) break;
+    VSaveWriteJob *job = saveWriterQueue[0];
+    saveWriterQueue.removeAt(0);
+    saveWriterBusy = true;
+    mythread_mutex_unlock(&saveWriterLock);
+    SV_ExecuteSaveJob(job);
+    mythread_mutex_lock(&saveWriterLock);
+    saveWriterBusy = false;
+    saveWriterDone.append(job);
+  }
+  // mutex is held
+  mythread_mutex_unlock(&saveWriterLock);
+  Z_ThreadDone();
+  return MYTHREAD_RET_VALUE;
+}
+
+
+//==========================================================================
+//
+//  SV_StartSaveWriter
+//
+//  returns `false` if the writer thread cannot be started
+//
+//==========================================================================
+static bool SV_StartSaveWriter () {
+  if (saveWriterStarted) return true;
+  if (!saveWriterInited) {
+    saveWriterInited = true;
+    mythread_mutex_init(&saveWriterLock);
+    mythread_cond_init(&saveWriterCond);
+  }
+  saveWriterDoQuit = false;
+  saveWriterBusy = false;
+  if (mythread_create(&saveWriterThread, &saveWriterThreadProc, nullptr)) {
+    // don't touch `save_async`, it is user setting; we'll try again on the next save
+    GCon->Log(NAME_Warning, "cannot create save writer thread, saving synchronously");
+    return false;
+  }
+  saveWriterStarted = true;
+  return true;
+}
+
+
+//==========================================================================
+//
+//  SV_QueueSaveJob
+//
+//==========================================================================
+static void SV_QueueSaveJob (VSaveWriteJob *job) {
+  vassert(saveWriterStarted);
+  job->QueueTime = Sys_Time();
+  {
+    MyThreadLocker lock(&saveWriterLock);
+    saveWriterQueue.append(job);
+  }
+  mythread_cond_signal(&saveWriterCond);
+}
+
+
+//==========================================================================
+//
+//  SV_PollSaveWriter
+//
+//  process finished save jobs
+//
+//==========================================================================
+void SV_PollSaveWriter () {
+  if (!saveWriterStarted) return;
+  TArray<VSaveWriteJob *> done;
+  {
+    MyThreadLocker lock(&saveWriterLock);
+    done.swap(saveWriterDone);
+  }
+  for (auto &&job : done) SV_FinishSaveJob(job);
+}
+
+
+//==========================================================================
+//
+//  SV_WaitSaveWriter
+//
+//  wait until all queued saves are written
+//
+//==========================================================================
+void SV_WaitSaveWriter () {
+  if (!saveWriterStarted) return;
+  for (;;) {
+    {
+      MyThreadLocker lock(&saveWriterLock);
+      if (saveWriterQueue.length() == 0 && !saveWriterBusy) break;
+    }
+    Sys_Yield();
+  }
+  SV_PollSaveWriter();
+}
+
+
+//==========================================================================
+//
+//  SV_ShutdownSaveWriter
+//
+//  writes all pending saves, and stops the writer thread
+//
+//==========================================================================
+void SV_ShutdownSaveWriter () {
+  if (!saveWriterStarted) return;
+  {
+    MyThreadLocker lock(&saveWriterLock);
+    saveWriterDoQuit = true;
+  }
+  mythread_cond_signal(&saveWriterCond);
+  mythread_join(saveWriterThread);
+  SV_PollSaveWriter();
+  saveWriterStarted = false;
+}
+
+
 //==========================================================================
 //
 //  VSaveSlot::SaveToSlot
 //
+//  this builds savegame image, and passes it to the save writer.
+//  with `save_async`, compression and disk i/o are done in the
+//  background thread, and write errors are reported later.
+//
 //==========================================================================
 bool VSaveSlot::SaveToSlot (int Slot) {
   saveFileBase.clear();
 
-  VStream *Strm = SV_CreateSlotFileWrite(Slot, Description);
-  if (!Strm) {
-    saveFileBase.clear();
+  VStr fname = SV_GetSlotFileNameWrite(Slot, Description);
+  if (fname.isEmpty()) {
     GCon->Logf("ERROR: cannot save to slot %d!", Slot);
     return false;
   }
 
+  VSaveWriteJob *job = new VSaveWriteJob();
+  job->Slot = Slot;
+  job->FileName = fname.cloneUnique(); // used in the writer thread
+  job->CompressionLevel = clampval(save_compression_level.asInt(), 0, 9);
+
+  VArrayStream *HdrStrm = new VArrayStream("<savegame:header>", job->Header);
+  HdrStrm->BeginWrite();
+  VStream *Strm = HdrStrm; // base class, so const `Serialise()` overload is visible
+
   // write version info
   char VersionText[SAVE_VERSION_TEXT_LENGTH+1];
   memset(VersionText, 0, SAVE_VERSION_TEXT_LENGTH);
@@ -1078,32 +1567,62 @@ bool VSaveSlot::SaveToSlot (int Slot) {
   VStr TmpName(CurrentMap);
   *Strm << TmpName;
 
-  vint32 NumMaps = Maps.Num();
-  *Strm << STRM_INDEX(NumMaps);
-  for (int i = 0; i < Maps.Num(); ++i) {
-    TmpName = VStr(Maps[i]->Name);
-    vint32 DataLen = Maps[i]->Data.Num();
-    *Strm << TmpName << Maps[i]->Compressed << STRM_INDEX(Maps[i]->DecompressedSize) << STRM_INDEX(DataLen);
-    Strm->Serialise(Maps[i]->Data.Ptr(), Maps[i]->Data.Num());
-  }
+  bool err = Strm->IsError();
+  delete Strm;
 
-  //HACK: if `NumMaps` is 0, we're saving checkpoint
-  if (NumMaps == 0) {
+  // the writer must see map files as they are after all queued saves are done
+  if (HasUnloadedMaps()) SV_WaitSaveWriter();
+
+  // maps are written by the writer; it owns the copies, so we can continue playing
+  // maps that are not loaded yet will be read by the writer too
+  for (int i = 0; i < Maps.Num(); ++i) {
+    const VSavedMap *src = Maps[i];
+    VSavedMap *Map = new VSavedMap();
+    Map->Compressed = src->Compressed;
+    Map->Name = src->Name;
+    Map->DecompressedSize = src->DecompressedSize;
+    Map->Generation = src->Generation;
+    Map->SourceFile = src->SourceFile.cloneUnique(); // writer clears it
+    Map->SourceOffset = src->SourceOffset;
+    Map->SourceSize = src->SourceSize;
+    Map->Data.setLength(src->Data.length());
+    if (src->Data.length()) memcpy(Map->Data.ptr(), src->Data.ptr(), src->Data.length());
+    job->Maps.append(Map);
+    job->MapNames.append(VStr(src->Name));
+  }
+
+  //HACK: if there are no maps, we're saving checkpoint
+  if (Maps.Num() == 0) {
     // save players inventory
+    VArrayStream *CpStrm = new VArrayStream("<savegame:checkpoint>", job->Trailer);
+    CpStrm->BeginWrite();
     VSavedCheckpoint &cp = CheckPoint;
-    cp.Serialise(Strm);
+    cp.Serialise(CpStrm);
+    err = (err || CpStrm->IsError());
+    delete CpStrm;
   }
 
-  bool err = Strm->IsError();
-  Strm->Close();
-  err = err || Strm->IsError();
-  delete Strm;
+  if (err) {
+    delete job;
+    GCon->Logf("ERROR: error saving to slot %d, savegame is corrupted!", Slot);
+    return false;
+  }
+
+  UpdateSaveDirWadList();
+  saveFileBase = fname;
+
+  if (save_async && SV_StartSaveWriter()) {
+    SV_QueueSaveJob(job);
+    return true;
+  }
 
+  // synchronous write
+  err = !SV_ExecuteSaveJob(job);
+  SV_FinishSaveJob(job);
   Host_ResetSkipFrames();
 
   if (err) {
     saveFileBase.clear();
-    GCon->Logf("ERROR: error saving to slot %d, savegame is corrupted!", Slot);
     return false;
   }
 
@@ -1123,6 +1642,31 @@ VSavedMap *VSaveSlot::FindMap (VName Name) {
 }
 
 
+//==========================================================================
+//
+//  VSaveSlot::HasUnloadedMaps
+//
+//==========================================================================
+bool VSaveSlot::HasUnloadedMaps () const {
+  for (auto &&Map : Maps) if (!Map->IsLoaded()) return true;
+  return false;
+}
+
+
+//==========================================================================
+//
+//  VSaveSlot::LoadAllMaps
+//
+//==========================================================================
+void VSaveSlot::LoadAllMaps () {
+  if (!HasUnloadedMaps()) return;
+  SV_WaitSaveWriter();
+  for (auto &&Map : Maps) {
+    if (!SV_LoadSavedMapData(Map)) Host_Error("cannot load data for map '%s' from savegame", *Map->Name);
+  }
+}
+
+
 //==========================================================================
 //
 //  SV_GetSaveString
@@ -1136,15 +1680,13 @@ bool SV_GetSaveString (int Slot, VStr &Desc) {
     Strm->Serialise(VersionText, SAVE_VERSION_TEXT_LENGTH);
     bool goodSave = true;
     Desc = "???";
-    if (VStr::Cmp(VersionText, SAVE_VERSION_TEXT) /*&& VStr::Cmp(VersionText, SAVE_VERSION_TEXT_NO_DATE)*/) {
+    if (!IsKnownSaveVersion(VersionText)) {
       // bad version, put an asterisk in front of the description
       goodSave = false;
     } else {
       *Strm << Desc;
       // skip extended data
-      if (VStr::Cmp(VersionText, SAVE_VERSION_TEXT) == 0) {
-        if (!SkipExtData(Strm) || Strm->IsError()) goodSave = false;
-      }
+      if (!SkipExtData(Strm) || Strm->IsError()) goodSave = false;
       if (goodSave) {
         // check list of loaded modules
         auto wadlist = FL_GetWadPk3List();
@@ -1184,7 +1726,7 @@ void SV_GetSaveDateString (int Slot, VStr &datestr) {
     memset(VersionText, 0, sizeof(VersionText));
     Strm->Serialise(VersionText, SAVE_VERSION_TEXT_LENGTH);
     datestr = "UNKNOWN";
-    if (VStr::Cmp(VersionText, SAVE_VERSION_TEXT) == 0) {
+    if (IsKnownSaveVersion(VersionText)) {
       VStr Desc;
       *Strm << Desc;
       datestr = LoadDateStrExtData(Strm);
@@ -1212,7 +1754,7 @@ static bool SV_GetSaveDateTVal (int Slot, TTimeVal *tv) {
     memset(VersionText, 0, sizeof(VersionText));
     Strm->Serialise(VersionText, SAVE_VERSION_TEXT_LENGTH);
     //fprintf(stderr, "OPENED slot #%d\n", Slot);
-    if (VStr::Cmp(VersionText, SAVE_VERSION_TEXT) != 0) { delete Strm; return false; }
+    if (!IsKnownSaveVersion(VersionText)) { delete Strm; return false; }
     //fprintf(stderr, "  slot #%d has valid version\n", Slot);
     VStr Desc;
     *Strm << Desc;
@@ -1612,7 +2154,7 @@ static void UnarchiveSounds (VStream &Strm) {
 // SV_SaveMap
 //
 //==========================================================================
-static void SV_SaveMap (bool savePlayers) {
+static void SV_SaveMap (bool savePlayers, bool deferCompression=false) {
   // make sure we don't have any garbage
   Host_CollectGarbage(true);
 
@@ -1651,21 +2193,17 @@ static void SV_SaveMap (bool savePlayers) {
     Map->Name = GLevel->MapName;
   }
 
-  // compress map data
+  // take map data; if compression is deferred, the save writer will do it
+  Map->Generation = ++savedMapGeneration;
   Map->DecompressedSize = Buf.Num();
+  Map->Compressed = 0;
+  Map->SourceFile.clear();
+  Map->SourceOffset = -1;
+  Map->SourceSize = 0;
   Map->Data.Clear();
-  if (save_compression_level <= 0) {
-    Map->Compressed = 0;
-    Map->Data.setLength(Buf.length());
-    if (Buf.length()) memcpy(Map->Data.ptr(), Buf.ptr(), Buf.length());
-  } else {
-    Map->Compressed = 1;
-    VArrayStream *ArrStrm = new VArrayStream("<savemap>", Map->Data);
-    ArrStrm->BeginWrite();
-    VZLibStreamWriter *ZipStrm = new VZLibStreamWriter(ArrStrm, (int)save_compression_level);
-    ZipStrm->Serialise(Buf.Ptr(), Buf.Num());
-    delete ZipStrm;
-    delete ArrStrm;
+  Map->Data.swap(Buf);
+  if (!deferCompression && !SV_CompressSavedMap(Map, clampval(save_compression_level.asInt(), 0, 9))) {
+    Host_Error("cannot compress map data");
   }
 
   delete Saver;
@@ -1876,19 +2414,15 @@ static bool SV_LoadMap (VName MapName, bool allowCheckpoints, bool hubTeleport)
   VSavedMap *Map = BaseSlot.FindMap(MapName);
   vassert(Map);
 
+  if (!Map->IsLoaded()) {
+    // make sure that the file is not replaced under our feet
+    SV_WaitSaveWriter();
+    if (!SV_LoadSavedMapData(Map)) Host_Error("cannot load data for map '%s' from savegame", *MapName);
+  }
+
   // decompress map data
   TArray<vuint8> DecompressedData;
-  if (!Map->Compressed) {
-    DecompressedData.setLength(Map->Data.length());
-    if (Map->Data.length()) memcpy(DecompressedData.ptr(), Map->Data.ptr(), Map->Data.length());
-  } else {
-    VArrayStream *ArrStrm = new VArrayStream("<savemap:mapdata>", Map->Data);
-    VZLibStreamReader *ZipStrm = new VZLibStreamReader(ArrStrm, VZLibStreamReader::UNKNOWN_SIZE, Map->DecompressedSize);
-    DecompressedData.SetNum(Map->DecompressedSize);
-    ZipStrm->Serialise(DecompressedData.Ptr(), DecompressedData.Num());
-    delete ZipStrm;
-    delete ArrStrm;
-  }
+  if (!SV_DecompressSavedMap(Map, DecompressedData)) Host_Error("cannot decompress data for map '%s' from savegame", *MapName);
 
   VSaveLoaderStream *Loader = new VSaveLoaderStream(new VArrayStream("<savemap:mapdata>", DecompressedData));
 
@@ -1927,6 +2461,10 @@ static bool SV_LoadMap (VName MapName, bool allowCheckpoints, bool hubTeleport)
 //
 //==========================================================================
 static void SV_SaveGame (int slot, VStr Description, bool checkpoint, bool isAutosave) {
+  const double stt = Sys_Time();
+  // process finished saves, so the base slot will get compressed maps
+  SV_PollSaveWriter();
+
   BaseSlot.Description = Description;
   BaseSlot.CurrentMap = GLevel->MapName;
 
@@ -1953,11 +2491,11 @@ static void SV_SaveGame (int slot, VStr Description, bool checkpoint, bool isAut
     if (!SV_SaveCheckpoint()) {
       GCon->Logf("AUTOSAVE: checkpoint creation failed, perform a full save sequence");
       checkpoint = false;
-      SV_SaveMap(true); // true = save player info
+      SV_SaveMap(true, save_async); // true = save player info
     }
   } else {
     // full save
-    SV_SaveMap(true); // true = save player info
+    SV_SaveMap(true, save_async); // true = save player info
   }
 
   // write data to destination slot
@@ -1996,6 +2534,8 @@ static void SV_SaveGame (int slot, VStr Description, bool checkpoint, bool isAut
     SV_SendAfterSaveEvent(isAutosave, checkpoint);
   }
 
+  if (dbg_save_timing) GCon->Logf(NAME_Debug, "SAVE: game was blocked for %d msecs", (int)((Sys_Time()-stt)*1000.0+0.5));
+
   Host_ResetSkipFrames();
 }
 
@@ -2524,3 +3064,104 @@ COMMAND(ShowSavePrefix) {
   GCon->Logf("save prefix: %s", *pfx);
 }
 #endif
+
+
+//==========================================================================
+//
+//  COMMAND SaveBench
+//
+//  SaveBench slot
+//  measures savegame directory loading, map loading, and map
+//  (de)compression speed for different compression levels
+//
+//==========================================================================
+COMMAND(SaveBench) {
+  if (Args.length() != 2) {
+    GCon->Log("usage: SaveBench slot");
+    return;
+  }
+
+  const int slot = VStr::atoi(*Args[1]);
+  const VStr oldFileBase = saveFileBase;
+  VSaveSlot *bslot = new VSaveSlot();
+  double stt = Sys_Time();
+  const bool loaded = bslot->LoadSlot(slot);
+  const double dirTime = Sys_Time()-stt;
+  saveFileBase = oldFileBase;
+  if (!loaded) {
+    GCon->Logf(NAME_Error, "cannot open savegame slot %d", slot);
+    delete bslot;
+    return;
+  }
+
+  // load map data
+  stt = Sys_Time();
+  int packedSize = 0;
+  for (auto &&Map : bslot->Maps) {
+    if (!SV_LoadSavedMapData(Map)) {
+      GCon->Logf(NAME_Error, "cannot load data for map '%s'", *Map->Name);
+      delete bslot;
+      return;
+    }
+    packedSize += Map->Data.length();
+  }
+  const double readTime = Sys_Time()-stt;
+  GCon->Logf("slot %d: %d map(s); directory: %.3f msecs; map data (%d bytes): %.3f msecs",
+    slot, bslot->Maps.length(), dirTime*1000.0, packedSize, readTime*1000.0);
+  if (bslot->Maps.length() == 0) {
+    delete bslot;
+    return;
+  }
+
+  // decompress maps
+  TArray<VSavedMap *> rawMaps;
+  int rawSize = 0;
+  stt = Sys_Time();
+  for (auto &&Map : bslot->Maps) {
+    VSavedMap *raw = new VSavedMap();
+    raw->Name = Map->Name;
+    raw->DecompressedSize = Map->DecompressedSize;
+    rawMaps.append(raw);
+    if (!SV_DecompressSavedMap(Map, raw->Data)) GCon->Logf(NAME_Error, "cannot decompress map '%s'", *Map->Name);
+    rawSize += raw->Data.length();
+  }
+  const double unpackTime = Sys_Time()-stt;
+  GCon->Logf("  unpacked %d bytes in %.3f msecs (%.2f MB/s)", rawSize, unpackTime*1000.0,
+    (unpackTime > 0 ? rawSize/unpackTime/(1024.0*1024.0) : 0.0));
+
+  // compress with different levels, sequentially and in parallel
+  static const int levels[] = { 1, 3, 6, 9 };
+  for (const int level : levels) {
+    double seqTime = 0, parTime = 0;
+    int outSize = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+      TArray<VSavedMap *> work;
+      for (auto &&raw : rawMaps) {
+        VSavedMap *Map = new VSavedMap();
+        Map->Name = raw->Name;
+        Map->DecompressedSize = raw->DecompressedSize;
+        Map->Data.setLength(raw->Data.length());
+        if (raw->Data.length()) memcpy(Map->Data.ptr(), raw->Data.ptr(), raw->Data.length());
+        work.append(Map);
+      }
+      stt = Sys_Time();
+      if (pass == 0) {
+        for (auto &&Map : work) SV_CompressSavedMap(Map, level);
+        seqTime = Sys_Time()-stt;
+        outSize = 0;
+        for (auto &&Map : work) outSize += Map->Data.length();
+      } else {
+        SV_CompressSavedMaps(work, level);
+        parTime = Sys_Time()-stt;
+      }
+      for (auto &&Map : work) delete Map;
+    }
+    GCon->Logf("  level %d: %d bytes (%d%%); sequential: %.3f msecs (%.2f MB/s); parallel: %.3f msecs (%.2f MB/s)",
+      level, outSize, (rawSize > 0 ? (int)((vint64)outSize*100/rawSize) : 0),
+      seqTime*1000.0, (seqTime > 0 ? rawSize/seqTime/(1024.0*1024.0) : 0.0),
+      parTime*1000.0, (parTime > 0 ? rawSize/parTime/(1024.0*1024.0) : 0.0));
+  }
+
+  for (auto &&raw : rawMaps) delete raw;
+  delete bslot;
+}
@@ -30,3 +30,8 @@ extern bool SV_GetSaveString (int Slot, VStr &Desc);
 extern void SV_GetSaveDateString (int Slot, VStr &datestr);
 extern void SV_AutoSaveOnLevelExit ();
 extern void SV_AutoSave (bool checkpoint);
+
+// background save writer
+extern void SV_PollSaveWriter (); // process finished saves
+extern void SV_WaitSaveWriter (); // wait until all queued saves are written
+extern void SV_ShutdownSaveWriter ();
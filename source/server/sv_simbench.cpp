@@ -0,0 +1,480 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2006 Jānis Legzdiņš
+//**  Copyright (C) 2018-2021 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  headless simulation benchmark
+//**
+//**  loads a map, optionally spawns bots and/or replays recorded player
+//**  inputs, and runs a fixed number of tics as fast as possible (without
+//**  real-time waiting, rendering, and network). reports tic time
+//**  percentiles for each subsystem, and a world state hash at the end,
+//**  so game logic changes can be both timed and checked for behaviour
+//**  changes (with the same build, seed, and inputs, the hash should be
+//**  the same).
+//**
+//**  tics are run like `SV_Ticker()` does with `real_time` off and
+//**  without frame splitting, except that garbage is collected on fixed
+//**  tics instead of by wall clock, so runs are repeatable.
+//**
+//**************************************************************************
+#include "../gamedefs.h"
+#include "sv_local.h"
+
+
+extern VCvarB dbg_world_think_vm_time;
+extern double worldThinkTimeVM;
+
+// collect garbage once in this number of tics (about twice per second)
+enum { SimBenchGCInterval = 17 };
+
+// input recording signature
+static const char SimBenchInputSign[8] = { 'K', '8', 'S', 'I', 'M', 'I', 'N', '1' };
+
+
+enum {
+  SB_Total,
+  SB_Players,
+  SB_Thinkers,
+  SB_WorldOther,
+  SB_GC,
+  SB_Max,
+};
+
+static const char *SimBenchSubsysName[SB_Max] = {
+  "total",
+  "players",
+  "thinkers",
+  "world other",
+  "gc",
+};
+
+
+struct SimBenchInput {
+  vint32 Tic; // level tic
+  TAVec ViewAngles;
+  float ForwardMove;
+  float SideMove;
+  float FlyMove;
+  vuint32 Buttons;
+};
+
+
+bool sv_simbench_recording = false;
+static VStream *simRecStrm = nullptr;
+static VStr simRecFileName;
+static int simRecPlayer = -1;
+static int simRecLastTic = -1;
+static int simRecCount = 0;
+
+
+//==========================================================================
+//
+//  SimBenchSerialiseInput
+//
+//==========================================================================
+static void SimBenchSerialiseInput (VStream &strm, SimBenchInput &inp) {
+  strm << inp.Tic;
+  strm << inp.ViewAngles.yaw << inp.ViewAngles.pitch << inp.ViewAngles.roll;
+  strm << inp.ForwardMove << inp.SideMove << inp.FlyMove;
+  strm << inp.Buttons;
+}
+
+
+//==========================================================================
+//
+//  SimBenchStopRecording
+//
+//==========================================================================
+static void SimBenchStopRecording () {
+  if (!simRecStrm) return;
+  sv_simbench_recording = false;
+  const bool ok = (simRecStrm->Close() && !simRecStrm->IsError());
+  delete simRecStrm;
+  simRecStrm = nullptr;
+  if (ok) {
+    GCon->Logf("sim bench: recorded %d tics of input to '%s'", simRecCount, *simRecFileName);
+  } else {
+    GCon->Logf(NAME_Error, "sim bench: error writing input recording '%s'", *simRecFileName);
+  }
+}
+
+
+//==========================================================================
+//
+//  SV_SimBenchRecordInput
+//
+//  records inputs of the first human player, once per level tic
+//
+//==========================================================================
+void SV_SimBenchRecordInput (VBasePlayer *Player) {
+  if (!simRecStrm || !GLevel) return;
+  if (Player->PlayerFlags&VBasePlayer::PF_IsBot) return;
+  const int pnum = SV_GetPlayerNum(Player);
+  if (simRecPlayer < 0) simRecPlayer = pnum;
+  if (pnum != simRecPlayer) return;
+  if (GLevel->TicTime == simRecLastTic) return;
+  if (GLevel->TicTime < simRecLastTic) {
+    // new level
+    GCon->Log(NAME_Warning, "sim bench: level changed, input recording stopped");
+    SimBenchStopRecording();
+    return;
+  }
+  simRecLastTic = GLevel->TicTime;
+  SimBenchInput inp;
+  inp.Tic = GLevel->TicTime;
+  inp.ViewAngles = Player->ViewAngles;
+  inp.ForwardMove = Player->ClientForwardMove;
+  inp.SideMove = Player->ClientSideMove;
+  inp.FlyMove = Player->FlyMove;
+  inp.Buttons = Player->AcsCurrButtons;
+  SimBenchSerialiseInput(*simRecStrm, inp);
+  ++simRecCount;
+  if (simRecStrm->IsError()) SimBenchStopRecording();
+}
+
+
+//==========================================================================
+//
+//  SimBenchLoadInputs
+//
+//==========================================================================
+static bool SimBenchLoadInputs (VStr fname, TArray<SimBenchInput> &list, VStr &mapname) {
+  list.reset();
+  VStream *strm = FL_OpenSysFileRead(fname);
+  if (!strm) return false;
+  char sign[8];
+  strm->Serialise(sign, 8);
+  if (strm->IsError() || memcmp(sign, SimBenchInputSign, 8) != 0) {
+    delete strm;
+    return false;
+  }
+  *strm << mapname;
+  while (!strm->IsError() && strm->Tell() < strm->TotalSize()) {
+    SimBenchInput &inp = list.alloc();
+    SimBenchSerialiseInput(*strm, inp);
+  }
+  const bool ok = !strm->IsError();
+  delete strm;
+  return ok;
+}
+
+
+//==========================================================================
+//
+//  SimBenchApplyInput
+//
+//  sets inputs for the current level tic; returns next input index
+//
+//==========================================================================
+static int SimBenchApplyInput (VBasePlayer *Player, const TArray<SimBenchInput> &list, int idx) {
+  if (!Player->MO || !(Player->PlayerFlags&VBasePlayer::PF_Spawned)) return idx;
+  while (idx+1 < list.length() && list[idx+1].Tic <= GLevel->TicTime) ++idx;
+  if (idx >= list.length() || list[idx].Tic > GLevel->TicTime) return idx;
+  const SimBenchInput &inp = list[idx];
+  Player->ViewAngles = inp.ViewAngles;
+  Player->ClientForwardMove = inp.ForwardMove;
+  Player->ClientSideMove = inp.SideMove;
+  Player->FlyMove = inp.FlyMove;
+  Player->Buttons = inp.Buttons;
+  Player->AcsCurrButtons = inp.Buttons;
+  Player->AcsCurrButtonsPressed |= inp.Buttons;
+  return idx;
+}
+
+
+//==========================================================================
+//
+//  SimBenchConnectInputPlayer
+//
+//  connects a player without network connection, driven by recorded inputs
+//
+//==========================================================================
+static VBasePlayer *SimBenchConnectInputPlayer () {
+  if (svs.num_connected >= svs.max_clients) return nullptr;
+  int i;
+  for (i = 0; i < svs.max_clients; ++i) if (!GGameInfo->Players[i]) break;
+  if (i == svs.max_clients) return nullptr;
+  VBasePlayer *Player = GPlayersBase[i];
+  Player->PlayerFlags &= ~VBasePlayer::PF_IsBot;
+  Player->PlayerName = "input";
+  SV_ConnectClient(Player);
+  ++svs.num_connected;
+  Player->SetUserInfo(Player->UserInfo);
+  Player->SpawnClient();
+  return Player;
+}
+
+
+//==========================================================================
+//
+//  SimBenchWorldHash
+//
+//==========================================================================
+static vuint64 SimBenchWorldHash (VLevel *Level, int *entCount) {
+  XXH64_state_t *xx = XXH64_createState();
+  XXH64_reset(xx, 0x29a);
+  vint32 tic = Level->TicTime;
+  XXH64_update(xx, &tic, sizeof(tic));
+  int count = 0;
+  for (TThinkerIterator<VEntity> Ent(Level); Ent; ++Ent) {
+    VEntity *e = *Ent;
+    ++count;
+    const char *cname = e->GetClass()->GetName();
+    XXH64_update(xx, cname, strlen(cname)+1);
+    const float fv[10] = {
+      e->Origin.x, e->Origin.y, e->Origin.z,
+      e->Velocity.x, e->Velocity.y, e->Velocity.z,
+      e->Angles.yaw, e->Angles.pitch, e->Angles.roll,
+      e->StateTime,
+    };
+    XXH64_update(xx, fv, sizeof(fv));
+    XXH64_update(xx, &e->Health, sizeof(e->Health));
+    const char *sname = (e->State ? *e->State->Name : "<none>");
+    XXH64_update(xx, sname, strlen(sname)+1);
+  }
+  const vuint64 res = XXH64_digest(xx);
+  XXH64_freeState(xx);
+  if (entCount) *entCount = count;
+  return res;
+}
+
+
+extern "C" {
+  static int cmpSimBenchFloat (const void *aa, const void *bb, void *) {
+    const float a = *(const float *)aa;
+    const float b = *(const float *)bb;
+    return (a < b ? -1 : a > b ? 1 : 0);
+  }
+}
+
+
+//==========================================================================
+//
+//  SimBenchPercentile
+//
+//  `list` should be sorted
+//
+//==========================================================================
+static float SimBenchPercentile (const TArray<float> &list, int pct) {
+  if (list.length() == 0) return 0.0f;
+  const int idx = clampval((int)(((vint64)pct*list.length()+99)/100)-1, 0, list.length()-1);
+  return list[idx];
+}
+
+
+//==========================================================================
+//
+//  SimBench
+//
+//  usage:
+//    SimBench [options] mapname
+//  options:
+//    -tics n       -- run `n` measured tics (default: 2100, one minute)
+//    -warmup n     -- run `n` tics before measuring (default: 35)
+//    -bots n       -- spawn `n` bots
+//    -inputs file  -- replay player inputs recorded with `SimBenchRecord`
+//    -seed n       -- random seed (default: 1)
+//    -trace file   -- save Chrome trace of measured tics
+//    -quit         -- quit when done (used by `-simbench` CLI option)
+//
+//==========================================================================
+COMMAND(SimBench) {
+  int tics = 35*60;
+  int warmup = 35;
+  int bots = 0;
+  int seed = 1;
+  bool quit = false;
+  VStr inputName, traceName, mapname;
+
+  for (int f = 1; f < Args.length(); ++f) {
+    VStr arg = Args[f];
+    if (f+1 < Args.length() && arg.strEquCI("-tics")) { tics = max2(1, VStr::atoi(*Args[++f])); continue; }
+    if (f+1 < Args.length() && arg.strEquCI("-warmup")) { warmup = max2(0, VStr::atoi(*Args[++f])); continue; }
+    if (f+1 < Args.length() && arg.strEquCI("-bots")) { bots = clampval(VStr::atoi(*Args[++f]), 0, MAXPLAYERS); continue; }
+    if (f+1 < Args.length() && arg.strEquCI("-seed")) { seed = VStr::atoi(*Args[++f]); continue; }
+    if (f+1 < Args.length() && arg.strEquCI("-inputs")) { inputName = Args[++f]; continue; }
+    if (f+1 < Args.length() && arg.strEquCI("-trace")) { traceName = Args[++f]; continue; }
+    if (arg.strEquCI("-quit")) { quit = true; continue; }
+    if (arg.length() && arg[0] == '-') {
+      GCon->Logf(NAME_Error, "sim bench: unknown option '%s'", *arg);
+      mapname.clear();
+      break;
+    }
+    mapname = arg;
+  }
+  if (quit) host_request_exit = true;
+
+  if (mapname.isEmpty()) {
+    GCon->Log("usage: SimBench [-tics n] [-warmup n] [-bots n] [-inputs file] [-seed n] [-trace file] [-quit] mapname");
+    return;
+  }
+
+  TArray<SimBenchInput> inputs;
+  if (!inputName.isEmpty()) {
+    VStr inputMap;
+    if (!SimBenchLoadInputs(inputName, inputs, inputMap)) {
+      GCon->Logf(NAME_Error, "sim bench: cannot load inputs from '%s'", *inputName);
+      return;
+    }
+    if (!inputMap.strEquCI(mapname)) GCon->Logf(NAME_Warning, "sim bench: inputs were recorded on map '%s'", *inputMap);
+  }
+
+  SimBenchStopRecording();
+
+  // start the game
+  pcg3264_seedU32(&g_pcg3264_ctx, (vuint32)seed);
+  SV_SpawnNewGame(*mapname);
+  if (!GLevel || !GLevelInfo) {
+    GCon->Logf(NAME_Error, "sim bench: cannot start map '%s'", *mapname);
+    return;
+  }
+
+  VBasePlayer *inputPlayer = nullptr;
+  if (inputs.length()) {
+    inputPlayer = SimBenchConnectInputPlayer();
+    if (!inputPlayer) GCon->Log(NAME_Warning, "sim bench: no free player slot for inputs");
+  }
+  for (int f = 0; f < bots; ++f) SV_ConnectBot(va("simbot%d", f+1));
+
+  const bool oldVMTime = dbg_world_think_vm_time.asBool();
+  dbg_world_think_vm_time = true;
+
+  TArray<float> times[SB_Max];
+  for (auto &&arr : times) arr.resize(tics);
+
+  const double frameTime = SV_GetFrameTimeConstant();
+  int inputIdx = 0;
+  vuint64 wallStart = 0, wallEnd = 0;
+  ZoneStats zstats;
+  memset((void *)&zstats, 0, sizeof(zstats));
+
+  GCon->Logf("sim bench: running %d tics on '%s'...", warmup+tics, *mapname);
+  for (int tic = 0; tic < warmup+tics; ++tic) {
+    if (completed || sv.intermission || !GLevel) {
+      GCon->Logf(NAME_Warning, "sim bench: level ended after %d tics", tic);
+      break;
+    }
+    const bool measure = (tic >= warmup);
+    if (tic == warmup) {
+      if (!traceName.isEmpty()) VTrace::Start();
+      Z_ResetStats();
+      Z_EnableStats(1);
+      wallStart = Sys_GetTimeNano();
+    }
+    VTRACE_ZONE("SimTic");
+    if (inputPlayer) inputIdx = SimBenchApplyInput(inputPlayer, inputs, inputIdx);
+    host_frametime = frameTime;
+    GGameInfo->frametime = frameTime;
+    const vuint64 t0 = Sys_GetTimeNano();
+    SV_RunClients();
+    const vuint64 t1 = Sys_GetTimeNano();
+    GLevel->TickWorld(frameTime);
+    const vuint64 t2 = Sys_GetTimeNano();
+    if ((tic+1)%SimBenchGCInterval == 0) Host_CollectGarbage(true);
+    const vuint64 t3 = Sys_GetTimeNano();
+    if (measure) {
+      const float world = (float)((double)(t2-t1)/1000000.0);
+      const float thinkers = clampval((float)(worldThinkTimeVM*1000.0), 0.0f, world);
+      times[SB_Total].append((float)((double)(t3-t0)/1000000.0));
+      times[SB_Players].append((float)((double)(t1-t0)/1000000.0));
+      times[SB_Thinkers].append(thinkers);
+      times[SB_WorldOther].append(world-thinkers);
+      times[SB_GC].append((float)((double)(t3-t2)/1000000.0));
+    }
+  }
+  if (wallStart) {
+    wallEnd = Sys_GetTimeNano();
+    Z_GetStats(&zstats);
+    Z_EnableStats(0);
+    if (!traceName.isEmpty()) VTrace::Stop();
+  }
+  dbg_world_think_vm_time = oldVMTime;
+
+  const int measured = times[SB_Total].length();
+  GCon->Logf("sim bench: map '%s'; %d tics measured (%d warmup); %d bots; %s; seed %d", *mapname, measured, warmup,
+    bots, (inputPlayer ? va("%d inputs", inputs.length()) : "no inputs"), seed);
+  if (measured == 0) return;
+
+  GCon->Log("  subsystem       mean      p50      p90      p99      max  (msecs)");
+  for (int sb = 0; sb < SB_Max; ++sb) {
+    TArray<float> &list = times[sb];
+    double sum = 0.0;
+    for (auto &&v : list) sum += v;
+    timsort_r(list.ptr(), list.length(), sizeof(float), &cmpSimBenchFloat, nullptr);
+    GCon->Logf("  %-11s %8.3f %8.3f %8.3f %8.3f %8.3f", SimBenchSubsysName[sb], sum/measured,
+      SimBenchPercentile(list, 50), SimBenchPercentile(list, 90), SimBenchPercentile(list, 99), list[list.length()-1]);
+  }
+
+  const double wallTime = (double)(wallEnd-wallStart)/1000000000.0;
+  if (wallTime > 0.0) GCon->Logf("  speed: %.1f tics/sec (%.1fx real time)", measured/wallTime, measured/wallTime/35.0);
+  GCon->Logf("  memory: %.1f allocs/tic, %.1f KB/tic allocated, %d KB peak live", (double)zstats.allocCount/measured,
+    (double)zstats.allocBytes/1024.0/measured, (int)(zstats.peakBytes/1024));
+
+  int entCount = 0;
+  const vuint64 hash = SimBenchWorldHash(GLevel, &entCount);
+  GCon->Logf("  world: tic %d, %d entities, hash %016llx", GLevel->TicTime, entCount, (unsigned long long)hash);
+
+  if (!traceName.isEmpty()) Host_SaveTrace(traceName);
+}
+
+
+//==========================================================================
+//
+//  SimBenchRecord
+//
+//  usage:
+//    SimBenchRecord file  -- record inputs of the first human player
+//    SimBenchRecord       -- stop recording
+//
+//  start recording right after the map start, and play the map; the
+//  recording stops on level change.
+//
+//==========================================================================
+COMMAND(SimBenchRecord) {
+  if (Args.length() < 2) {
+    if (!simRecStrm) GCon->Log("usage: SimBenchRecord file");
+    SimBenchStopRecording();
+    return;
+  }
+  SimBenchStopRecording();
+  if (!GLevel || GGameInfo->NetMode == NM_None || GGameInfo->NetMode == NM_Client) {
+    GCon->Log("sim bench: game is not running");
+    return;
+  }
+  simRecFileName = Args[1];
+  simRecStrm = FL_OpenSysFileWrite(simRecFileName);
+  if (!simRecStrm) {
+    GCon->Logf(NAME_Error, "sim bench: cannot create '%s'", *simRecFileName);
+    return;
+  }
+  simRecStrm->Serialise(SimBenchInputSign, 8);
+  VStr mapname = VStr(GLevel->MapName);
+  *simRecStrm << mapname;
+  simRecPlayer = -1;
+  simRecLastTic = -1;
+  simRecCount = 0;
+  sv_simbench_recording = true;
+  GCon->Logf("sim bench: recording inputs to '%s'", *simRecFileName);
+}
@@ -1323,5 +1323,6 @@ bool VLevel::ChangeSector (sector_t *sector, int crunch) {
     csTouchCount = 1;
   }
   IncrementSZValidCount();
+  NoteGeometryChange();
   return ChangeSectorInternal(sector, crunch);
 }
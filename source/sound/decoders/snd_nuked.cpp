@@ -47,6 +47,9 @@ public:
 
   static VAudioCodec *Create (VStream *InStrm, const vuint8 sign[], int signsize);
 
+  // renders song as fast as possible; returns number of rendered frames, or -1
+  static int RenderSong (const TArray<vuint8> &song, int maxFrames, bool batched, double *time, vuint64 *hash);
+
 private:
   static OPLPlayer musplr;
   static TArray<vuint8> genmidi;
@@ -231,3 +234,97 @@ VAudioCodec *VNukedOPLAudioCodec::Create (VStream *InStrm, const vuint8 sign[],
   // return codec
   return codec;
 }
+
+
+//==========================================================================
+//
+//  VNukedOPLAudioCodec::RenderSong
+//
+//==========================================================================
+int VNukedOPLAudioCodec::RenderSong (const TArray<vuint8> &song, int maxFrames, bool batched, double *time, vuint64 *hash) {
+  if (!gmlumpTried) loadGenMIDI();
+  if (gmlumpTried < 0) return -1; // no "genmidi" lump
+
+  // don't touch the music player
+  OPLPlayer *plr = new OPLPlayer(48000, (snd_nukedopl_type.asInt() > 0), snd_nukedopl_stereo.asBool());
+  if (!plr->loadGenMIDI(genmidi.ptr(), (size_t)genmidi.length()) ||
+      !plr->load(song.ptr(), (size_t)song.length()) || !plr->play())
+  {
+    delete plr;
+    return -1;
+  }
+  plr->setBatched(batched);
+
+  enum { ChunkFrames = 4096 };
+  vint16 buf[ChunkFrames*2];
+  // chunk hashes are chained, so we don't need to keep the whole output
+  vuint64 hh = 0;
+  int frames = 0;
+  const double stt = -Sys_Time();
+  while (frames < maxFrames && plr->isPlaying()) {
+    const int rd = (int)plr->generate(buf, (size_t)min2((int)ChunkFrames, maxFrames-frames)*2, true);
+    if (rd <= 0) break;
+    hh = XXH64(buf, (size_t)rd*4, hh);
+    frames += rd;
+  }
+  *time = stt+Sys_Time();
+  *hash = hh;
+
+  delete plr;
+  return frames;
+}
+
+
+//==========================================================================
+//
+//  NukedOPLBench
+//
+//  renders MIDI (or MUS) song into memory as fast as possible, with and
+//  without batched generation, and reports rendered samples per second;
+//  doesn't need a sound device
+//
+//  usage: NukedOPLBench song [seconds]
+//
+//==========================================================================
+COMMAND(NukedOPLBench) {
+  if (Args.length() < 2) {
+    GCon->Log("usage: NukedOPLBench song [seconds]");
+    return;
+  }
+
+  int lump = W_CheckNumForName(VName(*Args[1], VName::AddLower8), WADNS_Music);
+  if (lump < 0) lump = W_CheckNumForFileName(Args[1]);
+  if (lump < 0) {
+    GCon->Logf(NAME_Error, "song '%s' not found", *Args[1]);
+    return;
+  }
+  const int seconds = (Args.length() > 2 ? clampval(VStr::atoi(*Args[2]), 1, 3600) : 300);
+
+  // OPL player can play MUS songs directly
+  TArray<vuint8> song;
+  W_LoadLumpIntoArrayIdx(lump, song);
+  if (song.length() < 4 || (memcmp(song.ptr(), MUSMAGIC, 4) != 0 && memcmp(song.ptr(), MIDIMAGIC, 4) != 0)) {
+    GCon->Logf(NAME_Error, "'%s' is not a MIDI or MUS song", *W_FullLumpName(lump));
+    return;
+  }
+
+  const int maxFrames = seconds*48000;
+  double tsingle = 0, tbatch = 0;
+  vuint64 hsingle = 0, hbatch = 0;
+  const int fsingle = VNukedOPLAudioCodec::RenderSong(song, maxFrames, false, &tsingle, &hsingle);
+  const int fbatch = VNukedOPLAudioCodec::RenderSong(song, maxFrames, true, &tbatch, &hbatch);
+  if (fsingle < 0 || fbatch < 0) {
+    GCon->Logf(NAME_Error, "cannot play song '%s'", *W_FullLumpName(lump));
+    return;
+  }
+
+  const double secs = (double)fsingle/48000.0;
+  GCon->Logf("%s: %.1f seconds of audio (%s)", *W_FullLumpName(lump), secs, (snd_nukedopl_type.asInt() > 0 ? "OPL3" : "OPL2"));
+  GCon->Logf("  per-sample: %8.3f msecs (%.0f samples/sec, %.1fx real-time)", tsingle*1000.0, (tsingle > 0 ? fsingle/tsingle : 0.0), (tsingle > 0 ? secs/tsingle : 0.0));
+  GCon->Logf("  batched:    %8.3f msecs (%.0f samples/sec, %.1fx real-time)", tbatch*1000.0, (tbatch > 0 ? fbatch/tbatch : 0.0), (tbatch > 0 ? secs/tbatch : 0.0));
+  if (fsingle != fbatch || hsingle != hbatch) {
+    GCon->Logf(NAME_Error, "  batched output differs from per-sample output!");
+  } else {
+    GCon->Log("  batched output is identical");
+  }
+}
@@ -97,6 +97,7 @@ static VCvarS snd_timidity_patches("snd_timidity_patches", "\\TIMIDITY", "Path t
 static VCvarS snd_timidity_patches("snd_timidity_patches", "/usr/share/timidity", "Path to timidity patches.", CVAR_Archive|CVAR_PreInit);
 #endif
 static VCvarI snd_timidity_verbosity("snd_timidity_verbosity", "0", "Some timidity crap.", CVAR_Archive);
+static VCvarB snd_timidity_simd("snd_timidity_simd", true, "Use SIMD resampling and mixing in Timidity (output is the same)?", CVAR_Archive);
 
 Sf2Data *TimidityManager::sf2_data = nullptr;
 DLS_Data *TimidityManager::patches = nullptr;
@@ -324,6 +325,7 @@ VTimidityAudioCodec::~VTimidityAudioCodec () {
 //
 //==========================================================================
 int VTimidityAudioCodec::Decode (vint16 *Data, int NumFrames) {
+  Song->use_simd = (snd_timidity_simd.asBool() ? TIMIDITY_SIMD : 0);
   return Timidity_PlaySome(Song, Data, NumFrames);
 }
 
@@ -388,3 +390,111 @@ VAudioCodec *VTimidityAudioCodec::Create (VStream *InStrm, const vuint8 sign[],
   // create codec
   return new VTimidityAudioCodec(Song);
 }
+
+
+//==========================================================================
+//
+//  TimidityRenderSong
+//
+//  renders song as fast as possible; returns number of rendered frames
+//
+//==========================================================================
+static int TimidityRenderSong (const TArray<vuint8> &mid, int maxFrames, bool simd, double *time, vuint64 *hash) {
+  MidiSong *Song = Timidity_LoadSongMem((void *)mid.ptr(), mid.length(), timidityManager.patches, timidityManager.sf2_data);
+  if (!Song) return -1;
+  Timidity_SetVolume(Song, 100);
+  Timidity_Start(Song);
+
+  enum { ChunkFrames = 4096 };
+  vint16 buf[ChunkFrames*2];
+  // chunk hashes are chained, so we don't need to keep the whole output
+  vuint64 hh = 0;
+  int frames = 0;
+  Song->use_simd = (simd ? TIMIDITY_SIMD : 0);
+  const double stt = -Sys_Time();
+  while (frames < maxFrames && Timidity_Active(Song)) {
+    const int rd = Timidity_PlaySome(Song, buf, min2((int)ChunkFrames, maxFrames-frames));
+    if (rd <= 0) break;
+    hh = XXH64(buf, (size_t)rd*4, hh);
+    frames += rd;
+  }
+  *time = stt+Sys_Time();
+  *hash = hh;
+
+  Timidity_Stop(Song);
+  Timidity_FreeSong(Song);
+  return frames;
+}
+
+
+//==========================================================================
+//
+//  TimidityBench
+//
+//  renders MIDI (or MUS) song into memory as fast as possible, with and
+//  without SIMD, and reports real-time factor; doesn't need a sound device
+//
+//  usage: TimidityBench song [seconds]
+//
+//==========================================================================
+COMMAND(TimidityBench) {
+  if (Args.length() < 2) {
+    GCon->Log("usage: TimidityBench song [seconds]");
+    return;
+  }
+
+  int lump = W_CheckNumForName(VName(*Args[1], VName::AddLower8), WADNS_Music);
+  if (lump < 0) lump = W_CheckNumForFileName(Args[1]);
+  if (lump < 0) {
+    GCon->Logf(NAME_Error, "song '%s' not found", *Args[1]);
+    return;
+  }
+  const int seconds = (Args.length() > 2 ? clampval(VStr::atoi(*Args[2]), 1, 3600) : 300);
+
+  TArray<vuint8> mid;
+  W_LoadLumpIntoArrayIdx(lump, mid);
+  if (mid.length() >= 4 && memcmp(mid.ptr(), MUSMAGIC, 4) == 0) {
+    VMemoryStreamRO musStrm(W_FullLumpName(lump), mid.ptr(), mid.length());
+    VMemoryStream midStrm;
+    midStrm.BeginWrite();
+    VQMus2Mid Conv;
+    if (!Conv.Run(musStrm, midStrm)) {
+      GCon->Logf(NAME_Error, "cannot convert MUS '%s' to MIDI", *W_FullLumpName(lump));
+      return;
+    }
+    mid = midStrm.GetArray();
+  }
+  if (mid.length() < 0x0e || memcmp(mid.ptr(), MIDIMAGIC, 4) != 0) {
+    GCon->Logf(NAME_Error, "'%s' is not a MIDI song", *W_FullLumpName(lump));
+    return;
+  }
+
+  if (!timidityManager.InitTimidity()) {
+    GCon->Log(NAME_Error, "cannot initialise Timidity");
+    return;
+  }
+
+  const int maxFrames = seconds*OUTPUT_RATE;
+  double tscalar = 0, tsimd = 0;
+  vuint64 hscalar = 0, hsimd = 0;
+  const int fscalar = TimidityRenderSong(mid, maxFrames, false, &tscalar, &hscalar);
+  const int fsimd = TimidityRenderSong(mid, maxFrames, true, &tsimd, &hsimd);
+  if (fscalar < 0 || fsimd < 0) {
+    GCon->Logf(NAME_Error, "cannot load MIDI song '%s'", *W_FullLumpName(lump));
+    return;
+  }
+
+  const double secs = (double)fscalar/OUTPUT_RATE;
+  GCon->Logf("%s: %.1f seconds of audio", *W_FullLumpName(lump), secs);
+  GCon->Logf("  scalar: %8.3f msecs (%.1fx real-time)", tscalar*1000.0, (tscalar > 0 ? secs/tscalar : 0.0));
+  if (TIMIDITY_SIMD) {
+    GCon->Logf("  SIMD:   %8.3f msecs (%.1fx real-time)", tsimd*1000.0, (tsimd > 0 ? secs/tsimd : 0.0));
+    if (fscalar != fsimd || hscalar != hsimd) {
+      GCon->Logf(NAME_Error, "  SIMD output differs from scalar output!");
+    } else {
+      GCon->Log("  SIMD output is identical");
+    }
+  } else {
+    GCon->Log("  SIMD is not available in this build");
+  }
+}
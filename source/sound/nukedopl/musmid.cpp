@@ -1117,6 +1117,7 @@ OPLPlayer::OPLPlayer (int32_t asamplerate, bool aopl3mode, bool astereo) {
   SynthInit();
   PlayerInit();
   mOPLCounter = 0;
+  mBatched = true;
 }
 
 
@@ -1229,6 +1230,34 @@ uint32_t OPLPlayer::generate (int16_t *buffer, size_t buflen, bool bufIsStereo)
       }
       mOPLCounter -= mSampleRate;
     }
+    if (mBatched) {
+      // generate all samples up to the next song event at once
+      // if the song was finished by the callback, only one last sample is generated
+      uint32_t count = (mPlayerActive ? (mSampleRate-mOPLCounter+mSongTempo-1)/mSongTempo : 1);
+      if (count > length-i) count = length-i;
+      mOPLCounter += count*mSongTempo;
+      if (mStereo) {
+        OPL3_GenerateBatch(&chip, buffer+i*2, count);
+        i += count;
+        continue;
+      }
+      int16_t tmp[256*2];
+      while (count) {
+        const uint32_t n = (count > 256 ? 256 : count);
+        OPL3_GenerateBatch(&chip, tmp, n);
+        for (uint32_t f = 0; f < n; ++f, ++i) {
+          int32_t iv = (tmp[f*2]+tmp[f*2+1])/2;
+          if (iv < -32768) iv = -32768; else if (iv > 32767) iv = 32767;
+          if (bufIsStereo) {
+            buffer[i*2+0] = buffer[i*2+1] = (int16_t)iv;
+          } else {
+            buffer[i] = (int16_t)iv;
+          }
+        }
+        count -= n;
+      }
+      continue;
+    }
     mOPLCounter += mSongTempo;
     OPL3_GenerateResampled(&chip, accm);
     if (mStereo) {
@@ -224,6 +224,7 @@ private:
   DataFormat mDataFormat = DataFormat::Unknown;
 
   uint32_t mOPLCounter;
+  bool mBatched; // generate samples in batches between song events (faster, produces the same output)
 
   uint8_t *songdata;
   uint32_t songlen;
@@ -353,6 +354,9 @@ public:
   inline void setStereo (bool v) noexcept { mStereo = v; }
   inline bool isStereo () const noexcept { return mStereo; }
 
+  inline void setBatched (bool v) noexcept { mBatched = v; }
+  inline bool isBatched () const noexcept { return mBatched; }
+
   // returns `false` if song cannot be started (or if it is already playing)
   bool play ();
   void stop ();
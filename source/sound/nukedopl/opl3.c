@@ -682,6 +682,67 @@ static void OPL3_SlotCalcFB(opl3_slot *slot)
     slot->prout = slot->out;
 }
 
+static void OPL3_SlotProcess(opl3_slot *slot)
+{
+    OPL3_SlotCalcFB(slot);
+    OPL3_EnvelopeCalc(slot);
+    OPL3_PhaseGenerate(slot);
+    OPL3_SlotGenerate(slot);
+}
+
+//
+// Fast slot processing
+//
+// Gives exactly the same results as OPL3_SlotProcess(), but skips work
+// for silent slots. Phase generator is always run, as noise generator
+// and rhythm mode depend on it.
+//
+// With envelope attenuation >= 0x180, OPL3_EnvelopeCalcExp() shifts
+// exprom values (<= 0x7fa << 1) by 12 or more bits, so waveform output
+// is just a sign mask.
+//
+
+static Bit16s OPL3_SlotSilentOut(Bit8u wf, Bit16u phase)
+{
+    phase &= 0x3ff;
+    switch (wf)
+    {
+    case 0:
+    case 6:
+    case 7:
+        return (phase & 0x200) ? -1 : 0;
+    case 4:
+        return ((phase & 0x300) == 0x100) ? -1 : 0;
+    default:
+        return 0;
+    }
+}
+
+static void OPL3_SlotProcessFast(opl3_slot *slot)
+{
+    OPL3_SlotCalcFB(slot);
+    if (!slot->key && slot->eg_gen == envelope_gen_num_release && slot->eg_rout == 0x1ff)
+    {
+        // Envelope off, and stays off: the only things OPL3_EnvelopeCalc() changes
+        slot->eg_out = slot->eg_rout + (slot->reg_tl << 2)
+                     + (slot->eg_ksl >> kslshift[slot->reg_ksl]) + *slot->trem;
+        slot->pg_reset = 0;
+    }
+    else
+    {
+        OPL3_EnvelopeCalc(slot);
+    }
+    OPL3_PhaseGenerate(slot);
+    if (slot->eg_out >= 0x180)
+    {
+        slot->out = OPL3_SlotSilentOut(slot->reg_wf, slot->pg_phase_out + *slot->mod);
+    }
+    else
+    {
+        OPL3_SlotGenerate(slot);
+    }
+}
+
 //
 // Channel
 //
@@ -1047,7 +1108,7 @@ static Bit16s OPL3_ClipSample(Bit32s sample)
     return (Bit16s)sample;
 }
 
-void OPL3_Generate(opl3_chip *chip, Bit16s *buf)
+static inline void OPL3_GenerateInternal(opl3_chip *chip, Bit16s *buf, int fast)
 {
     Bit8u ii;
     Bit8u jj;
@@ -1058,10 +1119,14 @@ void OPL3_Generate(opl3_chip *chip, Bit16s *buf)
 
     for (ii = 0; ii < 15; ii++)
     {
-        OPL3_SlotCalcFB(&chip->slot[ii]);
-        OPL3_EnvelopeCalc(&chip->slot[ii]);
-        OPL3_PhaseGenerate(&chip->slot[ii]);
-        OPL3_SlotGenerate(&chip->slot[ii]);
+        if (fast)
+        {
+            OPL3_SlotProcessFast(&chip->slot[ii]);
+        }
+        else
+        {
+            OPL3_SlotProcess(&chip->slot[ii]);
+        }
     }
 
     chip->mixbuff[0] = 0;
@@ -1077,20 +1142,28 @@ void OPL3_Generate(opl3_chip *chip, Bit16s *buf)
 
     for (ii = 15; ii < 18; ii++)
     {
-        OPL3_SlotCalcFB(&chip->slot[ii]);
-        OPL3_EnvelopeCalc(&chip->slot[ii]);
-        OPL3_PhaseGenerate(&chip->slot[ii]);
-        OPL3_SlotGenerate(&chip->slot[ii]);
+        if (fast)
+        {
+            OPL3_SlotProcessFast(&chip->slot[ii]);
+        }
+        else
+        {
+            OPL3_SlotProcess(&chip->slot[ii]);
+        }
     }
 
     buf[0] = OPL3_ClipSample(chip->mixbuff[0]);
 
     for (ii = 18; ii < 33; ii++)
     {
-        OPL3_SlotCalcFB(&chip->slot[ii]);
-        OPL3_EnvelopeCalc(&chip->slot[ii]);
-        OPL3_PhaseGenerate(&chip->slot[ii]);
-        OPL3_SlotGenerate(&chip->slot[ii]);
+        if (fast)
+        {
+            OPL3_SlotProcessFast(&chip->slot[ii]);
+        }
+        else
+        {
+            OPL3_SlotProcess(&chip->slot[ii]);
+        }
     }
 
     chip->mixbuff[1] = 0;
@@ -1106,10 +1179,14 @@ void OPL3_Generate(opl3_chip *chip, Bit16s *buf)
 
     for (ii = 33; ii < 36; ii++)
     {
-        OPL3_SlotCalcFB(&chip->slot[ii]);
-        OPL3_EnvelopeCalc(&chip->slot[ii]);
-        OPL3_PhaseGenerate(&chip->slot[ii]);
-        OPL3_SlotGenerate(&chip->slot[ii]);
+        if (fast)
+        {
+            OPL3_SlotProcessFast(&chip->slot[ii]);
+        }
+        else
+        {
+            OPL3_SlotProcess(&chip->slot[ii]);
+        }
     }
 
     if ((chip->timer & 0x3f) == 0x3f)
@@ -1179,6 +1256,11 @@ void OPL3_Generate(opl3_chip *chip, Bit16s *buf)
     chip->writebuf_samplecnt++;
 }
 
+void OPL3_Generate(opl3_chip *chip, Bit16s *buf)
+{
+    OPL3_GenerateInternal(chip, buf, 0);
+}
+
 void OPL3_GenerateResampled(opl3_chip *chip, Bit16s *buf)
 {
     while (chip->samplecnt >= chip->rateratio)
@@ -1380,6 +1462,38 @@ void OPL3_GenerateStream(opl3_chip *chip, Bit16s *sndptr, Bit32u numsamples)
     }
 }
 
+//
+// Batched generation
+//
+// Produces the same samples as OPL3_GenerateStream(), using fast slot
+// processing. Output is interleaved stereo.
+//
+
+void OPL3_GenerateBatch(opl3_chip *chip, Bit16s *sndptr, Bit32u numsamples)
+{
+    Bit32u i;
+    Bit32s rateratio = chip->rateratio;
+    Bit32s samplecnt = chip->samplecnt;
+
+    for (i = 0; i < numsamples; i++)
+    {
+        while (samplecnt >= rateratio)
+        {
+            chip->oldsamples[0] = chip->samples[0];
+            chip->oldsamples[1] = chip->samples[1];
+            OPL3_GenerateInternal(chip, chip->samples, 1);
+            samplecnt -= rateratio;
+        }
+        sndptr[0] = (Bit16s)((chip->oldsamples[0] * (rateratio - samplecnt)
+                            + chip->samples[0] * samplecnt) / rateratio);
+        sndptr[1] = (Bit16s)((chip->oldsamples[1] * (rateratio - samplecnt)
+                            + chip->samples[1] * samplecnt) / rateratio);
+        samplecnt += 1 << RSM_FRAC;
+        sndptr += 2;
+    }
+    chip->samplecnt = samplecnt;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,353 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2006 Jānis Legzdiņš
+//**  Copyright (C) 2018-2021 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  offline audio codec benchmark
+//**
+//**  drives audio codecs through their `Decode()` path into a null sink,
+//**  without a sound device, and reports decoding speed (as real-time
+//**  factor), allocations and peak memory for each file. output hashes
+//**  can be saved as a baseline, and checked against it later, so decoder
+//**  optimisations can be measured and regression-tested.
+//**
+//**************************************************************************
+#include "../gamedefs.h"
+#include "snd_local.h"
+
+
+struct AudioBenchItem {
+  VStr Name;
+  int Lump; // -1 for disk files
+};
+
+
+struct AudioBenchResult {
+  const char *CodecName;
+  int SampleRate;
+  int Channels;
+  int Frames;
+  double Time; // seconds
+  vuint64 Hash;
+  ZoneStats Mem;
+};
+
+
+struct AudioBenchBaseline {
+  VStr Codec;
+  int Frames;
+  vuint64 Hash;
+};
+
+
+//==========================================================================
+//
+//  AudioBenchOpen
+//
+//  returns memory stream, or `nullptr`
+//
+//==========================================================================
+static VStream *AudioBenchOpen (const AudioBenchItem &item) {
+  VStream *strm = (item.Lump >= 0 ? W_CreateLumpReaderNum(item.Lump) : FL_OpenSysFileRead(item.Name));
+  if (!strm) return nullptr;
+  // codecs are benchmarked, not file reading
+  VMemoryStream *ms = new VMemoryStream(strm->GetName());
+  TArray<vuint8> &arr = ms->GetArray();
+  const int size = strm->TotalSize();
+  arr.setLength(max2(0, size));
+  if (size > 0) strm->Serialise(arr.ptr(), size);
+  const bool err = strm->IsError();
+  strm->Close();
+  delete strm;
+  if (err || size < 4) {
+    delete ms;
+    return nullptr;
+  }
+  ms->BeginRead();
+  return ms;
+}
+
+
+//==========================================================================
+//
+//  AudioBenchConvertMus
+//
+//  converts MUS to MIDI, like the music player does
+//
+//==========================================================================
+static VStream *AudioBenchConvertMus (VStream *strm) {
+  vuint8 sign[4];
+  strm->Seek(0);
+  strm->Serialise(sign, 4);
+  strm->Seek(0);
+  if (snd_midi_player.asInt() == 3 || memcmp(sign, MUSMAGIC, 4) != 0) return strm;
+  VMemoryStream *mid = new VMemoryStream(strm->GetName());
+  mid->BeginWrite();
+  VQMus2Mid Conv;
+  const int len = Conv.Run(*strm, *mid);
+  strm->Close();
+  delete strm;
+  if (!len) {
+    delete mid;
+    return nullptr;
+  }
+  mid->Seek(0);
+  mid->BeginRead();
+  return mid;
+}
+
+
+//==========================================================================
+//
+//  AudioBenchRun
+//
+//  returns `false` if no codec can decode the file
+//
+//==========================================================================
+static bool AudioBenchRun (const AudioBenchItem &item, const char *codecFilter, int maxSeconds, AudioBenchResult &res) {
+  memset((void *)&res, 0, sizeof(res));
+
+  Z_ResetStats();
+  Z_EnableStats(1);
+  const double stt = -Sys_Time();
+
+  VStream *strm = AudioBenchOpen(item);
+  if (strm) strm = AudioBenchConvertMus(strm);
+  if (!strm) {
+    Z_EnableStats(0);
+    return false;
+  }
+
+  vuint8 sign[4];
+  strm->Seek(0);
+  strm->Serialise(sign, 4);
+
+  VAudioCodec *Codec = nullptr;
+  for (FAudioCodecDesc *Desc = FAudioCodecDesc::List; Desc && !Codec; Desc = Desc->Next) {
+    if (codecFilter && codecFilter[0] && !VStr::strEquCI(Desc->Description, codecFilter)) continue;
+    strm->Seek(0);
+    if (strm->IsError()) break;
+    Codec = Desc->Creator(strm, sign, 4);
+    if (Codec) res.CodecName = Desc->Description;
+  }
+
+  if (!Codec) {
+    // codecs take ownership of the stream only on success
+    strm->Close();
+    delete strm;
+    Z_EnableStats(0);
+    return false;
+  }
+
+  res.SampleRate = Codec->SampleRate;
+  res.Channels = Codec->NumChannels;
+
+  enum { ChunkFrames = 4096 };
+  vint16 *buf = (vint16 *)Z_Malloc(ChunkFrames*2*sizeof(vint16));
+  const int maxFrames = (maxSeconds > 0 ? maxSeconds*max2(1, Codec->SampleRate) : 0x7fffffff);
+  // chunk hashes are chained, so we don't need to keep the whole output
+  vuint64 hash = 0;
+  while (res.Frames < maxFrames && !Codec->Finished()) {
+    const int rd = Codec->Decode(buf, min2((int)ChunkFrames, maxFrames-res.Frames));
+    if (rd <= 0) break;
+    // codecs always produce interleaved stereo
+    hash = XXH64(buf, (size_t)rd*2*sizeof(vint16), hash);
+    res.Frames += rd;
+  }
+  Z_Free(buf);
+  delete Codec;
+
+  res.Time = stt+Sys_Time();
+  res.Hash = hash;
+  Z_EnableStats(0);
+  Z_GetStats(&res.Mem);
+  return true;
+}
+
+
+//==========================================================================
+//
+//  AudioBenchLoadBaseline
+//
+//  baseline is a text file; each line is:
+//    hash <TAB> frames <TAB> codec <TAB> name
+//
+//==========================================================================
+static bool AudioBenchLoadBaseline (VStr fname, TMap<VStr, AudioBenchBaseline> &map) {
+  VStream *strm = FL_OpenSysFileRead(fname);
+  if (!strm) return false;
+  const int size = strm->TotalSize();
+  VStr text;
+  if (size > 0) {
+    text.setLength(size);
+    strm->Serialise(text.getMutableCStr(), size);
+  }
+  const bool err = strm->IsError();
+  delete strm;
+  if (err) return false;
+
+  TArray<VStr> lines;
+  text.split('\n', lines);
+  for (auto &&line : lines) {
+    TArray<VStr> parts;
+    line.xstrip().split('\t', parts);
+    if (parts.length() != 4) continue;
+    AudioBenchBaseline bl;
+    bl.Hash = (vuint64)strtoull(*parts[0], nullptr, 16);
+    bl.Frames = VStr::atoi(*parts[1]);
+    bl.Codec = parts[2];
+    map.put(parts[3], bl);
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  AudioBenchCollect
+//
+//  `name` can be a lump name (music namespace), lump file name, disk file
+//  name, or one of the special names:
+//    @music  -- all music lumps
+//    @sounds -- all sound lumps
+//
+//==========================================================================
+static void AudioBenchCollect (VStr name, TArray<AudioBenchItem> &list) {
+  if (name.strEquCI("@music") || name.strEquCI("@sounds")) {
+    const EWadNamespace ns = (name.strEquCI("@music") ? WADNS_Music : WADNS_Sounds);
+    for (auto &&it : WadNSIterator(ns)) {
+      AudioBenchItem &item = list.alloc();
+      item.Name = it.getFullName();
+      item.Lump = it.lump;
+    }
+    return;
+  }
+  int lump = W_CheckNumForFileName(name);
+  if (lump < 0 && name.length() <= 8) lump = W_CheckNumForName(VName(*name, VName::AddLower8), WADNS_Music);
+  if (lump < 0 && name.length() <= 8) lump = W_CheckNumForName(VName(*name, VName::AddLower8), WADNS_Sounds);
+  if (lump < 0 && !Sys_FileExists(name)) {
+    GCon->Logf(NAME_Warning, "audio bench: '%s' not found", *name);
+    return;
+  }
+  AudioBenchItem &item = list.alloc();
+  item.Name = (lump >= 0 ? W_FullLumpName(lump) : name);
+  item.Lump = lump;
+}
+
+
+//==========================================================================
+//
+//  AudioBench
+//
+//  usage:
+//    AudioBench [options] name...
+//  options:
+//    -seconds n   -- decode at most `n` seconds of each file (default: 600)
+//    -codec name  -- use only this codec
+//    -save file   -- save output hashes as a baseline
+//    -check file  -- compare output hashes with the baseline
+//
+//==========================================================================
+COMMAND(AudioBench) {
+  int maxSeconds = 600;
+  VStr codecFilter;
+  VStr saveName, checkName;
+  TArray<AudioBenchItem> items;
+
+  for (int f = 1; f < Args.length(); ++f) {
+    VStr arg = Args[f];
+    if (f+1 < Args.length() && arg.strEquCI("-seconds")) { maxSeconds = max2(0, VStr::atoi(*Args[++f])); continue; }
+    if (f+1 < Args.length() && arg.strEquCI("-codec")) { codecFilter = Args[++f]; continue; }
+    if (f+1 < Args.length() && arg.strEquCI("-save")) { saveName = Args[++f]; continue; }
+    if (f+1 < Args.length() && arg.strEquCI("-check")) { checkName = Args[++f]; continue; }
+    AudioBenchCollect(arg, items);
+  }
+
+  if (items.length() == 0) {
+    GCon->Log("usage: AudioBench [-seconds n] [-codec name] [-save file] [-check file] name|@music|@sounds...");
+    return;
+  }
+
+  TMap<VStr, AudioBenchBaseline> baseline;
+  if (!checkName.isEmpty() && !AudioBenchLoadBaseline(checkName, baseline)) {
+    GCon->Logf(NAME_Error, "audio bench: cannot load baseline '%s'", *checkName);
+    return;
+  }
+
+  VStream *saveStrm = nullptr;
+  if (!saveName.isEmpty()) {
+    saveStrm = FL_OpenSysFileWrite(saveName);
+    if (!saveStrm) {
+      GCon->Logf(NAME_Error, "audio bench: cannot create baseline '%s'", *saveName);
+      return;
+    }
+  }
+
+  int decoded = 0, failed = 0, mismatches = 0;
+  double totalTime = 0, totalAudio = 0;
+  for (auto &&item : items) {
+    AudioBenchResult res;
+    if (!AudioBenchRun(item, *codecFilter, maxSeconds, res)) {
+      GCon->Logf(NAME_Warning, "%s: no codec", *item.Name);
+      ++failed;
+      continue;
+    }
+    ++decoded;
+    const double secs = (double)res.Frames/max2(1, res.SampleRate);
+    totalTime += res.Time;
+    totalAudio += secs;
+    GCon->Logf("%s: %s, %d Hz, %d ch; %.2f secs in %.3f msecs (%.1fx); %u allocs (%u KB), peak %d KB; hash %016llx",
+      *item.Name, res.CodecName, res.SampleRate, res.Channels, secs, res.Time*1000.0, (res.Time > 0 ? secs/res.Time : 0.0),
+      (unsigned)(res.Mem.allocCount+res.Mem.reallocCount), (unsigned)(res.Mem.allocBytes/1024), (int)(res.Mem.peakBytes/1024),
+      (unsigned long long)res.Hash);
+
+    if (!checkName.isEmpty()) {
+      const AudioBenchBaseline *bl = baseline.find(item.Name);
+      if (!bl) {
+        GCon->Logf(NAME_Warning, "  not in baseline");
+      } else if (bl->Hash != res.Hash || bl->Frames != res.Frames || !bl->Codec.strEqu(res.CodecName)) {
+        GCon->Logf(NAME_Error, "  MISMATCH: baseline is %s, %d frames, hash %016llx", *bl->Codec, bl->Frames, (unsigned long long)bl->Hash);
+        ++mismatches;
+      }
+    }
+
+    if (saveStrm) {
+      char hbuf[32];
+      snprintf(hbuf, sizeof(hbuf), "%016llx", (unsigned long long)res.Hash);
+      VStr line = VStr(hbuf)+"\t"+VStr(res.Frames)+"\t"+res.CodecName+"\t"+item.Name+"\n";
+      saveStrm->Serialise(*line, line.length());
+    }
+  }
+
+  if (saveStrm) {
+    if (!saveStrm->Close()) GCon->Logf(NAME_Error, "audio bench: error writing baseline '%s'", *saveName);
+    delete saveStrm;
+  }
+
+  GCon->Logf("audio bench: %d files decoded, %d failed; %.2f secs of audio in %.3f secs (%.1fx real-time)",
+    decoded, failed, totalAudio, totalTime, (totalTime > 0 ? totalAudio/totalTime : 0.0));
+  if (!checkName.isEmpty()) {
+    if (mismatches) GCon->Logf(NAME_Error, "audio bench: %d files differ from the baseline", mismatches); else GCon->Log("audio bench: all files match the baseline");
+  }
+}
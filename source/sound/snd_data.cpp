@@ -1183,44 +1183,33 @@ void VSoundManager::ProcessLoadedSounds () {
 
 //==========================================================================
 //
-//  VSoundManager::LoadSoundInternal
-//
-//  lock should not be held
+//  VSoundManager::ResolveSampleLump
 //
 //==========================================================================
-bool VSoundManager::LoadSoundInternal (int sound_id) {
+int VSoundManager::ResolveSampleLump (int Lump) {
   /*static*/ const char *Exts[] = { "flac", "opus", "wav", "raw", "ogg", "mp3", nullptr };
+  if (Lump < 0) return Lump;
+  // `va()` is not thread-safe
+  const int FileLump = W_FindLumpByFileNameWithExts(VStr("sound/")+*W_LumpName(Lump), Exts);
+  return (Lump < FileLump ? FileLump : Lump);
+}
 
-  sfxinfo_t *sfx;
-  {
-    MyThreadLocker lock(&loaderLock);
-    sfx = &S_sfx[sound_id];
-    if (sfx->loadedState == sfxinfo_t::ST_Invalid) return false;
-    if (sfx->loadedState == sfxinfo_t::ST_Loading) Sys_Error("internal error is sound loader");
-    if (sfx->loadedState == sfxinfo_t::ST_Loaded) return true;
-    if (sfx->loadedState != sfxinfo_t::ST_NotLoaded) Sys_Error("internal error is sound loader");
-    sfx->loadedState = sfxinfo_t::ST_Loading;
-  }
-
-  int Lump = sfx->LumpNum;
-  if (Lump < 0) {
-    //soundsWarned.put(*S_sfx[sound_id].TagName);
-    //GCon->Logf(NAME_Warning, "Sound '%s' lump not found", *S_sfx[sound_id].TagName);
-    MyThreadLocker lock(&loaderLock);
-    sfx->loadedState = sfxinfo_t::ST_Invalid;
-    return false;
-  }
-
-  int FileLump = W_FindLumpByFileNameWithExts(va("sound/%s", *W_LumpName(Lump)), Exts);
-  if (Lump < FileLump) Lump = FileLump;
 
+//==========================================================================
+//
+//  VSoundManager::DecodeSample
+//
+//  decodes lump into `Sfx`, doesn't touch loading state
+//
+//==========================================================================
+bool VSoundManager::DecodeSample (sfxinfo_t &Sfx, int Lump, bool allowCache) {
   VStream *Strm = W_CreateLumpReaderNum(Lump);
-  if (!Strm) {
-    MyThreadLocker lock(&loaderLock);
-    sfx->LumpNum = Lump;
-    sfx->loadedState = sfxinfo_t::ST_Invalid;
-    return false;
-  }
+  if (!Strm) return false;
+
+  #ifdef CLIENT
+  vuint64 cacheKey = 0;
+  vuint32 cacheLumpSize = 0;
+  #endif
 
   // if the sound is quite small, load it in memory
   const int strmsize = Strm->TotalSize();
@@ -1236,31 +1225,101 @@ bool VSoundManager::LoadSoundInternal (int sound_id) {
       ms->Close();
       delete ms;
       GCon->Logf(NAME_Warning, "Sound lump '%s' cannot be read", *W_FullLumpName(Lump));
-      MyThreadLocker lock(&loaderLock);
-      sfx->LumpNum = Lump;
-      sfx->loadedState = sfxinfo_t::ST_Invalid;
       return false;
     }
+    #ifdef CLIENT
+    // decoded samples are cached by lump contents
+    // there is no reason to cache uncompressed wave files
+    if (allowCache && strmsize > 4 && memcmp(arr.ptr(), "RIFF", 4) != 0 && SfxCache_Enabled()) {
+      cacheKey = SfxCache_CalcKey(arr.ptr(), strmsize);
+      cacheLumpSize = (vuint32)strmsize;
+      if (SfxCache_Load(Sfx, cacheKey, cacheLumpSize)) {
+        ms->Close();
+        delete ms;
+        if (cli_DebugSound) GCon->Logf(NAME_Debug, "STRD: loaded sound (%s : %s) from cache", *Sfx.TagName, *W_FullLumpName(Lump));
+        return true;
+      }
+    }
+    #endif
     ms->BeginRead();
     Strm = ms;
     //GCon->Logf(NAME_Debug, "Sound lump '%s' loaded into memory (%d bytes)", *W_FullLumpName(Lump), strmsize);
   }
 
-  for (VSampleLoader *Ldr = VSampleLoader::List; Ldr && !S_sfx[sound_id].Data; Ldr = Ldr->Next) {
+  VSampleLoader *UsedLdr = nullptr;
+  for (VSampleLoader *Ldr = VSampleLoader::List; Ldr && !Sfx.Data; Ldr = Ldr->Next) {
     Strm->Seek(0);
-    Ldr->Load(*sfx, *Strm);
-    if (sfx->Data) {
-      if (cli_DebugSound) GCon->Logf(NAME_Debug, "STRD: loaded sound #%d (uc=%d) (%s : %s) format is '%s'", sound_id, S_sfx[sound_id].UseCount, *S_sfx[sound_id].TagName, *W_FullLumpName(Lump), Ldr->GetName());
+    Ldr->Load(Sfx, *Strm);
+    if (Sfx.Data) {
+      if (cli_DebugSound) GCon->Logf(NAME_Debug, "STRD: loaded sound (uc=%d) (%s : %s) format is '%s'", Sfx.UseCount, *Sfx.TagName, *W_FullLumpName(Lump), Ldr->GetName());
+      UsedLdr = Ldr;
       break;
     } else {
-      if (cli_DebugSound) GCon->Logf(NAME_Debug, "STRD: SKIPPED sound #%d (uc=%d) (%s : %s) format is '%s'", sound_id, S_sfx[sound_id].UseCount, *S_sfx[sound_id].TagName, *W_FullLumpName(Lump), Ldr->GetName());
+      if (cli_DebugSound) GCon->Logf(NAME_Debug, "STRD: SKIPPED sound (uc=%d) (%s : %s) format is '%s'", Sfx.UseCount, *Sfx.TagName, *W_FullLumpName(Lump), Ldr->GetName());
     }
   }
 
   Strm->Close();
   delete Strm;
 
-  if (!sfx->Data) {
+  if (!Sfx.Data) return false;
+
+  #ifdef CLIENT
+  // raw samples are not compressed too
+  if (cacheLumpSize && UsedLdr && !VStr::strEqu(UsedLdr->GetName(), "wav") && !VStr::strEqu(UsedLdr->GetName(), "raw")) {
+    SfxCache_Store(Sfx, cacheKey, cacheLumpSize);
+  }
+  #else
+  (void)UsedLdr;
+  (void)allowCache;
+  #endif
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VSoundManager::LoadSoundInternal
+//
+//  lock should not be held
+//
+//==========================================================================
+bool VSoundManager::LoadSoundInternal (int sound_id) {
+  {
+    MyThreadLocker lock(&loaderLock);
+    sfxinfo_t *sfx = &S_sfx[sound_id];
+    if (sfx->loadedState == sfxinfo_t::ST_Invalid) return false;
+    if (sfx->loadedState == sfxinfo_t::ST_Loading) Sys_Error("internal error is sound loader");
+    if (sfx->loadedState == sfxinfo_t::ST_Loaded) return true;
+    if (sfx->loadedState != sfxinfo_t::ST_NotLoaded) Sys_Error("internal error is sound loader");
+    sfx->loadedState = sfxinfo_t::ST_Loading;
+  }
+  return DecodeSoundInternal(sound_id);
+}
+
+
+//==========================================================================
+//
+//  VSoundManager::DecodeSoundInternal
+//
+//  sound state must be `ST_Loading`; lock should not be held
+//
+//==========================================================================
+bool VSoundManager::DecodeSoundInternal (int sound_id) {
+  sfxinfo_t *sfx = &S_sfx[sound_id];
+
+  int Lump = sfx->LumpNum;
+  if (Lump < 0) {
+    //soundsWarned.put(*S_sfx[sound_id].TagName);
+    //GCon->Logf(NAME_Warning, "Sound '%s' lump not found", *S_sfx[sound_id].TagName);
+    MyThreadLocker lock(&loaderLock);
+    sfx->loadedState = sfxinfo_t::ST_Invalid;
+    return false;
+  }
+
+  Lump = ResolveSampleLump(Lump);
+
+  if (!DecodeSample(*sfx, Lump, true)) {
     //soundsWarned.put(*S_sfx[sound_id].TagName);
     if (cli_DebugSound) GCon->Logf(NAME_Debug, "Failed to load sound '%s' (%s)", *S_sfx[sound_id].TagName, *W_FullLumpName(Lump));
     MyThreadLocker lock(&loaderLock);
@@ -1301,12 +1360,14 @@ int VSoundManager::LoadSound (int sound_id) {
       S_sfx[sound_id].loadedState = sfxinfo_t::ST_Loaded;
     }
     ++S_sfx[sound_id].UseCount;
+    S_sfx[sound_id].bDelivered = true;
     return LS_Ready;
   } else {
     MyThreadLocker lock(&loaderLock);
     // loaded?
     if (S_sfx[sound_id].loadedState == sfxinfo_t::ST_Loaded) {
       ++S_sfx[sound_id].UseCount;
+      S_sfx[sound_id].bDelivered = true;
       return LS_Ready;
     }
     // do not try to load sound that already failed once
@@ -1314,6 +1375,7 @@ int VSoundManager::LoadSound (int sound_id) {
     if (S_sfx[sound_id].loadedState == sfxinfo_t::ST_Invalid) return LS_Error;
     // mark current sound as used
     ++S_sfx[sound_id].UseCount; // it will be released in audio driver
+    S_sfx[sound_id].bDelivered = true;
     if (S_sfx[sound_id].loadedState == sfxinfo_t::ST_Loading) return LS_Pending;
     // process loaded sounds (why not?)
     ProcessLoadedSounds();
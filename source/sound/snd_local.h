@@ -101,6 +101,8 @@ struct sfxinfo_t {
   void *Data;
 
   int loadedState; // ST_XXX
+  // data was given to the audio driver at least once (driver keeps its own copy)
+  bool bDelivered;
 };
 
 struct seq_info_t {
@@ -708,6 +710,19 @@ public:
 };
 
 
+// persistent cache of decoded sound samples (snd_sfxcache.cpp)
+// all functions are thread-safe
+bool SfxCache_Enabled ();
+// `key` is calculated from lump data
+vuint64 SfxCache_CalcKey (const void *data, int size);
+// allocates `Sfx.Data` with `Z_Malloc()` on success
+bool SfxCache_Load (sfxinfo_t &Sfx, vuint64 key, vuint32 lumpSize);
+void SfxCache_Store (const sfxinfo_t &Sfx, vuint64 key, vuint32 lumpSize);
+
+// decodes sounds used by level actors, if enabled (snd_sfxcache.cpp)
+void SND_PrefetchLevelSounds (VLevel *Level);
+
+
 extern VCvarB snd_sf2_autoload;
 extern VCvarS snd_sf2_file;
 
@@ -949,6 +949,7 @@ void VAudio::StartMusic () {
 void VAudio::Start () {
   StopAllSequences();
   StopAllSound();
+  SND_PrefetchLevelSounds(GClLevel);
 }
 
 
@@ -971,6 +972,7 @@ void VAudio::MusicChanged () {
 //
 //==========================================================================
 void VAudio::UpdateSounds () {
+  VTRACE_ZONE("UpdateSounds");
   // check sound volume
   if (snd_sfx_volume < 0.0f) snd_sfx_volume = 0.0f;
   if (snd_sfx_volume > 1.0f) snd_sfx_volume = 1.0f;
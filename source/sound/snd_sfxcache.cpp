@@ -0,0 +1,653 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2006 Jānis Legzdiņš
+//**  Copyright (C) 2018-2021 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  persistent cache of decoded sound samples, and level sound prefetcher
+//**
+//**  compressed sounds (ogg, flac, mp3, opus) are decoded on the first
+//**  play, which can cause noticeable hitches with mods that have hundreds
+//**  of them. decoded (downmixed and silence-truncated) PCM samples are
+//**  stored on disk, keyed by the hash of the source lump data.
+//**
+//**  when a level is started, sounds referenced by its actor classes are
+//**  decoded by a small thread pool, so the first play only uploads data.
+//**
+//**************************************************************************
+#include "../gamedefs.h"
+#include "snd_local.h"
+
+
+static VCvarB snd_sfx_cache("snd_sfx_cache", true, "Cache decoded compressed sounds on disk?", CVAR_Archive);
+static VCvarI snd_sfx_cache_max_mb("snd_sfx_cache_max_mb", "256", "Maximum size of decoded sound cache, in megabytes.", CVAR_Archive);
+static VCvarB snd_prefetch_sfx("snd_prefetch_sfx", true, "Decode sounds used by level actors on level start?", CVAR_Archive);
+static VCvarI snd_prefetch_threads("snd_prefetch_threads", "0", "Number of threads for sound prefetching (0: number of CPUs).", CVAR_Archive);
+static VCvarI snd_prefetch_max_mb("snd_prefetch_max_mb", "64", "Stop prefetching sounds when decoded data takes this number of megabytes.", CVAR_Archive);
+
+
+// should be changed when decoders or cache format are changed
+static const char SfxCacheSignature[8] = { 'V', 'S', 'F', 'X', 'C', 'A', '0', '1' };
+
+struct SfxCacheHeader {
+  char sign[8];
+  vuint64 hash;
+  vuint32 lumpSize;
+  vuint32 sampleRate;
+  vuint32 dataSize;
+  vuint8 sampleBits;
+  vuint8 pad[3];
+};
+static_assert(sizeof(SfxCacheHeader) == 32, "invalid SfxCacheHeader size");
+
+
+// sounds are decoded in worker threads
+static mythread_mutex sfxCacheLock;
+static bool sfxCacheInited = false;
+static VStr sfxCacheDir;
+static vint64 sfxCacheSize = -1; // <0: not calculated yet
+static int sfxCacheHits = 0;
+static int sfxCacheMisses = 0;
+static int sfxCacheStores = 0;
+static atomic_int sfxCacheTmpCounter = 0; // for unique temporary file names
+
+static struct SfxCacheLockInit {
+  SfxCacheLockInit () { mythread_mutex_init(&sfxCacheLock); }
+} sfxCacheLockInit;
+
+
+//==========================================================================
+//
+//  SfxCacheGetDir
+//
+//  returns empty string if there is no cache directory
+//  should be called with locked mutex
+//
+//==========================================================================
+static VStr SfxCacheGetDir () {
+  if (!sfxCacheInited) {
+    sfxCacheInited = true;
+    VStr dir = FL_GetCacheDir();
+    if (!dir.isEmpty()) {
+      dir += "/sounds";
+      Sys_CreateDirectory(dir);
+      if (Sys_DirExists(dir)) sfxCacheDir = dir;
+    }
+  }
+  return sfxCacheDir.cloneUnique();
+}
+
+
+//==========================================================================
+//
+//  SfxCacheFileName
+//
+//==========================================================================
+static VStr SfxCacheFileName (VStr dir, vuint64 key) {
+  // `va()` is not thread-safe
+  char buf[64];
+  snprintf(buf, sizeof(buf), "/%08x%08x.vsfc", (vuint32)(key>>32), (vuint32)key);
+  return dir+buf;
+}
+
+
+struct SfxCacheFileInfo {
+  VStr name;
+  int time;
+  vint64 size;
+};
+
+
+//==========================================================================
+//
+//  SfxCacheScan
+//
+//  should be called with locked mutex
+//
+//==========================================================================
+static vint64 SfxCacheScan (VStr dir, TArray<SfxCacheFileInfo> *list) {
+  vint64 total = 0;
+  auto dh = Sys_OpenDir(dir);
+  if (!dh) return 0;
+  for (;;) {
+    VStr fname = Sys_ReadDir(dh);
+    if (fname.isEmpty()) break;
+    if (!fname.endsWithCI(".vsfc")) continue;
+    fname = dir+"/"+fname;
+    VStream *strm = FL_OpenSysFileRead(fname);
+    if (!strm) continue;
+    const vint64 size = strm->TotalSize();
+    delete strm;
+    total += size;
+    if (list) {
+      SfxCacheFileInfo &fi = list->alloc();
+      fi.name = fname;
+      fi.time = Sys_FileTime(fname);
+      fi.size = size;
+    }
+  }
+  Sys_CloseDir(dh);
+  return total;
+}
+
+
+//==========================================================================
+//
+//  SfxCacheEvict
+//
+//  removes least recently used files until cache size is below 90% of
+//  the limit; should be called with locked mutex
+//
+//==========================================================================
+static void SfxCacheEvict (VStr dir) {
+  const vint64 limit = (vint64)max2(0, snd_sfx_cache_max_mb.asInt())*1024*1024;
+  TArray<SfxCacheFileInfo> list;
+  sfxCacheSize = SfxCacheScan(dir, &list);
+  if (sfxCacheSize <= limit) return;
+  timsort_r(list.ptr(), list.length(), sizeof(SfxCacheFileInfo), [](const void *a, const void *b, void *) -> int {
+    const SfxCacheFileInfo *fa = (const SfxCacheFileInfo *)a;
+    const SfxCacheFileInfo *fb = (const SfxCacheFileInfo *)b;
+    return (fa->time < fb->time ? -1 : fa->time > fb->time ? 1 : 0);
+  }, nullptr);
+  const vint64 target = limit/10*9;
+  int removed = 0;
+  for (auto &&fi : list) {
+    if (sfxCacheSize <= target) break;
+    Sys_FileDelete(fi.name);
+    sfxCacheSize -= fi.size;
+    ++removed;
+  }
+  GCon->Logf(NAME_Dev, "sound cache: removed %d old files (%d KB left)", removed, (int)(sfxCacheSize/1024));
+}
+
+
+//==========================================================================
+//
+//  SfxCache_Enabled
+//
+//==========================================================================
+bool SfxCache_Enabled () {
+  return (snd_sfx_cache.asBool() && snd_sfx_cache_max_mb.asInt() > 0);
+}
+
+
+//==========================================================================
+//
+//  SfxCache_CalcKey
+//
+//==========================================================================
+vuint64 SfxCache_CalcKey (const void *data, int size) {
+  return XXH64(data, (size_t)max2(0, size), (unsigned long long)size);
+}
+
+
+//==========================================================================
+//
+//  SfxCache_Load
+//
+//==========================================================================
+bool SfxCache_Load (sfxinfo_t &Sfx, vuint64 key, vuint32 lumpSize) {
+  VStr dir;
+  {
+    MyThreadLocker lock(&sfxCacheLock);
+    dir = SfxCacheGetDir();
+  }
+  if (dir.isEmpty()) return false;
+
+  VStr fname = SfxCacheFileName(dir, key);
+  VStream *strm = FL_OpenSysFileRead(fname);
+  if (!strm) {
+    MyThreadLocker lock(&sfxCacheLock);
+    ++sfxCacheMisses;
+    return false;
+  }
+
+  SfxCacheHeader hdr;
+  memset((void *)&hdr, 0, sizeof(hdr));
+  strm->Serialise(&hdr, (int)sizeof(hdr));
+  bool ok = (!strm->IsError() &&
+             memcmp(hdr.sign, SfxCacheSignature, sizeof(hdr.sign)) == 0 &&
+             hdr.hash == key &&
+             hdr.lumpSize == lumpSize &&
+             (hdr.sampleBits == 8 || hdr.sampleBits == 16) &&
+             hdr.sampleRate > 0 && hdr.sampleRate <= 384000 &&
+             hdr.dataSize > 0 && hdr.dataSize <= 0x7fffffffU-(vuint32)sizeof(hdr) &&
+             strm->TotalSize() == (int)(sizeof(hdr)+hdr.dataSize));
+  vuint8 *data = nullptr;
+  if (ok) {
+    data = (vuint8 *)Z_Malloc(hdr.dataSize);
+    strm->Serialise(data, (int)hdr.dataSize);
+    ok = !strm->IsError();
+  }
+  delete strm;
+
+  if (!ok) {
+    Z_Free(data);
+    GCon->Logf(NAME_Warning, "sound cache: removing invalid file for '%s'", *Sfx.TagName);
+    MyThreadLocker lock(&sfxCacheLock);
+    Sys_FileDelete(fname);
+    sfxCacheSize = -1; // recalculate
+    ++sfxCacheMisses;
+    return false;
+  }
+
+  Sfx.SampleRate = hdr.sampleRate;
+  Sfx.SampleBits = hdr.sampleBits;
+  Sfx.DataSize = hdr.dataSize;
+  Sfx.Data = data;
+
+  // mark as recently used
+  Sys_Touch(fname);
+  MyThreadLocker lock(&sfxCacheLock);
+  ++sfxCacheHits;
+  return true;
+}
+
+
+//==========================================================================
+//
+//  SfxCache_Store
+//
+//==========================================================================
+void SfxCache_Store (const sfxinfo_t &Sfx, vuint64 key, vuint32 lumpSize) {
+  if (!Sfx.Data || Sfx.DataSize == 0 || (Sfx.SampleBits != 8 && Sfx.SampleBits != 16)) return;
+  if (!SfxCache_Enabled()) return;
+
+  VStr dir;
+  {
+    MyThreadLocker lock(&sfxCacheLock);
+    dir = SfxCacheGetDir();
+  }
+  if (dir.isEmpty()) return;
+
+  SfxCacheHeader hdr;
+  memset((void *)&hdr, 0, sizeof(hdr));
+  memcpy(hdr.sign, SfxCacheSignature, sizeof(hdr.sign));
+  hdr.hash = key;
+  hdr.lumpSize = lumpSize;
+  hdr.sampleRate = Sfx.SampleRate;
+  hdr.dataSize = Sfx.DataSize;
+  hdr.sampleBits = (vuint8)Sfx.SampleBits;
+
+  // write to temporary file first, so other threads (or other engine instances) will never see partial files
+  VStr fname = SfxCacheFileName(dir, key);
+  char tmpsfx[32];
+  snprintf(tmpsfx, sizeof(tmpsfx), ".%d.tmp", atomic_increment(&sfxCacheTmpCounter));
+  VStr tmpname = fname+tmpsfx;
+  VStream *strm = FL_OpenSysFileWrite(tmpname);
+  if (!strm) return;
+  strm->Serialise(&hdr, (int)sizeof(hdr));
+  strm->Serialise(Sfx.Data, (int)Sfx.DataSize);
+  const bool ok = strm->Close();
+  delete strm;
+  if (!ok || !Sys_FileRename(tmpname, fname)) {
+    Sys_FileDelete(tmpname);
+    return;
+  }
+
+  MyThreadLocker lock(&sfxCacheLock);
+  ++sfxCacheStores;
+  if (sfxCacheSize < 0) sfxCacheSize = SfxCacheScan(dir, nullptr); else sfxCacheSize += (vint64)sizeof(hdr)+Sfx.DataSize;
+  if (sfxCacheSize > (vint64)snd_sfx_cache_max_mb.asInt()*1024*1024) SfxCacheEvict(dir);
+}
+
+
+//==========================================================================
+//
+//  VSoundManager::AddPrefetchSound
+//
+//  follows aliases and random lists; `seen` prevents endless loops
+//
+//==========================================================================
+void VSoundManager::AddPrefetchSound (int sound_id, TArray<int> &list, TMapNC<int, bool> &seen) {
+  if (sound_id <= 0 || sound_id >= S_sfx.length()) return;
+  if (seen.has(sound_id)) return;
+  seen.put(sound_id, true);
+  const sfxinfo_t &sfx = S_sfx[sound_id];
+  if (sfx.Link == -1) {
+    if (sfx.LumpNum >= 0) list.append(sound_id);
+    return;
+  }
+  if (sfx.bPlayerReserve) {
+    for (int cls = 0; cls < PlayerClasses.length(); ++cls) {
+      for (int gender = 0; gender < PlayerGenders.length(); ++gender) {
+        AddPrefetchSound(LookupPlayerSound(cls, gender, sound_id), list, seen);
+      }
+    }
+  } else if (sfx.bRandomHeader) {
+    for (int f = 0; f < sfx.Link; ++f) AddPrefetchSound(sfx.Sounds[f], list, seen);
+  } else {
+    AddPrefetchSound(sfx.Link, list, seen);
+  }
+}
+
+
+//==========================================================================
+//
+//  VSoundManager::AddClassSounds
+//
+//  all name fields of class defaults which are known sounds; class
+//  fields (like projectile types) are followed too
+//
+//==========================================================================
+void VSoundManager::AddClassSounds (VClass *Class, TArray<int> &list, TMapNC<int, bool> &seen, TMapNC<VClass *, bool> &classSeen) {
+  if (!Class || !Class->Defaults || classSeen.has(Class)) return;
+  classSeen.put(Class, true);
+  for (VClass *C = Class; C; C = C->GetSuperClass()) {
+    for (VField *F = C->Fields; F; F = F->Next) {
+      if (F->Type.Type == TYPE_Name) {
+        const VName snd = *(const VName *)(Class->Defaults+F->Ofs);
+        if (snd != NAME_None) AddPrefetchSound(FindSound(snd), list, seen);
+      } else if (F->Type.Type == TYPE_Class) {
+        AddClassSounds(*(VClass **)(Class->Defaults+F->Ofs), list, seen, classSeen);
+      }
+    }
+  }
+}
+
+
+//==========================================================================
+//
+//  VSoundManager::CollectLevelSounds
+//
+//  map things are checked too, because network client has no thinkers
+//  when the level is started (they are replicated later)
+//
+//==========================================================================
+void VSoundManager::CollectLevelSounds (VLevel *Level, TArray<int> &list) {
+  list.reset();
+  if (!Level) return;
+  TMapNC<int, bool> seen;
+  TMapNC<VClass *, bool> classSeen;
+  for (VThinker *Th = Level->ThinkerHead; Th; Th = Th->Next) {
+    if (Th->IsGoingToDie()) continue;
+    AddClassSounds(Th->GetClass(), list, seen, classSeen);
+  }
+  if (GGameInfo) {
+    TMapNC<int, bool> typeSeen;
+    for (auto &&th : Level->allThings()) {
+      if (th.type == 0 || typeSeen.has(th.type)) continue;
+      typeSeen.put(th.type, true);
+      mobjinfo_t *nfo = VClass::FindMObjId(th.type, GGameInfo->GameFilterFlag);
+      if (nfo) AddClassSounds(nfo->Class, list, seen, classSeen);
+    }
+  }
+}
+
+
+struct SfxPrefetchContext {
+  VSoundManager *sman;
+  const int *Items;
+  int Count;
+  atomic_int Next;
+  atomic_int Decoded;
+  atomic_int Skipped;
+  vint64 MaxBytes;
+  vint64 Bytes; // protected by `loaderLock`
+};
+
+
+//==========================================================================
+//
+//  SfxPrefetchWorker
+//
+//==========================================================================
+static void SfxPrefetchWorker (SfxPrefetchContext *ctx) {
+  VSoundManager *sman = ctx->sman;
+  for (;;) {
+    const int idx = atomic_increment(&ctx->Next)-1;
+    if (idx >= ctx->Count) break;
+    const int sound_id = ctx->Items[idx];
+    bool skip;
+    {
+      MyThreadLocker lock(&sman->loaderLock);
+      skip = (ctx->MaxBytes > 0 && ctx->Bytes >= ctx->MaxBytes);
+      // sound is already claimed, return it back
+      if (skip) sman->S_sfx[sound_id].loadedState = sfxinfo_t::ST_NotLoaded;
+    }
+    if (skip) { atomic_increment(&ctx->Skipped); continue; }
+    if (sman->DecodeSoundInternal(sound_id)) {
+      MyThreadLocker lock(&sman->loaderLock);
+      sfxinfo_t &sfx = sman->S_sfx[sound_id];
+      // nobody uses it yet; first `LoadSound()` will take it
+      sfx.loadedState = sfxinfo_t::ST_Loaded;
+      ctx->Bytes += (vint64)sfx.DataSize;
+      atomic_increment(&ctx->Decoded);
+    }
+  }
+}
+
+
+//==========================================================================
+//
+//  sfxPrefetchThreadProc
+//
+//==========================================================================
+static MYTHREAD_RET_TYPE sfxPrefetchThreadProc (void *actx) {
+  SfxPrefetchWorker((SfxPrefetchContext *)actx);
+  Z_ThreadDone();
+  return MYTHREAD_RET_VALUE;
+}
+
+
+//==========================================================================
+//
+//  VSoundManager::PrefetchLevelSounds
+//
+//  this is called from the main thread on level start, and waits for
+//  all workers, so nobody can request claimed sounds meanwhile
+//
+//==========================================================================
+int VSoundManager::PrefetchLevelSounds (VLevel *Level, int threadCount) {
+  if (!Level) return 0;
+
+  TArray<int> list;
+  CollectLevelSounds(Level, list);
+
+  // claim sounds that are not loaded yet; sounds that were already given
+  // to the audio driver are stored there, so they are not needed
+  TArray<int> claimed;
+  {
+    MyThreadLocker lock(&loaderLock);
+    for (int sound_id : list) {
+      sfxinfo_t &sfx = S_sfx[sound_id];
+      if (sfx.bDelivered || sfx.Data || sfx.loadedState != sfxinfo_t::ST_NotLoaded) continue;
+      if (queuedSoundsMap.has(sound_id)) continue;
+      sfx.loadedState = sfxinfo_t::ST_Loading;
+      claimed.append(sound_id);
+    }
+  }
+  if (claimed.length() == 0) return 0;
+
+  if (threadCount <= 0) threadCount = snd_prefetch_threads.asInt();
+  if (threadCount <= 0) threadCount = Sys_GetCPUCount();
+  threadCount = clampval(threadCount, 1, 32);
+
+  SfxPrefetchContext ctx;
+  ctx.sman = this;
+  ctx.Items = claimed.ptr();
+  ctx.Count = claimed.length();
+  ctx.Next = 0;
+  ctx.Decoded = 0;
+  ctx.Skipped = 0;
+  ctx.MaxBytes = (vint64)max2(0, snd_prefetch_max_mb.asInt())*1024*1024;
+  ctx.Bytes = 0;
+
+  const double stt = -Sys_Time();
+  enum { MaxHelpers = 31 };
+  mythread helpers[MaxHelpers];
+  const int helperCount = min2(min2(claimed.length()-1, threadCount-1), (int)MaxHelpers);
+  int started = 0;
+  while (started < helperCount) {
+    if (mythread_create(&helpers[started], &sfxPrefetchThreadProc, &ctx)) break;
+    ++started;
+  }
+  // this thread is working too
+  SfxPrefetchWorker(&ctx);
+  for (int f = 0; f < started; ++f) mythread_join(helpers[f]);
+
+  GCon->Logf(NAME_Dev, "prefetched %d of %d level sounds (%d KB, %d skipped) in %.3f msecs using %d threads",
+    (int)ctx.Decoded, claimed.length(), (int)(ctx.Bytes/1024), (int)ctx.Skipped, (stt+Sys_Time())*1000.0, started+1);
+  return ctx.Decoded;
+}
+
+
+//==========================================================================
+//
+//  SND_PrefetchLevelSounds
+//
+//==========================================================================
+void SND_PrefetchLevelSounds (VLevel *Level) {
+  if (!snd_prefetch_sfx.asBool() || !GSoundManager || !Level) return;
+  (void)GSoundManager->PrefetchLevelSounds(Level);
+}
+
+
+//==========================================================================
+//
+//  SfxCacheInfo
+//
+//==========================================================================
+COMMAND(SfxCacheInfo) {
+  MyThreadLocker lock(&sfxCacheLock);
+  VStr dir = SfxCacheGetDir();
+  if (dir.isEmpty()) {
+    GCon->Log("sound cache: no cache directory");
+    return;
+  }
+  sfxCacheSize = SfxCacheScan(dir, nullptr);
+  GCon->Logf("sound cache: %d KB of %d MB used; hits: %d; misses: %d; stores: %d", (int)(sfxCacheSize/1024), snd_sfx_cache_max_mb.asInt(), sfxCacheHits, sfxCacheMisses, sfxCacheStores);
+}
+
+
+struct SfxBenchContext {
+  const int *Lumps;
+  int Count;
+  bool AllowCache;
+  atomic_int Next;
+  atomic_int Decoded;
+};
+
+
+//==========================================================================
+//
+//  SfxBenchWorker
+//
+//==========================================================================
+static void SfxBenchWorker (SfxBenchContext *ctx) {
+  for (;;) {
+    const int idx = atomic_increment(&ctx->Next)-1;
+    if (idx >= ctx->Count) break;
+    sfxinfo_t sfx;
+    memset((void *)&sfx, 0, sizeof(sfx));
+    sfx.LumpNum = -1; // don't report truncation
+    if (VSoundManager::DecodeSample(sfx, ctx->Lumps[idx], ctx->AllowCache)) atomic_increment(&ctx->Decoded);
+    if (sfx.Data) Z_Free(sfx.Data);
+  }
+}
+
+
+//==========================================================================
+//
+//  sfxBenchThreadProc
+//
+//==========================================================================
+static MYTHREAD_RET_TYPE sfxBenchThreadProc (void *actx) {
+  SfxBenchWorker((SfxBenchContext *)actx);
+  Z_ThreadDone();
+  return MYTHREAD_RET_VALUE;
+}
+
+
+//==========================================================================
+//
+//  RunSfxBench
+//
+//==========================================================================
+static double RunSfxBench (const TArray<int> &lumps, int threadCount, bool allowCache, int *decoded) {
+  SfxBenchContext ctx;
+  ctx.Lumps = lumps.ptr();
+  ctx.Count = lumps.length();
+  ctx.AllowCache = allowCache;
+  ctx.Next = 0;
+  ctx.Decoded = 0;
+  const double stt = -Sys_Time();
+  enum { MaxHelpers = 31 };
+  mythread helpers[MaxHelpers];
+  const int helperCount = min2(min2(lumps.length()-1, threadCount-1), (int)MaxHelpers);
+  int started = 0;
+  while (started < helperCount) {
+    if (mythread_create(&helpers[started], &sfxBenchThreadProc, &ctx)) break;
+    ++started;
+  }
+  SfxBenchWorker(&ctx);
+  for (int f = 0; f < started; ++f) mythread_join(helpers[f]);
+  *decoded = ctx.Decoded;
+  return (stt+Sys_Time())*1000.0;
+}
+
+
+//==========================================================================
+//
+//  SfxPrefetchBench
+//
+//  decodes all sounds referenced by the current level actors: on one
+//  thread without the cache, using the worker pool without the cache,
+//  and using the worker pool with the cache. doesn't touch loaded sounds.
+//
+//==========================================================================
+COMMAND(SfxPrefetchBench) {
+  VLevel *lvl = GLevel;
+  if (!lvl) lvl = GClLevel;
+  if (!lvl || !GSoundManager) {
+    GCon->Log("no level loaded");
+    return;
+  }
+
+  int threadCount = 0;
+  if (Args.length() > 1) threadCount = max2(0, VStr::atoi(*Args[1]));
+  if (threadCount <= 0) threadCount = snd_prefetch_threads.asInt();
+  if (threadCount <= 0) threadCount = Sys_GetCPUCount();
+  threadCount = clampval(threadCount, 1, 32);
+
+  TArray<int> ids;
+  GSoundManager->CollectLevelSounds(lvl, ids);
+  TArray<int> lumps;
+  for (int sound_id : ids) lumps.append(VSoundManager::ResolveSampleLump(GSoundManager->S_sfx[sound_id].LumpNum));
+  if (lumps.length() == 0) {
+    GCon->Log("no sounds referenced by level actors");
+    return;
+  }
+
+  int dec1 = 0, decN = 0, decC = 0;
+  const double t1 = RunSfxBench(lumps, 1, false, &dec1);
+  const double tN = RunSfxBench(lumps, threadCount, false, &decN);
+  // first pass fills the cache
+  (void)RunSfxBench(lumps, threadCount, true, &decC);
+  const double tC = RunSfxBench(lumps, threadCount, true, &decC);
+
+  GCon->Logf("%d sounds referenced by level actors", lumps.length());
+  GCon->Logf("  1 thread:  %9.3f msecs (%d decoded)", t1, dec1);
+  GCon->Logf("%3d threads: %9.3f msecs (%d decoded)", threadCount, tN, decN);
+  GCon->Logf("%3d threads: %9.3f msecs (%d decoded, from cache)", threadCount, tC, decC);
+}
@@ -80,6 +80,13 @@ public: // fuck you, shitplusplus!
   volatile bool loaderThreadStarted;
 
   bool LoadSoundInternal (int sound_id);
+  // sound state must be `ST_Loading`; lock should not be held
+  bool DecodeSoundInternal (int sound_id);
+
+  // decodes sound lump into `Sfx`; can be called from any thread
+  static bool DecodeSample (sfxinfo_t &Sfx, int Lump, bool allowCache);
+  // returns real lump to load for sound lump (there can be a file with the same name)
+  static int ResolveSampleLump (int Lump);
 
 public:
   // the complete set of sound effects
@@ -117,6 +124,12 @@ public:
   // call this when loading a new map
   void CleanupSounds ();
 
+  // decodes sounds referenced by level actor classes using worker threads
+  // decoded samples are kept until the first play; returns number of decoded sounds
+  int PrefetchLevelSounds (VLevel *Level, int threadCount=0);
+  // collects playable sound ids referenced by level actor classes (thinkers and map things)
+  void CollectLevelSounds (VLevel *Level, TArray<int> &list);
+
 #if defined(VAVOOM_REVERB)
   VReverbInfo *FindEnvironment (int);
 #endif
@@ -181,6 +194,10 @@ private:
   void AssignSeqTranslations(VScriptParser *, int, seqtype_t);
 
   void ParseReverbs(VScriptParser *);
+
+  // for level sounds prefetcher
+  void AddPrefetchSound (int sound_id, TArray<int> &list, TMapNC<int, bool> &seen);
+  void AddClassSounds (VClass *Class, TArray<int> &list, TMapNC<int, bool> &seen, TMapNC<VClass *, bool> &classSeen);
 };
 
 //
@@ -0,0 +1,120 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 2018-2021 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  string microbenchmark
+//**
+//**  measures VStr operations the VM does a lot: refcounted and interned
+//**  copies, assignments, literal lookups, names, and formatting.
+//**
+//**************************************************************************
+#include "gamedefs.h"
+
+
+//==========================================================================
+//
+//  StrBenchReport
+//
+//==========================================================================
+static void StrBenchReport (const char *name, double stt, int iters, vuint32 sink) {
+  const double msecs = (Sys_Time()-stt)*1000.0;
+  GCon->Logf(NAME_Debug, "  %-28s %9.3f msecs (%7.2f nsecs/op)  [%08x]", name, msecs, msecs*1000000.0/(double)max2(1, iters), sink);
+}
+
+
+//==========================================================================
+//
+//  StrBench
+//
+//  string-heavy microbenchmark: refcounting, literals, names, formatting
+//
+//  usage:
+//    StrBench [iterations]
+//
+//==========================================================================
+COMMAND(StrBench) {
+  int iters = 2000000;
+  if (Args.length() > 1) iters = clampval(VStr::atoi(*Args[1]), 1000, 100000000);
+
+  const char *text = "The quick brown fox jumps over the lazy dog";
+  VStr mutstr(text);
+  VStr immstr = VStr::intern(text);
+  VName name = VName(text);
+  TArray<VStr> slots;
+  slots.setLength(64);
+
+  GCon->Logf(NAME_Debug, "=== VStr benchmark: %d iterations ===", iters);
+
+  // copy and destroy (incref/decref)
+  vuint32 sink = 0;
+  double stt = Sys_Time();
+  for (int f = 0; f < iters; ++f) { VStr s(mutstr); sink += (vuint32)s.length(); }
+  StrBenchReport("copy (refcounted)", stt, iters, sink);
+
+  sink = 0;
+  stt = Sys_Time();
+  for (int f = 0; f < iters; ++f) { VStr s(immstr); sink += (vuint32)s.length(); }
+  StrBenchReport("copy (interned)", stt, iters, sink);
+
+  // assign over other strings, like VM locals and fields do
+  sink = 0;
+  stt = Sys_Time();
+  for (int f = 0; f < iters; ++f) { VStr &s = slots[f&63]; s = (f&1 ? mutstr : immstr); sink += (vuint32)s.length(); }
+  StrBenchReport("assign (mixed)", stt, iters, sink);
+  for (auto &&s : slots) s.clear();
+
+  // uniqueness checks
+  sink = 0;
+  stt = Sys_Time();
+  for (int f = 0; f < iters; ++f) { VStr s(mutstr); sink += (vuint32)s.getMutableCStr()[f%s.length()]; }
+  StrBenchReport("copy+make unique", stt, iters, sink);
+
+  // literal lookup in the intern pool (what the compiler does)
+  sink = 0;
+  stt = Sys_Time();
+  for (int f = 0; f < iters/16; ++f) { VStr s = VStr::intern(text); sink += (vuint32)s.length(); }
+  StrBenchReport("intern lookup", stt, iters/16, sink);
+
+  // name to string
+  sink = 0;
+  stt = Sys_Time();
+  for (int f = 0; f < iters; ++f) { VStr s(name); sink += (vuint32)s.length(); }
+  StrBenchReport("name to string", stt, iters, sink);
+
+  // concatenation
+  sink = 0;
+  stt = Sys_Time();
+  for (int f = 0; f < iters/4; ++f) { VStr s = immstr+mutstr; sink += (vuint32)s.length(); }
+  StrBenchReport("concatenation", stt, iters/4, sink);
+
+  // formatting
+  sink = 0;
+  stt = Sys_Time();
+  for (int f = 0; f < iters/16; ++f) { VStr s = VStr(va("%s: %d (%g)", *immstr, f, (double)f*0.5)); sink += (vuint32)s.length(); }
+  StrBenchReport("va formatting", stt, iters/16, sink);
+
+  int icount = 0, ibytes = 0, ihits = 0;
+  VStr::getInternStats(&icount, &ibytes, &ihits);
+  GCon->Logf(NAME_Debug, "  intern pool: %d strings, %d bytes, %d hits", icount, ibytes, ihits);
+}
@@ -94,6 +94,7 @@ void Sys_Shutdown () {
 extern bool ttyRefreshInputLine;
 extern bool ttyExtraDisabled;
 extern bool dedEnableTTYLog;
+extern mythread_mutex dedTTYLock;
 
 static char text[8192];
 #ifndef _WIN32
@@ -116,6 +117,8 @@ static void onShowCompletionMatchCB (bool isheader, VStr s) {
   } else {
     GCon->Logf("\034D  %s", *s);
   }
+  // the flag is checked by the log thread
+  VLog::FlushAsync();
   dedEnableTTYLog = olddis;
 }
 #endif
@@ -125,8 +128,12 @@ static void onShowCompletionMatchCB (bool isheader, VStr s) {
 //
 //  UpdateTTYPrompt
 //
+//  the logger calls this from the log thread
+//  never log anything with `dedTTYLock` held
+//
 //==========================================================================
 void UpdateTTYPrompt () {
+  MyThreadLocker lock(&dedTTYLock);
   if (!ttyRefreshInputLine) return;
   ttyRefreshInputLine = false;
   vassert(textpos < (int)ARRAY_COUNT(text));
@@ -198,28 +205,41 @@ char *Sys_ConsoleInput () {
   // C-smth
   if (evt.type == TTYEvent::Type::ModChar) {
     if (evt.ch == 'C') Sys_Quit("*** ABORTED ***");
-    if (evt.ch == 'Y') { textpos = 0; ttyRefreshInputLine = true; UpdateTTYPrompt(); return nullptr; }
+    if (evt.ch == 'Y') {
+      MyThreadLocker lock(&dedTTYLock);
+      textpos = 0;
+      ttyRefreshInputLine = true;
+      UpdateTTYPrompt();
+      return nullptr;
+    }
   } else if (evt.type == TTYEvent::Type::Enter) {
-    if (textpos == 0) return nullptr;
-    strcpy(text2, text);
-    textpos = 0;
-    text[0] = 0;
-    ttyRefreshInputLine = true;
-    UpdateTTYPrompt();
+    {
+      MyThreadLocker lock(&dedTTYLock);
+      if (textpos == 0) return nullptr;
+      strcpy(text2, text);
+      textpos = 0;
+      text[0] = 0;
+      ttyRefreshInputLine = true;
+      UpdateTTYPrompt();
+    }
     GCon->Logf(">%s", text2);
     return text2;
   }
 
   if (evt.type == TTYEvent::Type::Backspace) {
+    MyThreadLocker lock(&dedTTYLock);
     if (textpos == 0) return nullptr;
     text[--textpos] = 0;
     ttyRefreshInputLine = true;
   } else if (evt.type == TTYEvent::Type::Tab) {
     // autocompletion
+    MyThreadLocker lock(&dedTTYLock);
     if (textpos == 0) return nullptr;
     //TODO: autocompletion with moved cursor
     const int curpos = textpos;
+    text[textpos] = 0;
     VStr clineRest(text); // after cursor
+    lock.resetLock(); // autocompletion can print matches
     VStr cline = clineRest.left(curpos);
     clineRest.chopLeft(curpos);
     if (cline.length() && clineRest.length() && clineRest[0] == '"') {
@@ -237,6 +257,7 @@ char *Sys_ConsoleInput () {
     oldpfx.chopLeft(cmdstart); // remove completed commands
     VStr newpfx = VCommand::GetAutoComplete(oldpfx);
     if (oldpfx != newpfx) {
+      MyThreadLocker tlock(&dedTTYLock);
       textpos = 0;
       PutToTTYText(*cline.left(cmdstart));
       PutToTTYText(*newpfx);
@@ -252,6 +273,7 @@ char *Sys_ConsoleInput () {
       char tmp[2];
       tmp[0] = (char)evt.ch;
       tmp[1] = 0;
+      MyThreadLocker lock(&dedTTYLock);
       PutToTTYText(tmp);
     }
   }
@@ -276,6 +298,8 @@ static void signal_handler (int s) {
   VObject::vmAbortBySignal += 1;
   // Ignore future instances of this signal.
   signal(s, SIG_IGN);
+  // the log thread may be gone with us
+  VLog::EmergencyFlush();
 
   //  Exit with error message
 #ifdef __linux__
@@ -438,6 +462,8 @@ int main (int argc, char **argv) {
 
     if (!logEnabled) {
       GCon->Logf(NAME_Warning, "disabling TTY logs to avoid random slowdowns and disconnects.");
+      // the flag is checked by the log thread
+      VLog::FlushAsync();
       dedEnableTTYLog = false;
     }
 
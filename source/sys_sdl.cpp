@@ -302,6 +302,8 @@ static void signal_handler (int s) {
   VObject::vmAbortBySignal += 1;
   // ignore future instances of this signal
   signal(s, SIG_IGN);
+  // the log thread may be gone with us
+  VLog::EmergencyFlush();
   stack_trace();
 
   // exit with error message
@@ -246,6 +246,10 @@ static void my_output_message (j_common_ptr cinfo) {
 vuint8 *VJpegTexture::GetPixels () {
   // if we already have loaded pixels, return them
   if (Pixels) return Pixels;
+  if (LoadCachedPixels(TexCacheOpt_JpegLib)) {
+    ConvertPixelsToShaded();
+    return Pixels;
+  }
   transFlags = TransValueSolid; // anyway
 
   mFormat = mOrigFormat = TEXFMT_RGBA;
@@ -353,6 +357,7 @@ vuint8 *VJpegTexture::GetPixels () {
   // free memory
   //delete Strm;
 
+  SaveCachedPixels();
   ConvertPixelsToShaded();
   return Pixels;
 }
@@ -403,6 +408,10 @@ static const stbi_io_callbacks stbcbacks = {
 vuint8 *VJpegTexture::GetPixels () {
   // if we already have loaded pixels, return them
   if (Pixels) return Pixels;
+  if (LoadCachedPixels(TexCacheOpt_JpegStb)) {
+    ConvertPixelsToShaded();
+    return Pixels;
+  }
   transFlags = TransValueSolid; // anyway
 
   mFormat = mOrigFormat = TEXFMT_RGBA;
@@ -455,6 +464,7 @@ vuint8 *VJpegTexture::GetPixels () {
   // free memory
   stbi_image_free(data);
 
+  SaveCachedPixels();
   ConvertPixelsToShaded();
   return Pixels;
 }
@@ -568,6 +568,20 @@ void VMultiPatchTexture::SetFrontSkyLayer () {
 }
 
 
+//==========================================================================
+//
+//  VMultiPatchTexture::GetSourceTextures
+//
+//==========================================================================
+void VMultiPatchTexture::GetSourceTextures (TArray<VTexture *> &list, TArray<bool> &need8) {
+  for (int i = 0; i < PatchCount; ++i) {
+    if (!Patches[i].Tex) continue;
+    list.append(Patches[i].Tex);
+    need8.append(!!Patches[i].Trans);
+  }
+}
+
+
 //==========================================================================
 //
 //  VMultiPatchTexture::GetPixels
@@ -141,6 +141,10 @@ VPngTexture::~VPngTexture () {
 vuint8 *VPngTexture::GetPixels () {
   // if we already have loaded pixels, return them
   if (Pixels) return Pixels;
+  if (LoadCachedPixels(TexCacheOpt_PNG)) {
+    ConvertPixelsToShaded();
+    return Pixels;
+  }
   transFlags = TransValueSolid; // for now
 
   VCheckedStream Strm(SourceLump);
@@ -181,6 +185,7 @@ vuint8 *VPngTexture::GetPixels () {
   // free memory
   //delete Strm;
 
+  SaveCachedPixels();
   ConvertPixelsToShaded();
   return Pixels;
 }
@@ -137,6 +137,10 @@ VTgaTexture::~VTgaTexture () {
 vuint8 *VTgaTexture::GetPixels () {
   // if we already have loaded pixels, return them
   if (Pixels) return Pixels;
+  if (LoadCachedPixels(TexCacheOpt_TGA)) {
+    ConvertPixelsToShaded();
+    return Pixels;
+  }
   transFlags = TransValueSolid; // for now
 
   // load texture
@@ -408,6 +412,7 @@ vuint8 *VTgaTexture::GetPixels () {
       }
     }
   }
+  SaveCachedPixels();
   ConvertPixelsToShaded();
   return Pixels;
 }
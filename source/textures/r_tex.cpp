@@ -209,6 +209,9 @@ static bool isSeenMissingTexture (VName Name) {
 //==========================================================================
 VTextureManager::VTextureManager ()
   : inMapTextures(0)
+  , ResidencyFrame(1)
+  , ResidencyEvictedCount(0)
+  , ResidencyEvictedBytes(0)
   , DefaultTexture(-1)
   , Time(0)
 {
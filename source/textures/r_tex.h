@@ -96,6 +96,7 @@ public:
   virtual void SetFrontSkyLayer () override;
   virtual void ReleasePixels () override;
   virtual vuint8 *GetPixels () override;
+  virtual void GetSourceTextures (TArray<VTexture *> &list, TArray<bool> &need8) override;
   virtual bool IsMultipatch () const noexcept override;
 };
 
@@ -207,6 +208,8 @@ public:
 
 
 // texture that returns a wiggly version of another texture
+// with `r_warp_phases` set, the animation is quantized to a fixed number of phases per cycle;
+// each phase is generated from precomputed offset tables, and (for small textures) cached
 class VWarpTexture : public VTexture {
 protected:
   VTexture *SrcTex;
@@ -218,6 +221,29 @@ protected:
   float *XSin2;
   float *YSin1;
   float *YSin2;
+  // phase-quantized warping
+  int PhaseCount; // number of phases the tables were built for; 0: not built
+  int CurPhase; // phase in `Pixels`, or -1
+  int PhaseFormat; // source format the cache was built for
+  TArray<vint32> PhaseOfs; // per-phase offset tables; see `BuildPhaseTables()`
+  vuint8 *PhaseCache; // `PhaseCount` images, or `nullptr` if the cycle is too big to cache
+  vuint8 *PhaseFlags; // per-phase `transFlags`; 0x80 is set for cached phases
+
+protected:
+  // returns number of phases to use, or 0 for exact (continuous) warping
+  static int GetWarpPhases () noexcept;
+  int CalcPhase (int phases) const noexcept;
+  void ClearPhaseCache () noexcept;
+  vuint8 *GetPixelsPhased (int phases);
+
+  // length of one warp cycle, in seconds (at speed 1)
+  virtual float GetWarpCycle () const noexcept;
+  // fill `PhaseOfs` for `PhaseCount` phases
+  virtual void BuildPhaseTables ();
+  // render one phase; returns transparency flags
+  virtual vuint32 RenderPhase (int phase, const vuint8 *src, vuint8 *dest);
+  // old continuous warping
+  virtual vuint8 *GetPixelsExact ();
 
 public:
   VWarpTexture (VTexture *, float aspeed=1);
@@ -234,9 +260,14 @@ public:
 
 // different style of warping
 class VWarp2Texture : public VWarpTexture {
+protected:
+  virtual float GetWarpCycle () const noexcept override;
+  virtual void BuildPhaseTables () override;
+  virtual vuint32 RenderPhase (int phase, const vuint8 *src, vuint8 *dest) override;
+  virtual vuint8 *GetPixelsExact () override;
+
 public:
   VWarp2Texture (VTexture *, float aspeed=1);
-  virtual vuint8 *GetPixels () override;
 };
 
 
@@ -252,4 +283,36 @@ extern void R_InitFTAnims (); // called by `R_InitTexture()`
 extern void R_ShutdownFTAnims (); // called by `R_ShutdownTexture()`
 
 
+// ////////////////////////////////////////////////////////////////////////// //
+// SIMD image kernels (see "r_tex_simd.cpp")
+// ////////////////////////////////////////////////////////////////////////// //
+enum {
+  TEXSIMD_None,
+  TEXSIMD_SSE2,
+  TEXSIMD_AVX2,
+};
+
+// kernel set to use, limited by CPU features and `r_texture_simd`
+int TexSimd_Level ();
+// force kernel set (used by benchmarks); `-1` returns to normal mode
+void TexSimd_ForceLevel (int level);
+const char *TexSimd_LevelName (int level);
+
+// these return the number of processed pixels; the caller should process the rest
+int TexSimd_PremultiplyRGBA (vuint8 *dest, const vuint8 *src, int count); // `dest` may be equal to `src`
+int TexSimd_PremultiplyImage (rgba_t *pic, int count);
+
+// these return `false` if nothing was done, and the caller should use scalar code
+bool TexSimd_MipMap (int width, int height, vuint8 *in);
+bool TexSimd_ResampleWeighted (int widthin, int heightin, const vuint8 *datain, int widthout, int heightout, vuint8 *dataout, float sx, float sy);
+
+// these always process the whole image
+void TexSimd_ShadeRGBA (rgba_t *pic, int count, vuint32 shadeColor);
+void TexSimd_ShadeAlpha8 (rgba_t *dest, const vuint8 *src, int count, vuint32 shadeColor);
+
+// return the index of the first pixel in [start..end) that is all zeroes (or has zero alpha), or `end`
+int TexSimd_FindZeroPixel (const rgba_t *pic, int start, int end);
+int TexSimd_FindTransparentPixel (const rgba_t *pic, int start, int end);
+
+
 #endif
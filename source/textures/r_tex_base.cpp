@@ -134,6 +134,7 @@ VTexture::VTexture ()
   , transFlags(TransValueUnknown)
   , lastTextureFiltering(-666)
   , lastUpdateFrame(0)
+  , lastUseFrame(0)
   , DriverHandle(0)
   , DriverTranslated()
   , Pixels(nullptr)
@@ -145,6 +146,10 @@ VTexture::VTexture ()
   , alreadyCropped(false)
   , shadeColor(-1)
   , shadeColorSaved(-1)
+  , pixelCacheKey(0)
+  , pixelCacheTime(-1)
+  , pixelCacheOpts(0)
+  , pixelCacheState(0)
 {
 }
 
@@ -242,6 +247,22 @@ void VTexture::ReleasePixels () {
 }
 
 
+//==========================================================================
+//
+//  VTexture::GetPixelMemoryUsage
+//
+//==========================================================================
+size_t VTexture::GetPixelMemoryUsage () const noexcept {
+  if (Width < 1 || Height < 1) return 0;
+  const size_t count = (size_t)Width*(size_t)Height;
+  size_t res = 0;
+  if (Pixels) res += count*(mFormat == TEXFMT_RGBA ? 4 : 1);
+  if (Pixels8Bit) res += count;
+  if (Pixels8BitA) res += count*sizeof(pala_t);
+  return res;
+}
+
+
 //==========================================================================
 //
 //  VTexture::GetPixels8
@@ -366,6 +387,15 @@ rgba_t *VTexture::GetPalette () {
 }
 
 
+//==========================================================================
+//
+//  VTexture::GetSourceTextures
+//
+//==========================================================================
+void VTexture::GetSourceTextures (TArray<VTexture *> &/*list*/, TArray<bool> &/*need8*/) {
+}
+
+
 //==========================================================================
 //
 //  VTexture::GetHighResolutionTexture
@@ -541,8 +571,10 @@ VTexture::VTransData *VTexture::FindDriverShaded (vuint32 ShadeColor, int CMap,
 void VTexture::PremultiplyRGBAInPlace (void *databuff, int w, int h) {
   if (w < 1 || h < 1) return;
   vuint8 *data = (vuint8 *)databuff;
+  const int done = TexSimd_PremultiplyRGBA(data, data, w*h);
+  data += done*4;
   // premultiply original image
-  for (int count = w*h; count > 0; --count, data += 4) {
+  for (int count = w*h-done; count > 0; --count, data += 4) {
     int a = data[3];
     if (a == 0) {
       data[0] = data[1] = data[2] = 0;
@@ -564,8 +596,11 @@ void VTexture::PremultiplyRGBA (void *dest, const void *src, int w, int h) {
   if (w < 1 || h < 1) return;
   const vuint8 *s = (const vuint8 *)src;
   vuint8 *d = (vuint8 *)dest;
+  const int done = TexSimd_PremultiplyRGBA(d, s, w*h);
+  s += done*4;
+  d += done*4;
   // premultiply image
-  for (int count = w*h; count > 0; --count, s += 4, d += 4) {
+  for (int count = w*h-done; count > 0; --count, s += 4, d += 4) {
     int a = s[3];
     if (a == 0) {
       *(vuint32 *)d = 0;
@@ -646,6 +681,13 @@ void VTexture::SmoothEdges (vuint8 *buffer, int w, int h) {
     l1 += 4;
 
     for (x = 1; x < w-1; ++x, l1 += 4) {
+      if (l1[MSB] != 0) {
+        // skip opaque run; alpha is never changed here, so this is safe
+        const int nx = TexSimd_FindTransparentPixel((const rgba_t *)(l1-x*4), x, w-1);
+        l1 += (nx-x)*4;
+        x = nx;
+        if (x >= w-1) break;
+      }
       if (l1[MSB] == 0 && !CHKPIX(-w) && !CHKPIX(-1) && !CHKPIX(1) && !CHKPIX(-w-1) && !CHKPIX(-w+1) && !CHKPIX(w-1) && !CHKPIX(w+1)) {
         CHKPIX(w);
       }
@@ -711,6 +753,7 @@ void VTexture::ResampleTexture (int widthin, int heightin, const vuint8 *datain,
       }
     }
   } else {
+    if (TexSimd_ResampleWeighted(widthin, heightin, datain, widthout, heightout, dataout, sx, sy)) return;
     // use weighted sample
     if (sx <= 1.0f && sy <= 1.0f) {
       // magnify both width and height: use weighted sample of 4 pixels
@@ -796,6 +839,8 @@ void VTexture::MipMap (int width, int height, vuint8 *InIn) {
   int i, j;
   vuint8 *out = in;
 
+  if (TexSimd_MipMap(width, height, in)) return;
+
   if (width == 1 || height == 1) {
     // special case when only one dimension is scaled
     int total = width*height/2;
@@ -948,26 +993,35 @@ void VTexture::shadePixelsRGBA (int shadeColor) {
   vassert(Pixels);
   vassert(shadeColor >= 0);
   vassert(mFormat == TEXFMT_RGBA);
-  const vuint8 shadeR = (shadeColor>>16)&0xff;
-  const vuint8 shadeG = (shadeColor>>8)&0xff;
-  const vuint8 shadeB = (shadeColor)&0xff;
-  rgba_t *pic = (rgba_t *)Pixels;
-  for (int f = Width*Height; f--; ++pic) {
-    // use red as intensity
-    vuint8 intensity = pic->r;
-    /*k8: nope
-    // use any non-zero color as intensity
-    if (!intensity) {
-           if (pic->g) intensity = pic->g;
-      else if (pic->b) intensity = pic->b;
+  // use red as intensity
+  TexSimd_ShadeRGBA((rgba_t *)Pixels, Width*Height, (vuint32)shadeColor);
+}
+
+
+//==========================================================================
+//
+//  ColorIntensityCache
+//
+//  `colorIntensity()` does sRGB conversions, and it is too slow to call
+//  for each pixel; textures usually have few distinct colors, though
+//
+//==========================================================================
+struct ColorIntensityCache {
+  vuint32 Keys[256]; // 0 means "empty"
+  vuint8 Values[256];
+
+  inline ColorIntensityCache () noexcept { memset((void *)Keys, 0, sizeof(Keys)); }
+
+  inline vuint8 get (int r, int g, int b) noexcept {
+    const vuint32 key = 0x01000000u|((vuint32)r<<16)|((vuint32)g<<8)|(vuint32)b;
+    const unsigned idx = (key*2654435761u)>>24;
+    if (Keys[idx] != key) {
+      Keys[idx] = key;
+      Values[idx] = colorIntensity(r, g, b);
     }
-    */
-    pic->r = shadeR;
-    pic->g = shadeG;
-    pic->b = shadeB;
-    pic->a = intensity;
+    return Values[idx];
   }
-}
+};
 
 
 //==========================================================================
@@ -984,8 +1038,9 @@ void VTexture::stencilPixelsRGBA (int shadeColor) {
   const float shadeG = (shadeColor>>8)&0xff;
   const float shadeB = (shadeColor)&0xff;
   rgba_t *pic = (rgba_t *)Pixels;
+  ColorIntensityCache cic;
   for (int f = Width*Height; f > 0; --f, ++pic) {
-    float intensity = colorIntensity(pic->r, pic->g, pic->b)/255.0f;
+    float intensity = cic.get(pic->r, pic->g, pic->b)/255.0f;
     pic->r = clampToByte(intensity*shadeR);
     pic->g = clampToByte(intensity*shadeG);
     pic->b = clampToByte(intensity*shadeB);
@@ -1010,20 +1065,15 @@ rgba_t *VTexture::CreateShadedPixels (vuint32 shadeColor, const rgba_t *palette)
   // create shaded data
   if (Format == TEXFMT_8 || Format == TEXFMT_8Pal) {
     //GLog.Logf(NAME_Debug, "*** FMT8(%s): 0x%08x", *W_FullLumpName(SourceLump), shadeColor);
-    const vuint8 *src = (const vuint8 *)Pixels;
-    for (int f = Width*Height; f--; ++dest, ++src) {
-      dest->r = shadeR;
-      dest->g = shadeG;
-      dest->b = shadeB;
-      dest->a = *src;
-    }
+    TexSimd_ShadeAlpha8(dest, (const vuint8 *)Pixels, Width*Height, shadeColor);
   } else {
     vassert(Format == TEXFMT_RGBA);
     //GLog.Logf(NAME_Debug, "*** FMT32(%s): 0x%08x", *W_FullLumpName(SourceLump), shadeColor);
     const rgba_t *src = (const rgba_t *)Pixels;
+    ColorIntensityCache cic;
     for (int f = Width*Height; f--; ++dest, ++src) {
       #if 1
-      const vuint8 ci = colorIntensity(src->r, src->g, src->b);
+      const vuint8 ci = cic.get(src->r, src->g, src->b);
       dest->r = shadeR;
       dest->g = shadeG;
       dest->b = shadeB;
@@ -1149,10 +1199,9 @@ void VTexture::FilterFringe (rgba_t *pic, int wdt, int hgt) {
 
   if (!pic || wdt < 1 || hgt < 1) return;
   for (int y = 0; y < hgt; ++y) {
-    for (int x = 0; x < wdt; ++x) {
+    // only fully zero pixels are changed, and changed pixels are never used as a source
+    for (int x = TexSimd_FindZeroPixel(pic+y*wdt, 0, wdt); x < wdt; x = TexSimd_FindZeroPixel(pic+y*wdt, x+1, wdt)) {
       rgba_t *dp = &pic[y*wdt+x];
-      if (dp->a != 0) continue;
-      if (dp->r != 0 || dp->g != 0 || dp->b != 0) continue;
       int r = 0, g = 0, b = 0, cnt = 0;
       rgba_t px;
       for (int dy = -1; dy < 2; ++dy) {
@@ -1187,7 +1236,9 @@ void VTexture::FilterFringe (rgba_t *pic, int wdt, int hgt) {
 //==========================================================================
 void VTexture::PremultiplyImage (rgba_t *pic, int wdt, int hgt) {
   if (!pic || wdt < 1 || hgt < 1) return;
-  for (int ofs = wdt*hgt; ofs--; ++pic) {
+  const int done = TexSimd_PremultiplyImage(pic, wdt*hgt);
+  pic += done;
+  for (int ofs = wdt*hgt-done; ofs--; ++pic) {
     pic->r = clampToByte((int)((float)pic->r*(pic->a/255.0f)));
     pic->g = clampToByte((int)((float)pic->g*(pic->a/255.0f)));
     pic->b = clampToByte((int)((float)pic->b*(pic->a/255.0f)));
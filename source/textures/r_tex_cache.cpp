@@ -0,0 +1,381 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2006 Jānis Legzdiņš
+//**  Copyright (C) 2018-2021 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  persistent cache of decoded texture pixels
+//**
+//**  hires textures (png, jpeg, tga) are slow to decode, so decoded RGBA
+//**  pixels are stored on disk. the key is built from the source file name,
+//**  lump name, lump size and source file modification time, so cache hits
+//**  don't read the lump at all; lumps without a usable file stamp (nested
+//**  archives) are keyed by the hash of the lump data. decoder id is a part
+//**  of the key too. each cache file is a fixed 40-byte header followed by
+//**  raw pixels, so it can be read with one call (or mapped into memory).
+//**
+//**  cache size is limited; least recently used files (by modification
+//**  time, which is updated on each hit) are removed first.
+//**
+//**************************************************************************
+#include "../gamedefs.h"
+
+
+static VCvarB r_texture_cache("r_texture_cache", true, "Cache decoded hires textures on disk?", CVAR_Archive);
+static VCvarI r_texture_cache_max_mb("r_texture_cache_max_mb", "512", "Maximum size of decoded texture cache, in megabytes.", CVAR_Archive);
+static VCvarI r_texture_cache_min_kb("r_texture_cache_min_kb", "64", "Don't cache textures with smaller source lumps (in kilobytes).", CVAR_Archive);
+
+
+// should be changed when decoders or cache format are changed
+static const char TexCacheSignature[8] = { 'V', 'T', 'X', 'C', 'A', 'C', '0', '2' };
+
+struct TexCacheHeader {
+  char sign[8];
+  vuint64 key;
+  vuint32 lumpSize;
+  vint32 lumpTime; // source file modification time, or -1 if `key` is a hash of lump data
+  vuint32 opts; // decoder id
+  vint32 width;
+  vint32 height;
+  vuint8 format; // always `TEXFMT_RGBA` for now
+  vuint8 transFlags;
+  vuint8 pad[2];
+};
+static_assert(sizeof(TexCacheHeader) == 40, "invalid TexCacheHeader size");
+
+// `VStream::Serialise()` takes `int`, and nobody needs bigger hires textures anyway
+#define TEXCACHE_MAX_DIM     (16384)
+#define TEXCACHE_MAX_PIXSIZE ((vint64)256*1024*1024)
+
+
+// decoders can run in worker threads
+static mythread_mutex texCacheLock;
+static bool texCacheInited = false;
+static VStr texCacheDir;
+static vint64 texCacheSize = -1; // <0: not calculated yet
+static int texCacheHits = 0;
+static int texCacheMisses = 0;
+static int texCacheStores = 0;
+static int texCacheInvalid = 0; // invalid files removed
+static int texCacheEvicted = 0; // old files removed to keep the size limit
+static atomic_int texCacheTmpCounter = 0; // for unique temporary file names
+
+static struct TexCacheLockInit {
+  TexCacheLockInit () { mythread_mutex_init(&texCacheLock); }
+} texCacheLockInit;
+
+
+//==========================================================================
+//
+//  TexCacheGetDir
+//
+//  returns empty string if there is no cache directory
+//  should be called with locked mutex
+//
+//==========================================================================
+static VStr TexCacheGetDir () {
+  if (!texCacheInited) {
+    texCacheInited = true;
+    VStr dir = FL_GetCacheDir();
+    if (!dir.isEmpty()) {
+      dir += "/textures";
+      Sys_CreateDirectory(dir);
+      if (Sys_DirExists(dir)) texCacheDir = dir;
+    }
+  }
+  return texCacheDir.cloneUnique();
+}
+
+
+//==========================================================================
+//
+//  TexCacheFileName
+//
+//==========================================================================
+static VStr TexCacheFileName (VStr dir, vuint64 key) {
+  // `va()` is not thread-safe
+  char buf[64];
+  snprintf(buf, sizeof(buf), "/%08x%08x.vtxc", (vuint32)(key>>32), (vuint32)key);
+  return dir+buf;
+}
+
+
+struct TexCacheFileInfo {
+  VStr name;
+  int time;
+  vint64 size;
+};
+
+
+//==========================================================================
+//
+//  TexCacheScan
+//
+//  should be called with locked mutex
+//
+//==========================================================================
+static vint64 TexCacheScan (VStr dir, TArray<TexCacheFileInfo> *list) {
+  vint64 total = 0;
+  auto dh = Sys_OpenDir(dir);
+  if (!dh) return 0;
+  for (;;) {
+    VStr fname = Sys_ReadDir(dh);
+    if (fname.isEmpty()) break;
+    if (!fname.endsWithCI(".vtxc")) continue;
+    fname = dir+"/"+fname;
+    VStream *strm = FL_OpenSysFileRead(fname);
+    if (!strm) continue;
+    const vint64 size = strm->TotalSize();
+    delete strm;
+    total += size;
+    if (list) {
+      TexCacheFileInfo &fi = list->alloc();
+      fi.name = fname;
+      fi.time = Sys_FileTime(fname);
+      fi.size = size;
+    }
+  }
+  Sys_CloseDir(dh);
+  return total;
+}
+
+
+//==========================================================================
+//
+//  TexCacheEvict
+//
+//  removes least recently used files until cache size is below 90% of
+//  the limit; should be called with locked mutex
+//
+//==========================================================================
+static void TexCacheEvict (VStr dir) {
+  const vint64 limit = (vint64)max2(0, r_texture_cache_max_mb.asInt())*1024*1024;
+  TArray<TexCacheFileInfo> list;
+  texCacheSize = TexCacheScan(dir, &list);
+  if (texCacheSize <= limit) return;
+  timsort_r(list.ptr(), list.length(), sizeof(TexCacheFileInfo), [](const void *a, const void *b, void *) -> int {
+    const TexCacheFileInfo *fa = (const TexCacheFileInfo *)a;
+    const TexCacheFileInfo *fb = (const TexCacheFileInfo *)b;
+    return (fa->time < fb->time ? -1 : fa->time > fb->time ? 1 : 0);
+  }, nullptr);
+  const vint64 target = limit/10*9;
+  int removed = 0;
+  for (auto &&fi : list) {
+    if (texCacheSize <= target) break;
+    Sys_FileDelete(fi.name);
+    texCacheSize -= fi.size;
+    ++removed;
+  }
+  // this can be called from a worker thread, so don't log anything here; see `TexCacheInfo`
+  texCacheEvicted += removed;
+}
+
+
+//==========================================================================
+//
+//  TexCacheCalcKey
+//
+//  uses source file name and stamp if possible, so the lump is not read
+//
+//==========================================================================
+static bool TexCacheCalcKey (int lump, vuint32 opts, vuint64 *key, vint32 *lumpTime) {
+  const int size = W_LumpLength(lump);
+  if (size <= 0 || size < r_texture_cache_min_kb.asInt()*1024) return false;
+
+  VStr pakname = W_FullPakNameForLump(lump);
+  VStr lumpname = W_RealLumpName(lump);
+  int ftime = -1;
+  if (!pakname.isEmpty() && !lumpname.isEmpty()) {
+    // for mounted directories, check the file itself
+    ftime = Sys_FileTime(Sys_DirExists(pakname) ? pakname+"/"+lumpname : pakname);
+  }
+
+  if (ftime > 0) {
+    const vuint64 seed = ((vuint64)(vuint32)ftime<<32)|(vuint32)size;
+    vuint64 k = XXH64(*pakname, (size_t)pakname.length(), (unsigned long long)seed);
+    k = XXH64(*lumpname, (size_t)lumpname.length(), (unsigned long long)(k^opts));
+    *key = k;
+    *lumpTime = ftime;
+    return true;
+  }
+
+  // nested archive, or something; hash lump data
+  VStream *strm = W_CreateLumpReaderNum(lump);
+  if (!strm) return false;
+  TArray<vuint8> data;
+  data.setLength(size);
+  strm->Serialise(data.ptr(), size);
+  const bool err = strm->IsError();
+  delete strm;
+  if (err) return false;
+  *key = XXH64(data.ptr(), (size_t)size, (unsigned long long)(((vuint64)opts<<32)|(vuint32)size));
+  *lumpTime = -1;
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VTexture::LoadCachedPixels
+//
+//==========================================================================
+bool VTexture::LoadCachedPixels (vuint32 opts) {
+  if (!r_texture_cache.asBool() || SourceLump < 0 || pixelCacheState == 2) return false;
+
+  if (pixelCacheState == 0) {
+    if (!TexCacheCalcKey(SourceLump, opts, &pixelCacheKey, &pixelCacheTime)) { pixelCacheState = 2; return false; }
+    pixelCacheOpts = opts;
+    pixelCacheState = 1;
+  }
+
+  VStr dir;
+  {
+    MyThreadLocker lock(&texCacheLock);
+    dir = TexCacheGetDir();
+  }
+  if (dir.isEmpty()) return false;
+
+  VStr fname = TexCacheFileName(dir, pixelCacheKey);
+  VStream *strm = FL_OpenSysFileRead(fname);
+  if (!strm) {
+    MyThreadLocker lock(&texCacheLock);
+    ++texCacheMisses;
+    return false;
+  }
+
+  TexCacheHeader hdr;
+  memset((void *)&hdr, 0, sizeof(hdr));
+  strm->Serialise(&hdr, (int)sizeof(hdr));
+  // header comes from disk, so check dimensions before multiplying them
+  bool ok = (!strm->IsError() &&
+             memcmp(hdr.sign, TexCacheSignature, sizeof(hdr.sign)) == 0 &&
+             hdr.key == pixelCacheKey &&
+             hdr.lumpTime == pixelCacheTime &&
+             hdr.opts == pixelCacheOpts &&
+             (int)hdr.lumpSize == W_LumpLength(SourceLump) &&
+             hdr.format == TEXFMT_RGBA &&
+             hdr.width > 0 && hdr.width <= TEXCACHE_MAX_DIM && hdr.height > 0 && hdr.height <= TEXCACHE_MAX_DIM);
+  const vint64 pixSize = (ok ? (vint64)hdr.width*(vint64)hdr.height*4 : 0);
+  ok = (ok && pixSize <= TEXCACHE_MAX_PIXSIZE && (vint64)strm->TotalSize() == (vint64)sizeof(hdr)+pixSize);
+  vuint8 *data = nullptr;
+  if (ok) {
+    data = new vuint8[(size_t)pixSize];
+    strm->Serialise(data, (int)pixSize);
+    ok = !strm->IsError();
+  }
+  delete strm;
+
+  if (!ok) {
+    delete[] data;
+    MyThreadLocker lock(&texCacheLock);
+    Sys_FileDelete(fname);
+    texCacheSize = -1; // recalculate
+    ++texCacheInvalid;
+    ++texCacheMisses;
+    return false;
+  }
+
+  Width = hdr.width;
+  Height = hdr.height;
+  mFormat = mOrigFormat = TEXFMT_RGBA;
+  transFlags = hdr.transFlags;
+  Pixels = data;
+
+  // mark as recently used
+  Sys_Touch(fname);
+  MyThreadLocker lock(&texCacheLock);
+  ++texCacheHits;
+  return true;
+}
+
+
+//==========================================================================
+//
+//  VTexture::SaveCachedPixels
+//
+//==========================================================================
+void VTexture::SaveCachedPixels () {
+  if (!r_texture_cache.asBool() || pixelCacheState != 1 || !Pixels) return;
+  // only RGBA textures are cached
+  if (mFormat != TEXFMT_RGBA || Width < 1 || Height < 1 || Width > TEXCACHE_MAX_DIM || Height > TEXCACHE_MAX_DIM) { pixelCacheState = 2; return; }
+  const vint64 pixSize = (vint64)Width*(vint64)Height*4;
+  if (pixSize > TEXCACHE_MAX_PIXSIZE) { pixelCacheState = 2; return; }
+  if (r_texture_cache_max_mb.asInt() <= 0) return;
+
+  VStr dir;
+  {
+    MyThreadLocker lock(&texCacheLock);
+    dir = TexCacheGetDir();
+  }
+  if (dir.isEmpty()) return;
+
+  TexCacheHeader hdr;
+  memset((void *)&hdr, 0, sizeof(hdr));
+  memcpy(hdr.sign, TexCacheSignature, sizeof(hdr.sign));
+  hdr.key = pixelCacheKey;
+  hdr.lumpSize = (vuint32)W_LumpLength(SourceLump);
+  hdr.lumpTime = pixelCacheTime;
+  hdr.opts = pixelCacheOpts;
+  hdr.width = Width;
+  hdr.height = Height;
+  hdr.format = TEXFMT_RGBA;
+  hdr.transFlags = (vuint8)transFlags;
+
+  // write to temporary file first, so other threads (or other engine instances) will never see partial files
+  VStr fname = TexCacheFileName(dir, pixelCacheKey);
+  char tmpsfx[32];
+  snprintf(tmpsfx, sizeof(tmpsfx), ".%d.tmp", atomic_increment(&texCacheTmpCounter));
+  VStr tmpname = fname+tmpsfx;
+  VStream *strm = FL_OpenSysFileWrite(tmpname);
+  if (!strm) return;
+  strm->Serialise(&hdr, (int)sizeof(hdr));
+  strm->Serialise(Pixels, (int)pixSize);
+  const bool ok = strm->Close();
+  delete strm;
+  if (!ok || !Sys_FileRename(tmpname, fname)) {
+    Sys_FileDelete(tmpname);
+    return;
+  }
+
+  MyThreadLocker lock(&texCacheLock);
+  ++texCacheStores;
+  if (texCacheSize < 0) texCacheSize = TexCacheScan(dir, nullptr); else texCacheSize += (vint64)sizeof(hdr)+pixSize;
+  if (texCacheSize > (vint64)r_texture_cache_max_mb.asInt()*1024*1024) TexCacheEvict(dir);
+}
+
+
+//==========================================================================
+//
+//  TexCacheInfo
+//
+//==========================================================================
+COMMAND(TexCacheInfo) {
+  MyThreadLocker lock(&texCacheLock);
+  VStr dir = TexCacheGetDir();
+  if (dir.isEmpty()) {
+    GCon->Log("texture cache: no cache directory");
+    return;
+  }
+  texCacheSize = TexCacheScan(dir, nullptr);
+  GCon->Logf("texture cache: %d KB of %d MB used; hits: %d; misses: %d; stores: %d; invalid: %d; evicted: %d", (int)(texCacheSize/1024), r_texture_cache_max_mb.asInt(), texCacheHits, texCacheMisses, texCacheStores, texCacheInvalid, texCacheEvicted);
+}
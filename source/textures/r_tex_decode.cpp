@@ -0,0 +1,276 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2006 Jānis Legzdiņš
+//**  Copyright (C) 2018-2021 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  parallel texture decoder
+//**
+//**  decoding is split from uploading: worker threads call `GetPixels()`,
+//**  and the renderer uploads already decoded pixels on the main thread.
+//**  composite textures read pixels of their patches, so textures are
+//**  decoded in "waves": patches first, then textures built from them.
+//**
+//**************************************************************************
+#include "../gamedefs.h"
+#include "r_tex.h"
+
+
+static VCvarI r_texture_decode_threads("r_texture_decode_threads", "0", "Number of threads used to decode textures on precaching (0: auto; 1: no worker threads).", CVAR_Archive);
+
+
+struct TexDecodeItem {
+  VTexture *Tex;
+  int Depth; // decoding wave; -1 means "being processed" (circular reference)
+  bool Need8; // `GetPixels8()` is used by some composite texture
+};
+
+
+struct TexDecodeList {
+  TArray<TexDecodeItem> Items;
+  TMapNC<VTexture *, int> Map; // texture -> index in `Items`
+  int MaxDepth;
+
+  TexDecodeList () : Items(), Map(), MaxDepth(0) {}
+
+  // returns item index, or -1
+  int Add (VTexture *Tex, bool need8);
+};
+
+
+//==========================================================================
+//
+//  TexDecodeList::Add
+//
+//==========================================================================
+int TexDecodeList::Add (VTexture *Tex, bool need8) {
+  if (!Tex || Tex->Type == TEXTYPE_Null || Tex->bIsCameraTexture || Tex->IsDynamicTexture()) return -1;
+
+  auto ip = Map.get(Tex);
+  if (ip) {
+    Items[*ip].Need8 = (Items[*ip].Need8 || need8);
+    return *ip;
+  }
+
+  const int idx = Items.length();
+  Map.put(Tex, idx);
+  TexDecodeItem &it = Items.alloc();
+  it.Tex = Tex;
+  it.Depth = -1;
+  it.Need8 = need8;
+
+  // textures used to build this one should be decoded first
+  TArray<VTexture *> srclist;
+  TArray<bool> src8;
+  Tex->GetSourceTextures(srclist, src8);
+  int depth = 0;
+  for (int f = 0; f < srclist.length(); ++f) {
+    const int sidx = Add(srclist[f], src8[f]);
+    if (sidx < 0) continue;
+    if (Items[sidx].Depth < 0) {
+      // circular reference; let the main thread deal with it
+      GCon->Logf(NAME_Warning, "circular patch reference in texture '%s'", *Tex->Name);
+      depth = -1;
+      break;
+    }
+    depth = max2(depth, Items[sidx].Depth+1);
+  }
+  // circular references are decoded on the main thread, after everything else
+  Items[idx].Depth = (depth >= 0 ? depth : 0x7fffffff);
+  if (depth >= 0) MaxDepth = max2(MaxDepth, depth);
+  return idx;
+}
+
+
+//==========================================================================
+//
+//  CollectTexturesToDecode
+//
+//  renderer uploads hires replacements instead of original textures
+//
+//==========================================================================
+static void CollectTexturesToDecode (TexDecodeList &dl, const TArray<VTexture *> &list) {
+  for (VTexture *Tex : list) {
+    if (!Tex || Tex->Type == TEXTYPE_Null || Tex->bIsCameraTexture) continue;
+    // hires textures are created here, because texture manager is not thread-safe
+    VTexture *hitex = Tex->GetHighResolutionTexture();
+    dl.Add((hitex && hitex->Type != TEXTYPE_Null ? hitex : Tex), false);
+    if (Tex->Brightmap) {
+      VTexture *bmtex = Tex->Brightmap->GetHighResolutionTexture();
+      dl.Add((bmtex && bmtex->Type != TEXTYPE_Null ? bmtex : Tex->Brightmap), false);
+    }
+  }
+}
+
+
+struct TexDecodeContext {
+  TexDecodeItem **Items;
+  int Count;
+  atomic_int Next;
+};
+
+
+//==========================================================================
+//
+//  TexDecodeWorker
+//
+//==========================================================================
+static void TexDecodeWorker (TexDecodeContext *ctx) {
+  for (;;) {
+    const int idx = atomic_increment(&ctx->Next)-1;
+    if (idx >= ctx->Count) break;
+    TexDecodeItem *it = ctx->Items[idx];
+    (void)it->Tex->GetPixels();
+    if (it->Need8) (void)it->Tex->GetPixels8();
+  }
+}
+
+
+//==========================================================================
+//
+//  texDecodeThreadProc
+//
+//==========================================================================
+static MYTHREAD_RET_TYPE texDecodeThreadProc (void *actx) {
+  TexDecodeWorker((TexDecodeContext *)actx);
+  Z_ThreadDone();
+  return MYTHREAD_RET_VALUE;
+}
+
+
+//==========================================================================
+//
+//  DecodeTextureList
+//
+//==========================================================================
+static int DecodeTextureList (TexDecodeList &dl, int threadCount) {
+  if (dl.Items.length() == 0) return 0;
+  if (threadCount <= 0) threadCount = r_texture_decode_threads.asInt();
+  if (threadCount <= 0) threadCount = Sys_GetCPUCount();
+  threadCount = clampval(threadCount, 1, 32);
+
+  enum { MaxHelpers = 31 };
+  mythread helpers[MaxHelpers];
+
+  TArray<TexDecodeItem *> wave;
+  for (int depth = 0; depth <= dl.MaxDepth; ++depth) {
+    wave.reset();
+    for (auto &&it : dl.Items) if (it.Depth == depth) wave.append(&it);
+    if (wave.length() == 0) continue;
+
+    TexDecodeContext ctx;
+    ctx.Items = wave.ptr();
+    ctx.Count = wave.length();
+    ctx.Next = 0;
+
+    const int helperCount = min2(min2(wave.length()-1, threadCount-1), (int)MaxHelpers);
+    int started = 0;
+    while (started < helperCount) {
+      if (mythread_create(&helpers[started], &texDecodeThreadProc, &ctx)) break;
+      ++started;
+    }
+    // this thread is working too
+    TexDecodeWorker(&ctx);
+    for (int f = 0; f < started; ++f) mythread_join(helpers[f]);
+  }
+
+  // textures with circular references
+  for (auto &&it : dl.Items) {
+    if (it.Depth <= dl.MaxDepth) continue;
+    (void)it.Tex->GetPixels();
+    if (it.Need8) (void)it.Tex->GetPixels8();
+  }
+
+  return dl.Items.length();
+}
+
+
+//==========================================================================
+//
+//  VTextureManager::DecodeTextures
+//
+//==========================================================================
+int VTextureManager::DecodeTextures (const TArray<VTexture *> &list, int threadCount) {
+  TexDecodeList dl;
+  CollectTexturesToDecode(dl, list);
+  return DecodeTextureList(dl, threadCount);
+}
+
+
+//==========================================================================
+//
+//  TexDecodeBench
+//
+//  decodes all wall and flat textures of the current map, first on one
+//  thread, and then using the worker pool. doesn't need a renderer.
+//
+//==========================================================================
+COMMAND(TexDecodeBench) {
+  VLevel *lvl = GLevel;
+  #ifdef CLIENT
+  if (!lvl) lvl = GClLevel;
+  #endif
+  if (!lvl) {
+    GCon->Log("no level loaded");
+    return;
+  }
+
+  int threadCount = 0;
+  if (Args.length() > 1) threadCount = max2(0, VStr::atoi(*Args[1]));
+
+  const int maxtex = GTextureManager.GetNumTextures();
+  TArray<bool> present;
+  present.setLength(maxtex);
+  for (auto &&b : present) b = false;
+  for (int f = 0; f < lvl->NumSectors; ++f) {
+    const sector_t *sec = &lvl->Sectors[f];
+    if (sec->floor.pic > 0 && sec->floor.pic < maxtex) present[sec->floor.pic] = true;
+    if (sec->ceiling.pic > 0 && sec->ceiling.pic < maxtex) present[sec->ceiling.pic] = true;
+  }
+  for (int f = 0; f < lvl->NumSides; ++f) {
+    const side_t *side = &lvl->Sides[f];
+    if (side->TopTexture > 0 && side->TopTexture < maxtex) present[side->TopTexture] = true;
+    if (side->MidTexture > 0 && side->MidTexture < maxtex) present[side->MidTexture] = true;
+    if (side->BottomTexture > 0 && side->BottomTexture < maxtex) present[side->BottomTexture] = true;
+  }
+
+  TArray<VTexture *> list;
+  for (int f = 1; f < maxtex; ++f) if (present[f]) list.append(GTextureManager.getIgnoreAnim(f));
+
+  TexDecodeList dl;
+  CollectTexturesToDecode(dl, list);
+
+  double times[2];
+  vuint64 pixelCount = 0;
+  for (int pass = 0; pass < 2; ++pass) {
+    for (auto &&it : dl.Items) it.Tex->ReleasePixels();
+    times[pass] = -Sys_Time();
+    (void)DecodeTextureList(dl, (pass == 0 ? 1 : threadCount));
+    times[pass] += Sys_Time();
+  }
+  for (auto &&it : dl.Items) pixelCount += (vuint64)max2(0, it.Tex->GetWidth())*(vuint64)max2(0, it.Tex->GetHeight());
+
+  GCon->Logf("TexDecodeBench: %d map textures, %d decoded textures (%d waves), %.2f megapixels", list.length(), dl.Items.length(), dl.MaxDepth+1, (double)pixelCount/1000000.0);
+  GCon->Logf("  single thread: %.3f msecs", times[0]*1000.0);
+  GCon->Logf("  worker pool  : %.3f msecs (%.2fx)", times[1]*1000.0, (times[1] > 0 ? times[0]/times[1] : 0.0));
+}
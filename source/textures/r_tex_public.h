@@ -291,6 +291,8 @@ public:
   }
 
   vuint32 lastUpdateFrame;
+  // residency manager LRU stamp: `VTextureManager::GetResidencyFrame()` at the last use
+  vuint32 lastUseFrame;
 
   // driver data
   struct VTransData {
@@ -340,6 +342,11 @@ protected:
   bool alreadyCropped;
   int shadeColor;
   int shadeColorSaved; // `ConvertPixelsToShaded()` saves `shadeColor` here, so we can restore it after `ReleasePixels()`
+  // persistent pixel cache key (source file stamp or lump hash, and decoder options); see "r_tex_cache.cpp"
+  vuint64 pixelCacheKey;
+  vint32 pixelCacheTime; // source file modification time, or -1 if the key is a lump hash
+  vuint32 pixelCacheOpts;
+  vuint8 pixelCacheState; // 0: key is not calculated yet; 1: key is valid; 2: texture is not cacheable
 
 public:
   static void checkerFill8 (vuint8 *dest, int width, int height);
@@ -384,6 +391,20 @@ protected:
 
   void CalcRealDimensions ();
 
+  // decoder ids for the pixel cache; pixels decoded by different decoders are cached separately
+  enum {
+    TexCacheOpt_PNG = 1u,
+    TexCacheOpt_TGA = 2u,
+    TexCacheOpt_JpegLib = 3u,
+    TexCacheOpt_JpegStb = 4u,
+  };
+
+  // persistent cache of decoded RGBA pixels (see "r_tex_cache.cpp")
+  // call `LoadCachedPixels()` before decoding; it sets `Pixels`, dimensions, format and transparency flags
+  // call `SaveCachedPixels()` after decoding, but before `ConvertPixelsToShaded()`
+  bool LoadCachedPixels (vuint32 opts);
+  void SaveCachedPixels ();
+
 public:
   static void FilterFringe (rgba_t *pic, int wdt, int hgt);
   static void PremultiplyImage (rgba_t *pic, int wdt, int hgt);
@@ -461,12 +482,23 @@ public:
   // can be used to release hires texture memory
   virtual void ReleasePixels ();
 
+  // mark texture as recently used, so the residency manager will keep its pixels
+  inline void MarkUsed () noexcept;
+  // bytes held by decoded pixel buffers (hires replacement and brightmap are not counted)
+  size_t GetPixelMemoryUsage () const noexcept;
+  // hires replacement, if it is already loaded; never loads anything
+  inline VTexture *GetLoadedHiResTexture () const noexcept { return HiResTexture; }
+
   virtual vuint8 *GetPixels () = 0;
   vuint8 *GetPixels8 ();
   pala_t *GetPixels8A ();
   virtual rgba_t *GetPalette ();
   virtual VTexture *GetHighResolutionTexture ();
 
+  // textures whose pixels are read by `GetPixels()`; used by the parallel decoder
+  // `need8` is set for textures read with `GetPixels8()`
+  virtual void GetSourceTextures (TArray<VTexture *> &list, TArray<bool> &need8);
+
   // this returns temporary data, which should be freed with `FreeShadedPixels()`
   // WARNING: next call to `CreateShadedPixels()` may invalidate the pointer!
   //          that means that you MUST call `FreeShadedPixels()` before trying to
@@ -532,6 +564,10 @@ public:
   };
 
 private:
+  vuint32 ResidencyFrame; // incremented by `ResidencyTick()`
+  int ResidencyEvictedCount;
+  vint64 ResidencyEvictedBytes;
+
   void rehashTextures ();
 
   inline VTexture *getTxByIndex (int idx) const noexcept {
@@ -728,6 +764,22 @@ public:
   inline int GetNumTextures () const noexcept { return Textures.length(); }
   inline int GetNumMapTextures () const noexcept { return MapTextures.length(); }
 
+  // decode pixels of the given textures (and their hires replacements, brightmaps and patches)
+  // with worker threads; no GPU work is done, so renderer will only upload ready pixels
+  // dynamic and camera textures are skipped; should be called from the main thread
+  // returns number of decoded textures
+  int DecodeTextures (const TArray<VTexture *> &list, int threadCount=-1);
+
+  // pixel residency manager (see "r_tex_residency.cpp")
+  // should be called once per rendered frame; releases pixels of cold textures to keep
+  // decoded pixel memory within `r_texture_ram_budget_mb`
+  void ResidencyTick ();
+  inline vuint32 GetResidencyFrame () const noexcept { return ResidencyFrame; }
+  // releases least recently used pixel buffers until `budget` is met; returns number of released textures
+  int EnforceResidencyBudget (vint64 budget, int minIdleFrames);
+  // log memory usage, and `topCount` biggest resident textures
+  void DumpResidencyStats (int topCount);
+
   // to use in `ExportTexture` command
   void FillNameAutocompletion (VStr prefix, TArray<VStr> &list);
   VTexture *GetExistingTextureByName (VStr txname, int type=TEXTYPE_Any);
@@ -781,6 +833,8 @@ void R_UpdateSkyFlatNum (bool force=false);
 
 // ////////////////////////////////////////////////////////////////////////// //
 extern VTextureManager GTextureManager;
+
+inline void VTexture::MarkUsed () noexcept { lastUseFrame = GTextureManager.GetResidencyFrame(); }
 extern int skyflatnum;
 extern int screenBackTexNum;
 
@@ -0,0 +1,238 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2006 Jānis Legzdiņš
+//**  Copyright (C) 2018-2021 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  texture pixel residency manager
+//**
+//**  decoded pixels are kept in RAM until somebody calls `ReleasePixels()`,
+//**  so with hires packs CPU-side texture memory grows with each map.
+//**  renderer marks textures with the current residency frame on each use;
+//**  when decoded pixels take more than the budget, pixels of the least
+//**  recently used textures are released. released textures are simply
+//**  decoded again on the next `GetPixels()` call (and the decoded pixel
+//**  cache makes this cheap for hires textures).
+//**
+//**  budget is checked only from `ResidencyTick()`, which is called
+//**  between frames, so nobody holds pixel pointers at that time.
+//**
+//**************************************************************************
+#include "../gamedefs.h"
+#include "r_tex.h"
+
+
+static VCvarI r_texture_ram_budget_mb("r_texture_ram_budget_mb", "1024", "Budget for decoded texture pixels in RAM, in megabytes (0: unlimited).", CVAR_Archive);
+static VCvarI r_texture_ram_min_idle("r_texture_ram_min_idle", "350", "Never release pixels of textures used in this number of last frames.", CVAR_Archive);
+static VCvarB r_texture_ram_verbose("r_texture_ram_verbose", false, "Report released texture memory?", CVAR_Archive);
+
+// budget is checked once in this number of frames
+enum { ResidencyCheckInterval = 32 };
+
+
+struct ResidentTexture {
+  VTexture *Tex;
+  size_t Bytes;
+  vuint32 LastUse; // for hires replacements and brightmaps, this includes owner's last use
+};
+
+
+//==========================================================================
+//
+//  CollectResidentTexture
+//
+//==========================================================================
+static void CollectResidentTexture (TArray<ResidentTexture> &list, VTexture *tex, vuint32 ownerLastUse, vint64 &total) {
+  if (!tex) return;
+  const size_t bytes = tex->GetPixelMemoryUsage();
+  const vuint32 lastUse = max2(tex->lastUseFrame, ownerLastUse);
+  if (bytes) {
+    ResidentTexture &rt = list.alloc();
+    rt.Tex = tex;
+    rt.Bytes = bytes;
+    rt.LastUse = lastUse;
+    total += (vint64)bytes;
+  }
+  // hires replacement and brightmap are owned by this texture, and are not in texture lists
+  VTexture *hitex = tex->GetLoadedHiResTexture();
+  if (hitex && hitex != tex) CollectResidentTexture(list, hitex, lastUse, total);
+  if (tex->Brightmap && tex->Brightmap != tex) CollectResidentTexture(list, tex->Brightmap, lastUse, total);
+}
+
+
+//==========================================================================
+//
+//  CollectResidentTextures
+//
+//==========================================================================
+static vint64 CollectResidentTextures (TArray<ResidentTexture> &list, VTextureManager &tman) {
+  vint64 total = 0;
+  list.reset();
+  for (int f = 0; f < tman.GetNumTextures(); ++f) CollectResidentTexture(list, tman.getIgnoreAnim(f), 0, total);
+  for (int f = 0; f < tman.GetNumMapTextures(); ++f) CollectResidentTexture(list, tman.getMapTexIgnoreAnim(f), 0, total);
+  return total;
+}
+
+
+//==========================================================================
+//
+//  CompareResidentLRU
+//
+//==========================================================================
+static int CompareResidentLRU (const void *aa, const void *bb, void *) {
+  const ResidentTexture *a = (const ResidentTexture *)aa;
+  const ResidentTexture *b = (const ResidentTexture *)bb;
+  if (a->LastUse != b->LastUse) return (a->LastUse < b->LastUse ? -1 : 1);
+  // release bigger textures first
+  if (a->Bytes != b->Bytes) return (a->Bytes > b->Bytes ? -1 : 1);
+  return 0;
+}
+
+
+//==========================================================================
+//
+//  CompareResidentSize
+//
+//==========================================================================
+static int CompareResidentSize (const void *aa, const void *bb, void *) {
+  const ResidentTexture *a = (const ResidentTexture *)aa;
+  const ResidentTexture *b = (const ResidentTexture *)bb;
+  if (a->Bytes != b->Bytes) return (a->Bytes > b->Bytes ? -1 : 1);
+  return 0;
+}
+
+
+//==========================================================================
+//
+//  VTextureManager::ResidencyTick
+//
+//==========================================================================
+void VTextureManager::ResidencyTick () {
+  if (++ResidencyFrame == 0) ResidencyFrame = 1;
+  if (ResidencyFrame%ResidencyCheckInterval != 0) return;
+  const int budgetMB = r_texture_ram_budget_mb.asInt();
+  if (budgetMB <= 0) return;
+  (void)EnforceResidencyBudget((vint64)budgetMB*1024*1024, max2(0, r_texture_ram_min_idle.asInt()));
+}
+
+
+//==========================================================================
+//
+//  VTextureManager::EnforceResidencyBudget
+//
+//  releases pixels down to 90% of the budget, so we won't do this
+//  on each check
+//
+//==========================================================================
+int VTextureManager::EnforceResidencyBudget (vint64 budget, int minIdleFrames) {
+  static TArray<ResidentTexture> list;
+  vint64 total = CollectResidentTextures(list, *this);
+  if (total <= budget) return 0;
+
+  const double stt = -Sys_Time();
+  const vint64 target = budget/10*9;
+  const vint64 oldTotal = total;
+  const vuint32 idleLimit = (ResidencyFrame > (vuint32)minIdleFrames ? ResidencyFrame-(vuint32)minIdleFrames : 0);
+
+  timsort_r(list.ptr(), list.length(), sizeof(ResidentTexture), &CompareResidentLRU, nullptr);
+
+  int released = 0;
+  for (auto &&rt : list) {
+    if (total <= target) break;
+    if (rt.LastUse >= idleLimit) break; // everything else is hot
+    VTexture *tex = rt.Tex;
+    // these cannot be reloaded, or will be regenerated anyway
+    if (tex->SourceLump < 0 || tex->IsDynamicTexture() || tex->bIsCameraTexture) continue;
+    // `ReleasePixels()` may release patches and brightmaps too; they will be counted on the next check
+    const size_t before = tex->GetPixelMemoryUsage();
+    if (!before) continue; // already released by its owner
+    tex->ReleasePixels();
+    const size_t freed = before-min2(before, tex->GetPixelMemoryUsage());
+    if (!freed) continue;
+    total -= (vint64)freed;
+    ResidencyEvictedBytes += (vint64)freed;
+    ++ResidencyEvictedCount;
+    ++released;
+  }
+  list.reset();
+
+  if (released && r_texture_ram_verbose.asBool()) {
+    GCon->Logf(NAME_Debug, "texture residency: released %d textures (%d KB of %d KB) in %.3f msecs", released, (int)((oldTotal-total)/1024), (int)(oldTotal/1024), (stt+Sys_Time())*1000.0);
+  }
+  return released;
+}
+
+
+//==========================================================================
+//
+//  VTextureManager::DumpResidencyStats
+//
+//==========================================================================
+void VTextureManager::DumpResidencyStats (int topCount) {
+  TArray<ResidentTexture> list;
+  const vint64 total = CollectResidentTextures(list, *this);
+
+  const vuint32 minIdle = (vuint32)max2(0, r_texture_ram_min_idle.asInt());
+  int hotCount = 0;
+  vint64 hotBytes = 0;
+  for (auto &&rt : list) {
+    if (ResidencyFrame-rt.LastUse < minIdle) { ++hotCount; hotBytes += (vint64)rt.Bytes; }
+  }
+
+  GCon->Logf("texture residency: frame %u; budget: %d MB", ResidencyFrame, r_texture_ram_budget_mb.asInt());
+  GCon->Logf("  resident: %d textures, %d KB (%d textures, %d KB used in last %u frames)", list.length(), (int)(total/1024), hotCount, (int)(hotBytes/1024), minIdle);
+  GCon->Logf("  released: %d textures, %d KB", ResidencyEvictedCount, (int)(ResidencyEvictedBytes/1024));
+
+  if (topCount <= 0 || list.length() == 0) return;
+  timsort_r(list.ptr(), list.length(), sizeof(ResidentTexture), &CompareResidentSize, nullptr);
+  for (int f = 0; f < list.length() && f < topCount; ++f) {
+    const ResidentTexture &rt = list[f];
+    GCon->Logf("  %6d KB  %4dx%-4d  idle %6u  %s (%s)", (int)(rt.Bytes/1024), rt.Tex->Width, rt.Tex->Height, ResidencyFrame-rt.LastUse, *rt.Tex->Name, (rt.Tex->SourceLump >= 0 ? *W_FullLumpName(rt.Tex->SourceLump) : "<generated>"));
+  }
+}
+
+
+//==========================================================================
+//
+//  TexResidency
+//
+//  usage:
+//    TexResidency [top]  -- show stats, and `top` biggest textures
+//    TexResidency trim   -- enforce the budget now, ignoring idle limit
+//
+//==========================================================================
+COMMAND(TexResidency) {
+  if (Args.length() > 1 && Args[1].strEquCI("trim")) {
+    const int budgetMB = r_texture_ram_budget_mb.asInt();
+    if (budgetMB <= 0) {
+      GCon->Log("texture residency budget is not set");
+      return;
+    }
+    const int released = GTextureManager.EnforceResidencyBudget((vint64)budgetMB*1024*1024, 0);
+    GCon->Logf("released pixels of %d textures", released);
+    return;
+  }
+  int topCount = 10;
+  if (Args.length() > 1) topCount = max2(0, VStr::atoi(*Args[1]));
+  GTextureManager.DumpResidencyStats(topCount);
+}
@@ -0,0 +1,753 @@
+//**************************************************************************
+//**
+//**    ##   ##    ##    ##   ##   ####     ####   ###     ###
+//**    ##   ##  ##  ##  ##   ##  ##  ##   ##  ##  ####   ####
+//**     ## ##  ##    ##  ## ##  ##    ## ##    ## ## ## ## ##
+//**     ## ##  ########  ## ##  ##    ## ##    ## ##  ###  ##
+//**      ###   ##    ##   ###    ##  ##   ##  ##  ##       ##
+//**       #    ##    ##    #      ####     ####   ##       ##
+//**
+//**  Copyright (C) 1999-2006 Jānis Legzdiņš
+//**  Copyright (C) 2018-2021 Ketmar Dark
+//**
+//**  This program is free software: you can redistribute it and/or modify
+//**  it under the terms of the GNU General Public License as published by
+//**  the Free Software Foundation, version 3 of the License ONLY.
+//**
+//**  This program is distributed in the hope that it will be useful,
+//**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//**  GNU General Public License for more details.
+//**
+//**  You should have received a copy of the GNU General Public License
+//**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//**
+//**************************************************************************
+//**
+//**  SIMD versions of the per-pixel texture routines
+//**
+//**  SSE2 is always available on x86_64; AVX2 kernels are compiled with
+//**  function-level target attributes, and selected at runtime.
+//**
+//**  all integer kernels produce exactly the same output as scalar code
+//**  (`x*a/255` is computed as `(t+1+(t>>8))>>8`, which is exact for
+//**  `t` in [0..255*255]). float kernels use the same operations in the
+//**  same order, so they are exact too, unless the compiler fuses scalar
+//**  multiply-adds (FMA builds); then resampled pixels may differ by 1.
+//**
+//**  `AdjustGamma()` is a table lookup, and is left scalar (SSE2 has no
+//**  gathers). `SmoothEdges()` and `FilterFringe()` are branchy, so only
+//**  the scan for pixels that need work is vectorised.
+//**
+//**************************************************************************
+#include "../gamedefs.h"
+#include "r_tex.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+# define VV_TEXSIMD_X86
+# include <emmintrin.h>
+# include <immintrin.h>
+# define VV_TEXSIMD_AVX2  __attribute__((target("avx2")))
+#endif
+
+
+static VCvarI r_texture_simd("r_texture_simd", "2", "SIMD level for texture processing (0: none; 1: SSE2; 2: AVX2, if supported).", CVAR_Archive);
+
+
+//==========================================================================
+//
+//  TexSimdDetect
+//
+//==========================================================================
+static int TexSimdDetect () {
+  #ifdef VV_TEXSIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return TEXSIMD_AVX2;
+  return TEXSIMD_SSE2;
+  #else
+  return TEXSIMD_None;
+  #endif
+}
+
+
+static int texSimdDetected = TexSimdDetect();
+static int texSimdForced = -1;
+
+
+//==========================================================================
+//
+//  TexSimd_Level
+//
+//==========================================================================
+int TexSimd_Level () {
+  const int lvl = (texSimdForced >= 0 ? texSimdForced : r_texture_simd.asInt());
+  return clampval(lvl, (int)TEXSIMD_None, texSimdDetected);
+}
+
+
+//==========================================================================
+//
+//  TexSimd_ForceLevel
+//
+//==========================================================================
+void TexSimd_ForceLevel (int level) {
+  texSimdForced = (level < 0 ? -1 : level);
+}
+
+
+//==========================================================================
+//
+//  TexSimd_LevelName
+//
+//==========================================================================
+const char *TexSimd_LevelName (int level) {
+  switch (level) {
+    case TEXSIMD_None: return "scalar";
+    case TEXSIMD_SSE2: return "SSE2";
+    case TEXSIMD_AVX2: return "AVX2";
+  }
+  return "unknown";
+}
+
+
+#ifdef VV_TEXSIMD_X86
+// ////////////////////////////////////////////////////////////////////////// //
+// SSE2 kernels
+// ////////////////////////////////////////////////////////////////////////// //
+
+//==========================================================================
+//
+//  PremulPixels16_SSE2
+//
+//  two pixels, as 16-bit lanes
+//
+//==========================================================================
+static VVA_ALWAYS_INLINE __m128i PremulPixels16_SSE2 (const __m128i px) {
+  // broadcast alpha; alpha lanes are multiplied by 255, so they are kept intact
+  __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+  a = _mm_or_si128(_mm_and_si128(a, _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1)), _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0));
+  __m128i t = _mm_mullo_epi16(px, a);
+  // exact `t/255`
+  t = _mm_add_epi16(t, _mm_add_epi16(_mm_srli_epi16(t, 8), _mm_set1_epi16(1)));
+  return _mm_srli_epi16(t, 8);
+}
+
+
+//==========================================================================
+//
+//  PremultiplyRGBA_SSE2
+//
+//==========================================================================
+static int PremultiplyRGBA_SSE2 (vuint8 *dest, const vuint8 *src, int count) {
+  const __m128i zero = _mm_setzero_si128();
+  const int total = count&~3;
+  for (int f = 0; f < total; f += 4, src += 16, dest += 16) {
+    const __m128i px = _mm_loadu_si128((const __m128i *)src);
+    const __m128i lo = PremulPixels16_SSE2(_mm_unpacklo_epi8(px, zero));
+    const __m128i hi = PremulPixels16_SSE2(_mm_unpackhi_epi8(px, zero));
+    _mm_storeu_si128((__m128i *)dest, _mm_packus_epi16(lo, hi));
+  }
+  return total;
+}
+
+
+//==========================================================================
+//
+//  PremulPixelFloat_SSE2
+//
+//  one pixel, as 32-bit lanes
+//
+//==========================================================================
+static VVA_ALWAYS_INLINE __m128i PremulPixelFloat_SSE2 (const __m128i px) {
+  const __m128 fpx = _mm_cvtepi32_ps(px);
+  const __m128 mul = _mm_div_ps(_mm_shuffle_ps(fpx, fpx, _MM_SHUFFLE(3, 3, 3, 3)), _mm_set1_ps(255.0f));
+  const __m128i res = _mm_cvttps_epi32(_mm_mul_ps(fpx, mul));
+  // keep original alpha
+  const __m128i amask = _mm_set_epi32(-1, 0, 0, 0);
+  return _mm_or_si128(_mm_andnot_si128(amask, res), _mm_and_si128(amask, px));
+}
+
+
+//==========================================================================
+//
+//  PremultiplyImage_SSE2
+//
+//==========================================================================
+static int PremultiplyImage_SSE2 (rgba_t *pic, int count) {
+  const __m128i zero = _mm_setzero_si128();
+  const int total = count&~3;
+  for (int f = 0; f < total; f += 4, pic += 4) {
+    const __m128i px = _mm_loadu_si128((const __m128i *)pic);
+    const __m128i lo = _mm_unpacklo_epi8(px, zero);
+    const __m128i hi = _mm_unpackhi_epi8(px, zero);
+    const __m128i p0 = PremulPixelFloat_SSE2(_mm_unpacklo_epi16(lo, zero));
+    const __m128i p1 = PremulPixelFloat_SSE2(_mm_unpackhi_epi16(lo, zero));
+    const __m128i p2 = PremulPixelFloat_SSE2(_mm_unpacklo_epi16(hi, zero));
+    const __m128i p3 = PremulPixelFloat_SSE2(_mm_unpackhi_epi16(hi, zero));
+    _mm_storeu_si128((__m128i *)pic, _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3)));
+  }
+  return total;
+}
+
+
+//==========================================================================
+//
+//  HalvePairs_SSE2
+//
+//  sums horizontal pixel pairs: (p0+p1, p2+p3) from two registers of
+//  16-bit lanes, each holding two pixels
+//
+//==========================================================================
+static VVA_ALWAYS_INLINE __m128i HalvePairs_SSE2 (const __m128i a, const __m128i b) {
+  return _mm_unpacklo_epi64(_mm_add_epi16(a, _mm_srli_si128(a, 8)), _mm_add_epi16(b, _mm_srli_si128(b, 8)));
+}
+
+
+//==========================================================================
+//
+//  MipMap_SSE2
+//
+//  operates in place; output never overtakes unread input
+//
+//==========================================================================
+static bool MipMap_SSE2 (int width, int height, vuint8 *in) {
+  const __m128i zero = _mm_setzero_si128();
+  vuint8 *out = in;
+
+  if (width == 1 || height == 1) {
+    const int total = width*height/2;
+    int f = 0;
+    for (; f+4 <= total; f += 4, in += 32, out += 16) {
+      const __m128i a0 = _mm_loadu_si128((const __m128i *)in);
+      const __m128i a1 = _mm_loadu_si128((const __m128i *)(in+16));
+      const __m128i o0 = _mm_srli_epi16(HalvePairs_SSE2(_mm_unpacklo_epi8(a0, zero), _mm_unpackhi_epi8(a0, zero)), 1);
+      const __m128i o1 = _mm_srli_epi16(HalvePairs_SSE2(_mm_unpacklo_epi8(a1, zero), _mm_unpackhi_epi8(a1, zero)), 1);
+      _mm_storeu_si128((__m128i *)out, _mm_packus_epi16(o0, o1));
+    }
+    for (; f < total; ++f, in += 8, out += 4) {
+      for (int c = 0; c < 4; ++c) out[c] = vuint8((in[c]+in[c+4])>>1);
+    }
+    return true;
+  }
+
+  // odd widths are handled by the scalar code
+  if (width&1) return false;
+
+  const int rowbytes = width*4;
+  const int outwdt = width/2;
+  const int hh = height/2;
+  for (int y = 0; y < hh; ++y) {
+    const vuint8 *r0 = in+(y*2)*rowbytes;
+    const vuint8 *r1 = r0+rowbytes;
+    int x = 0;
+    for (; x+4 <= outwdt; x += 4, r0 += 32, r1 += 32, out += 16) {
+      const __m128i a0 = _mm_loadu_si128((const __m128i *)r0);
+      const __m128i a1 = _mm_loadu_si128((const __m128i *)(r0+16));
+      const __m128i b0 = _mm_loadu_si128((const __m128i *)r1);
+      const __m128i b1 = _mm_loadu_si128((const __m128i *)(r1+16));
+      const __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+      const __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+      const __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+      const __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+      const __m128i o0 = _mm_srli_epi16(HalvePairs_SSE2(s0, s1), 2);
+      const __m128i o1 = _mm_srli_epi16(HalvePairs_SSE2(s2, s3), 2);
+      _mm_storeu_si128((__m128i *)out, _mm_packus_epi16(o0, o1));
+    }
+    for (; x < outwdt; ++x, r0 += 8, r1 += 8, out += 4) {
+      for (int c = 0; c < 4; ++c) out[c] = vuint8((r0[c]+r0[c+4]+r1[c]+r1[c+4])>>2);
+    }
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  LoadPixelF_SSE2
+//
+//==========================================================================
+static VVA_ALWAYS_INLINE __m128 LoadPixelF_SSE2 (const vuint8 *src) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i px = _mm_cvtsi32_si128(*(const vint32 *)src);
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(px, zero), zero));
+}
+
+
+//==========================================================================
+//
+//  LoadPixel16_SSE2
+//
+//==========================================================================
+static VVA_ALWAYS_INLINE __m128i LoadPixel16_SSE2 (const vuint8 *src) {
+  return _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const vint32 *)src), _mm_setzero_si128());
+}
+
+
+//==========================================================================
+//
+//  ResampleWeighted_SSE2
+//
+//  mirrors the scalar code in `VTexture::ResampleTexture()`, but
+//  processes all four channels at once
+//
+//==========================================================================
+static bool ResampleWeighted_SSE2 (int widthin, int heightin, const vuint8 *datain, int widthout, int heightout, vuint8 *dataout, float sx, float sy) {
+  const __m128i zero = _mm_setzero_si128();
+  if (sx <= 1.0f && sy <= 1.0f) {
+    // magnify both width and height: use weighted sample of 4 pixels
+    for (int i = 0; i < heightout; ++i) {
+      const int i0 = int(i*sy);
+      int i1 = i0+1;
+      if (i1 >= heightin) i1 = heightin-1;
+      const float alpha = i*sy-i0;
+      const __m128 alpha0 = _mm_set1_ps(1.0f-alpha);
+      const __m128 alpha1 = _mm_set1_ps(alpha);
+      vuint8 *dst = dataout+(i*widthout)*4;
+      for (int j = 0; j < widthout; ++j, dst += 4) {
+        const int j0 = int(j*sx);
+        int j1 = j0+1;
+        if (j1 >= widthin) j1 = widthin-1;
+        const float beta = j*sx-j0;
+        const __m128 beta0 = _mm_set1_ps(1.0f-beta);
+        const __m128 beta1 = _mm_set1_ps(beta);
+        const __m128 s1 = _mm_add_ps(_mm_mul_ps(LoadPixelF_SSE2(datain+(i0*widthin+j0)*4), beta0), _mm_mul_ps(LoadPixelF_SSE2(datain+(i0*widthin+j1)*4), beta1));
+        const __m128 s2 = _mm_add_ps(_mm_mul_ps(LoadPixelF_SSE2(datain+(i1*widthin+j0)*4), beta0), _mm_mul_ps(LoadPixelF_SSE2(datain+(i1*widthin+j1)*4), beta1));
+        const __m128i res = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(s1, alpha0), _mm_mul_ps(s2, alpha1)));
+        const __m128i res16 = _mm_packs_epi32(res, zero);
+        *(vint32 *)dst = _mm_cvtsi128_si32(_mm_packus_epi16(res16, zero));
+      }
+    }
+  } else {
+    // shrink width and/or height: use an unweighted box filter
+    // the box is at most 2x2, so division is a shift
+    for (int i = 0; i < heightout; ++i) {
+      const int i0 = int(i*sy);
+      int i1 = i0+1;
+      if (i1 >= heightin) i1 = heightin-1;
+      vuint8 *dst = dataout+(i*widthout)*4;
+      for (int j = 0; j < widthout; ++j, dst += 4) {
+        const int j0 = int(j*sx);
+        int j1 = j0+1;
+        if (j1 >= widthin) j1 = widthin-1;
+        __m128i sum = LoadPixel16_SSE2(datain+(i0*widthin+j0)*4);
+        if (j1 != j0) sum = _mm_add_epi16(sum, LoadPixel16_SSE2(datain+(i0*widthin+j1)*4));
+        if (i1 != i0) {
+          sum = _mm_add_epi16(sum, LoadPixel16_SSE2(datain+(i1*widthin+j0)*4));
+          if (j1 != j0) sum = _mm_add_epi16(sum, LoadPixel16_SSE2(datain+(i1*widthin+j1)*4));
+        }
+        sum = _mm_srl_epi16(sum, _mm_cvtsi32_si128((j1-j0)+(i1-i0)));
+        *(vint32 *)dst = _mm_cvtsi128_si32(_mm_packus_epi16(sum, zero));
+      }
+    }
+  }
+  return true;
+}
+
+
+//==========================================================================
+//
+//  ShadeRGBA_SSE2
+//
+//==========================================================================
+static int ShadeRGBA_SSE2 (rgba_t *pic, int count, vuint32 shade) {
+  const __m128i sc = _mm_set1_epi32((vint32)shade);
+  const int total = count&~3;
+  for (int f = 0; f < total; f += 4, pic += 4) {
+    // use red as intensity
+    const __m128i px = _mm_loadu_si128((const __m128i *)pic);
+    _mm_storeu_si128((__m128i *)pic, _mm_or_si128(_mm_slli_epi32(px, 24), sc));
+  }
+  return total;
+}
+
+
+//==========================================================================
+//
+//  ShadeAlpha8_SSE2
+//
+//==========================================================================
+static int ShadeAlpha8_SSE2 (rgba_t *dest, const vuint8 *src, int count, vuint32 shade) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i sc = _mm_set1_epi32((vint32)shade);
+  const int total = count&~15;
+  for (int f = 0; f < total; f += 16, src += 16, dest += 16) {
+    const __m128i px = _mm_loadu_si128((const __m128i *)src);
+    const __m128i lo = _mm_unpacklo_epi8(px, zero);
+    const __m128i hi = _mm_unpackhi_epi8(px, zero);
+    _mm_storeu_si128((__m128i *)(dest+0), _mm_or_si128(_mm_slli_epi32(_mm_unpacklo_epi16(lo, zero), 24), sc));
+    _mm_storeu_si128((__m128i *)(dest+4), _mm_or_si128(_mm_slli_epi32(_mm_unpackhi_epi16(lo, zero), 24), sc));
+    _mm_storeu_si128((__m128i *)(dest+8), _mm_or_si128(_mm_slli_epi32(_mm_unpacklo_epi16(hi, zero), 24), sc));
+    _mm_storeu_si128((__m128i *)(dest+12), _mm_or_si128(_mm_slli_epi32(_mm_unpackhi_epi16(hi, zero), 24), sc));
+  }
+  return total;
+}
+
+
+//==========================================================================
+//
+//  FindPixel_SSE2
+//
+//  finds first pixel that is zero after masking with `mask`
+//
+//==========================================================================
+static int FindPixel_SSE2 (const rgba_t *pic, int start, int end, vuint32 mask) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i msk = _mm_set1_epi32((vint32)mask);
+  int f = start;
+  for (; f+4 <= end; f += 4) {
+    const __m128i px = _mm_and_si128(_mm_loadu_si128((const __m128i *)(pic+f)), msk);
+    const int bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(px, zero)));
+    if (bits) return f+__builtin_ctz((unsigned)bits);
+  }
+  for (; f < end; ++f) if ((*(const vuint32 *)(pic+f)&mask) == 0) return f;
+  return end;
+}
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+// AVX2 kernels
+// ////////////////////////////////////////////////////////////////////////// //
+
+//==========================================================================
+//
+//  PremulPixels16_AVX2
+//
+//  four pixels, as 16-bit lanes
+//
+//==========================================================================
+static VV_TEXSIMD_AVX2 inline __m256i PremulPixels16_AVX2 (const __m256i px) {
+  __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+  a = _mm256_or_si256(_mm256_and_si256(a, _mm256_set1_epi64x(0x0000ffffffffffffLL)), _mm256_set1_epi64x(0x00ff000000000000LL));
+  __m256i t = _mm256_mullo_epi16(px, a);
+  t = _mm256_add_epi16(t, _mm256_add_epi16(_mm256_srli_epi16(t, 8), _mm256_set1_epi16(1)));
+  return _mm256_srli_epi16(t, 8);
+}
+
+
+//==========================================================================
+//
+//  PremultiplyRGBA_AVX2
+//
+//==========================================================================
+static VV_TEXSIMD_AVX2 int PremultiplyRGBA_AVX2 (vuint8 *dest, const vuint8 *src, int count) {
+  const __m256i zero = _mm256_setzero_si256();
+  const int total = count&~7;
+  for (int f = 0; f < total; f += 8, src += 32, dest += 32) {
+    // unpacks and packs work inside 128-bit lanes, so pixel order is preserved
+    const __m256i px = _mm256_loadu_si256((const __m256i *)src);
+    const __m256i lo = PremulPixels16_AVX2(_mm256_unpacklo_epi8(px, zero));
+    const __m256i hi = PremulPixels16_AVX2(_mm256_unpackhi_epi8(px, zero));
+    _mm256_storeu_si256((__m256i *)dest, _mm256_packus_epi16(lo, hi));
+  }
+  return total;
+}
+
+
+//==========================================================================
+//
+//  ShadeRGBA_AVX2
+//
+//==========================================================================
+static VV_TEXSIMD_AVX2 int ShadeRGBA_AVX2 (rgba_t *pic, int count, vuint32 shade) {
+  const __m256i sc = _mm256_set1_epi32((vint32)shade);
+  const int total = count&~7;
+  for (int f = 0; f < total; f += 8, pic += 8) {
+    const __m256i px = _mm256_loadu_si256((const __m256i *)pic);
+    _mm256_storeu_si256((__m256i *)pic, _mm256_or_si256(_mm256_slli_epi32(px, 24), sc));
+  }
+  return total;
+}
+
+
+//==========================================================================
+//
+//  ShadeAlpha8_AVX2
+//
+//==========================================================================
+static VV_TEXSIMD_AVX2 int ShadeAlpha8_AVX2 (rgba_t *dest, const vuint8 *src, int count, vuint32 shade) {
+  const __m256i sc = _mm256_set1_epi32((vint32)shade);
+  const int total = count&~7;
+  for (int f = 0; f < total; f += 8, src += 8, dest += 8) {
+    const __m256i px = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)src));
+    _mm256_storeu_si256((__m256i *)dest, _mm256_or_si256(_mm256_slli_epi32(px, 24), sc));
+  }
+  return total;
+}
+
+
+//==========================================================================
+//
+//  FindPixel_AVX2
+//
+//==========================================================================
+static VV_TEXSIMD_AVX2 int FindPixel_AVX2 (const rgba_t *pic, int start, int end, vuint32 mask) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i msk = _mm256_set1_epi32((vint32)mask);
+  int f = start;
+  for (; f+8 <= end; f += 8) {
+    const __m256i px = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(pic+f)), msk);
+    const int bits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(px, zero)));
+    if (bits) return f+__builtin_ctz((unsigned)bits);
+  }
+  return FindPixel_SSE2(pic, f, end, mask);
+}
+#endif
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+// dispatchers
+// ////////////////////////////////////////////////////////////////////////// //
+
+//==========================================================================
+//
+//  TexSimd_PremultiplyRGBA
+//
+//==========================================================================
+int TexSimd_PremultiplyRGBA (vuint8 *dest, const vuint8 *src, int count) {
+  #ifdef VV_TEXSIMD_X86
+  switch (TexSimd_Level()) {
+    case TEXSIMD_SSE2: return PremultiplyRGBA_SSE2(dest, src, count);
+    case TEXSIMD_AVX2: return PremultiplyRGBA_AVX2(dest, src, count);
+  }
+  #endif
+  return 0;
+}
+
+
+//==========================================================================
+//
+//  TexSimd_PremultiplyImage
+//
+//==========================================================================
+int TexSimd_PremultiplyImage (rgba_t *pic, int count) {
+  #ifdef VV_TEXSIMD_X86
+  // float kernel gains nothing from AVX2 here
+  if (TexSimd_Level() >= TEXSIMD_SSE2) return PremultiplyImage_SSE2(pic, count);
+  #endif
+  return 0;
+}
+
+
+//==========================================================================
+//
+//  TexSimd_MipMap
+//
+//==========================================================================
+bool TexSimd_MipMap (int width, int height, vuint8 *in) {
+  #ifdef VV_TEXSIMD_X86
+  // AVX2 version would need cross-lane shuffles, and it is memory-bound anyway
+  if (TexSimd_Level() >= TEXSIMD_SSE2) return MipMap_SSE2(width, height, in);
+  #endif
+  return false;
+}
+
+
+//==========================================================================
+//
+//  TexSimd_ResampleWeighted
+//
+//==========================================================================
+bool TexSimd_ResampleWeighted (int widthin, int heightin, const vuint8 *datain, int widthout, int heightout, vuint8 *dataout, float sx, float sy) {
+  #ifdef VV_TEXSIMD_X86
+  if (TexSimd_Level() >= TEXSIMD_SSE2) return ResampleWeighted_SSE2(widthin, heightin, datain, widthout, heightout, dataout, sx, sy);
+  #endif
+  return false;
+}
+
+
+//==========================================================================
+//
+//  TexSimd_ShadeRGBA
+//
+//  use red as intensity
+//
+//==========================================================================
+void TexSimd_ShadeRGBA (rgba_t *pic, int count, vuint32 shadeColor) {
+  const rgba_t shade((shadeColor>>16)&0xff, (shadeColor>>8)&0xff, shadeColor&0xff, 0);
+  int done = 0;
+  #ifdef VV_TEXSIMD_X86
+  switch (TexSimd_Level()) {
+    case TEXSIMD_SSE2: done = ShadeRGBA_SSE2(pic, count, *(const vuint32 *)&shade); break;
+    case TEXSIMD_AVX2: done = ShadeRGBA_AVX2(pic, count, *(const vuint32 *)&shade); break;
+  }
+  #endif
+  for (pic += done; done < count; ++done, ++pic) {
+    const vuint8 intensity = pic->r;
+    pic->r = shade.r;
+    pic->g = shade.g;
+    pic->b = shade.b;
+    pic->a = intensity;
+  }
+}
+
+
+//==========================================================================
+//
+//  TexSimd_ShadeAlpha8
+//
+//==========================================================================
+void TexSimd_ShadeAlpha8 (rgba_t *dest, const vuint8 *src, int count, vuint32 shadeColor) {
+  const rgba_t shade((shadeColor>>16)&0xff, (shadeColor>>8)&0xff, shadeColor&0xff, 0);
+  int done = 0;
+  #ifdef VV_TEXSIMD_X86
+  switch (TexSimd_Level()) {
+    case TEXSIMD_SSE2: done = ShadeAlpha8_SSE2(dest, src, count, *(const vuint32 *)&shade); break;
+    case TEXSIMD_AVX2: done = ShadeAlpha8_AVX2(dest, src, count, *(const vuint32 *)&shade); break;
+  }
+  #endif
+  for (dest += done, src += done; done < count; ++done, ++dest, ++src) {
+    dest->r = shade.r;
+    dest->g = shade.g;
+    dest->b = shade.b;
+    dest->a = *src;
+  }
+}
+
+
+//==========================================================================
+//
+//  TexSimd_FindZeroPixel
+//
+//==========================================================================
+int TexSimd_FindZeroPixel (const rgba_t *pic, int start, int end) {
+  #ifdef VV_TEXSIMD_X86
+  switch (TexSimd_Level()) {
+    case TEXSIMD_SSE2: return FindPixel_SSE2(pic, start, end, 0xffffffffu);
+    case TEXSIMD_AVX2: return FindPixel_AVX2(pic, start, end, 0xffffffffu);
+  }
+  #endif
+  for (; start < end; ++start) {
+    const rgba_t &px = pic[start];
+    if (px.r == 0 && px.g == 0 && px.b == 0 && px.a == 0) break;
+  }
+  return start;
+}
+
+
+//==========================================================================
+//
+//  TexSimd_FindTransparentPixel
+//
+//==========================================================================
+int TexSimd_FindTransparentPixel (const rgba_t *pic, int start, int end) {
+  #ifdef VV_TEXSIMD_X86
+  switch (TexSimd_Level()) {
+    case TEXSIMD_SSE2: return FindPixel_SSE2(pic, start, end, 0xff000000u);
+    case TEXSIMD_AVX2: return FindPixel_AVX2(pic, start, end, 0xff000000u);
+  }
+  #endif
+  for (; start < end; ++start) if (pic[start].a == 0) break;
+  return start;
+}
+
+
+// ////////////////////////////////////////////////////////////////////////// //
+// benchmark
+// ////////////////////////////////////////////////////////////////////////// //
+struct TexSimdBenchImage {
+  int Width, Height;
+  vuint8 *Src; // Width*Height pixels
+  vuint8 *Dest; // `TexSimdBenchImage::DestSize()` bytes
+  static size_t DestSize (int w, int h) { return (size_t)(w+w/2)*(size_t)(h+h/2)*4; }
+};
+
+typedef void (*TexSimdBenchFn) (TexSimdBenchImage &img);
+
+static void TSB_PremulInPlace (TexSimdBenchImage &img) { memcpy(img.Dest, img.Src, img.Width*img.Height*4); VTexture::PremultiplyRGBAInPlace(img.Dest, img.Width, img.Height); }
+static void TSB_PremulCopy (TexSimdBenchImage &img) { VTexture::PremultiplyRGBA(img.Dest, img.Src, img.Width, img.Height); }
+static void TSB_PremulFloat (TexSimdBenchImage &img) { memcpy(img.Dest, img.Src, img.Width*img.Height*4); VTexture::PremultiplyImage((rgba_t *)img.Dest, img.Width, img.Height); }
+static void TSB_MipMap (TexSimdBenchImage &img) { memcpy(img.Dest, img.Src, img.Width*img.Height*4); VTexture::MipMap(img.Width, img.Height, img.Dest); }
+static void TSB_Magnify (TexSimdBenchImage &img) { VTexture::ResampleTexture(img.Width, img.Height, img.Src, img.Width+img.Width/2, img.Height+img.Height/2, img.Dest, 0); }
+static void TSB_Shrink (TexSimdBenchImage &img) { VTexture::ResampleTexture(img.Width, img.Height, img.Src, img.Width/2, img.Height/2, img.Dest, 0); }
+static void TSB_Fringe (TexSimdBenchImage &img) { memcpy(img.Dest, img.Src, img.Width*img.Height*4); VTexture::FilterFringe((rgba_t *)img.Dest, img.Width, img.Height); }
+static void TSB_SmoothEdges (TexSimdBenchImage &img) { memcpy(img.Dest, img.Src, img.Width*img.Height*4); VTexture::SmoothEdges(img.Dest, img.Width, img.Height); }
+static void TSB_Shade (TexSimdBenchImage &img) { memcpy(img.Dest, img.Src, img.Width*img.Height*4); TexSimd_ShadeRGBA((rgba_t *)img.Dest, img.Width*img.Height, 0x40a0ffu); }
+static void TSB_ShadeAlpha8 (TexSimdBenchImage &img) { TexSimd_ShadeAlpha8((rgba_t *)img.Dest, img.Src, img.Width*img.Height, 0x40a0ffu); }
+
+
+//==========================================================================
+//
+//  TexSimdBench
+//
+//  usage: TexSimdBench [megapixels-per-run]
+//  every kernel is run with each available SIMD level, and compared
+//  with the scalar output
+//
+//==========================================================================
+COMMAND(TexSimdBench) {
+  static const struct {
+    const char *Name;
+    TexSimdBenchFn Fn;
+  } kernels[] = {
+    { "premul-inplace", &TSB_PremulInPlace },
+    { "premul-copy", &TSB_PremulCopy },
+    { "premul-float", &TSB_PremulFloat },
+    { "mipmap", &TSB_MipMap },
+    { "resample-magnify", &TSB_Magnify },
+    { "resample-shrink", &TSB_Shrink },
+    { "filter-fringe", &TSB_Fringe },
+    { "smooth-edges", &TSB_SmoothEdges },
+    { "shade-rgba", &TSB_Shade },
+    { "shade-alpha8", &TSB_ShadeAlpha8 },
+  };
+  static const int sizes[] = { 64, 256, 1024, 2048 };
+
+  int mpix = 16;
+  if (Args.length() > 1) mpix = clampval(VStr::atoi(*Args[1]), 1, 1024);
+
+  const int maxLevel = texSimdDetected;
+  GCon->Logf("TexSimdBench: best available kernel set is %s; %d megapixels per run", TexSimd_LevelName(maxLevel), mpix);
+
+  for (unsigned si = 0; si < ARRAY_COUNT(sizes); ++si) {
+    const int size = sizes[si];
+    TexSimdBenchImage img;
+    img.Width = img.Height = size;
+    const size_t dsize = TexSimdBenchImage::DestSize(size, size);
+    img.Src = (vuint8 *)Z_Malloc(size*size*4);
+    img.Dest = (vuint8 *)Z_Malloc(dsize);
+    vuint8 *ref = (vuint8 *)Z_Malloc(dsize);
+
+    // runs of opaque, fully transparent, and translucent pixels
+    vuint32 seed = 0x29a;
+    for (int f = 0; f < size*size; f += 16) {
+      seed = seed*1664525u+1013904223u;
+      const int mode = (seed>>24)%3;
+      for (int n = f; n < f+16 && n < size*size; ++n) {
+        vuint8 *px = img.Src+n*4;
+        seed = seed*1664525u+1013904223u;
+        px[0] = (seed>>8)&0xff;
+        px[1] = (seed>>16)&0xff;
+        px[2] = (seed>>24)&0xff;
+        px[3] = (mode == 0 ? 255 : mode == 1 ? 0 : (seed>>4)&0xff);
+        if (mode == 1) px[0] = px[1] = px[2] = 0;
+      }
+    }
+
+    const int reps = max2(1, mpix*1024*1024/(size*size));
+    for (unsigned ki = 0; ki < ARRAY_COUNT(kernels); ++ki) {
+      VStr line = VStr(va("  %4dx%-4d %-16s", size, size, kernels[ki].Name));
+      double scalarTime = 0;
+      for (int lvl = TEXSIMD_None; lvl <= maxLevel; ++lvl) {
+        TexSimd_ForceLevel(lvl);
+        memset(img.Dest, 0, dsize);
+        double stt = -Sys_Time();
+        for (int r = 0; r < reps; ++r) kernels[ki].Fn(img);
+        stt += Sys_Time();
+        if (lvl == TEXSIMD_None) {
+          scalarTime = stt;
+          memcpy(ref, img.Dest, dsize);
+          line += va(" %s: %8.3f ms", TexSimd_LevelName(lvl), stt*1000.0);
+        } else {
+          const bool same = (memcmp(ref, img.Dest, dsize) == 0);
+          line += va("; %s: %8.3f ms (%5.2fx)%s", TexSimd_LevelName(lvl), stt*1000.0, (stt > 0 ? scalarTime/stt : 0.0), (same ? "" : " MISMATCH!"));
+        }
+      }
+      TexSimd_ForceLevel(-1);
+      GCon->Log(line);
+    }
+
+    Z_Free(ref);
+    Z_Free(img.Dest);
+    Z_Free(img.Src);
+  }
+}
@@ -22,11 +22,46 @@
 //**  You should have received a copy of the GNU General Public License
 //**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //**
+//**
+//**  warping textures
+//**
+//**  old warping recomputes the whole image (including sines) each time
+//**  the texture time changes, which is every tic for every visible warped
+//**  texture. with `r_warp_phases`, time is quantized to a fixed number of
+//**  phases per warp cycle; offset tables for all phases are built once,
+//**  and generated images are cached (if the whole cycle fits into
+//**  `r_warp_cache_mb`), so each phase is rendered only once.
+//**
+//**  warp frequencies are rounded to integer harmonics of the cycle, so
+//**  the animation loops exactly:
+//**    warp 1: 7.5 seconds; 48 deg/sec for both axes (was 44 and 50)
+//**    warp 2: 6 seconds; harmonics 5, 2 and 4 (was 313.9, 118.3 and 251.1 deg/sec)
+//**
 //**************************************************************************
 #include "../gamedefs.h"
 #include "r_tex.h"
 
 
+static VCvarI r_warp_phases("r_warp_phases", "256", "Number of phases in warp texture cycle (0: exact, slow warping).", CVAR_Archive);
+static VCvarI r_warp_cache_mb("r_warp_cache_mb", "4", "Cache all phases of warp texture if they fit into this number of megabytes.", CVAR_Archive);
+
+static int warpForcedPhases = -1; // for benchmarks
+static int warpStatRendered = 0;
+static int warpStatCached = 0;
+
+
+//==========================================================================
+//
+//  WrapOfs
+//
+//==========================================================================
+static inline int WrapOfs (const float v, const int size) noexcept {
+  int res = ((int)floorf(v))%size;
+  if (res < 0) res += size;
+  return res;
+}
+
+
 //==========================================================================
 //
 //  VWarpTexture::VWarpTexture
@@ -43,6 +78,12 @@ VWarpTexture::VWarpTexture (VTexture *ASrcTex, float aspeed)
   , XSin2(nullptr)
   , YSin1(nullptr)
   , YSin2(nullptr)
+  , PhaseCount(0)
+  , CurPhase(-1)
+  , PhaseFormat(-1)
+  , PhaseOfs()
+  , PhaseCache(nullptr)
+  , PhaseFlags(nullptr)
 {
   Width = SrcTex->GetWidth();
   Height = SrcTex->GetHeight();
@@ -62,6 +103,7 @@ VWarpTexture::VWarpTexture (VTexture *ASrcTex, float aspeed)
 //
 //==========================================================================
 VWarpTexture::~VWarpTexture () {
+  ClearPhaseCache();
   if (Pixels) {
     delete[] Pixels;
     Pixels = nullptr;
@@ -106,6 +148,114 @@ bool VWarpTexture::IsDynamicTexture () const noexcept {
 //==========================================================================
 void VWarpTexture::SetFrontSkyLayer () {
   SrcTex->SetFrontSkyLayer();
+  // source pixels are changed
+  ClearPhaseCache();
+}
+
+
+//==========================================================================
+//
+//  VWarpTexture::GetWarpPhases
+//
+//==========================================================================
+int VWarpTexture::GetWarpPhases () noexcept {
+  const int phases = (warpForcedPhases >= 0 ? warpForcedPhases : r_warp_phases.asInt());
+  return (phases <= 0 ? 0 : clampval(phases, 8, 4096));
+}
+
+
+//==========================================================================
+//
+//  VWarpTexture::CalcPhase
+//
+//==========================================================================
+int VWarpTexture::CalcPhase (int phases) const noexcept {
+  double t = (double)GTextureManager.Time*Speed/GetWarpCycle();
+  t -= floor(t);
+  return clampval((int)(t*phases), 0, phases-1);
+}
+
+
+//==========================================================================
+//
+//  VWarpTexture::ClearPhaseCache
+//
+//==========================================================================
+void VWarpTexture::ClearPhaseCache () noexcept {
+  if (PhaseCache) { delete[] PhaseCache; PhaseCache = nullptr; }
+  if (PhaseFlags) { delete[] PhaseFlags; PhaseFlags = nullptr; }
+  PhaseOfs.clear();
+  PhaseCount = 0;
+  CurPhase = -1;
+}
+
+
+//==========================================================================
+//
+//  VWarpTexture::GetWarpCycle
+//
+//==========================================================================
+float VWarpTexture::GetWarpCycle () const noexcept {
+  return 7.5f;
+}
+
+
+//==========================================================================
+//
+//  VWarpTexture::BuildPhaseTables
+//
+//  for each phase: source row offset for each column, and source column
+//  offset for each row; both are already wrapped
+//
+//==========================================================================
+void VWarpTexture::BuildPhaseTables () {
+  const int stride = Width+Height;
+  PhaseOfs.setLength(PhaseCount*stride);
+  for (int p = 0; p < PhaseCount; ++p) {
+    const float theta = 360.0f*p/PhaseCount;
+    vint32 *xrow = PhaseOfs.ptr()+p*stride;
+    vint32 *ycol = xrow+Width;
+    for (int x = 0; x < Width; ++x) xrow[x] = WrapOfs(msin(theta+x/WarpXScale*5.625f+95.625f)*8*WarpYScale+8*WarpYScale*Height, Height);
+    for (int y = 0; y < Height; ++y) ycol[y] = WrapOfs(msin(theta+y/WarpYScale*5.625f)*8*WarpXScale+8*WarpXScale*Width, Width);
+  }
+}
+
+
+//==========================================================================
+//
+//  VWarpTexture::RenderPhase
+//
+//==========================================================================
+vuint32 VWarpTexture::RenderPhase (int phase, const vuint8 *src, vuint8 *dest) {
+  const vint32 *xrow = PhaseOfs.ptr()+phase*(Width+Height);
+  const vint32 *ycol = xrow+Width;
+  vuint32 flags = 0;
+  if (PhaseFormat == TEXFMT_8 || PhaseFormat == TEXFMT_8Pal) {
+    for (int y = 0; y < Height; ++y) {
+      int col = ycol[y];
+      for (int x = 0; x < Width; ++x) {
+        int row = xrow[x]+y;
+        if (row >= Height) row -= Height;
+        if (!(*dest++ = src[col+row*Width])) flags |= FlagTransparent;
+        if (++col == Width) col = 0;
+      }
+    }
+  } else {
+    const vuint32 *src32 = (const vuint32 *)src;
+    vuint32 *dst = (vuint32 *)dest;
+    for (int y = 0; y < Height; ++y) {
+      int col = ycol[y];
+      for (int x = 0; x < Width; ++x, ++dst) {
+        int row = xrow[x]+y;
+        if (row >= Height) row -= Height;
+        *dst = src32[col+row*Width];
+        const vuint8 a8 = (((*dst)>>24)&0xffu);
+        if (a8 != 0xffu) flags |= (a8 ? FlagTranslucent : FlagTransparent);
+        if (++col == Width) col = 0;
+      }
+    }
+  }
+  return flags;
 }
 
 
@@ -115,6 +265,8 @@ void VWarpTexture::SetFrontSkyLayer () {
 //
 //==========================================================================
 bool VWarpTexture::CheckModified () {
+  const int phases = GetWarpPhases();
+  if (phases > 0) return (PhaseCount != phases || CurPhase != CalcPhase(phases));
   return (GenTime != GTextureManager.Time*Speed);
 }
 
@@ -125,6 +277,72 @@ bool VWarpTexture::CheckModified () {
 //
 //==========================================================================
 vuint8 *VWarpTexture::GetPixels () {
+  const int phases = GetWarpPhases();
+  if (phases > 0) return GetPixelsPhased(phases);
+  if (PhaseCount) ClearPhaseCache();
+  return GetPixelsExact();
+}
+
+
+//==========================================================================
+//
+//  VWarpTexture::GetPixelsPhased
+//
+//==========================================================================
+vuint8 *VWarpTexture::GetPixelsPhased (int phases) {
+  const int phase = CalcPhase(phases);
+  if (Pixels && PhaseCount == phases && CurPhase == phase) return Pixels;
+
+  const vuint8 *SrcPixels = SrcTex->GetPixels();
+  mFormat = mOrigFormat = SrcTex->Format;
+  const size_t bpp = (mFormat == TEXFMT_8 || mFormat == TEXFMT_8Pal ? 1 : 4);
+  const size_t imgsize = (size_t)Width*(size_t)Height*bpp;
+
+  if (PhaseCount != phases || PhaseFormat != mFormat) {
+    // pixel buffer size depends on the format
+    if (PhaseFormat != mFormat && Pixels) { delete[] Pixels; Pixels = nullptr; }
+    ClearPhaseCache();
+    PhaseCount = phases;
+    PhaseFormat = mFormat;
+    BuildPhaseTables();
+    if ((vint64)imgsize*phases <= (vint64)max2(0, r_warp_cache_mb.asInt())*1024*1024) {
+      PhaseCache = new vuint8[imgsize*phases];
+      PhaseFlags = new vuint8[phases];
+      memset(PhaseFlags, 0, phases);
+    }
+  }
+
+  GenTime = -1.0f; // force regeneration if exact mode will be turned on
+  Pixels8BitValid = false;
+  Pixels8BitAValid = false;
+  if (!Pixels) Pixels = new vuint8[imgsize];
+
+  vuint32 flags;
+  if (PhaseCache && (PhaseFlags[phase]&0x80u)) {
+    memcpy(Pixels, PhaseCache+imgsize*phase, imgsize);
+    flags = PhaseFlags[phase]&0x7fu;
+    ++warpStatCached;
+  } else {
+    flags = RenderPhase(phase, SrcPixels, Pixels);
+    if (PhaseCache) {
+      memcpy(PhaseCache+imgsize*phase, Pixels, imgsize);
+      PhaseFlags[phase] = (vuint8)(0x80u|flags);
+    }
+    ++warpStatRendered;
+  }
+
+  transFlags = SrcTex->transFlags|flags;
+  CurPhase = phase;
+  return Pixels;
+}
+
+
+//==========================================================================
+//
+//  VWarpTexture::GetPixelsExact
+//
+//==========================================================================
+vuint8 *VWarpTexture::GetPixelsExact () {
   if (Pixels && GenTime == GTextureManager.Time*Speed) return Pixels;
 
   const vuint8 *SrcPixels = SrcTex->GetPixels();
@@ -220,10 +438,91 @@ VWarp2Texture::VWarp2Texture (VTexture *ASrcTex, float aspeed)
 
 //==========================================================================
 //
-//  VWarp2Texture::GetPixels
+//  VWarp2Texture::GetWarpCycle
+//
+//==========================================================================
+float VWarp2Texture::GetWarpCycle () const noexcept {
+  return 6.0f;
+}
+
+
+//==========================================================================
+//
+//  VWarp2Texture::BuildPhaseTables
+//
+//  for each phase: column and row offsets for each row, then column and
+//  row offsets for each column; all are already wrapped
+//
+//==========================================================================
+void VWarp2Texture::BuildPhaseTables () {
+  const int stride = (Width+Height)*2;
+  PhaseOfs.setLength(PhaseCount*stride);
+  for (int p = 0; p < PhaseCount; ++p) {
+    const float theta = 360.0f*p/PhaseCount;
+    vint32 *ycol = PhaseOfs.ptr()+p*stride;
+    vint32 *yrow = ycol+Height;
+    vint32 *xcol = yrow+Height;
+    vint32 *xrow = xcol+Width;
+    for (int y = 0; y < Height; ++y) {
+      ycol[y] = WrapOfs(msin(y/WarpYScale*5.625f+theta*5+39.55f)*2*WarpXScale, Width);
+      yrow[y] = WrapOfs(y+(2*Height+msin(y/WarpYScale*5.625f+theta*2+30.76f)*2)*WarpYScale, Height);
+    }
+    for (int x = 0; x < Width; ++x) {
+      xcol[x] = WrapOfs(x+(2*Width+msin(x/WarpXScale*11.25f+theta*4+13.18f)*2)*WarpXScale, Width);
+      xrow[x] = WrapOfs(msin(x/WarpXScale*11.25f+theta*4+52.73f)*2*WarpYScale, Height);
+    }
+  }
+}
+
+
+//==========================================================================
+//
+//  VWarp2Texture::RenderPhase
 //
 //==========================================================================
-vuint8 *VWarp2Texture::GetPixels () {
+vuint32 VWarp2Texture::RenderPhase (int phase, const vuint8 *src, vuint8 *dest) {
+  const vint32 *ycol = PhaseOfs.ptr()+phase*(Width+Height)*2;
+  const vint32 *yrow = ycol+Height;
+  const vint32 *xcol = yrow+Height;
+  const vint32 *xrow = xcol+Width;
+  if (PhaseFormat == TEXFMT_8 || PhaseFormat == TEXFMT_8Pal) {
+    for (int y = 0; y < Height; ++y) {
+      const int yc = ycol[y];
+      const int yr = yrow[y];
+      for (int x = 0; x < Width; ++x) {
+        int col = yc+xcol[x];
+        if (col >= Width) col -= Width;
+        int row = yr+xrow[x];
+        if (row >= Height) row -= Height;
+        *dest++ = src[col+row*Width];
+      }
+    }
+  } else {
+    const vuint32 *src32 = (const vuint32 *)src;
+    vuint32 *dst = (vuint32 *)dest;
+    for (int y = 0; y < Height; ++y) {
+      const int yc = ycol[y];
+      const int yr = yrow[y];
+      for (int x = 0; x < Width; ++x) {
+        int col = yc+xcol[x];
+        if (col >= Width) col -= Width;
+        int row = yr+xrow[x];
+        if (row >= Height) row -= Height;
+        *dst++ = src32[col+row*Width];
+      }
+    }
+  }
+  // old code doesn't calculate flags for this warp type
+  return 0;
+}
+
+
+//==========================================================================
+//
+//  VWarp2Texture::GetPixelsExact
+//
+//==========================================================================
+vuint8 *VWarp2Texture::GetPixelsExact () {
   if (Pixels && GenTime == GTextureManager.Time*Speed) return Pixels;
   Pixels8BitValid = false;
   Pixels8BitAValid = false;
@@ -283,5 +582,97 @@ void VWarpTexture::ReleasePixels () {
   if (InReleasingPixels()) return; // already released
   VTexture::ReleasePixels();
   ReleasePixelsLock rlock(this);
+  ClearPhaseCache();
   if (SrcTex) SrcTex->ReleasePixels();
 }
+
+
+//==========================================================================
+//
+//  WarpBench
+//
+//  usage: WarpBench [seconds]
+//  animates warp textures of the current map for the given game time at
+//  35 FPS, with exact warping, and with phased warping (cold and warm)
+//
+//==========================================================================
+COMMAND(WarpBench) {
+  VLevel *lvl = GLevel;
+  #ifdef CLIENT
+  if (!lvl) lvl = GClLevel;
+  #endif
+  if (!lvl) {
+    GCon->Log("no level loaded");
+    return;
+  }
+
+  float seconds = 8.0f;
+  if (Args.length() > 1) seconds = clampval(VStr::atof(*Args[1], 8.0f), 0.1f, 600.0f);
+  const int frames = max2(1, (int)(seconds*35.0f));
+
+  // collect warp textures (and their hires replacements) used on the map
+  TArray<VTexture *> list;
+  TMapNC<VTexture *, bool> seen;
+  auto addTex = [&](int texnum) {
+    if (texnum <= 0) return;
+    VTexture *tex = GTextureManager(texnum);
+    if (!tex || !tex->WarpType) return;
+    if (r_hirestex) {
+      VTexture *hitex = tex->GetHighResolutionTexture();
+      if (hitex) tex = hitex;
+    }
+    if (seen.has(tex)) return;
+    seen.put(tex, true);
+    list.append(tex);
+  };
+  for (int f = 0; f < lvl->NumSectors; ++f) {
+    addTex(lvl->Sectors[f].floor.pic);
+    addTex(lvl->Sectors[f].ceiling.pic);
+  }
+  for (int f = 0; f < lvl->NumSides; ++f) {
+    addTex(lvl->Sides[f].TopTexture);
+    addTex(lvl->Sides[f].MidTexture);
+    addTex(lvl->Sides[f].BottomTexture);
+  }
+  if (list.length() == 0) {
+    GCon->Log("no warp textures on this map");
+    return;
+  }
+
+  vint64 pixelCount = 0;
+  for (auto &&tex : list) pixelCount += (vint64)tex->GetWidth()*tex->GetHeight();
+
+  const float oldTime = GTextureManager.Time;
+  const int phases = (r_warp_phases.asInt() > 0 ? r_warp_phases.asInt() : 256);
+  static const char *passNames[3] = { "exact", "phased (cold)", "phased (warm)" };
+
+  GCon->Logf("WarpBench: %d warp textures (%.2f megapixels), %d frames, %d phases", list.length(), (double)pixelCount/1000000.0, frames, phases);
+  for (int pass = 0; pass < 3; ++pass) {
+    warpForcedPhases = (pass == 0 ? 0 : phases);
+    if (pass < 2) for (auto &&tex : list) tex->ReleasePixels();
+    // make sure sources are decoded
+    GTextureManager.Time = oldTime;
+    for (auto &&tex : list) (void)tex->GetPixels();
+    warpStatRendered = warpStatCached = 0;
+    int updates = 0;
+    double stt = -Sys_Time();
+    for (int frame = 1; frame <= frames; ++frame) {
+      GTextureManager.Time = oldTime+frame/35.0f;
+      for (auto &&tex : list) {
+        if (tex->CheckModified()) {
+          (void)tex->GetPixels();
+          ++updates;
+        }
+      }
+    }
+    stt += Sys_Time();
+    if (pass == 0) {
+      GCon->Logf("  %-14s: %8.3f msecs (%.4f msecs per frame); %d updates", passNames[pass], stt*1000.0, stt*1000.0/frames, updates);
+    } else {
+      GCon->Logf("  %-14s: %8.3f msecs (%.4f msecs per frame); %d updates (%d rendered, %d from cache)", passNames[pass], stt*1000.0, stt*1000.0/frames, updates, warpStatRendered, warpStatCached);
+    }
+  }
+
+  warpForcedPhases = -1;
+  GTextureManager.Time = oldTime;
+}